@@ -220,3 +220,24 @@ int utils_write32withmask(void __iomem *working_address, u32 value,
 	iowrite32(register_value_to_write, working_address);
 	return 0;
 }
+
+/**
+ * utils_num_eth_ports - Reads the number of Ethernet ports of the framer
+ *
+ * Reads CFG_CONFIG_NO_OF_ETH_PORTS, limited to the MAX_NUM_ETH_PORTS ports
+ * supported by the driver. An IP reporting no ports is taken to have one
+ *
+ * Return: the number of Ethernet ports
+ */
+int utils_num_eth_ports(void)
+{
+	u32 num_ports;
+
+	num_ports = (ioread32(lp->base_addr + CFG_CONFIG_NO_OF_ETH_PORTS_ADDR) &
+		     CFG_CONFIG_NO_OF_ETH_PORTS_MASK) >>
+		    CFG_CONFIG_NO_OF_ETH_PORTS_OFFSET;
+	if (!num_ports)
+		return 1;
+
+	return min_t(u32, num_ports, MAX_NUM_ETH_PORTS);
+}
@@ -416,7 +416,7 @@ int xroe_sysfs_defm_init(void)
 	if (!kobj_dir_eth_config)
 		return -ENOMEM;
 
-	for (i = 0; i < MAX_NUM_ETH_PORTS; i++) {
+	for (i = 0; i < lp->num_eth_ports; i++) {
 		snprintf(eth_port_dir_name, sizeof(eth_port_dir_name),
 			 "eth_port_%d", i);
 		kobj_dir_eth_ports[i] =
@@ -7,6 +7,7 @@
 
 #include <linux/init.h>
 #include <linux/kobject.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/stat.h>
 #include <linux/string.h>
@@ -128,13 +129,67 @@ static struct attribute *stats_attrs[] = {
 };
 ATTRIBUTE_GROUPS(stats);
 
+/**
+ * snapshot_read - Reads a binary snapshot of the statistics of all ports
+ * @filp:	The file pointer
+ * @kobj:	The kernel object of the "stats" directory
+ * @attr:	The binary attribute
+ * @buff:	The buffer to copy the snapshot into
+ * @off:	The offset in the snapshot
+ * @count:	The number of bytes to copy
+ *
+ * Reads the STATS_ETH_STATS block of every Ethernet port present into a
+ * struct xroe_stats_snapshot, in place of one sysfs read per counter and port
+ *
+ * Return: the number of bytes copied
+ */
+static ssize_t snapshot_read(struct file *filp, struct kobject *kobj,
+			     struct bin_attribute *attr, char *buff,
+			     loff_t off, size_t count)
+{
+	struct xroe_stats_snapshot snapshot;
+	void __iomem *working_address;
+	unsigned long flags;
+	int port;
+	int i;
+
+	if (off >= sizeof(snapshot))
+		return 0;
+	if (count > sizeof(snapshot) - off)
+		count = sizeof(snapshot) - off;
+
+	memset(&snapshot, 0, sizeof(snapshot));
+	snapshot.version = XROE_STATS_SNAPSHOT_VERSION;
+	snapshot.num_ports = lp->num_eth_ports;
+	snapshot.num_words = XROE_STATS_SNAPSHOT_WORDS;
+
+	spin_lock_irqsave(&lp->reg_lock, flags);
+	snapshot.timestamp_ns = ktime_get_ns();
+	for (port = 0; port < lp->num_eth_ports; port++) {
+		working_address = lp->base_addr +
+				  STATS_ETH_STATS_TOTAL_RX_GOOD_PKT_CNT_ADDR +
+				  (ADDR_LOOP_OFFSET_STATS * port);
+		for (i = 0; i < XROE_STATS_SNAPSHOT_WORDS; i++)
+			snapshot.words[port][i] =
+				ioread32(working_address + (i * sizeof(u32)));
+	}
+	spin_unlock_irqrestore(&lp->reg_lock, flags);
+
+	memcpy(buff, (char *)&snapshot + off, count);
+
+	return count;
+}
+
+static BIN_ATTR_RO(snapshot, sizeof(struct xroe_stats_snapshot));
+
 /**
  * xroe_sysfs_stats_init - Creates the xroe sysfs "stats" subdirectory & entries
  *
  * Return: 0 on success, negative value in case of failure to
  * create the sysfs group
  *
- * Creates the xroe sysfs "stats" subdirectory and entries under "xroe"
+ * Creates the xroe sysfs "stats" subdirectory and entries under "xroe", with the
+ * binary "snapshot" entry holding the statistics of all ports
  */
 int xroe_sysfs_stats_init(void)
 {
@@ -147,17 +202,32 @@ int xroe_sysfs_stats_init(void)
 	kobj_dir_stats = kobject_create_and_add("stats", root_xroe_kobj);
 	if (!kobj_dir_stats)
 		return -ENOMEM;
-	for (i = 0; i < MAX_NUM_ETH_PORTS; i++) {
+	ret = sysfs_create_bin_file(kobj_dir_stats, &bin_attr_snapshot);
+	if (ret)
+		goto err_stats;
+	for (i = 0; i < lp->num_eth_ports; i++) {
 		snprintf(eth_port_dir_name, sizeof(eth_port_dir_name),
 			 "eth_port_%d", i);
 		kobj_dir_eth_ports[i] =
 		kobject_create_and_add(eth_port_dir_name, kobj_dir_stats);
-		if (!kobj_dir_eth_ports[i])
-			return -ENOMEM;
+		if (!kobj_dir_eth_ports[i]) {
+			ret = -ENOMEM;
+			goto err_ports;
+		}
 		ret = sysfs_create_group(kobj_dir_eth_ports[i], *stats_groups);
-		if (ret)
+		if (ret) {
 			kobject_put(kobj_dir_eth_ports[i]);
+			goto err_ports;
+		}
 	}
 
+	return 0;
+
+err_ports:
+	while (i--)
+		kobject_put(kobj_dir_eth_ports[i]);
+	sysfs_remove_bin_file(kobj_dir_stats, &bin_attr_snapshot);
+err_stats:
+	kobject_put(kobj_dir_stats);
 	return ret;
 }
@@ -63,9 +63,17 @@ static int framer_probe(struct platform_device *pdev)
 	lp->base_addr = devm_ioremap_resource(&pdev->dev, r_mem);
 	if (IS_ERR(lp->base_addr))
 		return PTR_ERR(lp->base_addr);
+	lp->mem_start = r_mem->start;
+	lp->mem_end = r_mem->end;
+	spin_lock_init(&lp->reg_lock);
+	lp->num_eth_ports = utils_num_eth_ports();
+	dev_info(dev, "%d Ethernet port(s)\n", lp->num_eth_ports);
 
 	dev_set_drvdata(dev, lp);
 	xroe_sysfs_init();
+	rc = xroe_cdev_init(dev);
+	if (rc)
+		dev_err(dev, "Could not register /dev/xroe/ip (%d)\n", rc);
 	/* Get IRQ for the device */
 	/*
 	 * TODO: No IRQ *yet* in the DT from the framer block, as it's still
@@ -124,6 +132,7 @@ static int __init framer_init(void)
  */
 static void __exit framer_exit(void)
 {
+	xroe_cdev_exit();
 	xroe_sysfs_exit();
 	platform_driver_unregister(&framer_driver);
 	pr_info("XROE Framer exit\n");
@@ -14,22 +14,23 @@
 #include <linux/ioctl.h>
 #include <linux/kernel.h>
 #include <linux/kobject.h>
+#include <linux/miscdevice.h>
 #include <linux/module.h>
 #include <linux/of_address.h>
 #include <linux/of_device.h>
 #include <linux/of_platform.h>
 #include <linux/slab.h>
+#include <linux/spinlock.h>
 #include <linux/stat.h>
 #include <linux/string.h>
 #include <linux/sysfs.h>
 #include <linux/uaccess.h>
 #include <uapi/linux/stat.h> /* S_IRUSR, S_IWUSR */
 
-/* TODO: Remove hardcoded value of number of Ethernet ports and read the value
- * from the device tree.
- * For now user must modify these values to reflect the HW
+/* Maximum number of Ethernet ports. The number present is read from
+ * CFG_CONFIG_NO_OF_ETH_PORTS at probe time into framer_local.num_eth_ports
  */
-#define MAX_NUM_ETH_PORTS         0x1
+#define MAX_NUM_ETH_PORTS         0x4
 #define MAX_NUM_ORAN_CC           2
 #define MAX_NUM_ORAN_DL_DATA_PTR  5
 
@@ -43,6 +44,29 @@
 #define ADDR_LOOP_OFFSET_FILTER       0x20
 #define ADDR_LOOP_OFFSET_DL_DATA_PTR  0x4
 
+/* IOCTL commands, using 0xF5 as the magic number */
+#define XROE_FRAMER_MAGIC_NUMBER  0xF5
+#define XROE_FRAMER_IOSET	_IOW(XROE_FRAMER_MAGIC_NUMBER, 0, u32)
+#define XROE_FRAMER_IOGET	_IOR(XROE_FRAMER_MAGIC_NUMBER, 1, u32)
+#define XROE_FRAMER_IOBATCH	_IOWR(XROE_FRAMER_MAGIC_NUMBER, 2, \
+				      struct xroe_reg_batch)
+
+/* Maximum number of register operations in one XROE_FRAMER_IOBATCH call */
+#define XROE_REG_BATCH_MAX_OPS	1024
+
+/* Register operation types for XROE_FRAMER_IOBATCH */
+#define XROE_REG_OP_READ	0
+#define XROE_REG_OP_WRITE	1
+#define XROE_REG_OP_RMW		2
+
+/* Layout version of the /sys/kernel/xroe/stats/snapshot binary attribute */
+#define XROE_STATS_SNAPSHOT_VERSION	1
+
+/* Number of 32-bit statistics registers per Ethernet port in a snapshot */
+#define XROE_STATS_SNAPSHOT_WORDS \
+	(((STATS_ETH_STATS_USER_CTRL_RX_PKTS_RATE_ADDR - \
+	   STATS_ETH_STATS_TOTAL_RX_GOOD_PKT_CNT_ADDR) >> 2) + 1)
+
 
 /* TODO: to be made static as well, so that multiple instances can be used. As
  * of now, the following 3 structures are shared among the multiple
@@ -55,8 +79,52 @@ struct framer_local {
 	unsigned long mem_start;
 	unsigned long mem_end;
 	void __iomem *base_addr;
+	spinlock_t reg_lock; /* serialises register accesses from userspace */
+	int num_eth_ports;
 };
 
+/* Argument of XROE_FRAMER_IOGET/XROE_FRAMER_IOSET */
+struct xroe_ioctl_args {
+	u32 __user *offset;
+	u32 __user *value;
+};
+
+/*
+ * One entry of an XROE_FRAMER_IOBATCH transaction. For XROE_REG_OP_READ the
+ * field value ((reg & mask) >> offset) is returned in value. XROE_REG_OP_WRITE
+ * writes (value << offset) & mask to the whole register and
+ * XROE_REG_OP_RMW only replaces the bits selected by mask
+ */
+struct xroe_reg_op {
+	u32 addr;
+	u32 mask;
+	u32 offset;
+	u32 value;
+	u32 op;
+};
+
+/* Argument of XROE_FRAMER_IOBATCH, ops is a user pointer to num_ops entries */
+struct xroe_reg_batch {
+	u64 ops;
+	u32 num_ops;
+	u32 reserved;
+};
+
+/*
+ * Content of /sys/kernel/xroe/stats/snapshot. words[port] holds the raw
+ * STATS_ETH_STATS registers of the port, in address order, all read under the
+ * register lock so that the counters of a snapshot are consistent. The
+ * snapshot is taken on every read, so it must be read in a single read() call
+ */
+struct xroe_stats_snapshot {
+	u32 version;
+	u32 num_ports;
+	u32 num_words;
+	u32 reserved;
+	u64 timestamp_ns;
+	u32 words[MAX_NUM_ETH_PORTS][XROE_STATS_SNAPSHOT_WORDS];
+} __packed;
+
 struct xroe_reg_attribute {
 	struct kobj_attribute attr;
 	u32 offset;
@@ -70,5 +138,8 @@ int xroe_sysfs_shared_init(void);
 int xroe_sysfs_defm_init(void);
 int xroe_sysfs_cfg_init(void);
 void xroe_sysfs_exit(void);
+int xroe_cdev_init(struct device *dev);
+void xroe_cdev_exit(void);
 int utils_write32withmask(void __iomem *working_address, u32 value, u32 mask,
 			  u32 offset);
+int utils_num_eth_ports(void);
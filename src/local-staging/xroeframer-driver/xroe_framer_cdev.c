@@ -0,0 +1,298 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2019 Xilinx, Inc.
+ *
+ * Vasileios Bimpikas <vasileios.bimpikas@xilinx.com>
+ */
+
+#include <linux/fs.h>
+#include <linux/io.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
+#include "xroe_framer.h"
+
+/**
+ * xroe_range_valid - Checks that a block of registers is inside the framer
+ * @off:	The offset from the start of the framer address space
+ * @count:	The number of bytes accessed, at least 4
+ *
+ * Return: true if off and count are 32-bit aligned and the whole block is
+ * inside the mapped resource
+ */
+static bool xroe_range_valid(loff_t off, size_t count)
+{
+	u64 size = (u64)lp->mem_end - lp->mem_start + 1;
+
+	return off >= 0 && !(off & 0x3) && !(count & 0x3) &&
+	       size >= sizeof(u32) && (u64)off <= size - sizeof(u32) &&
+	       count <= size - off;
+}
+
+/**
+ * xroe_reg_valid - Checks that an offset is a register inside the framer
+ * @addr:	The offset from the start of the framer address space
+ *
+ * Return: true if addr is 32-bit aligned and inside the mapped resource
+ */
+static bool xroe_reg_valid(u32 addr)
+{
+	return xroe_range_valid(addr, sizeof(u32));
+}
+
+/**
+ * xroe_ip_read - Reads a block of registers
+ * @filp:	The file pointer
+ * @buf:	The user buffer to copy the register values into
+ * @count:	The number of bytes to read, a multiple of 4
+ * @ppos:	The offset in the framer address space
+ *
+ * The registers are read under the register lock, into a kernel buffer
+ * copied out once the lock is released
+ *
+ * Return: the number of bytes read or a negative errno on error
+ */
+static ssize_t xroe_ip_read(struct file *filp, char __user *buf, size_t count,
+			    loff_t *ppos)
+{
+	unsigned long flags;
+	u32 *values;
+	size_t i;
+	ssize_t ret = count;
+
+	if (!count)
+		return 0;
+	if (!xroe_range_valid(*ppos, count))
+		return -EINVAL;
+
+	values = kvmalloc(count, GFP_KERNEL);
+	if (!values)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&lp->reg_lock, flags);
+	for (i = 0; i < count / sizeof(u32); i++)
+		values[i] = ioread32(lp->base_addr + *ppos + i * sizeof(u32));
+	spin_unlock_irqrestore(&lp->reg_lock, flags);
+
+	if (copy_to_user(buf, values, count))
+		ret = -EFAULT;
+	else
+		*ppos += count;
+
+	kvfree(values);
+	return ret;
+}
+
+/**
+ * xroe_ip_write - Writes a block of registers
+ * @filp:	The file pointer
+ * @buf:	The user buffer containing the register values
+ * @count:	The number of bytes to write, a multiple of 4
+ * @ppos:	The offset in the framer address space
+ *
+ * The values are copied in first, then written under the register lock
+ *
+ * Return: the number of bytes written or a negative errno on error
+ */
+static ssize_t xroe_ip_write(struct file *filp, const char __user *buf,
+			     size_t count, loff_t *ppos)
+{
+	unsigned long flags;
+	u32 *values;
+	size_t i;
+
+	if (!count)
+		return 0;
+	if (!xroe_range_valid(*ppos, count))
+		return -EINVAL;
+
+	values = vmemdup_user(buf, count);
+	if (IS_ERR(values))
+		return PTR_ERR(values);
+
+	spin_lock_irqsave(&lp->reg_lock, flags);
+	for (i = 0; i < count / sizeof(u32); i++)
+		iowrite32(values[i], lp->base_addr + *ppos + i * sizeof(u32));
+	spin_unlock_irqrestore(&lp->reg_lock, flags);
+
+	kvfree(values);
+	*ppos += count;
+
+	return count;
+}
+
+/**
+ * xroe_ip_batch - Executes a list of register operations
+ * @arg:	User pointer to a struct xroe_reg_batch
+ *
+ * Copies the whole operation list from userspace, validates every address and
+ * then executes all operations in order while holding the register lock, so
+ * that the transaction is atomic with respect to the other reads, writes and
+ * ioctls of the device. Results of read operations are copied back in a
+ * single pass
+ *
+ * Return: 0 on success or a negative errno on error
+ */
+static long xroe_ip_batch(unsigned long arg)
+{
+	struct xroe_reg_batch batch;
+	struct xroe_reg_op *ops;
+	void __iomem *working_address;
+	unsigned long flags;
+	size_t size;
+	u32 value;
+	u32 i;
+	long ret = 0;
+
+	if (copy_from_user(&batch, (void __user *)arg, sizeof(batch)))
+		return -EFAULT;
+	if (!batch.num_ops || batch.num_ops > XROE_REG_BATCH_MAX_OPS)
+		return -EINVAL;
+
+	size = batch.num_ops * sizeof(*ops);
+	ops = kmalloc(size, GFP_KERNEL);
+	if (!ops)
+		return -ENOMEM;
+	if (copy_from_user(ops, u64_to_user_ptr(batch.ops), size)) {
+		ret = -EFAULT;
+		goto out;
+	}
+
+	for (i = 0; i < batch.num_ops; i++) {
+		if (!xroe_reg_valid(ops[i].addr) || ops[i].offset > 31 ||
+		    ops[i].op > XROE_REG_OP_RMW) {
+			ret = -EINVAL;
+			goto out;
+		}
+	}
+
+	spin_lock_irqsave(&lp->reg_lock, flags);
+	for (i = 0; i < batch.num_ops; i++) {
+		working_address = lp->base_addr + ops[i].addr;
+		switch (ops[i].op) {
+		case XROE_REG_OP_READ:
+			value = ioread32(working_address);
+			ops[i].value = (value & ops[i].mask) >> ops[i].offset;
+			break;
+		case XROE_REG_OP_WRITE:
+			iowrite32((ops[i].value << ops[i].offset) & ops[i].mask,
+				  working_address);
+			break;
+		case XROE_REG_OP_RMW:
+			utils_write32withmask(working_address, ops[i].value,
+					      ops[i].mask, ops[i].offset);
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&lp->reg_lock, flags);
+
+	if (copy_to_user(u64_to_user_ptr(batch.ops), ops, size))
+		ret = -EFAULT;
+out:
+	kfree(ops);
+	return ret;
+}
+
+/**
+ * xroe_ip_ioctl - The ioctl handler of /dev/xroe/ip
+ * @filp:	The file pointer
+ * @cmd:	XROE_FRAMER_IOGET, XROE_FRAMER_IOSET or XROE_FRAMER_IOBATCH
+ * @arg:	User pointer to the command's argument structure
+ *
+ * Return: 0 on success or a negative errno on error
+ */
+static long xroe_ip_ioctl(struct file *filp, unsigned int cmd,
+			  unsigned long arg)
+{
+	struct xroe_ioctl_args args;
+	unsigned long flags;
+	u32 addr, value;
+
+	if (cmd == XROE_FRAMER_IOBATCH)
+		return xroe_ip_batch(arg);
+
+	if (copy_from_user(&args, (void __user *)arg, sizeof(args)))
+		return -EFAULT;
+	if (get_user(addr, args.offset))
+		return -EFAULT;
+	if (!xroe_reg_valid(addr))
+		return -EINVAL;
+
+	switch (cmd) {
+	case XROE_FRAMER_IOGET:
+		spin_lock_irqsave(&lp->reg_lock, flags);
+		value = ioread32(lp->base_addr + addr);
+		spin_unlock_irqrestore(&lp->reg_lock, flags);
+		return put_user(value, args.value);
+	case XROE_FRAMER_IOSET:
+		if (get_user(value, args.value))
+			return -EFAULT;
+		spin_lock_irqsave(&lp->reg_lock, flags);
+		iowrite32(value, lp->base_addr + addr);
+		spin_unlock_irqrestore(&lp->reg_lock, flags);
+		return 0;
+	default:
+		return -ENOTTY;
+	}
+}
+
+/**
+ * xroe_ip_mmap - Maps the framer register window into userspace
+ * @filp:	The file pointer
+ * @vma:	The virtual memory area to map the registers into
+ *
+ * Return: 0 on success or a negative errno on error
+ */
+static int xroe_ip_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+
+	return vm_iomap_memory(vma, lp->mem_start,
+			       lp->mem_end - lp->mem_start + 1);
+}
+
+static const struct file_operations xroe_ip_fops = {
+	.owner = THIS_MODULE,
+	.llseek = default_llseek,
+	.read = xroe_ip_read,
+	.write = xroe_ip_write,
+	.unlocked_ioctl = xroe_ip_ioctl,
+	.mmap = xroe_ip_mmap,
+};
+
+static struct miscdevice xroe_ip_miscdev = {
+	.minor = MISC_DYNAMIC_MINOR,
+	.name = "xroe_ip",
+	.nodename = "xroe/ip",
+	.fops = &xroe_ip_fops,
+};
+
+static bool xroe_ip_registered;
+
+/**
+ * xroe_cdev_init - Registers the /dev/xroe/ip character device
+ * @dev:	The framer platform device, used as the parent
+ *
+ * Return: 0 on success or a negative errno on error
+ */
+int xroe_cdev_init(struct device *dev)
+{
+	int ret;
+
+	xroe_ip_miscdev.parent = dev;
+	ret = misc_register(&xroe_ip_miscdev);
+	xroe_ip_registered = !ret;
+
+	return ret;
+}
+
+/**
+ * xroe_cdev_exit - Removes the /dev/xroe/ip character device
+ */
+void xroe_cdev_exit(void)
+{
+	if (xroe_ip_registered)
+		misc_deregister(&xroe_ip_miscdev);
+	xroe_ip_registered = false;
+}
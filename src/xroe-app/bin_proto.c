@@ -0,0 +1,394 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file bin_proto.c
+* @addtogroup command_parser
+* @{
+*
+*  Server side of the binary command protocol, see xroe_bin.h
+*
+*  Requests are answered from the same module APIs as the text commands,
+*  with the values packed as they are instead of formatted. Each reply is
+*  built in a response, so that it is sent the same way as a text reply.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <endian.h>
+
+#include <xroe_types.h>
+#include <xroe_api.h>
+#include <roe_framer_fields.h>
+#include <radio_ctrl.h>
+#include <stats_sampler.h>
+#include <xroe_bin.h>
+#include <bin_proto.h>
+
+/**
+ * PROTO_BIN_MAX_REPLY Largest reply data, that of XROE_BIN_OP_RADIO for all
+ * antennas.
+ */
+#define PROTO_BIN_MAX_REPLY (sizeof(xroe_bin_radio_t) + MAX_NUMBER_OF_ANTENNAS * sizeof(xroe_bin_antenna_t))
+
+/* Access of a field, indexed by its identifier */
+#define PROTO_BIN_ACCESS(_id, _name, _reg, _stride, _access) _access,
+
+/************************** Variable Definitions *****************************/
+static const int ProtoBinAccess[XROE_NUM_FIELDS] = {
+	XROE_CTRL_FIELDS(PROTO_BIN_ACCESS)
+	XROE_FRAM_DRP_FIELDS(PROTO_BIN_ACCESS)
+	XROE_DEFM_DRP_FIELDS(PROTO_BIN_ACCESS)
+};
+
+/*****************************************************************************/
+/**
+*
+* Turns the return value of a module API into the status of a reply.
+*
+* @param [in]	ret   Return value, 0 or an errno value.
+*
+* @return
+*		- Status, EIO for values not fitting
+*
+******************************************************************************/
+static uint8_t proto_bin_status(int ret)
+{
+	return ((ret < 0) || (ret > 0xff)) ? EIO : (uint8_t)ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Packs the totals of the statistics counters of a port.
+*
+* @param [in]	index   Port, or XROE_BIN_ALL.
+* @param [out]	data    Reply data.
+* @param [out]	pLen    Length of the reply data.
+*
+* @return
+*		- 0 on success
+*		- errno value of the statistics module
+*
+******************************************************************************/
+static int proto_bin_stats(unsigned int index, uint8_t *data, uint32_t *pLen)
+{
+	xroe_bin_stats_t *pStats = (xroe_bin_stats_t *)data;
+	sampler_total_t total;
+	int port = (index == XROE_BIN_ALL) ? SAMPLER_ALL_PORTS : (int)index;
+	int num = SAMPLER_API_Num_Counters();
+	int ret;
+	int i;
+
+	if((port != SAMPLER_ALL_PORTS) && (port >= SAMPLER_API_Num_Ports()))
+	{
+		return EINVAL;
+	}
+	if(num > (int)((PROTO_BIN_MAX_REPLY - sizeof(*pStats)) / sizeof(uint64_t)))
+	{
+		num = (PROTO_BIN_MAX_REPLY - sizeof(*pStats)) / sizeof(uint64_t);
+	}
+
+	ret = SAMPLER_API_Refresh();
+	if(ret)
+	{
+		return ret;
+	}
+
+	pStats->Port = htole32(index);
+	pStats->NumCounters = htole32(num);
+	for(i = 0; i < num; i++)
+	{
+		if(SAMPLER_API_Total(port, i, &total))
+		{
+			total.Total = 0;
+		}
+		pStats->Totals[i] = htole64(total.Total);
+	}
+	*pLen = sizeof(*pStats) + num * sizeof(uint64_t);
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Packs the radio status, and the buffer state of one or all antennas.
+*
+* @param [in]	index   Antenna, or XROE_BIN_ALL.
+* @param [out]	data    Reply data.
+* @param [out]	pLen    Length of the reply data.
+*
+* @return
+*		- 0 on success
+*		- EINVAL if the antenna is not present
+*		- errno value of the radio module
+*
+******************************************************************************/
+static int proto_bin_radio(unsigned int index, uint8_t *data, uint32_t *pLen)
+{
+	xroe_bin_radio_t *pRadio = (xroe_bin_radio_t *)data;
+	xroe_bin_antenna_t *pAntenna;
+	single_antenna_status_struct *pStatus;
+	radio_ctrl_struct radio;
+	antennas_status_struct antennas;
+	int first = 0;
+	int num;
+	int ret;
+	int i;
+
+	ret = RADIO_CTRL_Get_Status(&radio, &antennas);
+	if(ret)
+	{
+		return ret;
+	}
+
+	num = antennas.NumOfAntennas;
+	if(num > MAX_NUMBER_OF_ANTENNAS)
+	{
+		num = MAX_NUMBER_OF_ANTENNAS;
+	}
+	if(index != XROE_BIN_ALL)
+	{
+		if((int)index >= num)
+		{
+			return EINVAL;
+		}
+		first = index;
+		num = 1;
+	}
+
+	pRadio->Enable = htole32(radio.Enable);
+	pRadio->Error = htole32(radio.Error);
+	pRadio->Status = htole32(radio.Status);
+	pRadio->Loopback = htole32(radio.Loopback);
+	pRadio->FirstAntenna = htole32(first);
+	pRadio->NumAntennas = htole32(num);
+	for(i = 0; i < num; i++)
+	{
+		pStatus = &antennas.Antenna[first + i];
+		pAntenna = &pRadio->Antennas[i];
+		pAntenna->Align = htole32(pStatus->Align);
+		pAntenna->Regular = htole32(pStatus->Regular);
+		pAntenna->Overflow = htole32(pStatus->Overflow);
+		pAntenna->Underflow = htole32(pStatus->Underflow);
+		pAntenna->CheckError = htole32(pStatus->CheckError);
+		pAntenna->BufStateLatency = htole32(pStatus->BufStateLatency);
+	}
+	*pLen = sizeof(*pRadio) + num * sizeof(*pAntenna);
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Tells whether the first bytes of a connection are those of a binary
+* request.
+*
+* @param [in]	data   Bytes received.
+* @param [in]	len    Number of bytes, at least 1.
+*
+* @return
+*		- 1 for a binary request, or a first byte that can only start one
+*		- 0 otherwise
+*
+******************************************************************************/
+int proto_bin_detect(const uint8_t *data, int len)
+{
+	if(data[0] != (XROE_BIN_MAGIC & 0xff))
+	{
+		return 0;
+	}
+	return (len < 2) || (data[1] == (XROE_BIN_MAGIC >> 8));
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the length of the request at the start of the bytes received.
+*
+* @param [in]	data   Bytes received.
+* @param [in]	len    Number of bytes.
+*
+* @return
+*		- Length of the request, header and value
+*		- 0 if the request is not complete yet
+*		- -1 if the bytes are not a request, or its value is too long
+*
+******************************************************************************/
+int proto_bin_frame_length(const uint8_t *data, int len)
+{
+	xroe_bin_request_t req;
+	int length;
+
+	if(len < (int)sizeof(req))
+	{
+		return 0;
+	}
+
+	memcpy(&req, data, sizeof(req));
+	if((le16toh(req.Magic) != XROE_BIN_MAGIC) || (le16toh(req.Length) > XROE_BIN_MAX_VALUE))
+	{
+		return -1;
+	}
+
+	length = sizeof(req) + le16toh(req.Length);
+	return (length > len) ? 0 : length;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns whether a request is a short register or version access, rather
+* than one reading the statistics or radio status of every port or antenna.
+*
+* @param [in]	frame   Request, of the length given by
+*                       proto_bin_frame_length().
+*
+* @return
+*		- 1 for register, field and version requests
+*		- 0 for XROE_BIN_OP_STATS and XROE_BIN_OP_RADIO
+*
+******************************************************************************/
+int proto_bin_is_short(const uint8_t *frame)
+{
+	xroe_bin_request_t req;
+
+	memcpy(&req, frame, sizeof(req));
+	return (req.Opcode != XROE_BIN_OP_STATS) && (req.Opcode != XROE_BIN_OP_RADIO);
+}
+
+/*****************************************************************************/
+/**
+*
+* Runs a complete request and appends its reply to a response.
+*
+* @param [in]		frame   Request, of the length given by
+*                           proto_bin_frame_length().
+* @param [in,out]	resp    Response to append the reply to.
+*
+******************************************************************************/
+void proto_bin_handle(const uint8_t *frame, response_t *resp)
+{
+	xroe_bin_request_t req;
+	xroe_bin_reply_t reply;
+	xroe_bin_version_t *pVersion;
+	xroe_bin_reg_t *pReg;
+	const uint8_t *value = frame + sizeof(req);
+	uint8_t data[PROTO_BIN_MAX_REPLY];
+	unsigned int major = 0;
+	unsigned int minor = 0;
+	unsigned int revision = 0;
+	unsigned int reg = 0;
+	uint32_t len = 0;
+	uint32_t addr;
+	uint32_t word = 0;
+	int ret = 0;
+
+	memcpy(&req, frame, sizeof(req));
+	req.Field = le16toh(req.Field);
+	req.Length = le16toh(req.Length);
+
+	switch(req.Opcode)
+	{
+		case XROE_BIN_OP_VERSION:
+			xroe_get_cfg_major_revision(0, &major);
+			xroe_get_cfg_minor_revision(0, &minor);
+			xroe_get_cfg_version_revision(0, &revision);
+			pVersion = (xroe_bin_version_t *)data;
+			pVersion->Protocol = htole32(XROE_BIN_VERSION);
+			pVersion->Major = htole32(major);
+			pVersion->Minor = htole32(minor);
+			pVersion->Revision = htole32(revision);
+			len = sizeof(*pVersion);
+			break;
+
+		case XROE_BIN_OP_PEEK:
+			if(req.Length != sizeof(addr))
+			{
+				ret = EINVAL;
+				break;
+			}
+			memcpy(&addr, value, sizeof(addr));
+			addr = le32toh(addr);
+			ret = IP_API_Read(addr, (uint8_t *)&word, sizeof(word));
+			pReg = (xroe_bin_reg_t *)data;
+			pReg->Addr = htole32(addr);
+			pReg->Value = htole32(word);
+			len = sizeof(*pReg);
+			break;
+
+		case XROE_BIN_OP_POKE:
+			if(req.Length != sizeof(*pReg))
+			{
+				ret = EINVAL;
+				break;
+			}
+			pReg = (xroe_bin_reg_t *)data;
+			memcpy(pReg, value, sizeof(*pReg));
+			addr = le32toh(pReg->Addr);
+			word = le32toh(pReg->Value);
+			ret = IP_API_Write(addr, (uint8_t *)&word, sizeof(word));
+			len = sizeof(*pReg);
+			break;
+
+		case XROE_BIN_OP_FIELD_GET:
+			if((req.Field >= XROE_NUM_FIELDS) || (req.Index >= MAX_NUMBER_OF_ANTENNAS))
+			{
+				ret = EINVAL;
+				break;
+			}
+			ret = xroe_field_get(req.Field, req.Index, &reg);
+			word = htole32(reg);
+			memcpy(data, &word, sizeof(word));
+			len = sizeof(word);
+			break;
+
+		case XROE_BIN_OP_FIELD_SET:
+			if((req.Field >= XROE_NUM_FIELDS) || (ProtoBinAccess[req.Field] != XROE_FIELD_RW) ||
+			   (req.Index >= MAX_NUMBER_OF_ANTENNAS) || (req.Length != sizeof(word)))
+			{
+				ret = EINVAL;
+				break;
+			}
+			memcpy(&word, value, sizeof(word));
+			ret = xroe_field_set(req.Field, req.Index, le32toh(word));
+			break;
+
+		case XROE_BIN_OP_STATS:
+			ret = proto_bin_stats(req.Index, data, &len);
+			break;
+
+		case XROE_BIN_OP_RADIO:
+			ret = proto_bin_radio(req.Index, data, &len);
+			break;
+
+		default:
+			ret = EOPNOTSUPP;
+			break;
+	}
+
+	reply.Magic = htole16(XROE_BIN_MAGIC);
+	reply.Opcode = req.Opcode;
+	reply.Status = proto_bin_status(ret);
+	reply.Tag = req.Tag;
+	if(reply.Status)
+	{
+		len = 0;
+	}
+	reply.Length = htole32(len);
+
+	resp_write(resp, &reply, sizeof(reply));
+	if(len)
+	{
+		resp_write(resp, data, len);
+	}
+}
+/** @} */
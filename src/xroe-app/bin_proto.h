@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file bin_proto.h
+* @addtogroup command_parser
+* @{
+*
+*  Server side of the binary command protocol, see xroe_bin.h
+*
+******************************************************************************/
+#ifndef BIN_PROTO_H		/* prevent circular inclusions */
+#define BIN_PROTO_H		/* by using protection macros */
+
+#include <stdint.h>
+#include <response.h>
+
+/************************** Function Prototypes ******************************/
+int proto_bin_detect(const uint8_t *data, int len);
+int proto_bin_frame_length(const uint8_t *data, int len);
+int proto_bin_is_short(const uint8_t *frame);
+void proto_bin_handle(const uint8_t *frame, response_t *resp);
+#endif /* end of protection macro */
+/** @} */
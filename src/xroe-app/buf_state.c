@@ -0,0 +1,630 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file buf_state.c
+* @addtogroup framer_driver_api
+* @{
+*
+*  Tracker of the deframer buffer state of every antenna
+*
+*  BUFSTATE_API_Timeout() and BUFSTATE_API_Poll() are called from the main
+*  loop, in the same way as the statistics sampler. All the fields of a
+*  buffer state are in one register, so each sample reads a single word per
+*  buffer and antenna in one IP_API_Batch() transaction and decodes the
+*  fields from it with the detected register layout.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+#define _GNU_SOURCE /* PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <roe_framer_fields.h>
+#include <xroe_api.h>
+#include <buf_state.h>
+
+#define BUFSTATE_NS_PER_SEC 1000000000ULL
+#define BUFSTATE_NS_PER_MS 1000000ULL
+
+/**
+ * bufstate_fields_struct Register fields of a buffer state.
+ */
+typedef struct bufstate_fields_struct{
+	xroe_field_id_t Flags[BUFSTATE_NUM_FLAGS];
+	xroe_field_id_t Rwin;
+	xroe_field_id_t Latency; /**< Also gives the address of the register */
+} bufstate_fields_struct;
+
+/**
+ * BufStateFields Register fields of the data and control buffer states.
+ */
+static const bufstate_fields_struct BufStateFields[BUFSTATE_NUM_BUFFERS] = {
+	[BUFSTATE_DATA] = {
+		{XROE_FIELD_defm_dbs_alignment, XROE_FIELD_defm_dbs_regular,
+		 XROE_FIELD_defm_dbs_overflow, XROE_FIELD_defm_dbs_underflow},
+		XROE_FIELD_defm_dbs_rwin, XROE_FIELD_defm_dbs_latency},
+	[BUFSTATE_CTRL] = {
+		{XROE_FIELD_defm_cbs_alignment, XROE_FIELD_defm_cbs_regular,
+		 XROE_FIELD_defm_cbs_overflow, XROE_FIELD_defm_cbs_underflow},
+		XROE_FIELD_defm_cbs_rwin, XROE_FIELD_defm_cbs_latency},
+};
+
+/**
+ * BufStateFlagNames Names of the state flags.
+ */
+static const char *BufStateFlagNames[BUFSTATE_NUM_FLAGS] = {
+	[BUFSTATE_ALIGN] = "align",
+	[BUFSTATE_REGULAR] = "regular",
+	[BUFSTATE_OVERFLOW] = "overflow",
+	[BUFSTATE_UNDERFLOW] = "underflow",
+};
+
+/**
+ * bufstate_struct State of the tracker.
+ */
+typedef struct bufstate_struct{
+	int PeriodMs;     /**< 0 when stopped */
+	uint64_t NextNs;
+	uint64_t StartMs; /**< Wall clock time of the start */
+	int NumAntennas;
+	xroe_reg_op_t Ops[BUFSTATE_MAX_ANTENNAS * BUFSTATE_NUM_BUFFERS];
+	bufstate_history_t History[BUFSTATE_MAX_ANTENNAS][BUFSTATE_NUM_BUFFERS];
+} bufstate_struct;
+
+/**
+ * BufState Tracker state and histories.
+ */
+static bufstate_struct BufState;
+
+/**
+ * BufStateLock Serialises the tracker between the main loop and the command
+ * threads. Recursive, as the API functions call each other.
+ */
+static pthread_mutex_t BufStateLock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+/*****************************************************************************/
+/**
+*
+* Returns the time of a clock in nanoseconds.
+*
+* @param [in]	clock   Clock to read.
+*
+* @return
+*		- Clock time in nanoseconds
+*
+******************************************************************************/
+static uint64_t bufstate_clock_ns(clockid_t clock)
+{
+	struct timespec now;
+
+	clock_gettime(clock, &now);
+	return (uint64_t)now.tv_sec * BUFSTATE_NS_PER_SEC + now.tv_nsec;
+}
+
+/*****************************************************************************/
+/**
+*
+* Extracts a field from the buffer state register.
+*
+* @param [in]	id      Field.
+* @param [in]	word    Register value.
+*
+* @return
+*		- Field value
+*
+******************************************************************************/
+static unsigned int bufstate_field(xroe_field_id_t id, uint32_t word)
+{
+	return (word & XroeFields[id].mask) >> XroeFields[id].offset;
+}
+
+/*****************************************************************************/
+/**
+*
+* Checks that every field of a buffer state is in the register of its
+* latency field, as the tracker reads the whole register once.
+*
+* @param [in]	buffer   Buffer to check.
+*
+* @return
+*		- 0 if the fields can be decoded from one register read
+*		- ENODEV otherwise
+*
+******************************************************************************/
+static int bufstate_check_fields(int buffer)
+{
+	const bufstate_fields_struct *fields = &BufStateFields[buffer];
+	const xroe_field_layout_t *latency = &XroeFields[fields->Latency];
+	int i;
+
+	if(!latency->mask || !XroeFields[fields->Rwin].mask || (XroeFields[fields->Rwin].addr != latency->addr))
+	{
+		return ENODEV;
+	}
+
+	for(i = 0; i < BUFSTATE_NUM_FLAGS; i++)
+	{
+		if(!XroeFields[fields->Flags[i]].mask || (XroeFields[fields->Flags[i]].addr != latency->addr))
+		{
+			return ENODEV;
+		}
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the histogram bucket of a latency.
+*
+* @param [in]	latency   Latency field value.
+*
+* @return
+*		- 0 for 0, n for [2^(n-1), 2^n)
+*
+******************************************************************************/
+static int bufstate_bucket(unsigned int latency)
+{
+	int bucket = 0;
+
+	while(latency && (bucket < BUFSTATE_LATENCY_BUCKETS - 1))
+	{
+		latency >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+/*****************************************************************************/
+/**
+*
+* Adds a sample of a buffer state register to the buffer's history.
+*
+* @param [in,out]	pHistory   History of the buffer.
+* @param [in]		buffer     Buffer sampled.
+* @param [in]		word       Register value.
+* @param [in]		now_ms     Wall clock time of the sample.
+*
+******************************************************************************/
+static void bufstate_add(bufstate_history_t *pHistory, int buffer, uint32_t word, uint64_t now_ms)
+{
+	const bufstate_fields_struct *fields = &BufStateFields[buffer];
+	bufstate_flag_history_t *pFlag;
+	unsigned int flags = 0;
+	unsigned int latency;
+	unsigned int rwin;
+	int i;
+
+	for(i = 0; i < BUFSTATE_NUM_FLAGS; i++)
+	{
+		if(!bufstate_field(fields->Flags[i], word))
+		{
+			continue;
+		}
+
+		flags |= 1 << i;
+		pFlag = &pHistory->FlagHistory[i];
+		pFlag->SetSamples++;
+		if(!pHistory->Samples || !(pHistory->Flags & (1 << i)))
+		{
+			pFlag->Rises++;
+			pFlag->LastRiseMs = now_ms;
+		}
+	}
+
+	rwin = bufstate_field(fields->Rwin, word) % BUFSTATE_RWIN_VALUES;
+	latency = bufstate_field(fields->Latency, word);
+	pHistory->Histogram[rwin][bufstate_bucket(latency)]++;
+
+	if(!pHistory->Samples)
+	{
+		pHistory->LatencyMin = pHistory->LatencyMax = latency;
+	}
+	else
+	{
+		pHistory->LatencyMin = (latency < pHistory->LatencyMin) ? latency : pHistory->LatencyMin;
+		pHistory->LatencyMax = (latency > pHistory->LatencyMax) ? latency : pHistory->LatencyMax;
+	}
+	pHistory->Flags = flags;
+	pHistory->Rwin = rwin;
+	pHistory->Latency = latency;
+	pHistory->Samples++;
+}
+
+/*****************************************************************************/
+/**
+*
+* Starts tracking, with BufStateLock held. See BUFSTATE_API_Start().
+*
+******************************************************************************/
+static int bufstate_api_start(int period_ms)
+{
+	unsigned int num_antennas = 0;
+	xroe_reg_op_t *op;
+	int buffer;
+	int i;
+
+	if(period_ms == 0)
+	{
+		BUFSTATE_API_Stop();
+		return 0;
+	}
+
+	if(period_ms < BUFSTATE_MIN_PERIOD_MS)
+	{
+		return EINVAL;
+	}
+
+	for(buffer = 0; buffer < BUFSTATE_NUM_BUFFERS; buffer++)
+	{
+		if(bufstate_check_fields(buffer))
+		{
+			return ENODEV;
+		}
+	}
+
+	/* Track the antennas the deframer was built with */
+	if(xroe_get_cfg_no_of_defm_ants(0, &num_antennas) || !num_antennas || (num_antennas > BUFSTATE_MAX_ANTENNAS))
+	{
+		num_antennas = BUFSTATE_MAX_ANTENNAS;
+	}
+
+	memset(&BufState, 0, sizeof(BufState));
+	BufState.NumAntennas = num_antennas;
+	for(i = 0; i < BufState.NumAntennas; i++)
+	{
+		for(buffer = 0; buffer < BUFSTATE_NUM_BUFFERS; buffer++)
+		{
+			op = &BufState.Ops[i * BUFSTATE_NUM_BUFFERS + buffer];
+			xroe_field_op(BufStateFields[buffer].Latency, i, op);
+			op->mask = 0xffffffff;
+			op->offset = 0;
+		}
+	}
+
+	BufState.PeriodMs = period_ms;
+	BufState.NextNs = bufstate_clock_ns(CLOCK_MONOTONIC);
+	BufState.StartMs = bufstate_clock_ns(CLOCK_REALTIME) / BUFSTATE_NS_PER_MS;
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Starts tracking, or changes the tracking period. The histories are
+* cleared.
+*
+* @param [in]	period_ms   Tracking period, 0 stops the tracker.
+*
+* @return
+*		- 0 on success
+*		- EINVAL if the period is below BUFSTATE_MIN_PERIOD_MS
+*		- ENODEV if the IP version has no per-antenna buffer state
+*
+******************************************************************************/
+int BUFSTATE_API_Start(int period_ms)
+{
+	int ret;
+
+	pthread_mutex_lock(&BufStateLock);
+	ret = bufstate_api_start(period_ms);
+	pthread_mutex_unlock(&BufStateLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Stops tracking, with BufStateLock held. See BUFSTATE_API_Stop().
+*
+******************************************************************************/
+static void bufstate_api_stop(void)
+{
+	BufState.PeriodMs = 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Stops tracking. The histories can still be queried.
+*
+******************************************************************************/
+void BUFSTATE_API_Stop(void)
+{
+	pthread_mutex_lock(&BufStateLock);
+	bufstate_api_stop();
+	pthread_mutex_unlock(&BufStateLock);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the tracking period, with BufStateLock held. See BUFSTATE_API_Period().
+*
+******************************************************************************/
+static int bufstate_api_period(void)
+{
+	return BufState.PeriodMs;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the tracking period.
+*
+* @return
+*		- Tracking period in milliseconds, 0 when stopped
+*
+******************************************************************************/
+int BUFSTATE_API_Period(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&BufStateLock);
+	ret = bufstate_api_period();
+	pthread_mutex_unlock(&BufStateLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the time until the next sample, with BufStateLock held. See BUFSTATE_API_Timeout().
+*
+******************************************************************************/
+static int bufstate_api_timeout(void)
+{
+	uint64_t now;
+
+	if(!BufState.PeriodMs)
+	{
+		return -1;
+	}
+
+	now = bufstate_clock_ns(CLOCK_MONOTONIC);
+	if(now >= BufState.NextNs)
+	{
+		return 0;
+	}
+
+	return (BufState.NextNs - now + BUFSTATE_NS_PER_MS - 1) / BUFSTATE_NS_PER_MS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns how long the main loop may wait before BUFSTATE_API_Poll() is due.
+*
+* @return
+*		- Milliseconds until the next sample
+*		- -1 when stopped
+*
+******************************************************************************/
+int BUFSTATE_API_Timeout(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&BufStateLock);
+	ret = bufstate_api_timeout();
+	pthread_mutex_unlock(&BufStateLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Samples the buffer states if due, with BufStateLock held. See BUFSTATE_API_Poll().
+*
+******************************************************************************/
+static int bufstate_api_poll(void)
+{
+	uint64_t now_ms;
+	uint64_t now;
+	int buffer;
+	int ret;
+	int i;
+
+	if(BUFSTATE_API_Timeout() != 0)
+	{
+		return 0;
+	}
+
+	/* Keep to the period, unless samples were missed altogether */
+	now = bufstate_clock_ns(CLOCK_MONOTONIC);
+	BufState.NextNs += BufState.PeriodMs * BUFSTATE_NS_PER_MS;
+	if(BufState.NextNs <= now)
+	{
+		BufState.NextNs = now + BufState.PeriodMs * BUFSTATE_NS_PER_MS;
+	}
+
+	ret = IP_API_Batch(BufState.Ops, BufState.NumAntennas * BUFSTATE_NUM_BUFFERS);
+	if(ret)
+	{
+		return ret;
+	}
+
+	now_ms = bufstate_clock_ns(CLOCK_REALTIME) / BUFSTATE_NS_PER_MS;
+	for(i = 0; i < BufState.NumAntennas; i++)
+	{
+		for(buffer = 0; buffer < BUFSTATE_NUM_BUFFERS; buffer++)
+		{
+			bufstate_add(&BufState.History[i][buffer], buffer, BufState.Ops[i * BUFSTATE_NUM_BUFFERS + buffer].value, now_ms);
+		}
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Samples the buffer state of all antennas if a sample is due.
+*
+* @return
+*		- 0 if nothing was due or on success
+*		- Return value of IP_API_Batch() on error, no sample is stored
+*
+******************************************************************************/
+int BUFSTATE_API_Poll(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&BufStateLock);
+	ret = bufstate_api_poll();
+	pthread_mutex_unlock(&BufStateLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the number of antennas tracked, with BufStateLock held. See BUFSTATE_API_Num_Antennas().
+*
+******************************************************************************/
+static int bufstate_api_num_antennas(void)
+{
+	return BufState.NumAntennas;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the number of antennas tracked.
+*
+* @return
+*		- Number of antennas, 0 if the tracker was never started
+*
+******************************************************************************/
+int BUFSTATE_API_Num_Antennas(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&BufStateLock);
+	ret = bufstate_api_num_antennas();
+	pthread_mutex_unlock(&BufStateLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the time tracking started, with BufStateLock held. See BUFSTATE_API_Start_Time().
+*
+******************************************************************************/
+static uint64_t bufstate_api_start_time(void)
+{
+	return BufState.StartMs;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the time the tracker was started.
+*
+* @return
+*		- Wall clock time in milliseconds, 0 if the tracker was never started
+*
+******************************************************************************/
+uint64_t BUFSTATE_API_Start_Time(void)
+{
+	uint64_t ret;
+
+	pthread_mutex_lock(&BufStateLock);
+	ret = bufstate_api_start_time();
+	pthread_mutex_unlock(&BufStateLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Copies the history of a buffer, with BufStateLock held. See BUFSTATE_API_History().
+*
+******************************************************************************/
+static int bufstate_api_history(int antenna, int buffer, bufstate_history_t *pHistory)
+{
+	if((antenna < 0) || (antenna >= BufState.NumAntennas) || (buffer < 0) || (buffer >= BUFSTATE_NUM_BUFFERS))
+	{
+		return EINVAL;
+	}
+
+	*pHistory = BufState.History[antenna][buffer];
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the history of a buffer of an antenna.
+*
+* @param [in]	antenna    Index of the antenna.
+* @param [in]	buffer     BUFSTATE_DATA or BUFSTATE_CTRL.
+* @param [out]	pHistory   Pointer to copy the history to.
+*
+* @return
+*		- 0 on success
+*		- EINVAL if the antenna or buffer is out of range
+*
+******************************************************************************/
+int BUFSTATE_API_History(int antenna, int buffer, bufstate_history_t *pHistory)
+{
+	int ret;
+
+	pthread_mutex_lock(&BufStateLock);
+	ret = bufstate_api_history(antenna, buffer, pHistory);
+	pthread_mutex_unlock(&BufStateLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the name of a state flag.
+*
+* @param [in]	flag   Index of the flag.
+*
+* @return
+*		- Name of the flag, NULL if out of range
+*
+******************************************************************************/
+const char *BUFSTATE_API_Flag_Name(int flag)
+{
+	return ((flag >= 0) && (flag < BUFSTATE_NUM_FLAGS)) ? BufStateFlagNames[flag] : NULL;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the lowest latency counted in a histogram bucket.
+*
+* @param [in]	bucket   Index of the bucket.
+*
+* @return
+*		- Lowest latency of the bucket
+*
+******************************************************************************/
+unsigned int BUFSTATE_API_Bucket_Low(int bucket)
+{
+	return bucket ? (1U << (bucket - 1)) : 0;
+}
+/** @} */
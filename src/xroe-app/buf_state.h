@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file buf_state.h
+* @addtogroup framer_driver_api
+* @{
+*
+*  Tracker of the deframer buffer state of every antenna
+*
+*  The tracker reads the data and control buffer state registers of all
+*  antennas at a fixed period from the application's main loop. For each
+*  buffer it counts the samples with each state flag set and the flag's
+*  rising edges, so that a single underflow between two status queries is
+*  still seen, and keeps a histogram of the buffer latency for each receive
+*  window setting.
+*
+******************************************************************************/
+#ifndef BUF_STATE_H		/* prevent circular inclusions */
+#define BUF_STATE_H		/* by using protection macros */
+
+#include <stdint.h>
+
+/* Shortest tracking period accepted, in milliseconds */
+#define BUFSTATE_MIN_PERIOD_MS 1
+
+/* Number of antennas tracked at most */
+#define BUFSTATE_MAX_ANTENNAS 8
+
+/* Histogram buckets: 0, then [2^(n-1), 2^n) up to the 24-bit latency field */
+#define BUFSTATE_LATENCY_BUCKETS 25
+
+/* Number of values of the 4-bit receive window field */
+#define BUFSTATE_RWIN_VALUES 16
+
+/***************************** Type Definitions ******************************/
+/**
+ * bufstate_buffer_t Deframer buffers of an antenna.
+ */
+typedef enum bufstate_buffer_t{
+	BUFSTATE_DATA,
+	BUFSTATE_CTRL,
+	BUFSTATE_NUM_BUFFERS
+} bufstate_buffer_t;
+
+/**
+ * bufstate_flag_t State flags of a buffer.
+ */
+typedef enum bufstate_flag_t{
+	BUFSTATE_ALIGN,
+	BUFSTATE_REGULAR,
+	BUFSTATE_OVERFLOW,
+	BUFSTATE_UNDERFLOW,
+	BUFSTATE_NUM_FLAGS
+} bufstate_flag_t;
+
+/**
+ * bufstate_flag_history_t History of a state flag.
+ */
+typedef struct bufstate_flag_history_t{
+	uint64_t SetSamples; /**< Samples with the flag set */
+	uint64_t Rises;      /**< Samples with the flag set after one without */
+	uint64_t LastRiseMs; /**< Wall clock time of the last rise, 0 if none */
+} bufstate_flag_history_t;
+
+/**
+ * bufstate_history_t History of a buffer since the tracker was started.
+ */
+typedef struct bufstate_history_t{
+	uint64_t Samples;
+	unsigned int Flags;      /**< Flags of the last sample, bit per bufstate_flag_t */
+	unsigned int Rwin;       /**< Receive window of the last sample */
+	unsigned int Latency;    /**< Latency of the last sample */
+	unsigned int LatencyMin;
+	unsigned int LatencyMax;
+	bufstate_flag_history_t FlagHistory[BUFSTATE_NUM_FLAGS];
+	uint64_t Histogram[BUFSTATE_RWIN_VALUES][BUFSTATE_LATENCY_BUCKETS];
+} bufstate_history_t;
+
+/************************** Function Prototypes ******************************/
+int BUFSTATE_API_Start(int period_ms);
+void BUFSTATE_API_Stop(void);
+int BUFSTATE_API_Period(void);
+int BUFSTATE_API_Timeout(void);
+int BUFSTATE_API_Poll(void);
+int BUFSTATE_API_Num_Antennas(void);
+uint64_t BUFSTATE_API_Start_Time(void);
+int BUFSTATE_API_History(int antenna, int buffer, bufstate_history_t *pHistory);
+const char *BUFSTATE_API_Flag_Name(int flag);
+unsigned int BUFSTATE_API_Bucket_Low(int bucket);
+#endif /* end of protection macro */
+/** @} */
@@ -26,35 +26,49 @@
 #include <sys/stat.h>
 #include <sys/fcntl.h>
 #include <netinet/in.h>
+#include <arpa/inet.h>
 #include <syslog.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
 
 #include <client.h>
 #include <comms.h>
+#include <xroe_client.h>
+
+/**
+ * client_batch_struct State of a command file being sent.
+ */
+typedef struct client_batch_struct{
+	char *Request;    /**< Connection option and commands, one per line */
+	size_t Length;
+	size_t Next;      /**< Offset of the command of the next reply */
+	size_t Limit;     /**< Offset up to which commands may be sent */
+	int Flags;
+	int Failed;       /**< Number of commands that failed */
+	int Stopped;      /**< A command failed with CLIENT_STOP_ON_ERROR */
+} client_batch_struct;
 
 /*****************************************************************************/
 /**
 *
-* Sends commands to an instance of the sample application.
-* This function takes a user-supplied command string and send it either to the
-* sample application listening on the local UNIX socket, or if addr is not NULL
-* then the sample application listening on the remore TCP/IP socket at addr.
-* 
+* Connects to an instance of the sample application, on the local UNIX
+* socket or if addr is not 0 on the remote TCP/IP socket at addr. Exits on
+* error.
 *
-* @param [in]	addr   	Address of remote application to send command to.
+* @param [in]	addr   	Address of remote application, 0 for local.
 * @param [in]	port   	Port of remote application.
-* @param [in]	command Pointer to command string.
 *
 * @return
-*		- 0
+*		- Connected socket
 *
 ******************************************************************************/
-int client_send_message(in_addr_t addr, int port, char *command)
+static int client_connect(in_addr_t addr, int port)
 {
 	struct sockaddr *serv_addr;
 	struct sockaddr_in in_serv_addr;
 	struct sockaddr_un un_serv_addr;
-	int sockfd, servlen, n;
-	char buffer[MAX_RESPONSE_LENGTH];
+	int sockfd, servlen;
 
 	if (addr)
 	{
@@ -68,7 +82,7 @@ int client_send_message(in_addr_t addr, int port, char *command)
 		if ((sockfd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
 		{
 			perror("Creating socket");
-			exit(0);
+			exit(EXIT_FAILURE);
 		}
 
 		serv_addr = (struct sockaddr *)&in_serv_addr;
@@ -83,7 +97,7 @@ int client_send_message(in_addr_t addr, int port, char *command)
 		if ((sockfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
 		{
 			perror("Creating socket");
-			exit(0);
+			exit(EXIT_FAILURE);
 		}
 
 		serv_addr = (struct sockaddr *)&un_serv_addr;
@@ -93,24 +107,418 @@ int client_send_message(in_addr_t addr, int port, char *command)
 	if (connect(sockfd, serv_addr, servlen) < 0)
 	{
 		perror("Connecting");
-		exit(0);
+		exit(EXIT_FAILURE);
 	}
+
+	return sockfd;
+}
+
+/*****************************************************************************/
+/**
+*
+* Sends a command taking over the connection, such as "subscribe", and
+* writes what the application sends until it closes the connection.
+*
+* @param [in]	addr   	Address of remote application, 0 for local.
+* @param [in]	port   	Port of remote application.
+* @param [in]	command Pointer to command string.
+*
+* @return
+*		- 0
+*
+******************************************************************************/
+static int client_stream_message(in_addr_t addr, int port, char *command)
+{
+	int sockfd, n;
+	char buffer[MAX_RESPONSE_LENGTH];
+
+	sockfd = client_connect(addr, port);
 	bzero(buffer, MAX_RESPONSE_LENGTH);
 
-	/* Send message to daemon and read response */
-	if (write(sockfd, command, strlen(command)) < 0 ) 
+	/* Send the newline-terminated message to daemon and read response */
+	n = snprintf(buffer, MAX_RESPONSE_LENGTH, "%s\n", command);
+	if (write(sockfd, buffer, (n < MAX_RESPONSE_LENGTH) ? n : MAX_RESPONSE_LENGTH - 1) < 0)
     {
       syslog(LOG_ERR, "Failed write to Send message to daemon\n");
     }
 
-	n = read(sockfd, buffer, MAX_RESPONSE_LENGTH);
-	if(write(1, buffer, n) < 0)
-    {
-      syslog(LOG_ERR, "Failed write to Send message to daemon\n");
-    }
+	/* No more commands, the daemon closes once it has answered */
+	shutdown(sockfd, SHUT_WR);
+
+	/* Read until the daemon closes, subscriptions keep on pushing */
+	while ((n = read(sockfd, buffer, MAX_RESPONSE_LENGTH)) > 0)
+	{
+		if(write(1, buffer, n) < 0)
+		{
+			syslog(LOG_ERR, "Failed write to Send message to daemon\n");
+			break;
+		}
+	}
 	close(sockfd);
 
 	return 0;
 }
 
-/** @} */
\ No newline at end of file
+/*****************************************************************************/
+/**
+*
+* Sends commands to an instance of the sample application.
+* This function takes a user-supplied command string and send it either to the
+* sample application listening on the local UNIX socket, or if addr is not NULL
+* then the sample application listening on the remore TCP/IP socket at addr.
+* The reply is written to standard output.
+* 
+*
+* @param [in]	addr   	Address of remote application to send command to.
+* @param [in]	port   	Port of remote application.
+* @param [in]	command Pointer to command string.
+*
+* @return
+*		- 0 if the command succeeded
+*		- 1 otherwise
+*
+******************************************************************************/
+int client_send_message(in_addr_t addr, int port, char *command)
+{
+	xroe_client_t *client;
+	struct in_addr in;
+	char host[INET_ADDRSTRLEN];
+	char *reply;
+	size_t len;
+	int status = 0;
+	int word;
+	int err;
+
+	/* Commands taking over the connection are not answered once */
+	command += strspn(command, " ");
+	word = strcspn(command, " ");
+	if (((word == 9) && !strncmp(command, "subscribe", 9)) || ((word == 4) && !strncmp(command, "quit", 4)))
+	{
+		return client_stream_message(addr, port, command);
+	}
+
+	in.s_addr = addr;
+	client = XROE_CLIENT_API_Open(addr ? inet_ntop(AF_INET, &in, host, sizeof(host)) : NULL, port, 0);
+	if (!client)
+	{
+		perror("Connecting");
+		return 1;
+	}
+
+	err = XROE_CLIENT_API_Request(client, command, &reply, &len, &status);
+	XROE_CLIENT_API_Close(client);
+	if (err)
+	{
+		fprintf(stderr, "%s: %s\n", command, strerror(err));
+		return 1;
+	}
+
+	if (write(1, reply, len) < 0)
+	{
+		syslog(LOG_ERR, "Failed write of reply\n");
+	}
+	free(reply);
+	return status ? 1 : 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads a command file into a pipelined request: the connection option
+* selecting replies preceded by their length and status, then each command on a line. Blank lines
+* and lines starting with '#' are skipped.
+*
+* @param [in]	file    	Open command file.
+* @param [out]	pLength 	Pointer to store the request length in.
+* @param [out]	pCount  	Pointer to store the number of commands in.
+*
+* @return
+*		- Request, to be freed by the caller
+*		- NULL if out of memory
+*
+******************************************************************************/
+static char *client_read_commands(FILE *file, size_t *pLength, int *pCount)
+{
+	char line[MAX_RESPONSE_LENGTH];
+	size_t length = 0;
+	size_t size = 0;
+	char *request = NULL;
+	char *tmp;
+	size_t n;
+
+	*pCount = 0;
+	snprintf(line, sizeof(line), "%s\n", COMMS_PIPELINE_STATUS_CMD);
+	do
+	{
+		n = strcspn(line, "\r\n");
+		if ((n == 0) || (line[0] == '#'))
+		{
+			continue;
+		}
+
+		if (length + n + 1 > size)
+		{
+			size = (size ? 2 * size : 4096) + n + 1;
+			tmp = realloc(request, size);
+			if (!tmp)
+			{
+				free(request);
+				return NULL;
+			}
+			request = tmp;
+		}
+		memcpy(request + length, line, n);
+		request[length + n] = '\n';
+		length += n + 1;
+		(*pCount)++;
+	} while (fgets(line, sizeof(line), file));
+
+	/* The connection option is not a command */
+	(*pCount)--;
+	*pLength = length;
+	return request;
+}
+/*****************************************************************************/
+/**
+*
+* Returns the offset following the end of the line starting at an offset of
+* a request.
+*
+* @param [in]	batch   	Command file being sent.
+* @param [in]	offset  	Start of the line.
+*
+* @return
+*		- Offset of the next line, the request length after the last one
+*
+******************************************************************************/
+static size_t client_next_line(const client_batch_struct *batch, size_t offset)
+{
+	char *newline = memchr(batch->Request + offset, '\n', batch->Length - offset);
+
+	return newline ? (size_t)(newline + 1 - batch->Request) : batch->Length;
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes the replies received so far to standard output. Each reply is
+* preceded by its length, the return value of its command and the time the
+* command took; failures, and the times if asked for, go to standard error.
+*
+* @param [in,out]	batch   	Command file being sent.
+* @param [in,out]	buffer  	Received data, the incomplete reply left at
+*                         		its start.
+* @param [in,out]	pLength 	Pointer to the length of the received data.
+*
+* @return
+*		- Number of complete replies written
+*
+******************************************************************************/
+static int client_write_replies(client_batch_struct *batch, char *buffer, size_t *pLength)
+{
+	size_t start = 0;
+	size_t reply;
+	unsigned long usecs;
+	char *command;
+	char *newline;
+	char *field;
+	int status;
+	int count = 0;
+	int len;
+
+	while (!batch->Stopped && ((newline = memchr(buffer + start, '\n', *pLength - start)) != NULL))
+	{
+		reply = strtoul(buffer + start, &field, 10);
+		if ((size_t)(newline + 1 - buffer) + reply > *pLength)
+		{
+			break;
+		}
+		status = strtol(field, &field, 10);
+		usecs = strtoul(field, NULL, 10);
+
+		if (write(1, newline + 1, reply) < 0)
+		{
+			syslog(LOG_ERR, "Failed write of reply\n");
+		}
+		start = newline + 1 - buffer + reply;
+		count++;
+
+		/* The command answered is the next line of the request */
+		command = batch->Request + batch->Next;
+		len = client_next_line(batch, batch->Next) - batch->Next - 1;
+		batch->Next += len + 1;
+		if (batch->Flags & CLIENT_TIMING)
+		{
+			fprintf(stderr, "%10.3f ms  %.*s\n", usecs / 1000.0, len, command);
+		}
+		if (status)
+		{
+			fprintf(stderr, "\"%.*s\" failed (%d)\n", len, command, status);
+			batch->Failed++;
+			batch->Stopped = (batch->Flags & CLIENT_STOP_ON_ERROR) != 0;
+		}
+		else if (batch->Flags & CLIENT_STOP_ON_ERROR)
+		{
+			/* Answered, the next command may be sent */
+			batch->Limit = client_next_line(batch, batch->Limit);
+		}
+	}
+
+	memmove(buffer, buffer + start, *pLength - start);
+	*pLength -= start;
+	return count;
+}
+
+/*****************************************************************************/
+/**
+*
+* Sends the commands of a file to an instance of the sample application over
+* a single connection, and writes the replies in order. Commands are sent
+* while replies are read, so files of any length do not fill both sockets.
+* To stop at the first command failing, each command is only sent once the
+* one before it has succeeded.
+*
+* @param [in]	addr   	Address of remote application, 0 for local.
+* @param [in]	port   	Port of remote application.
+* @param [in]	path   	Command file, "-" for standard input.
+* @param [in]	flags  	CLIENT_STOP_ON_ERROR, CLIENT_TIMING or 0.
+*
+* @return
+*		- 0 if every command was answered and succeeded
+*		- 1 otherwise
+*
+******************************************************************************/
+int client_send_file(in_addr_t addr, int port, char *path, int flags)
+{
+	client_batch_struct batch;
+	struct timespec start;
+	struct timespec end;
+	struct pollfd pfd;
+	FILE *file;
+	char *buffer;
+	char *larger;
+	size_t size = 4 * MAX_RESPONSE_LENGTH;
+	size_t sent = 0;
+	size_t received = 0;
+	ssize_t n;
+	int commands;
+	int replies = -1; /* The connection option is answered too */
+	int sockfd;
+
+	file = strcmp(path, "-") ? fopen(path, "r") : stdin;
+	if (!file)
+	{
+		perror(path);
+		return 1;
+	}
+	memset(&batch, 0, sizeof(batch));
+	batch.Flags = flags;
+	batch.Request = client_read_commands(file, &batch.Length, &commands);
+	if (file != stdin)
+	{
+		fclose(file);
+	}
+	buffer = batch.Request ? malloc(size) : NULL;
+	if (!buffer)
+	{
+		perror("Reading commands");
+		free(batch.Request);
+		return 1;
+	}
+
+	/* Replies follow the connection option, sent with the first command */
+	batch.Next = client_next_line(&batch, 0);
+	batch.Limit = (flags & CLIENT_STOP_ON_ERROR) ? client_next_line(&batch, batch.Next) : batch.Length;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	sockfd = client_connect(addr, port);
+	pfd.fd = sockfd;
+
+	while ((replies < commands) && !batch.Stopped)
+	{
+		pfd.events = POLLIN | ((sent < batch.Limit) ? POLLOUT : 0);
+		if (poll(&pfd, 1, -1) < 0)
+		{
+			perror("Polling");
+			break;
+		}
+
+		if ((pfd.revents & POLLOUT) && (sent < batch.Limit))
+		{
+			n = send(sockfd, batch.Request + sent, batch.Limit - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+			if ((n < 0) && (errno != EAGAIN))
+			{
+				perror("Sending commands");
+				break;
+			}
+			sent += (n > 0) ? n : 0;
+			if (sent == batch.Length)
+			{
+				shutdown(sockfd, SHUT_WR);
+			}
+		}
+
+		if (pfd.revents & (POLLIN | POLLHUP | POLLERR))
+		{
+			/* Make room for replies longer than the buffer */
+			if (received == size)
+			{
+				larger = realloc(buffer, size * 2);
+				if (!larger)
+				{
+					perror("Reading replies");
+					break;
+				}
+				buffer = larger;
+				size *= 2;
+			}
+			n = read(sockfd, buffer + received, size - received);
+			if (n <= 0)
+			{
+				break;
+			}
+			received += n;
+
+			/* The first reply, to the connection option, is not shown */
+			if (replies < 0)
+			{
+				char *newline = memchr(buffer, '\n', received);
+				size_t skip;
+
+				if (!newline || ((size_t)(newline + 1 - buffer) + strtoul(buffer, NULL, 10) > received))
+				{
+					continue;
+				}
+				skip = newline + 1 - buffer + strtoul(buffer, NULL, 10);
+				memmove(buffer, buffer + skip, received - skip);
+				received -= skip;
+				replies = 0;
+			}
+			replies += client_write_replies(&batch, buffer, &received);
+		}
+	}
+
+	close(sockfd);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	free(batch.Request);
+	free(buffer);
+
+	if (flags & CLIENT_TIMING)
+	{
+		fprintf(stderr, "%d commands in %.3f ms\n", (replies > 0) ? replies : 0,
+		        (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0);
+	}
+	if (batch.Stopped)
+	{
+		fprintf(stderr, "Stopped after %d of %d commands\n", replies, commands);
+		return 1;
+	}
+	if (replies < commands)
+	{
+		fprintf(stderr, "%d of %d commands answered\n", (replies > 0) ? replies : 0, commands);
+		return 1;
+	}
+	return batch.Failed ? 1 : 0;
+}
+
+/** @} */
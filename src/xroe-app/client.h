@@ -13,6 +13,11 @@
 *  A sample communication module for UNIX, UDP/IP and TCP/IP sockets.
 *
 ******************************************************************************/
+/* Flags of client_send_file() */
+#define CLIENT_STOP_ON_ERROR 1 /* Stop at the first command failing */
+#define CLIENT_TIMING 2 /* Print the time taken by each command */
+
 /************************** Function Prototypes ******************************/
 int client_send_message(in_addr_t in_addr, int port, char *command);
+int client_send_file(in_addr_t in_addr, int port, char *path, int flags);
 /** @} */
\ No newline at end of file
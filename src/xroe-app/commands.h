@@ -20,19 +20,30 @@
 /**
  * XROE_MAX_COMMANDS Number of commands handled at the top level.
  */
-#define XROE_MAX_COMMANDS 11
+#define XROE_MAX_COMMANDS 14
+
+/**
+ * XROE_SCRIPT_DIR Directory of the files run by the "script" command, which
+ * takes a plain file name in it.
+ */
+#ifndef XROE_SCRIPT_DIR
+#define XROE_SCRIPT_DIR "/etc/xroe/scripts"
+#endif
 
 /************************** Function Prototypes ******************************/
-int help_func(int argc, char **argv, char *resp);
-int ecpri_func(int argc, char **argv, char *resp);
-int ip_func(int argc, char **argv, char *resp);
-int stats_func(int argc, char **argv, char *resp);
-int version_func(int argc, char **argv, char *resp);
-int enable_func(int argc, char **argv, char *resp);
-int disable_func(int argc, char **argv, char *resp);
-int framing_func(int argc, char **argv, char *resp);
-int restart_func(int argc, char **argv, char *resp);
-int radio_ctrl_func(int argc, char **argv, char *resp);
+int help_func(int argc, char **argv, response_t *resp);
+int ecpri_func(int argc, char **argv, response_t *resp);
+int ip_func(int argc, char **argv, response_t *resp);
+int stats_func(int argc, char **argv, response_t *resp);
+int version_func(int argc, char **argv, response_t *resp);
+int enable_func(int argc, char **argv, response_t *resp);
+int disable_func(int argc, char **argv, response_t *resp);
+int framing_func(int argc, char **argv, response_t *resp);
+int restart_func(int argc, char **argv, response_t *resp);
+int radio_ctrl_func(int argc, char **argv, response_t *resp);
+int sim_func(int argc, char **argv, response_t *resp);
+int subscribe_func(int argc, char **argv, response_t *resp);
+int script_func(int argc, char **argv, response_t *resp);
 
 /**
  * cmds The top-level commands handled by the command parser.
@@ -50,7 +61,19 @@ commands_t cmds[XROE_MAX_COMMANDS] = {
 	{"restart", XROE_RESTART_STR, restart_func}, /**< "restart" command */
 	{"framing", XROE_FRAM_STR, framing_func}, /**< "framing" command */
 	{"radio", RADIO_CTRL_STR, radio_ctrl_func}, /**< "radio" command */
+	{"sim", SIM_STR, sim_func}, /**< "sim" command */
+	{"subscribe", SUBSCRIBE_STR, subscribe_func}, /**< "subscribe" command */
+	{"script", XROE_SCRIPT_STR, script_func}, /**< "script" command */
 	/* Keep this last - insert commands above */
 	{NULL, NULL, NULL} /**< NULL command to terminate array */
 };
+
+/**
+ * main_thread_cmds The commands run by the main loop, not the worker threads.
+ */
+const char *main_thread_cmds[] = {
+	"quit",
+	"subscribe",
+	NULL
+};
 /** @} */
\ No newline at end of file
@@ -12,43 +12,1285 @@
 *
 *  A sample communication module for UNIX, UDP/IP and TCP/IP sockets.
 *
+*  All sockets are watched by one epoll instance. Command connections are
+*  non-blocking and persistent: each carries any number of newline-terminated
+*  commands, which are answered in order. Partial commands and unsent replies
+*  are buffered per connection, so a slow client never holds up the others.
+*  A client shutting down its side of the connection has what it sent last
+*  taken as its last command, so a one-shot client of the earlier protocol
+*  is answered and the connection closed after the reply. One that never
+*  sends a newline and does not shut down is taken as one-shot once it has
+*  been idle for COMMS_ONESHOT_IDLE_MS.
+*
+*  Replies are sent as they are, unless the client sends COMMS_PIPELINE_CMD
+*  first: each reply is then preceded by its length in bytes, in decimal on a
+*  line of its own, so that pipelined commands can be matched to their
+*  replies. With COMMS_PIPELINE_STATUS_CMD the line also carries the return
+*  value of the command and its run time. A connection whose client does not read its replies stops being
+*  read from once COMMS_MAX_PENDING_OUTPUT bytes are waiting.
+*
+*  Commands may be run by the worker threads (see workers.h). A connection
+*  has one command at a time out with them, so that its replies stay in
+*  order, and is only freed once that command is done. The eCPRI sockets
+*  are each served by a thread of their own, which waits only for the eCPRI
+*  commands sharing the sockets and never for the main loop. So is the raw
+*  Ethernet socket receiving the eCPRI frames of the interface, when it can
+*  be opened.
+*
+*  Scrapes of the metrics port are connections of their own kind: the
+*  request is buffered like a command, and the HTTP response queued like a
+*  reply, then the connection is closed once it is sent.
+*
+*  With open_uring(), epoll still tells which sockets are ready, but the
+*  accepts and reads of all the ready sockets are then submitted to an
+*  io_uring instance at once, into input buffers registered with it, instead
+*  of being one system call each.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+#define _GNU_SOURCE /* accept4() */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <string.h>
+#include <linux/net_tstamp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/fcntl.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <net/if.h>
+#include <netpacket/packet.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <errno.h>
+#include <linux/sockios.h>
+#include <syslog.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <time.h>
+
+#include <comms.h>
+#include <ecpri_proto.h>
+#include <metrics.h>
+#include <subscribe.h>
+#include <workers.h>
+#include <ecpri_rt.h>
+#include <bin_proto.h>
+#include <uring.h>
+
+/** @name Communications Variables
+ *
+ * Variables used to manage communications between applications.
+ * @{
+ */
+int sock_fd; /**< File descriptor number for UNIX file socket */
+int sock_tcp; /**< File descriptor number for TCP/IP socket */
+int sock_ip; /**< File descriptor number for UDP/IP socket, the first of ecpri_socks */
+int sock_metrics = -1; /**< File descriptor number for the metrics TCP/IP socket */
+int port_ip; /**< Port number for TCP/IP and UDP/IP socket */
+int epoll_fd = -1; /**< File descriptor number for the epoll instance */
+int ecpri_stop_fd = -1; /**< File descriptor number stopping the eCPRI thread */
+int ecpri_socks[ECPRI_PROTO_MAX_SOCKETS + 1]; /**< File descriptor numbers for the UDP/IP sockets sharing the eCPRI port, then the raw Ethernet socket */
+pthread_t ecpri_thread[ECPRI_PROTO_MAX_SOCKETS + 1]; /**< Threads serving the sockets of ecpri_socks */
+int num_ecpri_threads; /**< Number of threads started */
+/**@}*/
+
+/**
+ * comms_conn_type_t Kinds of watched sockets.
+ */
+typedef enum comms_conn_type_t{
+  COMMS_LISTEN_UNIX,
+  COMMS_LISTEN_TCP,
+  COMMS_WORKERS,
+  COMMS_LISTEN_METRICS,
+  COMMS_CLIENT
+} comms_conn_type_t;
+
+/**
+ * comms_conn_struct State of a watched socket.
+ */
+typedef struct comms_conn_struct{
+  int Fd;
+  comms_conn_type_t Type;
+  int Slot;          /**< Index in CommsConns, for clients */
+  uint32_t Events;   /**< epoll events watched */
+  int Reads;         /**< Number of reads with data */
+  int Newline;       /**< A newline was received, not a one-shot client */
+  struct timespec Received; /**< Time of the last read with data */
+  int OneShot;       /**< Earlier protocol, one command then close */
+  int Framed;        /**< Replies are preceded by their length */
+  int Status;        /**< Framed replies also carry the command status */
+  int Binary;        /**< Binary requests, see xroe_bin.h */
+  int Metrics;       /**< Scrape of the metrics port, see metrics.h */
+  int PeerClosed;    /**< No more commands, close once answered */
+  int Busy;          /**< A command is out with the worker threads */
+  int Orphaned;      /**< Closed while busy, freed when the command is done */
+  int InLen;
+  char *In;          /**< Entry of CommsIn for the slot */
+  char *Out;         /**< Replies not sent yet */
+  int OutLen;
+  int OutSent;
+  int OutSize;
+} comms_conn_struct;
+
+/**
+ * CommsListeners The listening sockets and the worker threads' eventfd.
+ */
+static comms_conn_struct CommsListeners[NUM_LISTEN_SOCKETS] = {
+  {.Fd = -1, .Type = COMMS_LISTEN_UNIX},
+  {.Fd = -1, .Type = COMMS_LISTEN_TCP},
+  {.Fd = -1, .Type = COMMS_WORKERS},
+  {.Fd = -1, .Type = COMMS_LISTEN_METRICS}
+};
+
+/**
+ * CommsConns The command connections, NULL for free slots.
+ */
+static comms_conn_struct *CommsConns[COMMS_MAX_CONNECTIONS];
+
+/**
+ * CommsNext Slot checked first for the next command, so that the
+ * connections are served in turn.
+ */
+static int CommsNext;
+
+/**
+ * CommsCurrent Connection of the command being handled, the one
+ * send_response() answers. NULL if it has no connection.
+ */
+static comms_conn_struct *CommsCurrent;
+
+/**
+ * CommsIn Input buffers of the command connections, by slot. A connection
+ * closed while busy leaves its entry to the next one in the slot, as it no
+ * longer reads.
+ */
+static char CommsIn[COMMS_MAX_CONNECTIONS][MAX_RESPONSE_LENGTH];
+
+/**
+ * CommsRing io_uring instance of the accepts and reads, with CommsIn
+ * registered as buffer 0. Not set up (Fd -1) without open_uring().
+ */
+static uring_t CommsRing = {.Fd = -1};
+
+/*****************************************************************************/
+/**
+*
+* Sets the epoll events watched on a socket.
+*
+* @param [in]  conn     socket state
+* @param [in]  events   epoll events
+*
+* @return
+*    - 0 on success
+*    - -1 on error
+*
+******************************************************************************/
+static int comms_watch(comms_conn_struct *conn, uint32_t events)
+{
+  struct epoll_event ev;
+  int op = conn->Events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+
+  if(conn->Events == events)
+  {
+    return 0;
+  }
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events = events;
+  ev.data.ptr = conn;
+  if(!events)
+  {
+    op = EPOLL_CTL_DEL;
+  }
+  if(epoll_ctl(epoll_fd, op, conn->Fd, &ev) < 0)
+  {
+    syslog(LOG_ERR, "epoll_ctl fd %d: %s\n", conn->Fd, strerror(errno));
+    return -1;
+  }
+  conn->Events = events;
+  return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Watches a connection for the events it can handle now: input while there
+* is room for it and the client reads its replies, output while replies are
+* waiting.
+*
+* @param [in]  conn   connection
+*
+******************************************************************************/
+static void comms_update_watch(comms_conn_struct *conn)
+{
+  int pending = conn->OutLen - conn->OutSent;
+  uint32_t events = 0;
+
+  if(!conn->PeerClosed && (conn->InLen < MAX_RESPONSE_LENGTH - 1) && (pending <= COMMS_MAX_PENDING_OUTPUT))
+  {
+    events |= EPOLLIN;
+  }
+  if(pending)
+  {
+    events |= EPOLLOUT;
+  }
+  comms_watch(conn, events);
+}
+
+/*****************************************************************************/
+/**
+*
+* Sends a reply on a connection. When no earlier reply is waiting, the
+* chunks of the response are written straight to the socket, and only what
+* the socket does not take is copied to the replies not sent yet.
+*
+* @param [in]  conn       connection
+* @param [in]  response   reply
+*
+* @return
+*    - 0 on success
+*    - -1 if out of memory
+*
+******************************************************************************/
+static int comms_queue(comms_conn_struct *conn, const response_t *response)
+{
+  struct iovec iov[1 + RESP_MAX_CHUNKS];
+  struct msghdr msg;
+  char header[64];
+  size_t len = resp_len(response);
+  ssize_t sent = 0;
+  int count = 0;
+  int i;
+  char *out;
+
+  if(conn->Framed)
+  {
+    iov[0].iov_base = header;
+    if(conn->Status)
+    {
+      iov[0].iov_len = sprintf(header, "%zu %d %lu\n", len, response->Status, response->Usecs);
+    }
+    else
+    {
+      iov[0].iov_len = sprintf(header, "%zu\n", len);
+    }
+    len += iov[0].iov_len;
+    count = 1;
+  }
+  count += resp_iov(response, iov + count, RESP_MAX_CHUNKS);
+
+  /* Write errors are left for comms_flush() to handle */
+  if((conn->OutLen == conn->OutSent) && !SUBSCRIBE_API_Is_Pending())
+  {
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    sent = sendmsg(conn->Fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if(sent < 0)
+    {
+      sent = 0;
+    }
+    conn->OutLen = conn->OutSent = 0;
+  }
+  len -= sent;
+  if(!len)
+  {
+    return 0;
+  }
+
+  if(conn->OutLen + (int)len > conn->OutSize)
+  {
+    out = realloc(conn->Out, conn->OutLen + len);
+    if(!out)
+    {
+      return -1;
+    }
+    conn->Out = out;
+    conn->OutSize = conn->OutLen + len;
+  }
+  for(i = 0; i < count; i++)
+  {
+    if((size_t)sent >= iov[i].iov_len)
+    {
+      sent -= iov[i].iov_len;
+      continue;
+    }
+    memcpy(conn->Out + conn->OutLen, (char *)iov[i].iov_base + sent, iov[i].iov_len - sent);
+    conn->OutLen += iov[i].iov_len - sent;
+    sent = 0;
+  }
+  return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Starts watching a listening or eCPRI socket.
+*
+* @param [in]  type   kind of socket, also its index in CommsListeners
+* @param [in]  fd     socket
+*
+* @return
+*    - 0 on success
+*    - -1 on error
+*
+******************************************************************************/
+static int comms_listen(comms_conn_type_t type, int fd)
+{
+  if(epoll_fd < 0)
+  {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(epoll_fd < 0)
+    {
+      syslog(LOG_ERR, "Error creating epoll instance\n");
+      return -1;
+    }
+  }
+
+  CommsListeners[type].Fd = fd;
+  CommsListeners[type].Events = 0;
+  return comms_watch(&CommsListeners[type], EPOLLIN);
+}
+
+/*****************************************************************************/
+/**
+*
+* Closes a command connection and frees its state.
+*
+* @param [in]  conn   connection
+*
+******************************************************************************/
+static void comms_close(comms_conn_struct *conn)
+{
+  comms_watch(conn, 0);
+  close(conn->Fd);
+  CommsConns[conn->Slot] = NULL;
+  if(CommsCurrent == conn)
+  {
+    CommsCurrent = NULL;
+  }
+  if(conn->Busy)
+  {
+    /* The reply of the command still running is dropped when it is done */
+    conn->Orphaned = 1;
+    return;
+  }
+  free(conn->Out);
+  free(conn);
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes in a connection accepted, in a free slot.
+*
+* @param [in]  fd        socket of the connection, non-blocking
+* @param [in]  metrics   accepted from the metrics port
+*
+******************************************************************************/
+static void comms_add(int fd, int metrics)
+{
+  comms_conn_struct *conn;
+  int i;
+
+  for(i = 0; (i < COMMS_MAX_CONNECTIONS) && CommsConns[i]; i++)
+  {
+  }
+
+  conn = (i < COMMS_MAX_CONNECTIONS) ? calloc(1, sizeof(*conn)) : NULL;
+  if(!conn)
+  {
+    syslog(LOG_ERR, "Connection refused, %d connections open\n", COMMS_MAX_CONNECTIONS);
+    close(fd);
+    return;
+  }
+
+  conn->Fd = fd;
+  conn->Type = COMMS_CLIENT;
+  conn->Metrics = metrics;
+  conn->Slot = i;
+  conn->In = CommsIn[i];
+  CommsConns[i] = conn;
+  if(comms_watch(conn, EPOLLIN) < 0)
+  {
+    comms_close(conn);
+  }
+}
+
+/*****************************************************************************/
+/**
+*
+* Accepts all pending connections of a listening socket.
+*
+* @param [in]  listener   listening socket
+*
+******************************************************************************/
+static void comms_accept(comms_conn_struct *listener)
+{
+  int fd;
+
+  while((fd = accept4(listener->Fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+  {
+    comms_add(fd, listener->Type == COMMS_LISTEN_METRICS);
+  }
+
+  if((errno != EAGAIN) && (errno != EWOULDBLOCK))
+  {
+    syslog(LOG_ERR, "Error accepting connection\n");
+  }
+}
+
+/*****************************************************************************/
+/**
+*
+* Sends as much of the pending replies of a connection as the socket takes,
+* and closes the connection once a finished client is answered.
+*
+* @param [in]  conn   connection
+*
+******************************************************************************/
+static void comms_flush(comms_conn_struct *conn)
+{
+  ssize_t sent;
+
+  while(conn->OutSent < conn->OutLen)
+  {
+    sent = send(conn->Fd, conn->Out + conn->OutSent, conn->OutLen - conn->OutSent, MSG_NOSIGNAL);
+    if(sent < 0)
+    {
+      if((errno == EAGAIN) || (errno == EWOULDBLOCK))
+      {
+        /* Carry on when the client has read some */
+        comms_update_watch(conn);
+        return;
+      }
+      comms_close(conn);
+      return;
+    }
+    conn->OutSent += sent;
+  }
+
+  conn->OutLen = conn->OutSent = 0;
+  if(conn->PeerClosed && !conn->InLen && !conn->Busy && (conn != CommsCurrent))
+  {
+    comms_close(conn);
+    return;
+  }
+  comms_update_watch(conn);
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes in the result of a read into the command buffer of a client.
+*
+* @param [in]  conn   connection
+* @param [in]  len    bytes read, or -errno value
+*
+* @return
+*    - 0 to read on
+*    - 1 if there is nothing more to read for now
+*    - -1 if the connection was closed
+*
+******************************************************************************/
+static int comms_received(comms_conn_struct *conn, ssize_t len)
+{
+  if(len < 0)
+  {
+    if((len == -EAGAIN) || (len == -EWOULDBLOCK))
+    {
+      return 1;
+    }
+    comms_close(conn);
+    return -1;
+  }
+  else if(len == 0)
+  {
+    conn->PeerClosed = 1;
+  }
+  else if(conn->Metrics)
+  {
+    conn->InLen += len;
+  }
+  else
+  {
+    if(!conn->Reads++ && proto_bin_detect((uint8_t *)conn->In, len))
+    {
+      conn->Binary = 1;
+    }
+    else if(memchr(conn->In + conn->InLen, '\n', len))
+    {
+      conn->Newline = 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &conn->Received);
+    conn->InLen += len;
+  }
+  return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Answers the request of a metrics connection once it is complete, or as it
+* is if the buffer is full or the scraper has stopped sending, then closes
+* the connection once the response is sent.
+*
+* @param [in]  conn   connection
+*
+******************************************************************************/
+static void comms_metrics_request(comms_conn_struct *conn)
+{
+  response_t reply;
+
+  if(conn->InLen && (conn->PeerClosed || (conn->InLen == MAX_RESPONSE_LENGTH - 1) ||
+     METRICS_API_Complete(conn->In, conn->InLen)))
+  {
+    resp_init(&reply);
+    METRICS_API_Answer(conn->In, conn->InLen, &reply);
+    comms_queue(conn, &reply);
+    resp_reset(&reply);
+    conn->InLen = 0;
+    conn->PeerClosed = 1;
+  }
+
+  if(conn->PeerClosed)
+  {
+    comms_flush(conn);
+    return;
+  }
+  comms_update_watch(conn);
+}
+
+/*****************************************************************************/
+/**
+*
+* Checks the command buffer of a client after reading into it, and watches
+* the client for what comes next.
+*
+* @param [in]  conn   connection
+*
+******************************************************************************/
+static void comms_read_done(comms_conn_struct *conn)
+{
+  if(conn->Metrics)
+  {
+    comms_metrics_request(conn);
+    return;
+  }
+
+  if(!conn->OneShot && !conn->Binary && (conn->InLen == MAX_RESPONSE_LENGTH - 1) && !memchr(conn->In, '\n', conn->InLen))
+  {
+    syslog(LOG_ERR, "Command longer than %d bytes, closing connection\n", MAX_RESPONSE_LENGTH - 1);
+    comms_close(conn);
+    return;
+  }
+
+  if(conn->PeerClosed && !conn->InLen)
+  {
+    /* Nothing left to answer, close once the replies are sent */
+    comms_flush(conn);
+    return;
+  }
+  comms_update_watch(conn);
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads what a client sent into its command buffer.
+*
+* @param [in]  conn   connection
+*
+******************************************************************************/
+static void comms_read(comms_conn_struct *conn)
+{
+  ssize_t len;
+  int ret = 0;
+
+  while(!ret && !conn->PeerClosed && (conn->InLen < MAX_RESPONSE_LENGTH - 1))
+  {
+    len = read(conn->Fd, conn->In + conn->InLen, MAX_RESPONSE_LENGTH - 1 - conn->InLen);
+    ret = comms_received(conn, (len < 0) ? -errno : len);
+  }
+  if(ret >= 0)
+  {
+    comms_read_done(conn);
+  }
+}
+
+/*****************************************************************************/
+/**
+*
+* Accepts on the ready listening sockets and reads from the ready clients
+* with one io_uring submission. A socket gets one accept or read, epoll
+* reports it again if there is more.
+*
+* @param [in]  ready   listening sockets and clients with data
+* @param [in]  num     number of sockets
+*
+* @return
+*    - 0 on success
+*    - -1 if the ring failed, the sockets are then to be served without it
+*
+******************************************************************************/
+static int comms_uring_batch(comms_conn_struct **ready, int num)
+{
+  struct io_uring_sqe *pSqe;
+  struct io_uring_cqe *pCqe;
+  comms_conn_struct *conn;
+  int count = 0;
+  int i;
+
+  for(i = 0; i < num; i++)
+  {
+    conn = ready[i];
+    if((conn->Type == COMMS_CLIENT) && (conn->PeerClosed || (conn->InLen >= MAX_RESPONSE_LENGTH - 1)))
+    {
+      continue;
+    }
+    pSqe = uring_get_sqe(&CommsRing);
+    if(!pSqe)
+    {
+      return -1;
+    }
+    pSqe->fd = conn->Fd;
+    pSqe->user_data = (unsigned long)conn;
+    if(conn->Type == COMMS_CLIENT)
+    {
+      pSqe->opcode = IORING_OP_READ_FIXED;
+      pSqe->addr = (unsigned long)(conn->In + conn->InLen);
+      pSqe->len = MAX_RESPONSE_LENGTH - 1 - conn->InLen;
+      pSqe->buf_index = 0;
+    }
+    else
+    {
+      pSqe->opcode = IORING_OP_ACCEPT;
+      pSqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    }
+    count++;
+  }
+
+  /* All the sockets are ready, each entry completes at once */
+  if(count && (uring_submit_and_wait(&CommsRing, count) != count))
+  {
+    return -1;
+  }
+
+  while(count--)
+  {
+    pCqe = uring_peek_cqe(&CommsRing);
+    if(!pCqe)
+    {
+      return -1;
+    }
+    conn = (comms_conn_struct *)(unsigned long)pCqe->user_data;
+    if(conn->Type != COMMS_CLIENT)
+    {
+      if(pCqe->res >= 0)
+      {
+        comms_add(pCqe->res, conn->Type == COMMS_LISTEN_METRICS);
+      }
+      else if((pCqe->res != -EAGAIN) && (pCqe->res != -EWOULDBLOCK))
+      {
+        syslog(LOG_ERR, "Error accepting connection\n");
+      }
+    }
+    else if(comms_received(conn, pCqe->res) >= 0)
+    {
+      comms_read_done(conn);
+    }
+    uring_cqe_seen(&CommsRing);
+  }
+  return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Answers the complete binary requests of a connection. Register and field
+* accesses are run here, statistics and radio requests are handed to the
+* worker threads and the requests after them wait for their reply.
+*
+* @param [in]  conn   connection
+*
+* @return
+*    - 0 on success
+*    - -1 if the connection was closed on an invalid request
+*
+******************************************************************************/
+static int comms_binary_requests(comms_conn_struct *conn)
+{
+  response_t reply;
+  int used = 0;
+  int len;
+
+  resp_init(&reply);
+  while(conn->OutLen - conn->OutSent <= COMMS_MAX_PENDING_OUTPUT)
+  {
+    len = proto_bin_frame_length((uint8_t *)conn->In + used, conn->InLen - used);
+    if(len < 0)
+    {
+      syslog(LOG_ERR, "Invalid binary request, closing connection\n");
+      resp_reset(&reply);
+      comms_close(conn);
+      return -1;
+    }
+    if(!len)
+    {
+      if(conn->PeerClosed)
+      {
+        /* A partial request is never completed */
+        used = conn->InLen;
+      }
+      break;
+    }
+
+    if(!proto_bin_is_short((uint8_t *)conn->In + used) &&
+       !WORKERS_API_Submit_Binary((uint8_t *)conn->In + used, len, conn))
+    {
+      conn->Busy = 1;
+      used += len;
+      break;
+    }
+
+    proto_bin_handle((uint8_t *)conn->In + used, &reply);
+    comms_queue(conn, &reply);
+    resp_reset(&reply);
+    used += len;
+  }
+
+  conn->InLen -= used;
+  memmove(conn->In, conn->In + used, conn->InLen);
+  comms_update_watch(conn);
+  return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes the next complete command of a connection.
+*
+* @param [in]   conn      connection
+* @param [out]  command   pointer to string to copy the command into
+*
+* @return
+*    - length of the command
+*    - 0 if the connection has no complete command
+*
+******************************************************************************/
+static int comms_next_command(comms_conn_struct *conn, char *command)
+{
+  response_t reply;
+  char *newline;
+  int len;
+  int used;
+
+  while(conn->InLen)
+  {
+    newline = memchr(conn->In, '\n', conn->InLen);
+    if(newline)
+    {
+      len = newline - conn->In;
+      used = len + 1;
+    }
+    else if(conn->PeerClosed)
+    {
+      /* Last command, or the one of a one-shot client */
+      len = used = conn->InLen;
+    }
+    else
+    {
+      return 0;
+    }
+
+    memcpy(command, conn->In, len);
+    command[len] = 0;
+    conn->InLen -= used;
+    memmove(conn->In, conn->In + used, conn->InLen);
+    comms_update_watch(conn);
+
+    if(len && (command[len - 1] == '\r'))
+    {
+      command[--len] = 0;
+    }
+
+    if(!strcmp(command, COMMS_PIPELINE_CMD))
+    {
+      /* Connection option, answered here */
+      conn->Framed = 1;
+      resp_init(&reply);
+      resp_printf(&reply, "%s", COMMS_PIPELINE_STR);
+      comms_queue(conn, &reply);
+      comms_update_watch(conn);
+    }
+    else if(!strcmp(command, COMMS_PIPELINE_STATUS_CMD))
+    {
+      conn->Framed = 1;
+      conn->Status = 1;
+      resp_init(&reply);
+      resp_printf(&reply, "%s", COMMS_PIPELINE_STATUS_STR);
+      comms_queue(conn, &reply);
+      comms_update_watch(conn);
+    }
+    else if(len)
+    {
+      return len;
+    }
+  }
+
+  return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes the next command of any connection, serving the connections in turn.
+*
+* @param [out]  command   pointer to string to copy the command into
+*
+* @return
+*    - length of the command
+*    - 0 if no connection has a complete command
+*
+******************************************************************************/
+static int comms_ready_command(char *command)
+{
+  comms_conn_struct *conn;
+  int len;
+  int i;
+
+  for(i = 0; i < COMMS_MAX_CONNECTIONS; i++)
+  {
+    conn = CommsConns[(CommsNext + i) % COMMS_MAX_CONNECTIONS];
+    if(!conn || conn->Busy || conn->Metrics)
+    {
+      continue;
+    }
+
+    if(conn->Binary)
+    {
+      if(!comms_binary_requests(conn) && !conn->Busy && conn->PeerClosed && !conn->InLen &&
+         (conn->OutLen == conn->OutSent))
+      {
+        comms_close(conn);
+      }
+      continue;
+    }
+
+    /* A client not reading its replies waits for them to be sent */
+    if(conn->OutLen - conn->OutSent > COMMS_MAX_PENDING_OUTPUT)
+    {
+      continue;
+    }
+
+    len = comms_next_command(conn, command);
+    if(len)
+    {
+      CommsCurrent = conn;
+      CommsNext = (conn->Slot + 1) % COMMS_MAX_CONNECTIONS;
+      return len;
+    }
+    else if(conn->PeerClosed && (conn->OutLen == conn->OutSent))
+    {
+      comms_close(conn);
+    }
+  }
+
+  return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes the clients which have sent part of a line, never a newline, and
+* been idle for COMMS_ONESHOT_IDLE_MS as one-shot clients of the earlier
+* protocol: what they sent is their command, and they are closed once it is
+* answered.
+*
+* @return
+*    - milliseconds until the next client would be taken as one-shot
+*    - -1 if no client is waiting to be
+*
+******************************************************************************/
+static int comms_oneshot_poll(void)
+{
+  comms_conn_struct *conn;
+  struct timespec now;
+  long idle_ms;
+  int timeout = -1;
+  int i;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  for(i = 0; i < COMMS_MAX_CONNECTIONS; i++)
+  {
+    conn = CommsConns[i];
+    if(!conn || !conn->InLen || conn->Newline || conn->Binary || conn->Metrics || conn->PeerClosed)
+    {
+      continue;
+    }
+
+    idle_ms = (now.tv_sec - conn->Received.tv_sec) * 1000 +
+      (now.tv_nsec - conn->Received.tv_nsec) / 1000000;
+    if(idle_ms >= COMMS_ONESHOT_IDLE_MS)
+    {
+      conn->OneShot = 1;
+      conn->PeerClosed = 1;
+      comms_update_watch(conn);
+    }
+    else if((timeout < 0) || (COMMS_ONESHOT_IDLE_MS - idle_ms < timeout))
+    {
+      timeout = COMMS_ONESHOT_IDLE_MS - idle_ms;
+    }
+  }
+
+  return timeout;
+}
+
+/*****************************************************************************/
+/**
+*
+* Handles the eCPRI messages received on one of the eCPRI sockets until
+* close_connections() is called. The real-time settings are applied first,
+* and the wake-up latency of each message is recorded.
+*
+* @param [in]  arg   index of the socket in ecpri_socks
+*
+* @return
+*    - NULL
+*
+******************************************************************************/
+static void *comms_ecpri_thread(void *arg)
+{
+  struct pollfd fds[2];
+  struct timespec wake;
+  struct timespec stamp;
+  int index = (intptr_t)arg;
+  int fd = ecpri_socks[index];
+  short revents;
+
+  ECPRI_RT_API_Apply(index);
+
+  fds[0].fd = fd;
+  fds[0].events = POLLIN;
+  fds[1].fd = ecpri_stop_fd;
+  fds[1].events = POLLIN;
+
+  for(;;)
+  {
+    if(poll(fds, 2, -1) < 0)
+    {
+      if(errno == EINTR)
+      {
+        continue;
+      }
+      syslog(LOG_ERR, "Error polling eCPRI socket, eCPRI thread stopped\n");
+      break;
+    }
+    clock_gettime(CLOCK_REALTIME, &wake);
+    if(fds[1].revents)
+    {
+      break;
+    }
+
+    /* A command waiting for a response may have read the message meanwhile */
+    proto_ecpri_lock_socket(fd);
+    if(poll(fds, 1, 0) > 0)
+    {
+      revents = fds[0].revents;
+      proto_ecpri_handle_incoming_msg(fd, revents, NULL);
+      if(!proto_ecpri_get_event_time(fd, &stamp))
+      {
+        ECPRI_RT_API_Record((revents & POLLIN) ? ECPRI_RT_RX : ECPRI_RT_TX_TIMESTAMP, &wake, &stamp);
+      }
+    }
+    proto_ecpri_unlock_socket(fd);
+  }
+
+  return NULL;
+}
+
+/*****************************************************************************/
+/**
+*
+* Sends the reply of a command run by the worker threads, on the connection
+* it came from.
+*
+* @param [in]  context    connection
+* @param [in]  response   reply
+*
+******************************************************************************/
+static void comms_command_done(void *context, response_t *response)
+{
+  comms_conn_struct *conn = context;
+
+  conn->Busy = 0;
+  if(conn->Orphaned)
+  {
+    free(conn->Out);
+    free(conn);
+    return;
+  }
+
+  if(conn->Binary)
+  {
+    /* Binary replies are sent as they are, the next requests follow */
+    if(comms_queue(conn, response) < 0)
+    {
+      syslog(LOG_ERR, "Error sending response\n");
+      comms_close(conn);
+      return;
+    }
+    comms_flush(conn);
+    return;
+  }
+
+  CommsCurrent = conn;
+  send_response(response);
+}
+
+/*****************************************************************************/
+/**
+*
+* Turns on the hardware and software timestamps of the messages sent and
+* received on an eCPRI socket.
+*
+*
+* @param [in]  fd   socket
+*
+* @return
+*    - return value of setsockopt()
+*
+******************************************************************************/
+static int comms_ecpri_timestamping(int fd)
+{
+  int flags;
+
+  flags = SOF_TIMESTAMPING_TX_HARDWARE | SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RX_SOFTWARE;
+  flags |= SOF_TIMESTAMPING_RAW_HARDWARE | SOF_TIMESTAMPING_SOFTWARE;
+#ifdef SOF_TIMESTAMPING_OPT_TX_SWHW
+  flags |= SOF_TIMESTAMPING_OPT_TX_SWHW;
+#endif
+#ifdef   SOF_TIMESTAMPING_OPT_ID
+  flags |= SOF_TIMESTAMPING_OPT_ID;
+#endif
+#ifdef   SOF_TIMESTAMPING_OPT_TSONLY
+  flags |= SOF_TIMESTAMPING_OPT_TSONLY;
+#endif
+#ifdef   SOF_TIMESTAMPING_OPT_CMSG
+  flags |= SOF_TIMESTAMPING_OPT_CMSG;
+#endif
+
+  return setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags));
+}
+
+/*****************************************************************************/
+/**
+*
+* Opens a UDP/IP socket receiving eCPRI messages, bound to the eCPRI port
+* with SO_REUSEPORT so that several can share it.
+*
+*
+* @param [in]  nohw            soft mode, the socket is not bound to the interface
+* @param [in]  eth_port_name   interface of the eCPRI messages
+* @param [in]  first           set for the first socket, which also sets up
+*                              the hardware timestamping of the interface
+*
+* @return
+*    - socket on success
+*    - -1 on error
+*
+******************************************************************************/
+static int comms_ecpri_socket(int nohw, char *eth_port_name, int first)
+{
+  struct sockaddr_in in_serv_addr;
+  int reuse = 1;
+  struct ifreq ifreq;
+  struct hwtstamp_config cfg;
+  int err;
+  int fd;
+
+  memset(&ifreq, 0, sizeof(ifreq));
+  memset(&cfg, 0, sizeof(cfg));
+
+  if((fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0)
+  {
+     syslog(LOG_ERR, "Error creating UDP eCPRI socket\n");
+     return(-1);
+  }
+
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse)) < 0)
+  {
+     syslog(LOG_ERR, "setsockopt(SO_REUSEADDR) failed\n");
+     close(fd);
+     return(-1);
+  }
+
+#ifdef SO_REUSEPORT
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (const char*)&reuse, sizeof(reuse)) < 0) 
+  {
+     syslog(LOG_ERR, "setsockopt(SO_REUSEPORT) failed\n");
+     close(fd);
+     return(-1);
+  }
+#endif    
+  
+  err = comms_ecpri_timestamping(fd);
+  if ( err < 0) 
+  {
+    syslog(LOG_ERR, "ioctl SO_TIMESTAMPING failed: %x\n", err);
+    close(fd);
+    return (-1);
+  }
+
+  /* Hardware timestamping is set up per interface */
+  if(first)
+  {
+    strncpy(ifreq.ifr_name, eth_port_name, sizeof(ifreq.ifr_name) - 1);
+
+    ifreq.ifr_data = (void *) &cfg;
+
+    cfg.tx_type = HWTSTAMP_TX_ON;
+    cfg.rx_filter = HWTSTAMP_FILTER_ALL;
+
+    err = ioctl(fd, SIOCSHWTSTAMP, &ifreq);
+    if (err < 0) {
+      err = errno;
+      syslog(LOG_ERR, "SIOCSHWTSTAMP failed %x\n", err);
+      if (err == ERANGE)
+        syslog(LOG_ERR, "The requested time stamping mode is not supported by the hardware.\n");
+    } else {
+      syslog(LOG_ERR, "new settings:\ntx_type %d\nrx_filter %d\n", cfg.tx_type, cfg.rx_filter);
+    }
+  }
+
+  if(!nohw)
+  {
+    memset(&ifreq, 0, sizeof(ifreq));
+    snprintf(ifreq.ifr_name, sizeof(ifreq.ifr_name), "%s", eth_port_name);
+    if (setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, (void *)&ifreq, sizeof(ifreq)) < 0) 
+    {
+      syslog(LOG_ERR, "ioctl SO_BINDTODEVICE failed: %x\n", errno);
+      close(fd);
+      return (-1);
+    }
+  }
+
+  bzero((char *)&in_serv_addr, sizeof(in_serv_addr));
+  in_serv_addr.sin_family = AF_INET;
+  in_serv_addr.sin_addr.s_addr = INADDR_ANY;
+  in_serv_addr.sin_port = port_ip;
+  if (bind(fd, (struct sockaddr *)&in_serv_addr, sizeof(in_serv_addr)) < 0) 
+  {
+     syslog(LOG_ERR, "Error %x binding UDP socket\n", errno);
+     close(fd);
+     return(-1);
+  }
+
+  return fd;
+}
+
+/*****************************************************************************/
+/**
+*
+* Opens the raw Ethernet socket receiving the eCPRI frames (EtherType
+* ETH_P_ECPRI) of an interface, timestamped like the UDP/IP sockets. The
+* hardware timestamping of the interface is set up by the first of those.
+*
+*
+* @param [in]  eth_port_name   interface of the eCPRI messages
+* @param [out] ifindex         index of the interface
+*
+* @return
+*    - socket on success
+*    - -1 if the interface does not exist or the socket cannot be opened,
+*      raw sockets needing CAP_NET_RAW
+*
 ******************************************************************************/
+static int comms_ecpri_raw_socket(char *eth_port_name, int *ifindex)
+{
+  struct sockaddr_ll ll_addr;
+  int fd;
+#ifdef PACKET_IGNORE_OUTGOING
+  int ignore = 1;
+#endif
 
-/***************************** Include Files *********************************/
-#include <stdio.h>
-#include <stdlib.h>
-#include <unistd.h>
-#include <signal.h>
-#include <string.h>
-#include <linux/net_tstamp.h>
-#include <sys/socket.h>
-#include <sys/un.h>
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <sys/fcntl.h>
-#include <sys/ioctl.h>
-#include <netinet/in.h>
-#include <net/if.h>
-#include <poll.h>
-#include <errno.h>
-#include <linux/sockios.h>
-#include <syslog.h>
+  if((*ifindex = if_nametoindex(eth_port_name)) == 0)
+  {
+    return(-1);
+  }
+  if((fd = socket(AF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC, htons(ETH_P_ECPRI))) < 0)
+  {
+    return(-1);
+  }
 
-#include <comms.h>
-#include <ecpri_proto.h>
+  /* proto_ecpri_recv() drops the frames sent otherwise */
+#ifdef PACKET_IGNORE_OUTGOING
+  setsockopt(fd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &ignore, sizeof(ignore));
+#endif
 
-/** @name Communications Variables
- *
- * Variables used to manage communications between applications.
- * @{
- */
-int sock_fd; /**< File descriptor number for UNIX file socket */
-int sock_tcp; /**< File descriptor number for TCP/IP socket */
-int sock_ip; /**< File descriptor number for UDP/IP socket */
-int port_ip; /**< Port number for TCP/IP and UDP/IP socket */
-int newsockfd; /**< File descriptor number for new incoming socket */
-struct pollfd fds[NUM_LISTEN_SOCKETS]; /**< Socket file descriptor array */
-/**@}*/
+  if(comms_ecpri_timestamping(fd) < 0)
+  {
+    syslog(LOG_ERR, "SO_TIMESTAMPING failed on raw eCPRI socket: %x\n", errno);
+    close(fd);
+    return(-1);
+  }
+
+  memset(&ll_addr, 0, sizeof(ll_addr));
+  ll_addr.sll_family = AF_PACKET;
+  ll_addr.sll_protocol = htons(ETH_P_ECPRI);
+  ll_addr.sll_ifindex = *ifindex;
+  if(bind(fd, (struct sockaddr *)&ll_addr, sizeof(ll_addr)) < 0)
+  {
+    syslog(LOG_ERR, "Error %x binding raw eCPRI socket\n", errno);
+    close(fd);
+    return(-1);
+  }
+
+  return fd;
+}
+
+/*****************************************************************************/
+/**
+*
+* Spreads the eCPRI messages over the sockets sharing the port by their
+* source address, the way proto_ecpri_add_socket() expects, so that the
+* messages of a peer are always handled by the same thread.
+*
+*
+* @param [in]  fd    first socket bound to the port
+* @param [in]  num   number of sockets sharing the port
+*
+* @return
+*    - 0 on success
+*    - errno value if the kernel cannot steer the messages
+*
+******************************************************************************/
+static int comms_ecpri_steering(int fd, int num)
+{
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+  struct sock_filter code[ECPRI_PROTO_STEERING_LENGTH];
+  struct sock_fprog prog;
+
+  proto_ecpri_steering(num, code);
+  prog.len = ECPRI_PROTO_STEERING_LENGTH;
+  prog.filter = code;
+  if(setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) < 0)
+  {
+    return errno;
+  }
+  return 0;
+#else
+  (void)fd;
+  (void)num;
+  return EOPNOTSUPP;
+#endif
+}
 
 /*****************************************************************************/
 /**
@@ -56,27 +1298,26 @@ struct pollfd fds[NUM_LISTEN_SOCKETS]; /**< Socket file descriptor array */
 * Opens listening sockets.
 * 
 *
-* @param [in]  nohw   soft mode, do not open UNIX socket or UDP socket
-* @param [in]  port   port to bind TCP/IP and UDP/IP sockets to
+* @param [in]  nohw            soft mode, do not open UNIX socket or UDP socket
+* @param [in]  port            port to bind TCP/IP and UDP/IP sockets to
+* @param [in]  eth_port_name   interface of the eCPRI messages
+* @param [in]  ecpri_threads   number of UDP/IP sockets and threads receiving
+*                              the eCPRI messages, 1 to ECPRI_PROTO_MAX_SOCKETS
 *
 * @return
 *    - 1 on success
 *    - -1 on error
 *
 ******************************************************************************/
-int open_connections(int nohw, int port, char * eth_port_name)
+int open_connections(int nohw, int port, char * eth_port_name, int ecpri_threads)
 {
   int servlen;
   struct sockaddr_un fd_serv_addr;
   struct sockaddr_in in_serv_addr;
   int reuse = 1;
-  int flags;
-  struct ifreq ifreq;
-  struct hwtstamp_config cfg;
+  int ifindex;
   int err;
-
-  memset(&ifreq, 0, sizeof(ifreq));
-  memset(&cfg, 0, sizeof(cfg));
+  int i;
 
   if(!nohw)
   {
@@ -101,11 +1342,13 @@ int open_connections(int nohw, int port, char * eth_port_name)
        syslog(LOG_ERR, "Error binding socket\n");
        return(-1);
     }
-    listen(sock_fd, 5);
+    listen(sock_fd, SOMAXCONN);
+    fcntl(sock_fd, F_SETFL, fcntl(sock_fd, F_GETFL) | O_NONBLOCK);
 
-    /* Set up poll structure */
-    fds[0].fd = sock_fd; 
-    fds[0].events = POLLIN;
+    if(comms_listen(COMMS_LISTEN_UNIX, sock_fd) < 0)
+    {
+       return(-1);
+    }
   }
   else
   {
@@ -151,190 +1394,386 @@ int open_connections(int nohw, int port, char * eth_port_name)
      syslog(LOG_ERR, "Error binding TCP socket\n");
      return(-1);
   }
-  listen(sock_tcp, 5);
+  listen(sock_tcp, SOMAXCONN);
+  fcntl(sock_tcp, F_SETFL, fcntl(sock_tcp, F_GETFL) | O_NONBLOCK);
   
-  /* Set up poll structure */
-  fds[1].fd = sock_tcp; 
-  fds[1].events = POLLIN;
- 
-  /* Open IP4 datagram socket for receiving eCPRI messages */
-  if((sock_ip = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0)
+  if(comms_listen(COMMS_LISTEN_TCP, sock_tcp) < 0)
   {
-     syslog(LOG_ERR, "Error creating UDP eCPRI socket\n");
      return(-1);
   }
+ 
+  /* eCPRI messages are received on sockets sharing the port, each handled
+     by a thread of its own */
+  for(i = 0; i < ecpri_threads; i++)
+  {
+    if((ecpri_socks[i] = comms_ecpri_socket(nohw, eth_port_name, !i)) < 0)
+    {
+      return(-1);
+    }
+    proto_ecpri_add_socket(ecpri_socks[i]);
+    if(!i && (ecpri_threads > 1) && (err = comms_ecpri_steering(ecpri_socks[i], ecpri_threads)) != 0)
+    {
+      syslog(LOG_ERR, "Cannot steer eCPRI messages over %d sockets (%s), using one\n", ecpri_threads, strerror(err));
+      ecpri_threads = 1;
+    }
+  }
+  sock_ip = ecpri_socks[0];
 
-  if (setsockopt(sock_ip, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse)) < 0)
+  /* The peers given by a MAC address are reached over raw Ethernet, when
+     the socket can be opened, on a thread of its own */
+  if((ecpri_socks[ecpri_threads] = comms_ecpri_raw_socket(eth_port_name, &ifindex)) >= 0)
   {
-     syslog(LOG_ERR, "setsockopt(SO_REUSEADDR) failed\n");
-     return(-1);
+    proto_ecpri_set_raw_socket(ecpri_socks[ecpri_threads], ifindex);
+    ecpri_threads++;
+  }
+  else
+  {
+    syslog(LOG_INFO, "No raw Ethernet eCPRI socket on %s: %s\n", eth_port_name, strerror(errno));
   }
 
-#ifdef SO_REUSEPORT
-  if (setsockopt(sock_ip, SOL_SOCKET, SO_REUSEPORT, (const char*)&reuse, sizeof(reuse)) < 0) 
+  if((ecpri_stop_fd = eventfd(0, EFD_CLOEXEC)) < 0)
   {
-     syslog(LOG_ERR, "setsockopt(SO_REUSEPORT) failed\n");
+     syslog(LOG_ERR, "Error creating eCPRI thread eventfd\n");
      return(-1);
   }
-#endif    
-  
-  flags = SOF_TIMESTAMPING_TX_HARDWARE | SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RX_SOFTWARE;
-  flags |= SOF_TIMESTAMPING_RAW_HARDWARE | SOF_TIMESTAMPING_SOFTWARE;
-#ifdef SOF_TIMESTAMPING_OPT_TX_SWHW
-  flags |= SOF_TIMESTAMPING_OPT_TX_SWHW;
-#endif
-#ifdef   SOF_TIMESTAMPING_OPT_ID
-  flags |= SOF_TIMESTAMPING_OPT_ID;
-#endif
-#ifdef   SOF_TIMESTAMPING_OPT_TSONLY
-  flags |= SOF_TIMESTAMPING_OPT_TSONLY;
-#endif
-#ifdef   SOF_TIMESTAMPING_OPT_CMSG
-  flags |= SOF_TIMESTAMPING_OPT_CMSG;
-#endif
-  
-  err = setsockopt(sock_ip, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags));
-  if ( err < 0) 
+  for(i = 0; i < ecpri_threads; i++)
   {
-    syslog(LOG_ERR, "ioctl SO_TIMESTAMPING failed: %x\n", err);
-    return (-1);
+    if((err = pthread_create(&ecpri_thread[i], NULL, comms_ecpri_thread, (void *)(intptr_t)i)) != 0)
+    {
+      syslog(LOG_ERR, "Error starting eCPRI thread: %s\n", strerror(err));
+      return(-1);
+    }
+    num_ecpri_threads = i + 1;
   }
 
-  strncpy(ifreq.ifr_name, eth_port_name, sizeof(ifreq.ifr_name) - 1);
-
-  ifreq.ifr_data = (void *) &cfg;
+  return 1;
+}
 
-  cfg.tx_type = HWTSTAMP_TX_ON;
-  cfg.rx_filter = HWTSTAMP_FILTER_ALL;
+/*****************************************************************************/
+/**
+*
+* Opens the listening socket for OpenMetrics scrapes.
+* 
+*
+* @param [in]  port   port to bind the metrics TCP/IP socket to
+*
+* @return
+*    - 1 on success
+*    - -1 on error
+*
+******************************************************************************/
+int open_metrics(int port)
+{
+  struct sockaddr_in in_serv_addr;
+  int reuse = 1;
 
-  err = ioctl(sock_ip, SIOCSHWTSTAMP, &ifreq);
-  if (err < 0) {
-    err = errno;
-    syslog(LOG_ERR, "SIOCSHWTSTAMP failed %x\n", err);
-    if (err == ERANGE)
-      syslog(LOG_ERR, "The requested time stamping mode is not supported by the hardware.\n");
-  } else {
-    syslog(LOG_ERR, "new settings:\ntx_type %d\nrx_filter %d\n", cfg.tx_type, cfg.rx_filter);
+  if ((sock_metrics = socket(AF_INET,SOCK_STREAM,0)) < 0)
+  {
+     syslog(LOG_ERR, "Error creating metrics socket\n");
+     return(-1);
   }
 
-  if(!nohw)
+  if (setsockopt(sock_metrics, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse)) < 0)
   {
-    memset(&ifreq, 0, sizeof(ifreq));
-    snprintf(ifreq.ifr_name, sizeof(ifreq.ifr_name), "%s", eth_port_name);
-    if (setsockopt(sock_ip, SOL_SOCKET, SO_BINDTODEVICE, (void *)&ifreq, sizeof(ifreq)) < 0) 
-    {
-      syslog(LOG_ERR, "ioctl SO_BINDTODEVICE failed: %x\n", errno);
-      return (-1);
-    }
+     syslog(LOG_ERR, "setsockopt(SO_REUSEADDR) failed\n");
+     close(sock_metrics);
+     sock_metrics = -1;
+     return(-1);
   }
 
   bzero((char *)&in_serv_addr, sizeof(in_serv_addr));
   in_serv_addr.sin_family = AF_INET;
   in_serv_addr.sin_addr.s_addr = INADDR_ANY;
-  in_serv_addr.sin_port = port_ip;
-  if (bind(sock_ip, (struct sockaddr *)&in_serv_addr, sizeof(in_serv_addr)) < 0) 
+  in_serv_addr.sin_port = htons(port);
+  if (bind(sock_metrics, (struct sockaddr *)&in_serv_addr, sizeof(in_serv_addr)) < 0)
   {
-     syslog(LOG_ERR, "Error %x binding UDP socket\n", errno);
+     syslog(LOG_ERR, "Error binding metrics socket\n");
+     close(sock_metrics);
+     sock_metrics = -1;
+     return(-1);
+  }
+  listen(sock_metrics, 5);
+  fcntl(sock_metrics, F_SETFL, fcntl(sock_metrics, F_GETFL) | O_NONBLOCK);
+
+  if(comms_listen(COMMS_LISTEN_METRICS, sock_metrics) < 0)
+  {
+     close(sock_metrics);
+     sock_metrics = -1;
      return(-1);
   }
 
-  /* Set up poll structure */
-  fds[2].fd = sock_ip; 
-  fds[2].events = POLLIN;  
+  return 1;
+}
+
+
+/*****************************************************************************/
+/**
+*
+* Watches for the commands finished by the worker threads, once
+* WORKERS_API_Start() has succeeded.
+* 
+*
+* @return
+*    - 1 on success
+*    - -1 on error
+*
+******************************************************************************/
+int open_workers(void)
+{
+  return (comms_listen(COMMS_WORKERS, WORKERS_API_Event_Fd()) < 0) ? -1 : 1;
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets up the io_uring instance accepting and reading the command
+* connections, with their input buffers registered. Without it, each
+* socket is served by system calls of its own.
+*
+*
+* @return
+*    - 1 on success
+*    - -1 if the kernel has no io_uring, the sockets are served without it
+*
+******************************************************************************/
+int open_uring(void)
+{
+  struct iovec iov;
+  int err;
 
+  err = uring_init(&CommsRing, COMMS_MAX_EVENTS);
+  if(!err)
+  {
+    iov.iov_base = CommsIn;
+    iov.iov_len = sizeof(CommsIn);
+    err = uring_register_buffers(&CommsRing, &iov, 1);
+    if(err)
+    {
+      uring_exit(&CommsRing);
+    }
+  }
+  if(err)
+  {
+    syslog(LOG_NOTICE, "No io_uring for the command connections (%d)\n", err);
+    return -1;
+  }
   return 1;
 }
 
+/*****************************************************************************/
+/**
+*
+* Hands the command returned by get_message() to the worker threads. Its
+* reply is sent by send_response() once it is done, and no other command is
+* taken from the same connection meanwhile.
+* 
+*
+* @param [in]  command  command string
+*
+* @return
+*    - 0 if the command was handed over
+*    - 1 if it must be run and answered by the caller
+*
+******************************************************************************/
+int dispatch_command(char *command)
+{
+  comms_conn_struct *conn = CommsCurrent;
+
+  if(!conn || WORKERS_API_Submit(command, conn))
+  {
+    return 1;
+  }
+
+  conn->Busy = 1;
+  CommsCurrent = NULL;
+  return 0;
+}
 
 /*****************************************************************************/
 /**
 *
-* Gets any pending incoming messages.
+* Gets the next command, waiting for one at most timeout milliseconds.
+* Connections, metrics scrapes and the replies of the commands run by the
+* worker threads are handled on the way.
 * 
 *
-* @param [in]  nohw     soft mode, do not check UNIX socket
+* @param [in]  nohw     soft mode, no UNIX socket is open
 * @param [out]  command  pointer to string to copy incoming command into 
+* @param [in]  timeout  epoll_wait() timeout in milliseconds, -1 to wait forever
 *
 * @return
 *    - length of command string on success
+*    - 0 if the timeout expired or the messages were handled internally
 *    - -1 on error
 *
 ******************************************************************************/
-int get_message(int nohw, char *command)
+int get_message(int nohw, char *command, int timeout)
 {
-  unsigned int clilen, in_len = 0;
+  struct epoll_event events[COMMS_MAX_EVENTS];
+  comms_conn_struct *ready[COMMS_MAX_EVENTS];
+  int slots[COMMS_MAX_EVENTS];
+  comms_conn_struct *conn;
+  int num = 0;
+  int idle;
+  int len;
   int ret;
+  int i;
+
+  /* A command whose handler sent no reply is finished */
+  CommsCurrent = NULL;
 
-  if ((ret = poll(fds, NUM_LISTEN_SOCKETS, -1)) < 0) 
+  /* Wait no longer than until the next client turns out to be one-shot */
+  idle = comms_oneshot_poll();
+  if((idle >= 0) && ((timeout < 0) || (idle < timeout)))
   {
-    syslog(LOG_ERR, "Error polling for connections\n");
-    return -1;
+    timeout = idle;
   }
 
-  if((!nohw) && (fds[0].revents & POLLIN))
+  /* Commands already received are taken first, without waiting */
+  len = WORKERS_API_Full() ? 0 : comms_ready_command(command);
+  if(len)
   {
-    struct sockaddr_un cli_addr;
+    return len;
+  }
 
-    clilen = sizeof(cli_addr);
-    newsockfd = accept(fds[0].fd, (struct sockaddr *)&cli_addr, &clilen);
-    if (newsockfd < 0)
+  if ((ret = epoll_wait(epoll_fd, events, COMMS_MAX_EVENTS, timeout)) < 0) 
+  {
+    if(errno == EINTR)
     {
-      syslog(LOG_ERR, "Error accepting connection\n");
-      return -1;
+      return 0;
     }
-    in_len = read(newsockfd, command, MAX_RESPONSE_LENGTH);
+    syslog(LOG_ERR, "Error polling for connections\n");
+    return -1;
+  }
 
-    if(in_len > 0)
+  /* Accepts and reads come last, all at once */
+  for(i = 0; i < ret; i++)
+  {
+    conn = events[i].data.ptr;
+    slots[i] = -1;
+    switch(conn->Type)
     {
-      command[in_len] = 0;
+    case COMMS_LISTEN_UNIX:
+    case COMMS_LISTEN_TCP:
+    case COMMS_LISTEN_METRICS:
+      break;
+
+    case COMMS_WORKERS:
+      WORKERS_API_Complete(comms_command_done);
+      break;
+
+    case COMMS_CLIENT:
+      /* A connection closed by an earlier event is gone from the table */
+      if(CommsConns[conn->Slot] != conn)
+      {
+        break;
+      }
+      if(events[i].events & (EPOLLERR | EPOLLHUP))
+      {
+        if(!(events[i].events & EPOLLIN))
+        {
+          comms_close(conn);
+          break;
+        }
+      }
+      if(events[i].events & EPOLLOUT)
+      {
+        comms_flush(conn);
+        if(CommsConns[conn->Slot] != conn)
+        {
+          break;
+        }
+      }
+      if(events[i].events & EPOLLIN)
+      {
+        slots[i] = conn->Slot;
+      }
+      break;
     }
   }
-  else if(fds[1].revents & POLLIN)
-  {
-    struct sockaddr_in cli_addr;
 
-    clilen = sizeof(cli_addr);
-    newsockfd = accept(fds[1].fd, (struct sockaddr *)&cli_addr, &clilen);
-    if (newsockfd < 0)
+  for(i = 0; i < ret; i++)
+  {
+    conn = events[i].data.ptr;
+    if((slots[i] >= 0) ? (CommsConns[slots[i]] == conn) :
+       ((conn->Type == COMMS_LISTEN_UNIX) || (conn->Type == COMMS_LISTEN_TCP) ||
+        (conn->Type == COMMS_LISTEN_METRICS)))
     {
-      syslog(LOG_ERR, "Error accepting connection\n");
-      return -1;
+      ready[num++] = conn;
     }
-    in_len = read(newsockfd, command, MAX_RESPONSE_LENGTH);
-
-    if(in_len > 0)
+  }
+  if(CommsRing.Fd >= 0)
+  {
+    if(comms_uring_batch(ready, num))
     {
-      command[in_len] = 0;
+      /* epoll reports the sockets not served again */
+      syslog(LOG_ERR, "io_uring submission failed, serving the sockets without it\n");
+      uring_exit(&CommsRing);
     }
   }
-  else if(fds[2].revents & (POLLIN|POLLERR))
+  else
   {
-    /* in_len will get set to 0 if handled internally, or -1 on error */
-    in_len = proto_ecpri_handle_incoming_msg(fds[2].fd, fds[2].revents, command);
+    for(i = 0; i < num; i++)
+    {
+      if(ready[i]->Type == COMMS_CLIENT)
+      {
+        comms_read(ready[i]);
+      }
+      else
+      {
+        comms_accept(ready[i]);
+      }
+    }
   }
-  
-  return(in_len);
+
+  bzero(command, MAX_RESPONSE_LENGTH);
+  return WORKERS_API_Full() ? 0 : comms_ready_command(command);
 }
 
 
 /*****************************************************************************/
 /**
 *
-* Sends response message.
+* Sends the response to the command returned by get_message(), on the
+* connection it came from. A connection which subscribed is handed over to
+* the subscriptions.
 * 
 *
-* @param [in]  response     pointer to the response string to send.
+* @param [in]  response     response to send.
 *
 ******************************************************************************/
-void send_response(char *response)
-{  
-  
-  if (write(newsockfd, response, strlen(response)) < 0)
+void send_response(response_t *response)
+{
+  comms_conn_struct *conn = CommsCurrent;
+
+  CommsCurrent = NULL;
+  if(!conn)
+  {
+    return;
+  }
+
+  /* Queue the reply behind those not sent yet */
+  if(comms_queue(conn, response) < 0)
   {
     syslog(LOG_ERR, "Error sending response\n");
+    comms_close(conn);
+    return;
   }
-  
-  close(newsockfd);
+
+  if(SUBSCRIBE_API_Is_Pending())
+  {
+    comms_watch(conn, 0);
+    if(SUBSCRIBE_API_Attach(conn->Fd, conn->Out + conn->OutSent, conn->OutLen - conn->OutSent))
+    {
+      /* The subscriptions own the socket now */
+      CommsConns[conn->Slot] = NULL;
+      free(conn->Out);
+      free(conn);
+      return;
+    }
+  }
+
+  comms_flush(conn);
 }
 
 /*****************************************************************************/
@@ -343,17 +1782,60 @@ void send_response(char *response)
 * Closes the open sockets.
 * 
 *
-* @param [in]  nohw     soft mode, do not close UNIX or UDP/IP sockets.
+* @param [in]  nohw     soft mode, no UNIX socket to close.
 *
 ******************************************************************************/
 void close_connections(int nohw)
 {
+  uint64_t one = 1;
+  int i;
+
+  if(ecpri_stop_fd >= 0)
+  {
+    /* The eventfd stays readable, all the threads see it */
+    if(write(ecpri_stop_fd, &one, sizeof(one)) == sizeof(one))
+    {
+      for(i = 0; i < num_ecpri_threads; i++)
+      {
+        pthread_join(ecpri_thread[i], NULL);
+      }
+    }
+    close(ecpri_stop_fd);
+    ecpri_stop_fd = -1;
+  }
+
+  SUBSCRIBE_API_Close_All();
+  for(i = 0; i < COMMS_MAX_CONNECTIONS; i++)
+  {
+    if(CommsConns[i])
+    {
+      /* The worker threads are stopped, no reply is coming */
+      CommsConns[i]->Busy = 0;
+      comms_close(CommsConns[i]);
+    }
+  }
+  close(epoll_fd);
+  epoll_fd = -1;
+  if(CommsRing.Fd >= 0)
+  {
+    uring_exit(&CommsRing);
+  }
   close(sock_tcp);
+  if(sock_metrics >= 0)
+  {
+    close(sock_metrics);
+  }
   if(!nohw)
   {
     close(sock_fd);
     unlink(XROE_SOCKET_FILE); /* Deletes the file */
-    close(sock_ip);
   }
+
+  /* The eCPRI sockets, raw Ethernet included, are open in soft mode too */
+  for(i = 0; i < num_ecpri_threads; i++)
+  {
+    close(ecpri_socks[i]);
+  }
+  num_ecpri_threads = 0;
 }
 /** @} */
@@ -14,13 +14,16 @@
 *
 ******************************************************************************/
 
+#include <response.h>
+
 /**
  * XROE_SOCKET_FILE File name for UNIX socket.
  */
 #define XROE_SOCKET_FILE "/tmp/xroe"
 
 /**
- * MAX_RESPONSE_LENGTH Length of response string.
+ * MAX_RESPONSE_LENGTH Length of command strings, responses grow as needed
+ * (see response.h).
  */
 #define MAX_RESPONSE_LENGTH 1024
 
@@ -42,12 +45,61 @@
 /**
  * NUM_LISTEN_SOCKETS Number of sockets in the open socket list.
  */
-#define NUM_LISTEN_SOCKETS 3
+#define NUM_LISTEN_SOCKETS 4
+
+/**
+ * COMMS_MAX_CONNECTIONS Number of command connections open at the same time.
+ */
+#define COMMS_MAX_CONNECTIONS 256
+
+/**
+ * COMMS_MAX_EVENTS Number of socket events handled per wait.
+ */
+#define COMMS_MAX_EVENTS 64
+
+/**
+ * COMMS_MAX_PENDING_OUTPUT Bytes of replies waiting to be sent above which
+ * no more commands are taken from a connection.
+ */
+#define COMMS_MAX_PENDING_OUTPUT 65536
+
+/**
+ * COMMS_ONESHOT_IDLE_MS Time after which a client that has sent part of a
+ * line, and never a newline, is taken as a one-shot client of the earlier
+ * protocol which does not shut down its side of the connection.
+ */
+#define COMMS_ONESHOT_IDLE_MS 200
+
+/**
+ * COMMS_PIPELINE_CMD Connection option preceding each reply with its length.
+ */
+#define COMMS_PIPELINE_CMD "pipeline"
+
+/**
+ * COMMS_PIPELINE_STR Reply to COMMS_PIPELINE_CMD.
+ */
+#define COMMS_PIPELINE_STR "pipeline on\n"
+
+/**
+ * COMMS_PIPELINE_STATUS_CMD Connection option preceding each reply with its
+ * length, the return value of the command and the time it took in
+ * microseconds: "<length> <status> <usecs>\n".
+ */
+#define COMMS_PIPELINE_STATUS_CMD "pipeline status"
+
+/**
+ * COMMS_PIPELINE_STATUS_STR Reply to COMMS_PIPELINE_STATUS_CMD.
+ */
+#define COMMS_PIPELINE_STATUS_STR "pipeline status on\n"
 
 /************************** Function Prototypes ******************************/
-int open_connections(int nohw, int port, char *);
-int get_message(int nohw, char *command);
-void send_response(char *response);
+int open_connections(int nohw, int port, char *, int ecpri_threads);
+int open_metrics(int port);
+int open_workers(void);
+int open_uring(void);
+int dispatch_command(char *command);
+int get_message(int nohw, char *command, int timeout);
+void send_response(response_t *response);
 void close_connections(int nohw);
 
 extern int sock_ip; /**< File descriptor number for UDP/IP socket */
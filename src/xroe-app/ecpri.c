@@ -29,11 +29,12 @@
 #include <ecpri_str.h>
 #include <ecpri_proto.h>
 #include <comms.h>
+#include <ecpri_rt.h>
 
 /**
  * ECPRI_MAX_COMMANDS Number of commands handled by the ecpri module.
  */
-#define ECPRI_MAX_COMMANDS 9
+#define ECPRI_MAX_COMMANDS 10
 
 /**
  * RMA_READ Flag to indicate an RMA read operation.
@@ -46,14 +47,15 @@
 #define RMA_WRITE 2
 
 /************************** Function Prototypes ******************************/
-int ecpri_help_func(int argc, char **argv, char *resp);
-int ecpri_owdm_req_func(int argc, char **argv, char *resp);
-int ecpri_owdm_res_func(int argc, char **argv, char *resp);
-int ecpri_owdm_limit_func(int argc, char **argv, char *resp);
-int ecpri_rma_read_func(int argc, char **argv, char *resp);
-int ecpri_rma_write_func(int argc, char **argv, char *resp);
-int ecpri_test_mesg_func(int argc, char **argv, char *resp);
-int ecpri_rmr_req_func(int argc, char **argv, char *resp);
+int ecpri_help_func(int argc, char **argv, response_t *resp);
+int ecpri_owdm_req_func(int argc, char **argv, response_t *resp);
+int ecpri_owdm_res_func(int argc, char **argv, response_t *resp);
+int ecpri_owdm_limit_func(int argc, char **argv, response_t *resp);
+int ecpri_rma_read_func(int argc, char **argv, response_t *resp);
+int ecpri_rma_write_func(int argc, char **argv, response_t *resp);
+int ecpri_test_mesg_func(int argc, char **argv, response_t *resp);
+int ecpri_rmr_req_func(int argc, char **argv, response_t *resp);
+int ecpri_rt_func(int argc, char **argv, response_t *resp);
 
 /**
  * ecpri_cmds The commands handled by the disable module.
@@ -69,6 +71,7 @@ commands_t ecpri_cmds[ECPRI_MAX_COMMANDS] = {
 	{"owdm_limit", ECPRI_OWDM_LIMIT_STR, ecpri_owdm_limit_func},  /**< "owdm_limit" command */
 	{"test_mesg", ECPRI_TEST_MESG_STR, ecpri_test_mesg_func},  /**< "test_msg" command */
 	{"rmr_req", ECPRI_RMR_REQ_STR, ecpri_rmr_req_func},  /**< "rmr_req" command */
+	{"rt", ECPRI_RT_STR, ecpri_rt_func},  /**< "rt" command */
 	/* Keep this last - insert commands above */
 	{NULL, NULL, NULL} /**< NULL command to terminate array */ 
 };
@@ -81,7 +84,7 @@ commands_t ecpri_cmds[ECPRI_MAX_COMMANDS] = {
 * 
 *
 * @param [in]	type   		The direction, either TO_REMOTE or FROM_REMOTE.
-* @param [in]	dest_addr	IP address of remote node.
+* @param [in]	dest_addr	IP or MAC address of remote node.
 *
 * @return
 *		- 0 if address is not valid.
@@ -90,12 +93,10 @@ commands_t ecpri_cmds[ECPRI_MAX_COMMANDS] = {
 ******************************************************************************/
 int owdm_send_request(uint8_t type, char *dest_addr)
 {
-	struct sockaddr_in dest;
+	ecpri_peer_t dest;
 	int retval = 0;
 	
-	dest.sin_family = AF_INET;
-	dest.sin_port = port_ip;
-	if(inet_aton(dest_addr, (struct in_addr *)&dest.sin_addr) != 0)
+	if(proto_ecpri_parse_peer(dest_addr, port_ip, &dest) == 0)
 	{
 		retval = proto_ecpri_owdm_send_request(type, &dest);
 	}
@@ -111,7 +112,7 @@ int owdm_send_request(uint8_t type, char *dest_addr)
 * 
 *
 * @param [in]	type   		Can be read or write.
-* @param [in]	dest_addr	IP address of remote node.
+* @param [in]	dest_addr	IP or MAC address of remote node.
 * @param [in]	addr   		The remote memory address to access.
 * @param [in]	length   	The number of bytes to access.
 * @param [in]	values		Array of byte values to write, or NULL on read.
@@ -124,7 +125,7 @@ int owdm_send_request(uint8_t type, char *dest_addr)
 ******************************************************************************/
 int rma_send_request(int type, char *dest_addr, char *addr, char *length, char *values)
 {
-	struct sockaddr_in dest;
+	ecpri_peer_t dest;
 	uint64_t mem_addr;
 	uint16_t data_length;
 	char *val, *next_val;
@@ -162,9 +163,7 @@ int rma_send_request(int type, char *dest_addr, char *addr, char *length, char *
 	
 	if(retval == 0)
 	{
-		dest.sin_family = AF_INET;
-		dest.sin_port = port_ip;
-		if(inet_aton(dest_addr, (struct in_addr *)&dest.sin_addr) != 0)
+		if(proto_ecpri_parse_peer(dest_addr, port_ip, &dest) == 0)
 		{
 			retval = proto_ecpri_rma_send_request(type, data_length, &dest, mem_addr, ptr);
 		}
@@ -187,8 +186,9 @@ int rma_send_request(int type, char *dest_addr, char *addr, char *length, char *
 * This function calls the eCPRI protocol module to format and send the message.
 * 
 *
-* @param [in]	dest_addr	IP address of remote node.
-* @param [in]	dest_port	IP port address of the remote node.
+* @param [in]	dest_addr	IP or MAC address of remote node.
+* @param [in]	dest_port	IP port address of the remote node, unused for a
+*							MAC address.
 *
 * @return
 *		- 0 if address is not valid.
@@ -197,14 +197,12 @@ int rma_send_request(int type, char *dest_addr, char *addr, char *length, char *
 ******************************************************************************/
 int test_mesg_send_request(char *dest_addr, char *dest_port)
 {
-	struct sockaddr_in dest;
+	ecpri_peer_t dest;
 	int retval = 0;
 	int port = 0;
 
 	port = strtoll(dest_port, NULL, 0);
-	dest.sin_family = AF_INET;
-	dest.sin_port = htons(port);
-	if(inet_aton(dest_addr, (struct in_addr *)&dest.sin_addr) != 0)
+	if(proto_ecpri_parse_peer(dest_addr, htons(port), &dest) == 0)
 	{
 		retval = proto_ecpri_test_mesg_send(&dest);
 	}
@@ -220,21 +218,22 @@ int test_mesg_send_request(char *dest_addr, char *dest_port)
 * 
 *
 * @param [in]	type   		Can be read or write.
-* @param [in]	addr   		Ignored.
+* @param [in]	addr   		IP or MAC address of the remote node the request was sent to.
 * @param [in]	length   	The number of bytes read/written.
-* @param [in]	values		Array of byte values read, or NULL on write.
+* @param [in,out]	resp	Response to append the byte values read to.
 *
 * @return
+*		- -1 if address is not valid.
 *		- Return value of proto_ecpri_rma_get_response().
 *
 ******************************************************************************/
-int rma_get_response(int type, char *addr, int *length, char **values)
+int rma_get_response(int type, char *addr, int *length, response_t *resp)
 {
-	struct sockaddr_in src;
-	char *val;
+	ecpri_peer_t src;
 	int i;
 	uint8_t *ptr=NULL;
 	int retval = 0;
+	int err;
 
 	if(type==RMA_READ)
 	{
@@ -245,21 +244,26 @@ int rma_get_response(int type, char *addr, int *length, char **values)
 		type = ECPRI_RMA_MSG_WRITE;
 	}
 
+	/* The response is read on the socket the request was sent from */
+	if((err = proto_ecpri_parse_peer(addr, port_ip, &src)) != 0)
+	{
+		resp_printf(resp, "%s: %s\n", addr, strerror(err));
+		return -1;
+	}
 	retval = proto_ecpri_rma_get_response(type, length, &src, &ptr);
 	if(retval==0)
 	{		
 		if(type==ECPRI_RMA_MSG_READ)
 		{
-			val = *values;
 			for(i = 0; i < *length; i++)
 			{
-				val+=sprintf(val, " 0x%02x", ptr[i]);
+				resp_printf(resp, " 0x%02x", ptr[i]);
 			}
-			sprintf(val, "\n");
+			resp_printf(resp, "\n");
 		}
 		else
 		{
-			sprintf(*values, "got OK response, length %d\n", *length);
+			resp_printf(resp, "got OK response, length %d\n", *length);
 		}
 		
 		if(ptr)
@@ -287,12 +291,10 @@ int rma_get_response(int type, char *addr, int *length, char **values)
 ******************************************************************************/
 int rmr_send_request(char *dest_addr)
 {
-	struct sockaddr_in dest;
+	ecpri_peer_t dest;
 	int retval = 0;
 	
-	dest.sin_family = AF_INET;
-	dest.sin_port = port_ip;
-	if(inet_aton(dest_addr, (struct in_addr *)&dest.sin_addr) != 0)
+	if(proto_ecpri_parse_peer(dest_addr, port_ip, &dest) == 0)
 	{
 		retval = proto_ecpri_rmr_send_request(&dest);
 	}
@@ -308,21 +310,28 @@ int rmr_send_request(char *dest_addr)
 * 
 *
 * @param [in]	addr	Address of the remote node to reset.
-* @param [out]	values	Pointer to string to place the response into.
+* @param [in,out]	resp	Response to append the outcome to.
 *
 * @return
+*		- -1 if address is not valid.
 *		- Return value of proto_ecpri_rmr_get_response().
 *
 ******************************************************************************/
-int rmr_get_response(char *addr, char **values)
+int rmr_get_response(char *addr, response_t *resp)
 {
-	struct sockaddr_in src;
+	ecpri_peer_t src;
 	int retval = 0;
+	int err;
 
+	if((err = proto_ecpri_parse_peer(addr, port_ip, &src)) != 0)
+	{
+		resp_printf(resp, "%s: %s\n", addr, strerror(err));
+		return -1;
+	}
 	retval = proto_ecpri_rmr_get_response(&src);
 	if(retval==0)
 	{		
-		sprintf(*values, "got OK response\n");		
+		resp_printf(resp, "got OK response\n");		
 	}
 	
 	return retval;
@@ -336,22 +345,21 @@ int rmr_get_response(char *addr, char **values)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int ecpri_help_func(int argc, char **argv, char *resp)
+int ecpri_help_func(int argc, char **argv, response_t *resp)
 {
 	int i;
-	char *str = resp;
 	
-	str += sprintf(str, "ecpri help:\n");
+	resp_printf(resp, "ecpri help:\n");
 	
 	for(i=0; ecpri_cmds[i].cmd != NULL; i++)
 	{
-		str += sprintf(str, "\t%s\t : %s", ecpri_cmds[i].cmd, ecpri_cmds[i].helptxt);
+		resp_printf(resp, "\t%s\t : %s", ecpri_cmds[i].cmd, ecpri_cmds[i].helptxt);
 	}
 	return 0;
 }
@@ -364,27 +372,26 @@ int ecpri_help_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int ecpri_rma_read_func(int argc, char **argv, char *resp)
+int ecpri_rma_read_func(int argc, char **argv, response_t *resp)
 {
-	char *str = resp;
 	int read_length;
 	
 	if(argc != 3)
 	{
-		sprintf(str, "%s", ECPRI_RMA_READ_STR);
+		resp_printf(resp, "%s", ECPRI_RMA_READ_STR);
 	}
 	else
 	{
-		str += sprintf(str, "Sending RMA read request of %s bytes at %s to %s:\n", argv[2], argv[1], argv[0]);
+		resp_printf(resp, "Sending RMA read request of %s bytes at %s to %s:\n", argv[2], argv[1], argv[0]);
 		rma_send_request(RMA_READ, argv[0], argv[1], argv[2], NULL);
-		str += sprintf(str, "RMA read response: ");
-		rma_get_response(RMA_READ, argv[0], &read_length, &str);
+		resp_printf(resp, "RMA read response: ");
+		rma_get_response(RMA_READ, argv[0], &read_length, resp);
 	}	
 	return 0;
 }
@@ -397,22 +404,21 @@ int ecpri_rma_read_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int ecpri_rma_write_func(int argc, char **argv, char *resp)
+int ecpri_rma_write_func(int argc, char **argv, response_t *resp)
 {
-	char *str = resp;
 	int read_length;
 	char numbers[1024];
 	int i;
 	
 	if((argc < 4) || (atoi(argv[2]) != argc-3))
 	{
-		sprintf(str, "%s", ECPRI_RMA_WRITE_STR);
+		resp_printf(resp, "%s", ECPRI_RMA_WRITE_STR);
 	}
 	else
 	{
@@ -422,11 +428,11 @@ int ecpri_rma_write_func(int argc, char **argv, char *resp)
 			strcat(numbers, argv[i+3]);
 			strcat(numbers, " ");
 		}
-		str += sprintf(str, "Sending RMA write request of %s to %s:\n", argv[1], argv[0]);
+		resp_printf(resp, "Sending RMA write request of %s to %s:\n", argv[1], argv[0]);
 		
 		rma_send_request(RMA_WRITE, argv[0], argv[1], argv[2], numbers);
 
-		rma_get_response(RMA_WRITE, argv[0], &read_length, &str);
+		rma_get_response(RMA_WRITE, argv[0], &read_length, resp);
 	}	
 	return 0;
 }
@@ -440,24 +446,23 @@ int ecpri_rma_write_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int ecpri_owdm_req_func(int argc, char **argv, char *resp)
+int ecpri_owdm_req_func(int argc, char **argv, response_t *resp)
 {
-	char *str = resp;
 	uint8_t owdm_type;
 	
 	if(argc != 2)
 	{
-		sprintf(str, "%s\n", ECPRI_OWDM_REQ_STR);
+		resp_printf(resp, "%s\n", ECPRI_OWDM_REQ_STR);
 	}
 	else
 	{
-		str += sprintf(str, "Starting OWDM measurement to %s (type %s):\n", argv[0], argv[1]);
+		resp_printf(resp, "Starting OWDM measurement to %s (type %s):\n", argv[0], argv[1]);
 
 		if(strncmp(argv[1], "to_remote", 9)==0)
 		{
@@ -471,7 +476,7 @@ int ecpri_owdm_req_func(int argc, char **argv, char *resp)
 		}
 		else
 		{
-			sprintf(str, "%s\n", ECPRI_OWDM_REQ_STR);
+			resp_printf(resp, "%s\n", ECPRI_OWDM_REQ_STR);
 		}
 	}
 
@@ -486,19 +491,18 @@ int ecpri_owdm_req_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int ecpri_owdm_res_func(int argc, char **argv, char *resp)
+int ecpri_owdm_res_func(int argc, char **argv, response_t *resp)
 {
-	char *str = resp;
 	
 	if(argc != 0)
 	{
-		sprintf(str, "%s\n", ECPRI_OWDM_RES_STR);
+		resp_printf(resp, "%s\n", ECPRI_OWDM_RES_STR);
 	}
 	else
 	{
@@ -513,11 +517,11 @@ int ecpri_owdm_res_func(int argc, char **argv, char *resp)
 		
 		if(req_no != resp_no)
 		{
-			sprintf(str, "OWDM result: pending\n");
+			resp_printf(resp, "OWDM result: pending\n");
 		}
 		else
 		{
-			sprintf(str, "OWDM result #%d: direction %s (%s), %llu.%09lu\n", 
+			resp_printf(resp, "OWDM result #%d: direction %s (%s), %llu.%09lu\n", 
 						 resp_no,
 						 direction==TO_REMOTE?"TO_REMOTE":"FROM_REMOTE",
 						 inet_ntoa(node),
@@ -538,26 +542,25 @@ int ecpri_owdm_res_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int ecpri_owdm_limit_func(int argc, char **argv, char *resp)
+int ecpri_owdm_limit_func(int argc, char **argv, response_t *resp)
 {
-	char *str = resp;
 	
 	if(argc != 1)
 	{
-		sprintf(str, "%s\n", ECPRI_OWDM_LIMIT_STR);
+		resp_printf(resp, "%s\n", ECPRI_OWDM_LIMIT_STR);
 	}
 	else
 	{
 		long limit = strtol(argv[0], NULL, 0);
 
 		proto_ecpri_set_owdm_limit(limit);
-		sprintf(str, "OWDM report limit set to %ld\n", limit);
+		resp_printf(resp, "OWDM report limit set to %ld\n", limit);
 	}
 	return 0;
 }
@@ -570,26 +573,25 @@ int ecpri_owdm_limit_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int ecpri_rmr_req_func(int argc, char **argv, char *resp)
+int ecpri_rmr_req_func(int argc, char **argv, response_t *resp)
 {
-	char *str = resp;
 	
 	if(argc != 1)
 	{
-		sprintf(str, "%s", ECPRI_RMR_REQ_STR);
+		resp_printf(resp, "%s", ECPRI_RMR_REQ_STR);
 	}
 	else
 	{
-		str += sprintf(str, "Sending RMR request to %s:\n", argv[0]);
+		resp_printf(resp, "Sending RMR request to %s:\n", argv[0]);
 		rmr_send_request(argv[0]);
-		str += sprintf(str, "RMR response: ");
-		rmr_get_response(argv[0], &str);
+		resp_printf(resp, "RMR response: ");
+		rmr_get_response(argv[0], resp);
 	}	
 	return 0;
 }
@@ -602,23 +604,23 @@ int ecpri_rmr_req_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 1 if no commands tokens found.
 *		- 2 if no handler found for command.
-*		- 0 otherwise.
+*		- the return value of the command handler otherwise.
 *
 ******************************************************************************/
-int ecpri_func(int argc, char **argv, char *resp)
+int ecpri_func(int argc, char **argv, response_t *resp)
 {
 	int count = 0;
 	int found = 0;
-	char *str = resp;
+	int ret = 0;
 	
 	if(argc == 0)
 	{
-		sprintf(str, "\t%s", ECPRI_USAGE_STR);
+		resp_printf(resp, "\t%s", ECPRI_USAGE_STR);
 		return(1);
 	}
 
@@ -627,18 +629,21 @@ int ecpri_func(int argc, char **argv, char *resp)
 		if(strcmp(argv[0], ecpri_cmds[count].cmd)==0)
 		{
 			found = 1;
-			/* Call the handler function for the command given */
-			ecpri_cmds[count].func(argc-1, &argv[1], str);
+			/* Call the handler function for the command given, which may
+			   wait for a response on the socket of incoming messages */
+			proto_ecpri_lock();
+			ret = ecpri_cmds[count].func(argc-1, &argv[1], resp);
+			proto_ecpri_unlock();
 		}
 	}
 	
 	if(!found)
 	{
-		sprintf(str, "Command %s not found, try \"help\"\n", argv[0]);
+		resp_printf(resp, "Command %s not found, try \"help\"\n", argv[0]);
 		return(2);
 	}
 
-	return 0;
+	return ret;
 }
 
 /*****************************************************************************/
@@ -649,24 +654,133 @@ int ecpri_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int ecpri_test_mesg_func(int argc, char **argv, char *resp)
+int ecpri_test_mesg_func(int argc, char **argv, response_t *resp)
 {
-	char *str = resp;
 
 	if(argc != 2)
 	{
-		sprintf(str, "%s", ECPRI_TEST_MESG_STR);
+		resp_printf(resp, "%s", ECPRI_TEST_MESG_STR);
 		return(1);
 	}
 
-	str += sprintf(str, "Sending test message to %s:%s\n", argv[0], argv[1]);
+	resp_printf(resp, "Sending test message to %s:%s\n", argv[0], argv[1]);
 	test_mesg_send_request(argv[0], argv[1]);
 	return 0;
 }
-/** @} */
\ No newline at end of file
+/*****************************************************************************/
+/**
+*
+* Formats the outcome of one real-time setting of the eCPRI thread.
+*
+* @param [in]	err   errno of the setting.
+*
+* @return
+*		- "ok" or the error text
+*
+******************************************************************************/
+static const char *ecpri_rt_result(int err)
+{
+	return err ? strerror(err) : "ok";
+}
+
+/*****************************************************************************/
+/**
+*
+* Reports the real-time settings of the eCPRI thread and its wake-up latency
+* for each event, or clears the latency statistics.
+*
+* @param [in]	argc   Number of string arguments.
+* @param [in]	argv   Array of strings containg arguments.
+* @param [in,out]	resp   Response to append the reply text to.
+*
+* @return
+*		- 0 on success
+*		- 1 on bad arguments
+*
+******************************************************************************/
+int ecpri_rt_func(int argc, char **argv, response_t *resp)
+{
+	ecpri_rt_config_struct config;
+	ecpri_rt_latency_struct latency;
+	int event;
+	int i;
+
+	if(argc == 1 && !strcmp(argv[0], "reset"))
+	{
+		ECPRI_RT_API_Reset();
+		resp_printf(resp, "eCPRI thread latency statistics cleared\n");
+		return 0;
+	}
+	if(argc != 0)
+	{
+		resp_printf(resp, "%s", ECPRI_RT_STR);
+		return 1;
+	}
+
+	ECPRI_RT_API_Get_Config(&config);
+	resp_printf(resp, "eCPRI thread: cpu ");
+	if(config.Cpu < 0)
+	{
+		resp_printf(resp, "any");
+	}
+	else
+	{
+		resp_printf(resp, "%d (%s)", config.Cpu, ecpri_rt_result(config.CpuErr));
+	}
+	if(config.Prio > 0)
+	{
+		resp_printf(resp, ", SCHED_FIFO %d (%s)", config.Prio, ecpri_rt_result(config.PrioErr));
+	}
+	else
+	{
+		resp_printf(resp, ", SCHED_OTHER");
+	}
+	if(config.Cpu >= 0 || config.Prio > 0)
+	{
+		resp_printf(resp, ", mlock (%s)", ecpri_rt_result(config.MlockErr));
+	}
+	resp_printf(resp, "\n");
+
+	for(event = 0; event < ECPRI_RT_EVENTS; event++)
+	{
+		ECPRI_RT_API_Get(event, &latency);
+		resp_printf(resp, "%s: count %llu, last %llu ns, min %llu ns, mean %llu ns, max %llu ns\n",
+		            ECPRI_RT_API_Event_Name(event),
+		            (unsigned long long)latency.Count,
+		            (unsigned long long)latency.Last,
+		            (unsigned long long)latency.Min,
+		            (unsigned long long)(latency.Count ? latency.Sum / latency.Count : 0),
+		            (unsigned long long)latency.Max);
+		if(!latency.Count)
+		{
+			continue;
+		}
+		resp_printf(resp, "\t");
+		for(i = 0; i < ECPRI_RT_BUCKETS; i++)
+		{
+			if(!latency.Buckets[i])
+			{
+				continue;
+			}
+			if(i < ECPRI_RT_BUCKETS - 1)
+			{
+				resp_printf(resp, " <%lluus:%llu",
+				            (unsigned long long)(ECPRI_RT_API_Bucket_Limit(i) / 1000),
+				            (unsigned long long)latency.Buckets[i]);
+			}
+			else
+			{
+				resp_printf(resp, " more:%llu", (unsigned long long)latency.Buckets[i]);
+			}
+		}
+		resp_printf(resp, "\n");
+	}
+	return 0;
+}
+/** @} */
@@ -12,6 +12,18 @@
 *
 *  Sample eCPRI protocol library.
 *
+*  Messages may be received on several UDP/IP sockets sharing the eCPRI
+*  port, each served by a thread of its own (see proto_ecpri_add_socket()).
+*  Each socket has its own lock and OWDM state. The peers are spread over
+*  the sockets by their address, the same way for the messages received and
+*  for the requests sent by commands, so that the replies to a request come
+*  back on the socket it was sent from.
+*
+*  Peers given by a MAC address are reached over a raw Ethernet socket
+*  instead, with the eCPRI messages carried directly in frames of EtherType
+*  ETH_P_ECPRI (see proto_ecpri_set_raw_socket()). That socket has the same
+*  per-socket state, and its messages are timestamped the same way.
+*
 ******************************************************************************/
 
 /***************************** Include Files *********************************/
@@ -32,17 +44,23 @@
 #include <errno.h>
 #include <linux/errqueue.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <netinet/ip.h>
+#include <netinet/ether.h>
+#include <net/ethernet.h>
+#include <linux/filter.h>
 
 #include <ecpri_proto.h>
 #include <comms.h>
 #include <xroe_api.h>
 
 /************************** Function Prototypes ******************************/
-int proto_ecpri_handle_incoming_rma(uint8_t *buffer, uint16_t data_len, int fd, struct sockaddr_in *src);
-int proto_ecpri_handle_incoming_owdm(uint8_t *buffer, uint16_t data_len, int fd, struct sockaddr_in *src, struct timespec *ts);
-int proto_ecpri_handle_incoming_rmr(uint8_t *buffer, uint16_t data_len, int fd, struct sockaddr_in *src);
-int proto_ecpri_handle_incoming_event(uint8_t *buffer, uint16_t data_len, int fd, struct sockaddr_in *src);
-int proto_ecpri_handle_incoming_test_mesg(uint8_t *buffer, uint16_t data_len, int fd, struct sockaddr_in *src);
+int proto_ecpri_handle_incoming_rma(uint8_t *buffer, uint16_t data_len, int fd, ecpri_peer_t *src);
+int proto_ecpri_handle_incoming_owdm(uint8_t *buffer, uint16_t data_len, int fd, ecpri_peer_t *src, struct timespec *ts);
+int proto_ecpri_handle_incoming_rmr(uint8_t *buffer, uint16_t data_len, int fd, ecpri_peer_t *src);
+int proto_ecpri_handle_incoming_event(uint8_t *buffer, uint16_t data_len, int fd, ecpri_peer_t *src);
+int proto_ecpri_handle_incoming_test_mesg(uint8_t *buffer, uint16_t data_len, int fd, ecpri_peer_t *src);
 
 /**
  * Sequence number for eCPRI test messages.
@@ -55,7 +73,7 @@ int SEQ_NUM = 0;
  */
 typedef struct owdm_result
 {
-	struct sockaddr_in node;  /**< Address of other node */
+	ecpri_peer_t node;  /**< Address of other node */
 	ecpri_owdm_direction_type direction;  /**< Direction of measurement (TO_REMOTE or FROM_REMOTE)*/
 	int resp_num;  /**< The current response number */
 	uint8_t ts_sec[6];  /**< Seconds portion of delay */
@@ -73,20 +91,53 @@ typedef struct owdm_ts_msg
 	/*}@*/
 } owdm_ts_msg_type;
 
+/**
+ * proto_ecpri_socket_type State of a socket receiving eCPRI messages.
+ */
+typedef struct proto_ecpri_socket
+{
+	int fd;  /**< Socket, bound to the eCPRI port */
+	pthread_mutex_t lock;  /**< Serialises the use of the socket and of owdm_msg */
+	owdm_ts_msg_type owdm_msg;  /**< OWDM message storage */
+	owdm_result_type owdm_result;  /**< OWDM result storage, protected by ecpri_result_lock */
+	unsigned long result_seq;  /**< Value of ecpri_result_seq when owdm_result was stored */
+	struct timespec event_ts;  /**< Software timestamp of the last message or transmit
+	                                timestamp handled, zero if it had none */
+} proto_ecpri_socket_type;
+
 /**
  * Number of OWDM requests sent by this node.
  */
 int owdm_req = 0;
 
 /**
- * OWDM result storage.
+ * Sockets receiving eCPRI messages, in the order they were bound. The first
+ * is the default one, its fd set once by proto_ecpri_add_socket().
  */
-owdm_result_type owdm_result;
+static proto_ecpri_socket_type ecpri_sockets[ECPRI_PROTO_MAX_SOCKETS] = {
+	[0] = {.fd = -1}
+};
 
 /**
- * OWDM message storage.
+ * Number of sockets in ecpri_sockets. Without any, the first entry is used,
+ * with no socket.
  */
-owdm_ts_msg_type owdm_msg;
+static int ecpri_num_sockets = 0;
+
+/**
+ * Raw Ethernet socket, for the peers given by a MAC address.
+ */
+static proto_ecpri_socket_type ecpri_raw_socket;
+
+/**
+ * Interface index of ecpri_raw_socket, 0 if there is none.
+ */
+static int ecpri_raw_ifindex = 0;
+
+/**
+ * Number of OWDM results stored, the latest is reported.
+ */
+static unsigned long ecpri_result_seq = 0;
 
 /**
  * OWDM local delay compensation value.
@@ -98,6 +149,306 @@ uint8_t owdm_comp[8] = {0, 0, 0, 0, 0, 0, 0, 0};
  */
 long ecpri_report_limit = 0;
 
+/**
+ * Initialises the socket locks once, with priority inheritance as they are
+ * shared with the real-time eCPRI threads.
+ */
+static pthread_once_t ecpri_socket_lock_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Protects the OWDM results and request count, read without the socket locks.
+ */
+static pthread_mutex_t ecpri_result_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*****************************************************************************/
+/**
+*
+* Initialises the socket locks with priority inheritance.
+*
+******************************************************************************/
+static void proto_ecpri_lock_init(void)
+{
+	pthread_mutexattr_t attr;
+	int i;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+	for(i = 0; i < ECPRI_PROTO_MAX_SOCKETS; i++)
+	{
+		pthread_mutex_init(&ecpri_sockets[i].lock, &attr);
+	}
+	pthread_mutex_init(&ecpri_raw_socket.lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the state of a socket receiving eCPRI messages.
+*
+* @param [in]	fd	Socket, as given to proto_ecpri_add_socket() or
+*					proto_ecpri_set_raw_socket().
+*
+* @return
+*		- State of the socket, that of the default (first) one if fd is
+*		  unknown. Only reads the socket table, which is set up before the
+*		  eCPRI threads start.
+*
+******************************************************************************/
+static proto_ecpri_socket_type *proto_ecpri_socket_of_fd(int fd)
+{
+	int i;
+
+	if(ecpri_raw_ifindex && (ecpri_raw_socket.fd == fd))
+	{
+		return &ecpri_raw_socket;
+	}
+	for(i = 0; i < ecpri_num_sockets; i++)
+	{
+		if(ecpri_sockets[i].fd == fd)
+		{
+			return &ecpri_sockets[i];
+		}
+	}
+	return &ecpri_sockets[0];
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the state of the socket a remote node's messages are received on.
+* The choice must match the program given by proto_ecpri_steering().
+*
+* @param [in]	peer	Address of the remote node.
+*
+* @return
+*		- State of the socket, the raw Ethernet one for a MAC address.
+*
+******************************************************************************/
+static proto_ecpri_socket_type *proto_ecpri_socket_of_peer(const ecpri_peer_t *peer)
+{
+	if(peer->sa.sa_family == AF_PACKET)
+	{
+		return &ecpri_raw_socket;
+	}
+	if(ecpri_num_sockets < 2)
+	{
+		return &ecpri_sockets[0];
+	}
+	return &ecpri_sockets[ntohl(peer->in.sin_addr.s_addr) % ecpri_num_sockets];
+}
+
+/*****************************************************************************/
+/**
+*
+* Adds a socket receiving eCPRI messages. The sockets must be added in the
+* order they were bound to the eCPRI port, that of their SO_REUSEPORT group.
+*
+* @param [in]	fd	Socket, bound to the eCPRI port.
+*
+* @return
+*		- 0 on success
+*		- ENOSPC if there are ECPRI_PROTO_MAX_SOCKETS sockets already
+*
+******************************************************************************/
+int proto_ecpri_add_socket(int fd)
+{
+	if(ecpri_num_sockets >= ECPRI_PROTO_MAX_SOCKETS)
+	{
+		return ENOSPC;
+	}
+	ecpri_sockets[ecpri_num_sockets].fd = fd;
+	ecpri_num_sockets++;
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets the raw Ethernet socket receiving eCPRI messages, an AF_PACKET socket
+* of type SOCK_DGRAM bound to ETH_P_ECPRI on one interface. The peers given
+* by a MAC address are reached through it.
+*
+* @param [in]	fd			Socket.
+* @param [in]	ifindex		Index of the interface it is bound to.
+*
+* @return
+*		- 0 on success
+*		- EINVAL if the interface index is not valid
+*
+******************************************************************************/
+int proto_ecpri_set_raw_socket(int fd, int ifindex)
+{
+	if(ifindex <= 0)
+	{
+		return EINVAL;
+	}
+	ecpri_raw_socket.fd = fd;
+	ecpri_raw_ifindex = ifindex;
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Parses the address of a remote node: an IPv4 address, reached over UDP/IP
+* on a port, or a MAC address (aa:bb:cc:dd:ee:ff), reached over the raw
+* Ethernet socket.
+*
+* @param [in]	addr	Address string.
+* @param [in]	port	UDP port, in network byte order, for an IPv4 address.
+* @param [out]	peer	Address of the remote node.
+*
+* @return
+*		- 0 on success
+*		- EINVAL if the string is not an address
+*		- ENETDOWN for a MAC address without a raw Ethernet socket
+*
+******************************************************************************/
+int proto_ecpri_parse_peer(const char *addr, in_port_t port, ecpri_peer_t *peer)
+{
+	struct ether_addr mac;
+
+	memset(peer, 0, sizeof(*peer));
+	if(inet_aton(addr, &peer->in.sin_addr) != 0)
+	{
+		peer->in.sin_family = AF_INET;
+		peer->in.sin_port = port;
+		return 0;
+	}
+	if(ether_aton_r(addr, &mac) == NULL)
+	{
+		return EINVAL;
+	}
+	if(!ecpri_raw_ifindex)
+	{
+		return ENETDOWN;
+	}
+
+	peer->ll.sll_family = AF_PACKET;
+	peer->ll.sll_protocol = htons(ETH_P_ECPRI);
+	peer->ll.sll_ifindex = ecpri_raw_ifindex;
+	peer->ll.sll_halen = ETH_ALEN;
+	memcpy(peer->ll.sll_addr, mac.ether_addr_octet, ETH_ALEN);
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Fills in the classic BPF program steering the messages of a remote node to
+* the socket proto_ecpri_socket_of_peer() picks for it, given as
+* SO_ATTACH_REUSEPORT_CBPF to the sockets of the eCPRI port. The program
+* returns the source IPv4 address modulo the number of sockets.
+*
+* @param [in]	num		Number of sockets sharing the port.
+* @param [out]	code	Program, ECPRI_PROTO_STEERING_LENGTH instructions.
+*
+******************************************************************************/
+void proto_ecpri_steering(int num, struct sock_filter *code)
+{
+	const struct sock_filter program[ECPRI_PROTO_STEERING_LENGTH] = {
+		/* A = source address, the data starts after the UDP header */
+		BPF_STMT(BPF_LD | BPF_W | BPF_ABS, (uint32_t)(SKF_NET_OFF + (int)offsetof(struct iphdr, saddr))),
+		BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, num),
+		BPF_STMT(BPF_RET | BPF_A, 0)
+	};
+
+	memcpy(code, program, sizeof(program));
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes the lock on one socket receiving eCPRI messages and its protocol
+* state, held while a message received on it is handled.
+*
+* @param [in]	fd	Socket, as given to proto_ecpri_add_socket().
+*
+******************************************************************************/
+void proto_ecpri_lock_socket(int fd)
+{
+	pthread_once(&ecpri_socket_lock_once, proto_ecpri_lock_init);
+	pthread_mutex_lock(&proto_ecpri_socket_of_fd(fd)->lock);
+}
+
+/*****************************************************************************/
+/**
+*
+* Releases the lock taken by proto_ecpri_lock_socket().
+*
+* @param [in]	fd	Socket, as given to proto_ecpri_add_socket().
+*
+******************************************************************************/
+void proto_ecpri_unlock_socket(int fd)
+{
+	pthread_mutex_unlock(&proto_ecpri_socket_of_fd(fd)->lock);
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes the locks on all the sockets and their protocol state. Held by
+* commands for a whole request and response exchange, so that the threads
+* handling incoming messages do not read the responses.
+*
+******************************************************************************/
+void proto_ecpri_lock(void)
+{
+	int i;
+
+	pthread_once(&ecpri_socket_lock_once, proto_ecpri_lock_init);
+	for(i = 0; (i < ecpri_num_sockets) || !i; i++)
+	{
+		pthread_mutex_lock(&ecpri_sockets[i].lock);
+	}
+	pthread_mutex_lock(&ecpri_raw_socket.lock);
+}
+
+/*****************************************************************************/
+/**
+*
+* Releases the locks taken by proto_ecpri_lock().
+*
+******************************************************************************/
+void proto_ecpri_unlock(void)
+{
+	int i;
+
+	pthread_mutex_unlock(&ecpri_raw_socket.lock);
+	for(i = 0; (i < ecpri_num_sockets) || !i; i++)
+	{
+		pthread_mutex_unlock(&ecpri_sockets[i].lock);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the software timestamp of the last message or transmit timestamp
+* handled by proto_ecpri_handle_incoming_msg() on a socket. Called with the
+* socket lock held, by the thread that handled it.
+*
+* @param [in]	fd	Socket the message was handled on.
+* @param [out]	ts	Timestamp.
+*
+* @return
+*		- 0 on success
+*		- ENOENT if the event had no software timestamp
+*
+******************************************************************************/
+int proto_ecpri_get_event_time(int fd, struct timespec *ts)
+{
+	proto_ecpri_socket_type *sock = proto_ecpri_socket_of_fd(fd);
+
+	if(!sock->event_ts.tv_sec && !sock->event_ts.tv_nsec)
+	{
+		return ENOENT;
+	}
+	*ts = sock->event_ts;
+	return 0;
+}
+
 /*****************************************************************************/
 /**
 *
@@ -109,19 +460,20 @@ long ecpri_report_limit = 0;
 * @param [in]	length		Length of the payload.
 * @param [in]	type		eCPRI message type.
 * @param [in]	sock_d		File handle of the outbound socket.
-* @param [in]	dest		IP address of remote node.
+* @param [in]	dest		Address of remote node, IP or MAC as sock_d.
 *
 * @return
 *		- 0 if malloc fails.
 *		- Return value of sendto().
 *
 ******************************************************************************/
-int proto_ecpri_send(uint8_t *data, uint16_t length, ecpri_message_type_t type, int sock_d, struct sockaddr_in *dest)
+int proto_ecpri_send(uint8_t *data, uint16_t length, ecpri_message_type_t type, int sock_d, ecpri_peer_t *dest)
 {
 	uint8_t *buffer;
 	ecpri_header_t *header;
 	int retval = 0;
 	int buflen = length + ECPRI_PROTO_HEADER_SIZE;
+	socklen_t addrlen = (dest->sa.sa_family == AF_PACKET) ? sizeof(dest->ll) : sizeof(dest->in);
 
 	buffer = malloc(buflen);
 
@@ -134,7 +486,7 @@ int proto_ecpri_send(uint8_t *data, uint16_t length, ecpri_message_type_t type,
 		header->length = length;
 
 		memcpy(buffer+ECPRI_PROTO_HEADER_SIZE, data, length);
-		retval = sendto(sock_d, buffer, buflen, 0, (struct sockaddr *)dest, sizeof(struct sockaddr_in));
+		retval = sendto(sock_d, buffer, buflen, 0, &dest->sa, addrlen);
 
 		free(buffer);
 	}
@@ -156,20 +508,20 @@ int proto_ecpri_send(uint8_t *data, uint16_t length, ecpri_message_type_t type,
 * @param [out]	length		Length of payload received.
 * @param [out]	type		Received eCPRI message type.
 * @param [in]	sock_d		File handle of the receiving eCPRI socket.
-* @param [in]	src			IP address of remote node.
+* @param [out]	src			Address of remote node, IP or MAC as sock_d.
 * @param [out]	ts			Pointer to packet rx time-stamp.
 *
 * @return
-*		- 0 if short message received.
+*		- 0 if short message received, or a frame sent by this node.
 *		- -1 if short socket control message received or malloc fails.
 *		- 1 if time-stamp received.
 *		- length of payload otherwise.
 *
 ******************************************************************************/
-int proto_ecpri_recv(uint8_t **data, uint16_t *length, ecpri_message_type_t *type, int sock_d, struct sockaddr_in *src, uint8_t *ts)
+int proto_ecpri_recv(uint8_t **data, uint16_t *length, ecpri_message_type_t *type, int sock_d, ecpri_peer_t *src, uint8_t *ts)
 {
 	ecpri_header_t *header;
-	uint32_t size = sizeof(struct sockaddr_in);
+	uint32_t size = sizeof(*src);
 	int retval = 0;
 	uint8_t buffer[1024];
 	char control[256];
@@ -193,6 +545,12 @@ int proto_ecpri_recv(uint8_t **data, uint16_t *length, ecpri_message_type_t *typ
 	/* Get the incoming message(s) */
 	recv_len = recvmsg(sock_d, &msg, MSG_DONTWAIT);
 
+	/* A raw Ethernet socket also sees the frames sent on its interface */
+	if((recv_len >= 0) && (src->sa.sa_family == AF_PACKET) && (src->ll.sll_pkttype == PACKET_OUTGOING))
+	{
+		return 0;
+	}
+
 	if(recv_len >= ECPRI_PROTO_HEADER_SIZE)
 	{
 		header = (ecpri_header_t *)buffer;
@@ -361,7 +719,7 @@ int proto_ecpri_handle_timestamps(int sock_d, int errQueue, uint8_t *ts)
 *
 * @param [in]		type		Type of RMA message (Read or Write).
 * @param [in]		data_len	Length in bytes to read/write.
-* @param [in]		dest		IP address of remote node.
+* @param [in]		dest		Address of remote node.
 * @param [in]		offset		Remote memory address to read/write.
 * @param [in,out]	values 		Pointer to buffer for read/write.
 *
@@ -370,7 +728,7 @@ int proto_ecpri_handle_timestamps(int sock_d, int errQueue, uint8_t *ts)
 *		- Return value of proto_ecpri_send().
 *
 ******************************************************************************/
-int proto_ecpri_rma_send_request(int type, uint16_t data_len, struct sockaddr_in *dest, uint64_t offset, uint8_t *values)
+int proto_ecpri_rma_send_request(int type, uint16_t data_len, ecpri_peer_t *dest, uint64_t offset, uint8_t *values)
 {
 	uint8_t *buffer;
 	int buflen = 0;
@@ -407,7 +765,7 @@ int proto_ecpri_rma_send_request(int type, uint16_t data_len, struct sockaddr_in
 			memcpy(buffer + sizeof(ecpri_rma_msg_t), values, data_len);
 		}
 
-		retval = proto_ecpri_send(buffer, buflen, ECPRI_MSG_RMA, sock_ip, dest);
+		retval = proto_ecpri_send(buffer, buflen, ECPRI_MSG_RMA, proto_ecpri_socket_of_peer(dest)->fd, dest);
 
 		free(buffer);
 	}
@@ -427,7 +785,8 @@ int proto_ecpri_rma_send_request(int type, uint16_t data_len, struct sockaddr_in
 *
 * @param [in]	type		Type of RMA message expected (Read or Write).
 * @param [out]	length		Length in bytes read/written.
-* @param [in]	src			IP address of remote node to receive from.
+* @param [in,out]	src		Address of remote node to receive from,
+*							replaced by that of the message received.
 * @param [out]	values 		Pointer to buffer to put read data in.
 *
 * @return
@@ -436,17 +795,18 @@ int proto_ecpri_rma_send_request(int type, uint16_t data_len, struct sockaddr_in
 *		- Return value of proto_ecpri_recv() if not an RMA message.
 *
 ******************************************************************************/
-int proto_ecpri_rma_get_response(int type, int *length, struct sockaddr_in *src, uint8_t **values)
+int proto_ecpri_rma_get_response(int type, int *length, ecpri_peer_t *src, uint8_t **values)
 {
 	uint16_t data_len;
 	ecpri_message_type_t msg_type;
 	uint8_t *buffer=NULL;
 	int retval = 0;
 	ecpri_rma_msg_t *header;
+	int fd = proto_ecpri_socket_of_peer(src)->fd;
 
 	while(retval==0)
 	{
-		retval = proto_ecpri_recv(&buffer, &data_len, &msg_type, sock_ip, src, NULL);
+		retval = proto_ecpri_recv(&buffer, &data_len, &msg_type, fd, src, NULL);
 	}
 
 	if(msg_type == ECPRI_MSG_RMA)
@@ -496,9 +856,10 @@ int proto_ecpri_rma_get_response(int type, int *length, struct sockaddr_in *src,
 * the tx time-stamp for internal use, and if send_ts is non-zero sends a OWDM
 * follow-up message to the remote node with the time-stamp.
 *
+* @param [in]	sock	Socket to send from, and its OWDM state.
 * @param [in]	msg		Pointer to OWDM request message.
 * @param [in]	len		Length of message.
-* @param [in]	dest	IP address of remote node to send to.
+* @param [in]	dest	Address of remote node to send to.
 * @param [in]	send_ts	Pointer to buffer to put read data in.
 *
 * @return
@@ -507,18 +868,18 @@ int proto_ecpri_rma_get_response(int type, int *length, struct sockaddr_in *src,
 *		- Return value of proto_ecpri_send() for followup otherwise.
 *
 ******************************************************************************/
-int proto_ecpri_owdm_send_req_get_ts(uint8_t *msg, uint16_t len, struct sockaddr_in *dest, int send_ts)
+static int proto_ecpri_owdm_send_req_get_ts(proto_ecpri_socket_type *sock, uint8_t *msg, uint16_t len, ecpri_peer_t *dest, int send_ts)
 {
 	ecpri_owdm_msg_t *message = (ecpri_owdm_msg_t *)msg;
 	int retval = 0;
 	struct timespec ts[3];
 	int i;
 
-	retval = proto_ecpri_send(msg, len, ECPRI_MSG_OWDM, sock_ip, dest);
+	retval = proto_ecpri_send(msg, len, ECPRI_MSG_OWDM, sock->fd, dest);
 
 	if(send_ts && (retval > 0))
 	{
-		retval = proto_ecpri_handle_timestamps(sock_ip, 1, (uint8_t *)ts);
+		retval = proto_ecpri_handle_timestamps(sock->fd, 1, (uint8_t *)ts);
 
 		if(retval >= 0)
 		{
@@ -533,12 +894,12 @@ int proto_ecpri_owdm_send_req_get_ts(uint8_t *msg, uint16_t len, struct sockaddr
 			memcpy(message->comp, owdm_comp, 8);
 
 			/* Save TS for ourselves */
-			memcpy(owdm_msg.ts.ts_sec, message->ts_sec, 6);
-			memcpy(owdm_msg.ts.ts_nsec, message->ts_nsec, 4);
-			memcpy(owdm_msg.comp, message->comp, 8);
+			memcpy(sock->owdm_msg.ts.ts_sec, message->ts_sec, 6);
+			memcpy(sock->owdm_msg.ts.ts_nsec, message->ts_nsec, 4);
+			memcpy(sock->owdm_msg.comp, message->comp, 8);
 
 			message->action_type = ECPRI_OWDM_MSG_ACTION_FOL_UP;
-			retval = proto_ecpri_send(msg, len, ECPRI_MSG_OWDM, sock_ip, dest);
+			retval = proto_ecpri_send(msg, len, ECPRI_MSG_OWDM, sock->fd, dest);
 		}
 		else
 		{
@@ -549,7 +910,7 @@ int proto_ecpri_owdm_send_req_get_ts(uint8_t *msg, uint16_t len, struct sockaddr
 	if(retval > 0)
 	{
 		/* Flush Tx timestamp from buffer */
-		retval = proto_ecpri_handle_timestamps(sock_ip, 1, NULL);
+		retval = proto_ecpri_handle_timestamps(sock->fd, 1, NULL);
 	}
 
 	return retval;
@@ -561,7 +922,7 @@ int proto_ecpri_owdm_send_req_get_ts(uint8_t *msg, uint16_t len, struct sockaddr
 * Send an OWDM request.
 *
 * @param [in]	type	Type of OWDM request message.
-* @param [in]	dest	IP address of remote node to send to.
+* @param [in]	dest	Address of remote node to send to.
 *
 * @see ecpri_proto.h
 * @return
@@ -569,7 +930,7 @@ int proto_ecpri_owdm_send_req_get_ts(uint8_t *msg, uint16_t len, struct sockaddr
 *		- Return value of proto_ecpri_owdm_send_req_get_ts() otherwise.
 *
 ******************************************************************************/
-int proto_ecpri_owdm_send_request(uint8_t type, struct sockaddr_in *dest)
+int proto_ecpri_owdm_send_request(uint8_t type, ecpri_peer_t *dest)
 {
 	static uint8_t id = 0;
 	ecpri_owdm_msg_t message;
@@ -588,13 +949,17 @@ int proto_ecpri_owdm_send_request(uint8_t type, struct sockaddr_in *dest)
 			break;
 
 		case ECPRI_OWDM_MSG_ACTION_REQ_FOL_UP:
-			retval = proto_ecpri_owdm_send_req_get_ts((uint8_t *)&message, (uint16_t)sizeof(message), dest, 1);
+			retval = proto_ecpri_owdm_send_req_get_ts(proto_ecpri_socket_of_peer(dest), (uint8_t *)&message, (uint16_t)sizeof(message), dest, 1);
+			pthread_mutex_lock(&ecpri_result_lock);
 			owdm_req++;
+			pthread_mutex_unlock(&ecpri_result_lock);
 			break;
 
 			case ECPRI_OWDM_MSG_ACTION_REM_REQ_FOL_UP:
-			retval = proto_ecpri_owdm_send_req_get_ts((uint8_t *)&message, (uint16_t)sizeof(message), dest, 0);
+			retval = proto_ecpri_owdm_send_req_get_ts(proto_ecpri_socket_of_peer(dest), (uint8_t *)&message, (uint16_t)sizeof(message), dest, 0);
+			pthread_mutex_lock(&ecpri_result_lock);
 			owdm_req++;
+			pthread_mutex_unlock(&ecpri_result_lock);
 			break;
 
 		default:
@@ -675,14 +1040,14 @@ int ecpri_owdm_calc_delay(owdm_ts_msg_type *t1, owdm_ts_msg_type *t2, owdm_resul
 *
 * Send a Remote Reset request to a remote node.
 *
-* @param [in]	dest	IP address of the remote node.
+* @param [in]	dest	Address of the remote node.
 *
 * @return
 *		- -1 if malloc fails.
 *		- return value of proto_ecpri_send() otherwise.
 *
 ******************************************************************************/
-int proto_ecpri_rmr_send_request(struct sockaddr_in *dest)
+int proto_ecpri_rmr_send_request(ecpri_peer_t *dest)
 {
 	uint8_t *buffer;
 	int buflen = 0;
@@ -699,7 +1064,7 @@ int proto_ecpri_rmr_send_request(struct sockaddr_in *dest)
 		header->id = 0;
 		header->code_op = ECPRI_RMR_MSG_CODE_OP_REM_RESET_REQ;
 
-		retval = proto_ecpri_send(buffer, buflen, ECPRI_MSG_REM_RESET, sock_ip, dest);
+		retval = proto_ecpri_send(buffer, buflen, ECPRI_MSG_REM_RESET, proto_ecpri_socket_of_peer(dest)->fd, dest);
 
 		free(buffer);
 	}
@@ -716,7 +1081,8 @@ int proto_ecpri_rmr_send_request(struct sockaddr_in *dest)
 *
 * Get a Remote Reset response from a remote node.
 *
-* @param [in]	src	IP address of the remote node.
+* @param [in,out]	src	Address of the remote node, replaced by that of
+*						the message received.
 *
 * @return
 *		- 0 on valid response.
@@ -724,17 +1090,18 @@ int proto_ecpri_rmr_send_request(struct sockaddr_in *dest)
 *		- return value of proto_ecpri_recv() otherwise.
 *
 ******************************************************************************/
-int proto_ecpri_rmr_get_response(struct sockaddr_in *src)
+int proto_ecpri_rmr_get_response(ecpri_peer_t *src)
 {
 	uint16_t data_len;
 	ecpri_message_type_t msg_type;
 	uint8_t *buffer=NULL;
 	int retval = 0;
 	ecpri_rmr_msg_t *header;
+	int fd = proto_ecpri_socket_of_peer(src)->fd;
 
 	while(retval==0)
 	{
-		retval = proto_ecpri_recv(&buffer, &data_len, &msg_type, sock_ip, src, NULL);
+		retval = proto_ecpri_recv(&buffer, &data_len, &msg_type, fd, src, NULL);
 	}
 
 	if(msg_type == ECPRI_MSG_REM_RESET)
@@ -784,10 +1151,12 @@ int proto_ecpri_handle_incoming_msg(int fd, short revents, char *command)
 	uint8_t *buffer=NULL;
 	uint16_t data_len;
 	ecpri_message_type_t type;
-	struct sockaddr_in src;
+	ecpri_peer_t src;
 	struct timespec ts[3];
 	(void)command; /* We might want to pass this message out to the system later? */
 
+	memset(ts, 0, sizeof(ts));
+
 	if(revents & POLLIN)
 	{
 		retval = proto_ecpri_recv(&buffer, &data_len, &type, fd, &src, (uint8_t *)ts);
@@ -829,7 +1198,7 @@ int proto_ecpri_handle_incoming_msg(int fd, short revents, char *command)
 	{
 		retval = proto_ecpri_handle_timestamps(fd, 1, (uint8_t *)ts);
 	}
-
+	proto_ecpri_socket_of_fd(fd)->event_ts = ts[0];
 
 	if(buffer)
 	{
@@ -846,7 +1215,7 @@ int proto_ecpri_handle_incoming_msg(int fd, short revents, char *command)
 * @param [in]	buffer		Buffer containing incoming message.
 * @param [in]	data_len	Ignored.
 * @param [in]	fd			File handle of receiving/response socket.
-* @param [in]	src			IP address of remote node for replies.
+* @param [in]	src			Address of remote node for replies.
 *
 * @return
 *		- return value of IP_API_Write() on write.
@@ -854,7 +1223,7 @@ int proto_ecpri_handle_incoming_msg(int fd, short revents, char *command)
 *		- 0 on unhandled message type or read success.
 *
 ******************************************************************************/
-int proto_ecpri_handle_incoming_rma(uint8_t *buffer, uint16_t data_len, int fd, struct sockaddr_in *src)
+int proto_ecpri_handle_incoming_rma(uint8_t *buffer, uint16_t data_len, int fd, ecpri_peer_t *src)
 {
 	ecpri_rma_msg_t *header;
 	uint8_t type;
@@ -955,8 +1324,8 @@ int proto_ecpri_handle_incoming_rma(uint8_t *buffer, uint16_t data_len, int fd,
 *
 * @param [in]	buffer		Buffer containing incoming message.
 * @param [in]	data_len	Length of incoming message.
-* @param [in]	fd			Ignored.
-* @param [in]	src			IP address of remote node for replies and result.
+* @param [in]	fd			File handle of receiving/response socket.
+* @param [in]	src			Address of remote node for replies and result.
 * @param [in]	ts			Time-stamp of received message.
 *
 * @return
@@ -964,13 +1333,13 @@ int proto_ecpri_handle_incoming_rma(uint8_t *buffer, uint16_t data_len, int fd,
 *		- 0 otherwise.
 *
 ******************************************************************************/
-int proto_ecpri_handle_incoming_owdm(uint8_t *buffer, uint16_t data_len, int fd, struct sockaddr_in *src, struct timespec *ts)
+int proto_ecpri_handle_incoming_owdm(uint8_t *buffer, uint16_t data_len, int fd, ecpri_peer_t *src, struct timespec *ts)
 {
+	proto_ecpri_socket_type *sock = proto_ecpri_socket_of_fd(fd);
 	ecpri_owdm_msg_t *message;
 	owdm_ts_msg_type owdm_ts;
 	int retval = 0;
 	int i;
-	(void)fd;
 
 	if(data_len >= sizeof(ecpri_owdm_msg_t))
 	{
@@ -979,29 +1348,32 @@ int proto_ecpri_handle_incoming_owdm(uint8_t *buffer, uint16_t data_len, int fd,
 		{
 			case ECPRI_OWDM_MSG_ACTION_REQ_FOL_UP:
 				/* Store Rx timestamp for later */
-				memcpy(&owdm_msg.ts.node, src, sizeof(owdm_result.node));
+				memcpy(&sock->owdm_msg.ts.node, src, sizeof(sock->owdm_msg.ts.node));
 
 				for(i=0; i<6; i++)
 				{
-					owdm_msg.ts.ts_sec[i] = (uint8_t)(ts[2].tv_sec>>(8*i))&0xff;
+					sock->owdm_msg.ts.ts_sec[i] = (uint8_t)(ts[2].tv_sec>>(8*i))&0xff;
 				}
 				for(i=0; i<4; i++)
 				{
-					owdm_msg.ts.ts_nsec[i] = (uint8_t)(ts[2].tv_nsec>>(8*i))&0xff;
+					sock->owdm_msg.ts.ts_nsec[i] = (uint8_t)(ts[2].tv_nsec>>(8*i))&0xff;
 				}
-				memcpy(owdm_msg.comp, owdm_comp, 8);
+				memcpy(sock->owdm_msg.comp, owdm_comp, 8);
 				break;
 
 			case ECPRI_OWDM_MSG_ACTION_RESP:
 				/* Store result */
-				memcpy(&owdm_result.node, src, sizeof(owdm_result.node));
 				memcpy(owdm_ts.ts.ts_sec, message->ts_sec, 6);
 				memcpy(owdm_ts.ts.ts_nsec, message->ts_nsec, 4);
 				memcpy(owdm_ts.comp, message->comp, 8);
 
-				ecpri_owdm_calc_delay(&owdm_ts, &owdm_msg, &owdm_result);
-				owdm_result.direction = TO_REMOTE;
-				owdm_result.resp_num = owdm_req;
+				pthread_mutex_lock(&ecpri_result_lock);
+				memcpy(&sock->owdm_result.node, src, sizeof(sock->owdm_result.node));
+				ecpri_owdm_calc_delay(&owdm_ts, &sock->owdm_msg, &sock->owdm_result);
+				sock->owdm_result.direction = TO_REMOTE;
+				sock->owdm_result.resp_num = owdm_req;
+				sock->result_seq = ++ecpri_result_seq;
+				pthread_mutex_unlock(&ecpri_result_lock);
 				break;
 
 			case ECPRI_OWDM_MSG_ACTION_REM_REQ_FOL_UP:
@@ -1012,7 +1384,7 @@ int proto_ecpri_handle_incoming_owdm(uint8_t *buffer, uint16_t data_len, int fd,
 				new_msg.action_type = ECPRI_OWDM_MSG_ACTION_REQ_FOL_UP;
 
 				/* Send request with follow-up back */
-				retval = proto_ecpri_owdm_send_req_get_ts((uint8_t *)&new_msg, (uint16_t)sizeof(new_msg), src, 1);
+				retval = proto_ecpri_owdm_send_req_get_ts(sock, (uint8_t *)&new_msg, (uint16_t)sizeof(new_msg), src, 1);
 				break;
 			}
 			case ECPRI_OWDM_MSG_ACTION_FOL_UP:
@@ -1025,8 +1397,8 @@ int proto_ecpri_handle_incoming_owdm(uint8_t *buffer, uint16_t data_len, int fd,
 				new_msg.action_type = ECPRI_OWDM_MSG_ACTION_RESP;
 
 				/* Copy saved TS from original message into response */
-				memcpy(new_msg.ts_sec, owdm_msg.ts.ts_sec, 6);
-				memcpy(new_msg.ts_nsec, owdm_msg.ts.ts_nsec, 4);
+				memcpy(new_msg.ts_sec, sock->owdm_msg.ts.ts_sec, 6);
+				memcpy(new_msg.ts_nsec, sock->owdm_msg.ts.ts_nsec, 4);
 				memcpy(new_msg.comp, owdm_comp, 8);
 
 				/* Calc delay for ourselves from the TS in the follow-up */
@@ -1034,13 +1406,16 @@ int proto_ecpri_handle_incoming_owdm(uint8_t *buffer, uint16_t data_len, int fd,
 				memcpy(t1.ts.ts_nsec, message->ts_nsec, 4);
 				memcpy(t1.comp, message->comp, 8);
 
-				memcpy(&owdm_result.node, src, sizeof(owdm_result.node));
-				ecpri_owdm_calc_delay(&owdm_msg, &t1, &owdm_result);
-				owdm_result.direction = FROM_REMOTE;
-				owdm_result.resp_num = owdm_req;
+				pthread_mutex_lock(&ecpri_result_lock);
+				memcpy(&sock->owdm_result.node, src, sizeof(sock->owdm_result.node));
+				ecpri_owdm_calc_delay(&sock->owdm_msg, &t1, &sock->owdm_result);
+				sock->owdm_result.direction = FROM_REMOTE;
+				sock->owdm_result.resp_num = owdm_req;
+				sock->result_seq = ++ecpri_result_seq;
+				pthread_mutex_unlock(&ecpri_result_lock);
 
 				/* send response */
-				retval = proto_ecpri_owdm_send_req_get_ts((uint8_t *)&new_msg, (uint16_t)sizeof(new_msg), src, 0);
+				retval = proto_ecpri_owdm_send_req_get_ts(sock, (uint8_t *)&new_msg, (uint16_t)sizeof(new_msg), src, 0);
 				break;
 			}
 			default:
@@ -1066,14 +1441,14 @@ int proto_ecpri_handle_incoming_owdm(uint8_t *buffer, uint16_t data_len, int fd,
 * @param [in]	buffer		Buffer containing incoming message.
 * @param [in]	data_len	Ignored.
 * @param [in]	fd			File handle of socket for response.
-* @param [in]	src			IP address of remote node for replies.
+* @param [in]	src			Address of remote node for replies.
 *
 * @return
 *		- -1 on malloc failure.
 *		- 0 otherwise.
 *
 ******************************************************************************/
-int proto_ecpri_handle_incoming_rmr(uint8_t *buffer, uint16_t data_len, int fd, struct sockaddr_in *src)
+int proto_ecpri_handle_incoming_rmr(uint8_t *buffer, uint16_t data_len, int fd, ecpri_peer_t *src)
 {
 	ecpri_rmr_msg_t *header;
 	uint8_t type;
@@ -1135,7 +1510,7 @@ int proto_ecpri_handle_incoming_rmr(uint8_t *buffer, uint16_t data_len, int fd,
 *		- 0.
 *
 ******************************************************************************/
-int proto_ecpri_handle_incoming_event(uint8_t *buffer, uint16_t data_len, int fd, struct sockaddr_in *src)
+int proto_ecpri_handle_incoming_event(uint8_t *buffer, uint16_t data_len, int fd, ecpri_peer_t *src)
 {
 	(void)buffer;
 	(void)data_len;
@@ -1148,13 +1523,14 @@ int proto_ecpri_handle_incoming_event(uint8_t *buffer, uint16_t data_len, int fd
 /*****************************************************************************/
 /**
 *
-* Return the current OWDM result values.
+* Return the current OWDM result values, the latest stored on any socket.
 * 
 *
 * @param [out]	req_no		Latest OWDM request number.
 * @param [out]	resp_no		Latest OWDM response number.
 * @param [out]	direction	Direction of latest response.
-* @param [out]	node		Remote node of latest measurement.
+* @param [out]	node		Remote node of latest measurement, 0.0.0.0 for a
+*							node reached over raw Ethernet.
 * @param [out]	secs		Seconds portion of latest delay value.
 * @param [out]	nsecs		Nano-seconds portion of latest delay value.
 *
@@ -1162,21 +1538,38 @@ int proto_ecpri_handle_incoming_event(uint8_t *buffer, uint16_t data_len, int fd
 void proto_ecpri_get_owdm_result(int *req_no, int *resp_no, ecpri_owdm_direction_type *direction,
 								struct in_addr *node, unsigned long long *secs, unsigned long *nsecs)
 {
+	owdm_result_type *result = &ecpri_sockets[0].owdm_result;
+	unsigned long seq = ecpri_sockets[0].result_seq;
 	int i;
 
+	pthread_mutex_lock(&ecpri_result_lock);
+	for(i = 1; i < ecpri_num_sockets; i++)
+	{
+		if(ecpri_sockets[i].result_seq > seq)
+		{
+			result = &ecpri_sockets[i].owdm_result;
+			seq = ecpri_sockets[i].result_seq;
+		}
+	}
+	if(ecpri_raw_socket.result_seq > seq)
+	{
+		result = &ecpri_raw_socket.owdm_result;
+	}
+
 	*req_no = owdm_req;
-	*resp_no = owdm_result.resp_num;
-	*direction = owdm_result.direction;
-	*node = owdm_result.node.sin_addr;
+	*resp_no = result->resp_num;
+	*direction = result->direction;
+	node->s_addr = (result->node.sa.sa_family == AF_INET) ? result->node.in.sin_addr.s_addr : htonl(INADDR_ANY);
 
 	for(i=0; (i<sizeof(long long)) && (i<6); i++)
 	{
-		*secs |= (uint8_t)(owdm_result.ts_sec[i]&0xff)<<(8*i);
+		*secs |= (uint8_t)(result->ts_sec[i]&0xff)<<(8*i);
 	}
 	for(i=0; (i<sizeof(long)) && (i<4); i++)
 	{
-		*nsecs |= (uint8_t)(owdm_result.ts_nsec[i]&0xff)<<(8*i);
+		*nsecs |= (uint8_t)(result->ts_nsec[i]&0xff)<<(8*i);
 	}
+	pthread_mutex_unlock(&ecpri_result_lock);
 }
 
 /*****************************************************************************/
@@ -1186,14 +1579,14 @@ void proto_ecpri_get_owdm_result(int *req_no, int *resp_no, ecpri_owdm_direction
 * Sends a generic data message containing an incrementing sequence number.
 * 
 *
-* @param [in]	dest	IP address of the remote host to send to.
+* @param [in]	dest	Address of the remote host to send to.
 *
 * @return
 *		- -1 on malloc failure.
 *		- return value of proto_ecpri_send() otherwise.
 *
 ******************************************************************************/
-int proto_ecpri_test_mesg_send(struct sockaddr_in *dest)
+int proto_ecpri_test_mesg_send(ecpri_peer_t *dest)
 {
 	uint8_t *buffer;
 	int buflen = 0;
@@ -1211,7 +1604,7 @@ int proto_ecpri_test_mesg_send(struct sockaddr_in *dest)
 		memcpy(buffer + sizeof(PC_ID) + sizeof(REQ_ID), &SEQ_NUM, sizeof(SEQ_NUM));
 		SEQ_NUM++;
 
-		retval = proto_ecpri_send(buffer, buflen, ECPRI_MSG_GENERIC_DATA, sock_ip, dest);
+		retval = proto_ecpri_send(buffer, buflen, ECPRI_MSG_GENERIC_DATA, proto_ecpri_socket_of_peer(dest)->fd, dest);
 
 		free(buffer);
 	}
@@ -1237,7 +1630,7 @@ int proto_ecpri_test_mesg_send(struct sockaddr_in *dest)
 *		- 0.
 *
 ******************************************************************************/
-int proto_ecpri_handle_incoming_test_mesg(uint8_t *buffer, uint16_t data_len, int fd, struct sockaddr_in *src)
+int proto_ecpri_handle_incoming_test_mesg(uint8_t *buffer, uint16_t data_len, int fd, ecpri_peer_t *src)
 {
 	//(void)buffer;
 	(void)data_len;
@@ -18,6 +18,32 @@
 #include <stdint.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netpacket/packet.h>
+#include <linux/filter.h>
+#include <time.h>
+
+/**
+ * ECPRI_PROTO_MAX_SOCKETS Most sockets receiving eCPRI messages on the port.
+ */
+#define ECPRI_PROTO_MAX_SOCKETS (16)
+
+/**
+ * ECPRI_PROTO_STEERING_LENGTH Instructions of the program filled in by
+ * proto_ecpri_steering().
+ */
+#define ECPRI_PROTO_STEERING_LENGTH (3)
+
+/**
+ * ecpri_peer_t Address of a remote node: an IPv4 address and UDP port, or a
+ * MAC address on the interface of the raw Ethernet socket (EtherType
+ * ETH_P_ECPRI). The family tells which transport its messages use.
+ */
+typedef union ecpri_peer_u
+{
+	struct sockaddr sa; /**< Family, AF_INET or AF_PACKET */
+	struct sockaddr_in in; /**< UDP/IP peer */
+	struct sockaddr_ll ll; /**< Raw Ethernet peer */
+} ecpri_peer_t;
 
 /**
  * ECPRI_PROTO_MAGIC_BYTE Magic eCPRI message byte.
@@ -167,14 +193,23 @@ typedef struct ecpri_rmr_msg_s
 } ecpri_rmr_msg_t;
 
 /************************** Function Prototypes ******************************/
-int proto_ecpri_rma_send_request(int type, uint16_t data_len, struct sockaddr_in *dest, uint64_t offset, uint8_t *values);
-int proto_ecpri_rma_get_response(int type, int *length, struct sockaddr_in *src, uint8_t **values);
-int proto_ecpri_owdm_send_request(uint8_t type, struct sockaddr_in *dest);
+int proto_ecpri_add_socket(int fd);
+int proto_ecpri_set_raw_socket(int fd, int ifindex);
+int proto_ecpri_parse_peer(const char *addr, in_port_t port, ecpri_peer_t *peer);
+void proto_ecpri_steering(int num, struct sock_filter *code);
+void proto_ecpri_lock_socket(int fd);
+void proto_ecpri_unlock_socket(int fd);
+void proto_ecpri_lock(void);
+void proto_ecpri_unlock(void);
+int proto_ecpri_get_event_time(int fd, struct timespec *ts);
+int proto_ecpri_rma_send_request(int type, uint16_t data_len, ecpri_peer_t *dest, uint64_t offset, uint8_t *values);
+int proto_ecpri_rma_get_response(int type, int *length, ecpri_peer_t *src, uint8_t **values);
+int proto_ecpri_owdm_send_request(uint8_t type, ecpri_peer_t *dest);
 int proto_ecpri_handle_incoming_msg(int fd, short revents, char *command);
 void proto_ecpri_get_owdm_result(int *req_no, int *resp_no, ecpri_owdm_direction_type *direction, 
 								struct in_addr *node, unsigned long long *secs, unsigned long *nsecs);
 void proto_ecpri_set_owdm_limit(long limit);
-int proto_ecpri_test_mesg_send(struct sockaddr_in *dest);
-int proto_ecpri_rmr_send_request(struct sockaddr_in *dest);
-int proto_ecpri_rmr_get_response(struct sockaddr_in *src);
+int proto_ecpri_test_mesg_send(ecpri_peer_t *dest);
+int proto_ecpri_rmr_send_request(ecpri_peer_t *dest);
+int proto_ecpri_rmr_get_response(ecpri_peer_t *src);
 /** @} */
\ No newline at end of file
@@ -0,0 +1,379 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file ecpri_rt.c
+* @addtogroup command_parser
+* @{
+*
+*  Real-time settings and wake-up latency of the eCPRI thread
+*
+*  The settings are given on the command line and applied by the eCPRI thread
+*  itself when it starts. Failing to apply one, typically EPERM without
+*  CAP_SYS_NICE or CAP_IPC_LOCK, is logged and the thread carries on without.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <syslog.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include <ecpri_rt.h>
+
+/**
+ * ecpri_rt_struct Settings and latency statistics.
+ */
+typedef struct ecpri_rt_struct{
+	ecpri_rt_config_struct Config;
+	int Requested;      /**< Set when any setting was given */
+	pthread_once_t Once;
+	pthread_mutex_t Lock;
+	ecpri_rt_latency_struct Latency[ECPRI_RT_EVENTS];
+} ecpri_rt_struct;
+
+/**
+ * EcpriRt Real-time state of the eCPRI thread.
+ */
+static ecpri_rt_struct EcpriRt = {
+	.Config = { .Cpu = -1 },
+	.Once = PTHREAD_ONCE_INIT
+};
+
+/**
+ * EcpriRtEventNames Names of the events, as used by commands and metrics.
+ */
+static const char *EcpriRtEventNames[ECPRI_RT_EVENTS] = {"rx", "tx_timestamp"};
+
+/*****************************************************************************/
+/**
+*
+* Initialises the statistics lock with priority inheritance, so that a
+* command reading the statistics cannot hold up the real-time thread behind
+* a lower priority thread.
+*
+******************************************************************************/
+static void ecpri_rt_init(void)
+{
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+	pthread_mutex_init(&EcpriRt.Lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+/*****************************************************************************/
+/**
+*
+* Clears the statistics of one event, with the lock held.
+*
+* @param [in]	pLatency  Statistics.
+*
+******************************************************************************/
+static void ecpri_rt_clear(ecpri_rt_latency_struct *pLatency)
+{
+	memset(pLatency, 0, sizeof(*pLatency));
+	pLatency->Min = UINT64_MAX;
+}
+
+/*****************************************************************************/
+/**
+*
+* Parses the real-time settings of the eCPRI thread, given as a comma
+* separated list of "cpu=<n>" and "prio=<1..99>".
+*
+* @param [in]	spec  Settings.
+*
+* @return
+*		- 0 on success
+*		- EINVAL on an unknown or out of range setting
+*
+******************************************************************************/
+int ECPRI_RT_API_Configure(const char *spec)
+{
+	char buffer[64];
+	char *save = NULL;
+	char *token;
+	char *end;
+	long value;
+	int cpu = EcpriRt.Config.Cpu;
+	int prio = EcpriRt.Config.Prio;
+
+	if(strlen(spec) >= sizeof(buffer))
+	{
+		return EINVAL;
+	}
+	strcpy(buffer, spec);
+
+	for(token = strtok_r(buffer, ",", &save); token != NULL; token = strtok_r(NULL, ",", &save))
+	{
+		if(!strncmp(token, "cpu=", 4))
+		{
+			value = strtol(token + 4, &end, 10);
+			if(end == token + 4 || *end || value < 0 || value >= CPU_SETSIZE)
+			{
+				return EINVAL;
+			}
+			cpu = (int)value;
+		}
+		else if(!strncmp(token, "prio=", 5))
+		{
+			value = strtol(token + 5, &end, 10);
+			if(end == token + 5 || *end ||
+			   value < sched_get_priority_min(SCHED_FIFO) ||
+			   value > sched_get_priority_max(SCHED_FIFO))
+			{
+				return EINVAL;
+			}
+			prio = (int)value;
+		}
+		else
+		{
+			return EINVAL;
+		}
+	}
+
+	EcpriRt.Config.Cpu = cpu;
+	EcpriRt.Config.Prio = prio;
+	EcpriRt.Requested = 1;
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Applies the configured settings to the calling thread. The memory of the
+* whole process is locked, so that the thread does not take page faults on
+* the stacks and buffers it shares with the rest of the application.
+* With several eCPRI threads, each is pinned to the CPU after that of the
+* previous one.
+*
+* @param [in]	thread  Index of the eCPRI thread, from 0.
+*
+******************************************************************************/
+void ECPRI_RT_API_Apply(int thread)
+{
+	ecpri_rt_config_struct *pConfig = &EcpriRt.Config;
+	struct sched_param param;
+	cpu_set_t cpus;
+	int cpu;
+	int err;
+
+	pthread_once(&EcpriRt.Once, ecpri_rt_init);
+	if(!EcpriRt.Requested)
+	{
+		return;
+	}
+
+	if(mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+	{
+		err = errno;
+		syslog(LOG_ERR, "eCPRI thread: cannot lock memory: %s\n", strerror(err));
+		pthread_mutex_lock(&EcpriRt.Lock);
+		pConfig->MlockErr = err;
+		pthread_mutex_unlock(&EcpriRt.Lock);
+	}
+
+	if(pConfig->Cpu >= 0)
+	{
+		cpu = (pConfig->Cpu + thread) % CPU_SETSIZE;
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu, &cpus);
+		err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+		if(err)
+		{
+			syslog(LOG_ERR, "eCPRI thread: cannot pin to CPU %d: %s\n", cpu, strerror(err));
+			pthread_mutex_lock(&EcpriRt.Lock);
+			pConfig->CpuErr = err;
+			pthread_mutex_unlock(&EcpriRt.Lock);
+		}
+	}
+
+	if(pConfig->Prio > 0)
+	{
+		memset(&param, 0, sizeof(param));
+		param.sched_priority = pConfig->Prio;
+		err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if(err)
+		{
+			syslog(LOG_ERR, "eCPRI thread: cannot set SCHED_FIFO priority %d: %s\n", pConfig->Prio, strerror(err));
+			pthread_mutex_lock(&EcpriRt.Lock);
+			pConfig->PrioErr = err;
+			pthread_mutex_unlock(&EcpriRt.Lock);
+		}
+	}
+
+	pthread_mutex_lock(&EcpriRt.Lock);
+	pConfig->Applied = 1;
+	pthread_mutex_unlock(&EcpriRt.Lock);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the configured settings and whether they could be applied.
+*
+* @param [out]	pConfig  Settings.
+*
+******************************************************************************/
+void ECPRI_RT_API_Get_Config(ecpri_rt_config_struct *pConfig)
+{
+	pthread_once(&EcpriRt.Once, ecpri_rt_init);
+	pthread_mutex_lock(&EcpriRt.Lock);
+	*pConfig = EcpriRt.Config;
+	pthread_mutex_unlock(&EcpriRt.Lock);
+}
+
+/*****************************************************************************/
+/**
+*
+* Records the time between the kernel timestamping an event and the eCPRI
+* thread waking up for it. Latencies below zero, from the clock being set
+* in between, count as zero.
+*
+* @param [in]	event  Event woken up for.
+* @param [in]	wake   Time the thread woke up (CLOCK_REALTIME).
+* @param [in]	stamp  Software timestamp of the event.
+*
+******************************************************************************/
+void ECPRI_RT_API_Record(ecpri_rt_event_t event, const struct timespec *wake, const struct timespec *stamp)
+{
+	ecpri_rt_latency_struct *pLatency;
+	int64_t delta;
+	uint64_t nsecs;
+	uint64_t usecs;
+	int bucket = 0;
+
+	if((unsigned)event >= ECPRI_RT_EVENTS)
+	{
+		return;
+	}
+
+	delta = (int64_t)(wake->tv_sec - stamp->tv_sec) * 1000000000LL + (wake->tv_nsec - stamp->tv_nsec);
+	nsecs = delta > 0 ? (uint64_t)delta : 0;
+	for(usecs = nsecs / 1000; usecs && bucket < ECPRI_RT_BUCKETS - 1; usecs >>= 1)
+	{
+		bucket++;
+	}
+
+	pthread_once(&EcpriRt.Once, ecpri_rt_init);
+	pthread_mutex_lock(&EcpriRt.Lock);
+	pLatency = &EcpriRt.Latency[event];
+	if(!pLatency->Count)
+	{
+		pLatency->Min = UINT64_MAX;
+	}
+	pLatency->Count++;
+	pLatency->Sum += nsecs;
+	pLatency->Last = nsecs;
+	if(nsecs < pLatency->Min)
+	{
+		pLatency->Min = nsecs;
+	}
+	if(nsecs > pLatency->Max)
+	{
+		pLatency->Max = nsecs;
+	}
+	pLatency->Buckets[bucket]++;
+	pthread_mutex_unlock(&EcpriRt.Lock);
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes a copy of the wake-up latency statistics of an event.
+*
+* @param [in]	event     Event.
+* @param [out]	pLatency  Statistics, Min is 0 when nothing was recorded.
+*
+******************************************************************************/
+void ECPRI_RT_API_Get(ecpri_rt_event_t event, ecpri_rt_latency_struct *pLatency)
+{
+	memset(pLatency, 0, sizeof(*pLatency));
+	if((unsigned)event >= ECPRI_RT_EVENTS)
+	{
+		return;
+	}
+
+	pthread_once(&EcpriRt.Once, ecpri_rt_init);
+	pthread_mutex_lock(&EcpriRt.Lock);
+	*pLatency = EcpriRt.Latency[event];
+	pthread_mutex_unlock(&EcpriRt.Lock);
+
+	if(!pLatency->Count)
+	{
+		pLatency->Min = 0;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Clears the wake-up latency statistics of all events.
+*
+******************************************************************************/
+void ECPRI_RT_API_Reset(void)
+{
+	int i;
+
+	pthread_once(&EcpriRt.Once, ecpri_rt_init);
+	pthread_mutex_lock(&EcpriRt.Lock);
+	for(i = 0; i < ECPRI_RT_EVENTS; i++)
+	{
+		ecpri_rt_clear(&EcpriRt.Latency[i]);
+	}
+	pthread_mutex_unlock(&EcpriRt.Lock);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the upper limit of a histogram bucket.
+*
+* @param [in]	bucket  Bucket.
+*
+* @return
+*		- Limit (nsecs)
+*		- 0 for the last bucket, which has no limit
+*
+******************************************************************************/
+uint64_t ECPRI_RT_API_Bucket_Limit(int bucket)
+{
+	if(bucket < 0 || bucket >= ECPRI_RT_BUCKETS - 1)
+	{
+		return 0;
+	}
+	return 1000ULL << bucket;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the name of an event.
+*
+* @param [in]	event  Event.
+*
+* @return
+*		- Name
+*
+******************************************************************************/
+const char *ECPRI_RT_API_Event_Name(ecpri_rt_event_t event)
+{
+	if((unsigned)event >= ECPRI_RT_EVENTS)
+	{
+		return "unknown";
+	}
+	return EcpriRtEventNames[event];
+}
+/** @} */
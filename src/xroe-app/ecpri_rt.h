@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file ecpri_rt.h
+* @addtogroup command_parser
+* @{
+*
+*  Real-time settings and wake-up latency of the eCPRI thread
+*
+*  The thread serving the eCPRI socket can be pinned to a CPU and run at a
+*  SCHED_FIFO priority with its memory locked. The time from the kernel
+*  timestamping a message to the thread waking up for it is kept in a
+*  histogram per event, to check the jitter budget under load.
+*
+******************************************************************************/
+#ifndef ECPRI_RT_H		/* prevent circular inclusions */
+#define ECPRI_RT_H		/* by using protection macros */
+
+#include <stdint.h>
+#include <time.h>
+
+/* Histogram buckets, bucket n counts latencies below 2^n usecs, the last one the rest */
+#define ECPRI_RT_BUCKETS 22
+
+/**
+ * ecpri_rt_event_t Events waking up the eCPRI thread.
+ */
+typedef enum {
+	ECPRI_RT_RX = 0,            /**< Message received */
+	ECPRI_RT_TX_TIMESTAMP,      /**< Transmit timestamp on the error queue */
+	ECPRI_RT_EVENTS
+} ecpri_rt_event_t;
+
+/**
+ * ecpri_rt_latency_struct Wake-up latency of one event (nsecs).
+ */
+typedef struct ecpri_rt_latency_struct{
+	uint64_t Count;
+	uint64_t Sum;
+	uint64_t Min;
+	uint64_t Max;
+	uint64_t Last;
+	uint64_t Buckets[ECPRI_RT_BUCKETS];
+} ecpri_rt_latency_struct;
+
+/**
+ * ecpri_rt_config_struct Requested real-time settings and their outcome.
+ */
+typedef struct ecpri_rt_config_struct{
+	int Cpu;            /**< -1 when not pinned */
+	int Prio;           /**< 0 when not SCHED_FIFO */
+	int Applied;        /**< Set once the thread has started */
+	int CpuErr;         /**< errno of each setting, 0 on success */
+	int PrioErr;
+	int MlockErr;
+} ecpri_rt_config_struct;
+
+/************************** Function Prototypes ******************************/
+int ECPRI_RT_API_Configure(const char *spec);
+void ECPRI_RT_API_Apply(int thread);
+void ECPRI_RT_API_Get_Config(ecpri_rt_config_struct *pConfig);
+void ECPRI_RT_API_Record(ecpri_rt_event_t event, const struct timespec *wake, const struct timespec *stamp);
+void ECPRI_RT_API_Get(ecpri_rt_event_t event, ecpri_rt_latency_struct *pLatency);
+void ECPRI_RT_API_Reset(void);
+uint64_t ECPRI_RT_API_Bucket_Limit(int bucket);
+const char *ECPRI_RT_API_Event_Name(ecpri_rt_event_t event);
+#endif /* end of protection macro */
+/** @} */
@@ -27,7 +27,7 @@
 /**
  * ECPRI_OWDM_REQ_STR Help text for the ecpri module "owdm_req" option.
  */
-#define ECPRI_OWDM_REQ_STR "ecpri owdm_req <addr> <type> - Request an OWDM measurement to <addr> of type <to_remote|from_remote>\n"
+#define ECPRI_OWDM_REQ_STR "ecpri owdm_req <addr> <type> - Request an OWDM measurement to <addr> (IP or MAC address) of type <to_remote|from_remote>\n"
 
 /**
  * ECPRI_OWDM_RES_STR Help text for the ecpri module "owdm_res" option.
@@ -42,20 +42,25 @@
 /**
  * ECPRI_RMA_READ_STR Help text for the ecpri module "rma_read" option.
  */
-#define ECPRI_RMA_READ_STR "ecpri rma_read <ip_addr> <mem_addr> <length> - Request a read of <length> bytes at <mem_addr> from <ip_addr>\n"
+#define ECPRI_RMA_READ_STR "ecpri rma_read <addr> <mem_addr> <length> - Request a read of <length> bytes at <mem_addr> from <addr>, an IP address or a MAC address for raw Ethernet\n"
 
 /**
  * ECPRI_RMA_WRITE_STR Help text for the ecpri module "rma_write" option.
  */
-#define ECPRI_RMA_WRITE_STR "ecpri rma_write <ip_addr> <mem_addr> <length> \"<bytes 1..length>\" - Request a write of <length> <bytes> to <mem_addr> at <ip_addr>\n"
+#define ECPRI_RMA_WRITE_STR "ecpri rma_write <addr> <mem_addr> <length> \"<bytes 1..length>\" - Request a write of <length> <bytes> to <mem_addr> at <addr>, an IP address or a MAC address for raw Ethernet\n"
 
 /**
  * ECPRI_TEST_MESG_STR Help text for the ecpri module "test_mesg" option.
  */
-#define ECPRI_TEST_MESG_STR "ecpri test_mesg <ip_addr> <dest_port> - TESTING - Send a test message to <dest_port>\n"
+#define ECPRI_TEST_MESG_STR "ecpri test_mesg <addr> <dest_port> - TESTING - Send a test message to <dest_port>, or to the MAC address <addr> over raw Ethernet\n"
 
 /**
  * ECPRI_RMR_REQ_STR Help text for the ecpri module "rmr_req" option.
  */
-#define ECPRI_RMR_REQ_STR "ecpri rmr_req <ip_addr> - Request a remote reset of <ip_addr>\n"
+#define ECPRI_RMR_REQ_STR "ecpri rmr_req <addr> - Request a remote reset of <addr>, an IP address or a MAC address for raw Ethernet\n"
+
+/**
+ * ECPRI_RT_STR Help text for the ecpri module "rt" option.
+ */
+#define ECPRI_RT_STR "ecpri rt [reset] - Show the real-time settings and wake-up latency of the eCPRI thread, or clear the latency\n"
 /** @} */
\ No newline at end of file
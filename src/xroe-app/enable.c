@@ -36,9 +36,9 @@
 #define ENABLE_MAX_COMMANDS 4
 
 /************************** Function Prototypes ******************************/
-int enable_help_func(int argc, char **argv, char *resp);
-int enable_framer_func(int argc, char **argv, char *resp);
-int enable_deframer_func(int argc, char **argv, char *resp);
+int enable_help_func(int argc, char **argv, response_t *resp);
+int enable_framer_func(int argc, char **argv, response_t *resp);
+int enable_deframer_func(int argc, char **argv, response_t *resp);
 
 /**
  * enable_cmds The commands handled by the enable module.
@@ -62,13 +62,13 @@ commands_t enable_cmds[ENABLE_MAX_COMMANDS] = {
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- Return value of FRAMER_API_Framer_Restart()
 *
 ******************************************************************************/
-int enable_framer_func(int argc, char **argv, char *resp)
+int enable_framer_func(int argc, char **argv, response_t *resp)
 {
 	return(FRAMER_API_Framer_Restart(0));
 }
@@ -81,13 +81,13 @@ int enable_framer_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- Return value of FRAMER_API_Deframer_Restart()
 *
 ******************************************************************************/
-int enable_deframer_func(int argc, char **argv, char *resp)
+int enable_deframer_func(int argc, char **argv, response_t *resp)
 {
 	return(FRAMER_API_Deframer_Restart(0));
 }
@@ -101,22 +101,21 @@ int enable_deframer_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int enable_help_func(int argc, char **argv, char *resp)
+int enable_help_func(int argc, char **argv, response_t *resp)
 {
 	int i;
-	char *str = resp;
 
-	str += sprintf(str, "enable help:\n");
+	resp_printf(resp, "enable help:\n");
 
 	for(i=0; enable_cmds[i].cmd != NULL; i++)
 	{
-		str += sprintf(str, "\t%s\t : %s", enable_cmds[i].cmd, enable_cmds[i].helptxt);
+		resp_printf(resp, "\t%s\t : %s", enable_cmds[i].cmd, enable_cmds[i].helptxt);
 	}
 	return 0;
 }
@@ -130,23 +129,23 @@ int enable_help_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 1 if no commands tokens found.
 *		- 2 if no handler found for command.
-*		- 0 otherwise.
+*		- the return value of the command handler otherwise.
 *
 ******************************************************************************/
-int enable_func(int argc, char **argv, char *resp)
+int enable_func(int argc, char **argv, response_t *resp)
 {
 	int count = 0;
 	int found = 0;
-	char *str = resp;
+	int ret = 0;
 
 	if(argc == 0)
 	{
-		sprintf(str, "\t%s", ENABLE_USAGE_STR);
+		resp_printf(resp, "\t%s", ENABLE_USAGE_STR);
 		return(1);
 	}
 
@@ -156,16 +155,16 @@ int enable_func(int argc, char **argv, char *resp)
 		{
 			found = 1;
 			/* Call the handler function for the command given */
-			enable_cmds[count].func(argc-1, &argv[1], resp);
+			ret = enable_cmds[count].func(argc-1, &argv[1], resp);
 		}
 	}
 
 	if(!found)
 	{
-		str += sprintf(str, "Command %s not found, try \"help\"\n", argv[0]);
+		resp_printf(resp, "Command %s not found, try \"help\"\n", argv[0]);
 		return(2);
 	}
 
-	return 0;
+	return ret;
 }
 /** @} */
\ No newline at end of file
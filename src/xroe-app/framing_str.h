@@ -47,3 +47,15 @@
 "\t\t\t\tdbs_latency, dbs_alignment, dbs_overflow, dbs_underflow, dbs_regular, dbs_rwin\n" \
 "\t\t\t\tcbs_latency, cbs_alignment, cbs_overflow, cbs_underflow, cbs_regular, cbs_rwin\n"
 
+/**
+ * FRAMING_CACHE_STR Help text for the framing module "cache" option.
+ */
+#define FRAMING_CACHE_STR "Enable/disable the write-back register cache, usage \"framing cache [on|off] [interval]\", \n" \
+"\t\t\t<interval>: automatic commit interval in ms, 0 (default) for \"framing commit\" only\n" \
+"\t\t\twith no arguments shows the cache state\n"
+
+/**
+ * FRAMING_COMMIT_STR Help text for the framing module "commit" option.
+ */
+#define FRAMING_COMMIT_STR "Write all pending cached register changes to the framer, usage \"framing commit\"\n"
+
@@ -30,16 +30,18 @@
 #include <xroe_types.h>
 #include <ip_str.h>
 #include <xroe_api.h>
+#include <roe_framer_fields.h>
 
 /**
  * IP_MAX_COMMANDS Number of commands handled by the IP module.
  */
-#define IP_MAX_COMMANDS 4
+#define IP_MAX_COMMANDS 5
 
 /************************** Function Prototypes ******************************/
-int ip_help_func(int argc, char **argv, char *resp);
-int ip_peek_func(int argc, char **argv, char *resp);
-int ip_poke_func(int argc, char **argv, char *resp);
+int ip_help_func(int argc, char **argv, response_t *resp);
+int ip_peek_func(int argc, char **argv, response_t *resp);
+int ip_poke_func(int argc, char **argv, response_t *resp);
+int ip_version_func(int argc, char **argv, response_t *resp);
 
 /**
  * ip_cmds The commands handled by the IP module.
@@ -50,6 +52,7 @@ commands_t ip_cmds[IP_MAX_COMMANDS] = {
 	/* Insert commands here */
 	{"peek", IP_PEEK_STR, ip_peek_func},
 	{"poke", IP_POKE_STR, ip_poke_func},
+	{"version", IP_VERSION_STR, ip_version_func},
 	/* Keep this last - insert commands above */
 	{NULL, NULL, NULL}
 };
@@ -63,22 +66,21 @@ commands_t ip_cmds[IP_MAX_COMMANDS] = {
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int ip_help_func(int argc, char **argv, char *resp)
+int ip_help_func(int argc, char **argv, response_t *resp)
 {
 	int i;
-	char *str = resp;
 
-	str += sprintf(str, "ip help:\n");
+	resp_printf(resp, "ip help:\n");
 
 	for(i=0; ip_cmds[i].cmd != NULL; i++)
 	{
-		str += sprintf(str, "\t%s\t : %s", ip_cmds[i].cmd, ip_cmds[i].helptxt);
+		resp_printf(resp, "\t%s\t : %s", ip_cmds[i].cmd, ip_cmds[i].helptxt);
 	}
 	return 0;
 }
@@ -91,22 +93,21 @@ int ip_help_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int ip_peek_func(int argc, char **argv, char *resp)
+int ip_peek_func(int argc, char **argv, response_t *resp)
 {
 	int buf;
 	int addr;
 	int read = 0;
-	char *str = resp;
 
 	if(argc == 0)
 	{
-		sprintf(str, "\t%s", IP_PEEK_STR);
+		resp_printf(resp, "\t%s", IP_PEEK_STR);
 		return(1);
 	}
 
@@ -115,11 +116,11 @@ int ip_peek_func(int argc, char **argv, char *resp)
 	read = IP_API_Read(addr, (uint8_t *)&buf, sizeof(buf));
 	if(!read)
 	{
-		str += sprintf(str, "peek: 0x%08x : 0x%08x\n", addr, buf);
+		resp_printf(resp, "peek: 0x%08x : 0x%08x\n", addr, buf);
 	}
 	else
 	{
-		str += sprintf(str, "ip peek 0x%08x: error %d\n", addr, read);
+		resp_printf(resp, "ip peek 0x%08x: error %d\n", addr, read);
 	}
 
 	return 0;
@@ -133,38 +134,74 @@ int ip_peek_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int ip_poke_func(int argc, char **argv, char *resp)
+int ip_poke_func(int argc, char **argv, response_t *resp)
 {
 	int buf;
 	int addr;
 	int write = 0;
-	char *str = resp;
 
 	if(argc < 2)
 	{
-		sprintf(str, "\t%s", IP_POKE_STR);
+		resp_printf(resp, "\t%s", IP_POKE_STR);
 		return(1);
 	}
 
 	addr = strtol(argv[0], NULL, 0);
 	buf = strtol(argv[1], NULL, 0);
 
-	str += sprintf(str, "addr: 0x%08x, value: 0x%08x\n", addr, buf);
+	resp_printf(resp, "addr: 0x%08x, value: 0x%08x\n", addr, buf);
 
 	write = IP_API_Write(addr, (uint8_t *)&buf, sizeof(buf));
 	if(!write)
 	{
-		str += sprintf(str, "poke: 0x%08x : 0x%08x\n", addr, buf);
+		resp_printf(resp, "poke: 0x%08x : 0x%08x\n", addr, buf);
 	}
 	else
 	{
-		str += sprintf(str, "ip poke 0x%08x: error %d\n", addr, write);
+		resp_printf(resp, "ip poke 0x%08x: error %d\n", addr, write);
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Detects the IP version again and reports the register layout selected.
+* 
+*
+* @param [in]	argc   Number of string arguments.
+* @param [in]	argv   Array of strings containg arguments.
+* @param [in,out]	resp   Response to append the reply text to.
+*
+* @return
+*		- 0 Success
+*       - 2 IP version not known or revision not readable
+*
+******************************************************************************/
+int ip_version_func(int argc, char **argv, response_t *resp)
+{
+	unsigned int major = 0;
+	unsigned int minor = 0;
+	unsigned int version = 0;
+	int ret = 0;
+
+	ret = XROE_FIELDS_Detect();
+	xroe_get_cfg_major_revision(0, &major);
+	xroe_get_cfg_minor_revision(0, &minor);
+	xroe_get_cfg_version_revision(0, &version);
+
+	resp_printf(resp, "IP version %u.%u.%u, register layout %s\n", major, minor, version, XROE_FIELDS_Get_Layout()->name);
+	if(ret)
+	{
+		resp_printf(resp, "IP version not supported (%d)\n", ret);
+		return(2);
 	}
 
 	return 0;
@@ -178,23 +215,23 @@ int ip_poke_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 1 if no commands tokens found.
 *		- 2 if no handler found for command.
-*		- 0 otherwise.
+*		- the return value of the command handler otherwise.
 *
 ******************************************************************************/
-int ip_func(int argc, char **argv, char *resp)
+int ip_func(int argc, char **argv, response_t *resp)
 {
 	int count = 0;
 	int found = 0;
-	char *str = resp;
+	int ret = 0;
 
 	if(argc == 0)
 	{
-		sprintf(str, "\t%s", IP_USAGE_STR);
+		resp_printf(resp, "\t%s", IP_USAGE_STR);
 		return(1);
 	}
 
@@ -204,16 +241,16 @@ int ip_func(int argc, char **argv, char *resp)
 		{
 			found = 1;
 			/* Call the handler function for the command given */
-			ip_cmds[count].func(argc-1, &argv[1], str);
+			ret = ip_cmds[count].func(argc-1, &argv[1], resp);
 		}
 	}
 
 	if(!found)
 	{
-		str += sprintf(str, "Command %s not found, try \"help\"\n", argv[0]);
+		resp_printf(resp, "Command %s not found, try \"help\"\n", argv[0]);
 		return(2);
 	}
 
-	return 0;
+	return ret;
 }
 /** @} */
\ No newline at end of file
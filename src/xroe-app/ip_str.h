@@ -33,4 +33,9 @@
  * IP_POKE_STR Help text for the IP module "poke" option.
  */
 #define IP_POKE_STR "ip poke <address> <value>\n"
+
+/**
+ * IP_VERSION_STR Help text for the IP module "version" option.
+ */
+#define IP_VERSION_STR "ip version\n"
 /** @} */
\ No newline at end of file
@@ -0,0 +1,542 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file metrics.c
+* @addtogroup comms_lib
+* @{
+*
+*  OpenMetrics exposition of the Radio over Ethernet Framer state
+*
+*  METRICS_API_Answer() formats the HTTP response to a request received on
+*  the metrics port into a response, sent by the main loop like a command
+*  reply. Its length is not limited by MAX_RESPONSE_LENGTH.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <time.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+#include <xroe_types.h>
+#include <roe_framer_fields.h>
+#include <xroe_api.h>
+#include <stats_sampler.h>
+#include <radio_ctrl.h>
+#include <ecpri_proto.h>
+#include <ecpri_rt.h>
+#include <metrics.h>
+
+/* Size of the buffer the response is formatted in before each append */
+#define METRICS_BUFFER_LENGTH 4096
+
+#define METRICS_CONTENT_TYPE "application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+/**
+ * Position of each register in the framer status batch.
+ */
+#define METRICS_REG_FRAM_ENABLE		0
+#define METRICS_REG_DEFM_ENABLE		1
+#define METRICS_REG_XXV_RESET		2
+#define METRICS_REG_FRAM_READY		3
+#define METRICS_REG_DEFM_READY		4
+#define METRICS_REG_MAJOR		5
+#define METRICS_REG_MINOR		6
+#define METRICS_REG_REVISION		7
+#define METRICS_NUM_REGS		8
+
+/**
+ * metrics_writer_struct Buffered writer of a response.
+ */
+typedef struct metrics_writer_struct{
+	response_t *Resp;
+	int Length;  /**< Bytes in Buffer not appended yet */
+	int Error;   /**< Set once the response is full, the rest is dropped */
+	char Buffer[METRICS_BUFFER_LENGTH];
+} metrics_writer_struct;
+
+/**
+ * metrics_cache_struct Framer and radio status served to scrapers.
+ */
+typedef struct metrics_cache_struct{
+	uint64_t ReadNs;                      /**< Time of the last read, 0 if none */
+	int RegsValid[METRICS_NUM_REGS];      /**< Set for the fields of this IP */
+	uint32_t Regs[METRICS_NUM_REGS];
+	int RadioValid;
+	radio_ctrl_struct Radio;
+	antennas_status_struct Antennas;
+} metrics_cache_struct;
+
+/**
+ * MetricsCache Status read for the last scrape.
+ */
+static metrics_cache_struct MetricsCache;
+
+/* Whether an entry of SAMPLER_COUNTERS is a gauge */
+#define METRICS_COUNTER_GAUGE(_id, _name, _word, _gauge) [SAMPLER_##_id] = _gauge,
+
+/**
+ * MetricsCounterGauge Set for the sampled counters holding a rate.
+ */
+static const int MetricsCounterGauge[SAMPLER_NUM_COUNTERS] = {
+	SAMPLER_COUNTERS(METRICS_COUNTER_GAUGE)
+};
+
+/*****************************************************************************/
+/**
+*
+* Appends the buffered part of a response.
+*
+* @param [in,out]	pWriter   Response writer.
+*
+******************************************************************************/
+static void metrics_flush(metrics_writer_struct *pWriter)
+{
+	if(!pWriter->Error && pWriter->Length && resp_write(pWriter->Resp, pWriter->Buffer, pWriter->Length))
+	{
+		syslog(LOG_NOTICE, "%s:%d Metrics response longer than %d bytes, truncated\n", __FILE__, __LINE__, RESP_MAX_LENGTH);
+		pWriter->Error = 1;
+	}
+	pWriter->Length = 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Appends formatted text to a response, through the buffer.
+*
+* @param [in,out]	pWriter   Response writer.
+* @param [in]		fmt       printf() format.
+*
+******************************************************************************/
+static void metrics_printf(metrics_writer_struct *pWriter, const char *fmt, ...)
+{
+	va_list args;
+	int space;
+	int w;
+
+	space = sizeof(pWriter->Buffer) - pWriter->Length;
+	va_start(args, fmt);
+	w = vsnprintf(pWriter->Buffer + pWriter->Length, space, fmt, args);
+	va_end(args);
+
+	if(w >= space)
+	{
+		/* Did not fit, write out what is there and format again */
+		metrics_flush(pWriter);
+		space = sizeof(pWriter->Buffer);
+		va_start(args, fmt);
+		w = vsnprintf(pWriter->Buffer, space, fmt, args);
+		va_end(args);
+		w = (w < space) ? w : space - 1;
+	}
+
+	if(w > 0)
+	{
+		pWriter->Length += w;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes the TYPE and HELP lines of a metric family.
+*
+* @param [in,out]	pWriter   Response writer.
+* @param [in]		name      Family name.
+* @param [in]		type      OpenMetrics type.
+* @param [in]		help      Description.
+*
+******************************************************************************/
+static void metrics_family(metrics_writer_struct *pWriter, const char *name, const char *type, const char *help)
+{
+	metrics_printf(pWriter, "# TYPE %s %s\n# HELP %s %s\n", name, type, name, help);
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the framer and radio status, unless read less than
+* METRICS_MAX_AGE_MS ago.
+*
+******************************************************************************/
+static void metrics_update_cache(void)
+{
+	xroe_reg_op_t ops[METRICS_NUM_REGS];
+	struct timespec now;
+	uint64_t now_ns;
+	int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	now_ns = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+	if(MetricsCache.ReadNs && (now_ns - MetricsCache.ReadNs < METRICS_MAX_AGE_MS * 1000000ULL))
+	{
+		return;
+	}
+	MetricsCache.ReadNs = now_ns;
+
+	/* Fields absent in this IP version are left out of the batch */
+	memset(ops, 0, sizeof(ops));
+	MetricsCache.RegsValid[METRICS_REG_FRAM_ENABLE] = !xroe_op_fram_restart(0, &ops[METRICS_REG_FRAM_ENABLE]);
+	MetricsCache.RegsValid[METRICS_REG_DEFM_ENABLE] = !xroe_op_defm_restart(0, &ops[METRICS_REG_DEFM_ENABLE]);
+	MetricsCache.RegsValid[METRICS_REG_XXV_RESET] = !xroe_op_cfg_user_rw_out(0, &ops[METRICS_REG_XXV_RESET]);
+	MetricsCache.RegsValid[METRICS_REG_FRAM_READY] = !xroe_op_fram_ready(0, &ops[METRICS_REG_FRAM_READY]);
+	MetricsCache.RegsValid[METRICS_REG_DEFM_READY] = !xroe_op_defm_ready(0, &ops[METRICS_REG_DEFM_READY]);
+	MetricsCache.RegsValid[METRICS_REG_MAJOR] = !xroe_op_cfg_major_revision(0, &ops[METRICS_REG_MAJOR]);
+	MetricsCache.RegsValid[METRICS_REG_MINOR] = !xroe_op_cfg_minor_revision(0, &ops[METRICS_REG_MINOR]);
+	MetricsCache.RegsValid[METRICS_REG_REVISION] = !xroe_op_cfg_version_revision(0, &ops[METRICS_REG_REVISION]);
+
+	if(IP_API_Batch(ops, METRICS_NUM_REGS))
+	{
+		memset(MetricsCache.RegsValid, 0, sizeof(MetricsCache.RegsValid));
+	}
+	for(i = 0; i < METRICS_NUM_REGS; i++)
+	{
+		MetricsCache.Regs[i] = ops[i].value;
+	}
+
+	MetricsCache.RadioValid = !RADIO_CTRL_Get_Status(&MetricsCache.Radio, &MetricsCache.Antennas);
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes a framer status metric, if the IP has the field.
+*
+* @param [in,out]	pWriter   Response writer.
+* @param [in]		reg       Position of the register in the status batch.
+* @param [in]		name      Metric name.
+* @param [in]		help      Description.
+*
+******************************************************************************/
+static void metrics_framer_reg(metrics_writer_struct *pWriter, int reg, const char *name, const char *help)
+{
+	if(MetricsCache.RegsValid[reg])
+	{
+		metrics_family(pWriter, name, "gauge", help);
+		metrics_printf(pWriter, "%s %u\n", name, MetricsCache.Regs[reg]);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes the framer version and status metrics.
+*
+* @param [in,out]	pWriter   Response writer.
+*
+******************************************************************************/
+static void metrics_framer(metrics_writer_struct *pWriter)
+{
+	const xroe_layout_t *layout = XROE_FIELDS_Get_Layout();
+
+	metrics_family(pWriter, "xroe_ip", "info", "Framer IP version and register layout in use.");
+	metrics_printf(pWriter, "xroe_ip_info{version=\"%u.%u.%u\",layout=\"%s\"} 1\n",
+		MetricsCache.Regs[METRICS_REG_MAJOR], MetricsCache.Regs[METRICS_REG_MINOR],
+		MetricsCache.Regs[METRICS_REG_REVISION], layout->name);
+
+	metrics_family(pWriter, "xroe_eth_ports", "gauge", "Ethernet ports with statistics.");
+	metrics_printf(pWriter, "xroe_eth_ports %d\n", SAMPLER_API_Num_Ports());
+
+	metrics_framer_reg(pWriter, METRICS_REG_FRAM_ENABLE, "xroe_framer_enable", "Framer enable, as FramerEnable of \"stats gui\".");
+	metrics_framer_reg(pWriter, METRICS_REG_DEFM_ENABLE, "xroe_deframer_enable", "Deframer enable, as DeFramerEnable of \"stats gui\".");
+	metrics_framer_reg(pWriter, METRICS_REG_XXV_RESET, "xroe_xxv_reset", "Ethernet MAC reset.");
+	metrics_framer_reg(pWriter, METRICS_REG_FRAM_READY, "xroe_framer_ready", "Framer ready.");
+	metrics_framer_reg(pWriter, METRICS_REG_DEFM_READY, "xroe_deframer_ready", "Deframer ready.");
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes the statistics counters of every Ethernet port, from the sampler's
+* 64-bit totals, and the sampler's rates when it is running.
+*
+* @param [in,out]	pWriter   Response writer.
+*
+******************************************************************************/
+static void metrics_stats(metrics_writer_struct *pWriter)
+{
+	sampler_total_t total;
+	sampler_rate_t rate;
+	const char *name;
+	int port;
+	int i;
+
+	for(i = 0; i < SAMPLER_NUM_COUNTERS; i++)
+	{
+		name = SAMPLER_API_Counter_Name(i);
+		if(i == SAMPLER_FRAM_AUTO_RESTART_CNT)
+		{
+			/* Not a per port counter */
+			if(!SAMPLER_API_Total(0, i, &total))
+			{
+				metrics_family(pWriter, "xroe_stats_fram_auto_restart_cnt", "counter", "Framer automatic restarts.");
+				metrics_printf(pWriter, "xroe_stats_fram_auto_restart_cnt_total %" PRIu64 "\n", total.Total);
+			}
+			continue;
+		}
+
+		if(MetricsCounterGauge[i])
+		{
+			metrics_printf(pWriter, "# TYPE xroe_stats_%s gauge\n# HELP xroe_stats_%s Packets per second, from the %s register.\n", name, name, name);
+		}
+		else
+		{
+			metrics_printf(pWriter, "# TYPE xroe_stats_%s counter\n# HELP xroe_stats_%s Packets, from the 32-bit %s counter extended to 64 bits.\n", name, name, name);
+		}
+		for(port = 0; port < SAMPLER_API_Num_Ports(); port++)
+		{
+			if(SAMPLER_API_Total(port, i, &total))
+			{
+				continue;
+			}
+			metrics_printf(pWriter, "xroe_stats_%s%s{port=\"%d\"} %" PRIu64 "\n", name, MetricsCounterGauge[i] ? "" : "_total", port, total.Total);
+		}
+	}
+
+	metrics_family(pWriter, "xroe_stats_counter_wraps", "counter", "Wraps of the 32-bit statistics counters.");
+	for(port = 0; port < SAMPLER_API_Num_Ports(); port++)
+	{
+		for(i = 0; i < SAMPLER_NUM_COUNTERS; i++)
+		{
+			if(!MetricsCounterGauge[i] && (i != SAMPLER_FRAM_AUTO_RESTART_CNT) && !SAMPLER_API_Total(port, i, &total))
+			{
+				metrics_printf(pWriter, "xroe_stats_counter_wraps_total{port=\"%d\",counter=\"%s\"} %u\n", port, SAMPLER_API_Counter_Name(i), total.Wraps);
+			}
+		}
+	}
+
+	if(SAMPLER_API_Period() && !SAMPLER_API_Rate(0, &rate))
+	{
+		metrics_family(pWriter, "xroe_sampler_rate", "gauge", "Moving average of the per second change of a counter, all ports summed.");
+		for(i = 0; i < SAMPLER_NUM_COUNTERS; i++)
+		{
+			if(!SAMPLER_API_Rate(i, &rate))
+			{
+				metrics_printf(pWriter, "xroe_sampler_rate{counter=\"%s\"} %.1f\n", SAMPLER_API_Counter_Name(i), rate.Ewma);
+			}
+		}
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes a metric family with one value per antenna.
+*
+* @param [in,out]	pWriter   Response writer.
+* @param [in]		name      Metric name.
+* @param [in]		help      Description.
+* @param [in]		offset    Offset of the value in single_antenna_status_struct.
+*
+******************************************************************************/
+static void metrics_antennas(metrics_writer_struct *pWriter, const char *name, const char *help, size_t offset)
+{
+	const single_antenna_status_struct *antenna;
+	int i;
+
+	metrics_family(pWriter, name, "gauge", help);
+	for(i = 0; i < MetricsCache.Antennas.NumOfAntennas; i++)
+	{
+		antenna = &MetricsCache.Antennas.Antenna[i];
+		metrics_printf(pWriter, "%s{antenna=\"%d\"} %u\n", name, i, *(const unsigned int *)((const char *)antenna + offset));
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes the radio and per antenna status metrics.
+*
+* @param [in,out]	pWriter   Response writer.
+*
+******************************************************************************/
+static void metrics_radio(metrics_writer_struct *pWriter)
+{
+	if(!MetricsCache.RadioValid)
+	{
+		return;
+	}
+
+	metrics_family(pWriter, "xroe_radio_enable", "gauge", "Radio source enable.");
+	metrics_printf(pWriter, "xroe_radio_enable %u\n", MetricsCache.Radio.Enable);
+	metrics_family(pWriter, "xroe_radio_error", "gauge", "Radio CDC error bits 31:0.");
+	metrics_printf(pWriter, "xroe_radio_error %u\n", MetricsCache.Radio.Error);
+	metrics_family(pWriter, "xroe_radio_status", "gauge", "Radio CDC status bits 31:0.");
+	metrics_printf(pWriter, "xroe_radio_status %u\n", MetricsCache.Radio.Status);
+	metrics_family(pWriter, "xroe_radio_loopback", "gauge", "Radio CDC loopback.");
+	metrics_printf(pWriter, "xroe_radio_loopback %u\n", MetricsCache.Radio.Loopback);
+
+	metrics_antennas(pWriter, "xroe_antenna_align", "Deframer buffer state alignment.", offsetof(single_antenna_status_struct, Align));
+	metrics_antennas(pWriter, "xroe_antenna_regular", "Deframer buffer state regular.", offsetof(single_antenna_status_struct, Regular));
+	metrics_antennas(pWriter, "xroe_antenna_overflow", "Deframer buffer state overflow.", offsetof(single_antenna_status_struct, Overflow));
+	metrics_antennas(pWriter, "xroe_antenna_underflow", "Deframer buffer state underflow.", offsetof(single_antenna_status_struct, Underflow));
+	metrics_antennas(pWriter, "xroe_antenna_check_error", "Radio CDC check error.", offsetof(single_antenna_status_struct, CheckError));
+	metrics_antennas(pWriter, "xroe_antenna_buf_state_latency", "Deframer buffer state latency.", offsetof(single_antenna_status_struct, BufStateLatency));
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes the eCPRI One-Way Delay Measurement metrics.
+*
+* @param [in,out]	pWriter   Response writer.
+*
+******************************************************************************/
+static void metrics_owdm(metrics_writer_struct *pWriter)
+{
+	ecpri_owdm_direction_type direction = TO_REMOTE;
+	struct in_addr node;
+	unsigned long long secs = 0;
+	unsigned long nsecs = 0;
+	int req_no = 0;
+	int resp_no = 0;
+
+	proto_ecpri_get_owdm_result(&req_no, &resp_no, &direction, &node, &secs, &nsecs);
+
+	metrics_family(pWriter, "xroe_owdm_requests", "counter", "eCPRI One-Way Delay Measurement requests sent.");
+	metrics_printf(pWriter, "xroe_owdm_requests_total %d\n", req_no);
+	metrics_family(pWriter, "xroe_owdm_responses", "counter", "eCPRI One-Way Delay Measurement responses received.");
+	metrics_printf(pWriter, "xroe_owdm_responses_total %d\n", resp_no);
+
+	if(resp_no)
+	{
+		metrics_family(pWriter, "xroe_owdm_delay_seconds", "gauge", "Latest eCPRI One-Way Delay Measurement.");
+		metrics_printf(pWriter, "xroe_owdm_delay_seconds{direction=\"%s\",node=\"%s\"} %llu.%09lu\n",
+			(direction == TO_REMOTE) ? "TO_REMOTE" : "FROM_REMOTE", inet_ntoa(node), secs, nsecs);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes the wake-up latency histogram of the eCPRI thread, one series per
+* event waking it up.
+*
+* @param [in,out]	pWriter   Response writer.
+*
+******************************************************************************/
+static void metrics_ecpri_rt(metrics_writer_struct *pWriter)
+{
+	ecpri_rt_latency_struct latency;
+	unsigned long long count;
+	const char *name;
+	int event;
+	int i;
+
+	metrics_family(pWriter, "xroe_ecpri_wake_latency_seconds", "histogram",
+		"Time from the kernel timestamping an eCPRI event to the eCPRI thread waking up.");
+	for(event = 0; event < ECPRI_RT_EVENTS; event++)
+	{
+		ECPRI_RT_API_Get(event, &latency);
+		name = ECPRI_RT_API_Event_Name(event);
+		count = 0;
+		for(i = 0; i < ECPRI_RT_BUCKETS - 1; i++)
+		{
+			count += latency.Buckets[i];
+			metrics_printf(pWriter, "xroe_ecpri_wake_latency_seconds_bucket{event=\"%s\",le=\"%g\"} %llu\n",
+				name, ECPRI_RT_API_Bucket_Limit(i) / 1e9, count);
+		}
+		metrics_printf(pWriter, "xroe_ecpri_wake_latency_seconds_bucket{event=\"%s\",le=\"+Inf\"} %llu\n",
+			name, (unsigned long long)latency.Count);
+		metrics_printf(pWriter, "xroe_ecpri_wake_latency_seconds_count{event=\"%s\"} %llu\n",
+			name, (unsigned long long)latency.Count);
+		metrics_printf(pWriter, "xroe_ecpri_wake_latency_seconds_sum{event=\"%s\"} %llu.%09llu\n",
+			name, (unsigned long long)(latency.Sum / 1000000000ULL), (unsigned long long)(latency.Sum % 1000000000ULL));
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Tells whether the request received on a metrics connection is complete.
+* Only its request line is used, but its headers are taken in too, so that
+* none are left unread when the connection is closed.
+*
+* @param [in]	data   Bytes received.
+* @param [in]	len    Number of bytes.
+*
+* @return
+*		- 1 once the blank line ending the headers is received
+*		- 0 otherwise
+*
+******************************************************************************/
+int METRICS_API_Complete(const char *data, int len)
+{
+	int i;
+
+	for(i = 1; i < len; i++)
+	{
+		if((data[i] == '\n') && ((data[i - 1] == '\n') || ((i > 1) && (data[i - 1] == '\r') && (data[i - 2] == '\n'))))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Formats the HTTP response to a request for the metrics. The connection is
+* to be closed once the response is sent.
+*
+* @param [in]		request   Bytes received, the request line first.
+* @param [in]		len       Number of bytes.
+* @param [in,out]	resp      Response to append the HTTP response to.
+*
+* @return
+*		- 0 on success
+*		- EIO if the response was truncated
+*
+******************************************************************************/
+int METRICS_API_Answer(const char *request, int len, response_t *resp)
+{
+	static metrics_writer_struct writer;
+
+	memset(&writer, 0, sizeof(writer));
+	writer.Resp = resp;
+
+	if((len < 4) || (strncmp(request, "GET ", 4) != 0))
+	{
+		metrics_printf(&writer, "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+	}
+	else if(((len < 13) || (strncmp(request + 4, "/metrics ", 9) != 0)) &&
+	        ((len < 6) || (strncmp(request + 4, "/ ", 2) != 0)))
+	{
+		metrics_printf(&writer, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+	}
+	else
+	{
+		metrics_update_cache();
+
+		/* No Content-Length, the end of the response is the end of the connection */
+		metrics_printf(&writer, "HTTP/1.1 200 OK\r\nContent-Type: " METRICS_CONTENT_TYPE "\r\nConnection: close\r\n\r\n");
+		metrics_framer(&writer);
+		metrics_stats(&writer);
+		metrics_radio(&writer);
+		metrics_owdm(&writer);
+		metrics_ecpri_rt(&writer);
+		metrics_printf(&writer, "# EOF\n");
+	}
+
+	metrics_flush(&writer);
+
+	return writer.Error ? EIO : 0;
+}
+/** @} */
@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file metrics.h
+* @addtogroup comms_lib
+* @{
+*
+*  OpenMetrics exposition of the Radio over Ethernet Framer state
+*
+*  A scrape of "GET /metrics" on the metrics port returns the statistics
+*  counters of every Ethernet port, the framer, radio and antenna status and
+*  the eCPRI One-Way Delay Measurement results in the OpenMetrics text format.
+*  Counters come from the statistics sampler's totals, and the registers are
+*  read at most every METRICS_MAX_AGE_MS however often the units are scraped.
+*
+******************************************************************************/
+#ifndef METRICS_H		/* prevent circular inclusions */
+#define METRICS_H		/* by using protection macros */
+
+#include <response.h>
+
+/* Longest time the framer and radio status are served from cache, in ms */
+#define METRICS_MAX_AGE_MS 1000
+
+/************************** Function Prototypes ******************************/
+int METRICS_API_Complete(const char *data, int len);
+int METRICS_API_Answer(const char *request, int len, response_t *resp);
+#endif /* end of protection macro */
+/** @} */
@@ -19,11 +19,15 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
 
 #include <xroe_types.h>
 #include <xroefram_str.h>
 #include <commands.h>
 #include <parser.h>
+#include <comms.h>
 
 /*****************************************************************************/
 /**
@@ -33,22 +37,21 @@
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int help_func(int argc, char **argv, char *resp)
+int help_func(int argc, char **argv, response_t *resp)
 {
 	int i;
-	char *str = resp;
 
-	str += sprintf(str, "xroe-app help:\n");
+	resp_printf(resp, "xroe-app help:\n");
 
 	for (i = 0; i<XROE_MAX_COMMANDS - 1; i++)
 	{
-		str += sprintf(str, "\t%s\t : %s", cmds[i].cmd, cmds[i].helptxt);
+		resp_printf(resp, "\t%s\t : %s", cmds[i].cmd, cmds[i].helptxt);
 	}
 	return 0;
 }
@@ -61,19 +64,112 @@ int help_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int version_func(int argc, char **argv, char *resp)
+int version_func(int argc, char **argv, response_t *resp)
 {
-	sprintf(resp, XROE_VER_STR);
+	resp_printf(resp, XROE_VER_STR);
 	return 0;
 }
 
 
+/*****************************************************************************/
+/**
+*
+* Runs the commands of a file on the server, one per line, appending their
+* replies. Blank lines and lines starting with '#' are skipped. The first
+* command failing stops the script.
+*
+* The command port is open to the network, so only the files of
+* XROE_SCRIPT_DIR are run, by a name without any '/' or leading '.', and the
+* lines of a script are never echoed back in the errors.
+* 
+*
+* @param [in]	argc   Number of string arguments.
+* @param [in]	argv   Array of strings containg arguments.
+* @param [in,out]	resp   Response to append the reply text to.
+*
+* @return
+*		- 0 if every command succeeded
+*		- EINVAL on usage error, for a name outside XROE_SCRIPT_DIR, or for
+*		  commands not allowed in a script
+*		- ENAMETOOLONG if the path of the script does not fit PATH_MAX
+*		- errno value if the file cannot be opened
+*		- Return value of the failed command otherwise
+*
+******************************************************************************/
+int script_func(int argc, char **argv, response_t *resp)
+{
+	char line[MAX_RESPONSE_LENGTH];
+	char path[PATH_MAX];
+	FILE *file;
+	int number = 0;
+	int ret = 0;
+	int len;
+
+	if (argc != 1)
+	{
+		resp_printf(resp, "%s", XROE_SCRIPT_STR);
+		return EINVAL;
+	}
+
+	if ((argv[0][0] == '.') || strchr(argv[0], '/'))
+	{
+		resp_printf(resp, "script: %s: not a script name\n", argv[0]);
+		return EINVAL;
+	}
+
+	len = snprintf(path, sizeof(path), "%s/%s", XROE_SCRIPT_DIR, argv[0]);
+	if ((len < 0) || (len >= (int)sizeof(path)))
+	{
+		resp_printf(resp, "script: %s\n", strerror(ENAMETOOLONG));
+		return ENAMETOOLONG;
+	}
+
+	file = fopen(path, "r");
+	if (!file)
+	{
+		ret = errno;
+		resp_printf(resp, "script: %s: %s\n", argv[0], strerror(ret));
+		return ret;
+	}
+
+	while (!ret && fgets(line, sizeof(line), file))
+	{
+		number++;
+		len = strcspn(line, "\r\n");
+		line[len] = 0;
+		if ((len == 0) || (line[0] == '#'))
+		{
+			continue;
+		}
+
+		/* Commands taking over the connection, and scripts, are not run */
+		len = strspn(line, " ");
+		if (parse_command_is_inline(line) ||
+		    (!strncmp(line + len, "script", 6) && strchr(" ", line[len + 6])))
+		{
+			resp_printf(resp, "script: line %d: command not allowed in a script\n", number);
+			ret = EINVAL;
+			break;
+		}
+
+		parse_command(0, line, resp);
+		ret = resp->Status;
+		if (ret)
+		{
+			resp_printf(resp, "script: line %d: failed (%d), stopped\n", number, ret);
+		}
+	}
+
+	fclose(file);
+	return ret;
+}
+
 /*****************************************************************************/
 /**
 *
@@ -90,15 +186,16 @@ int version_func(int argc, char **argv, char *resp)
 int tokenise_input(char *in_str, char **cmd_tokens)
 {
 	int num_tokens = 0;
+	char *saveptr;
 	char *tmp;
 
-	tmp = strtok(in_str, " ");
+	tmp = strtok_r(in_str, " ", &saveptr);
 
 	while ((tmp != NULL) && (num_tokens < MAX_NUMBER_TOKENS))
 	{
 		cmd_tokens[num_tokens] = tmp;
 		num_tokens++;
-		tmp = strtok(NULL, " ");
+		tmp = strtok_r(NULL, " ", &saveptr);
 	}
 
 	return num_tokens;
@@ -113,29 +210,36 @@ int tokenise_input(char *in_str, char **cmd_tokens)
 *
 * @param [in]	nohw   		Ignored.
 * @param [in]	command		String of space separated command tokens.
-* @param [out]	response	Pointer to string to place response text in.
+* @param [in,out]	response	Response to append the reply text to.
 *
 * @return
 *		- 0 if no commands tokens found or no handler for command.
 *		- -1 on "quit" command.
 *		- Return value of lower-level command handler otherwise.
 *
+*		The return value, EINVAL for an unknown command, and the time taken
+*		are also stored in the response.
+*
 ******************************************************************************/
-int parse_command(int nohw, char *command, char *response)
+int parse_command(int nohw, char *command, response_t *response)
 {
 	int retVal = 0;
 	int count = 0;
 	int found = 0;
 	char *cmd_tokens[MAX_NUMBER_TOKENS];
+	struct timespec start;
+	struct timespec end;
 	int num_tokens = tokenise_input(command, cmd_tokens);
 
+	clock_gettime(CLOCK_MONOTONIC, &start);
 	if (num_tokens == 0)
 	{
-		sprintf(response, "%s", XROE_USAGE_STR);
+		resp_printf(response, "%s", XROE_USAGE_STR);
+		response->Status = EINVAL;
 	}
 	else if (strcmp(cmd_tokens[0], "quit") == 0)
 	{
-		sprintf(response, "%s", XROE_QUIT_STR);
+		resp_printf(response, "%s", XROE_QUIT_STR);
 		retVal = -1;
 	}
 	else
@@ -152,10 +256,52 @@ int parse_command(int nohw, char *command, char *response)
 
 		if (!found)
 		{
-			sprintf(response, "Command %s not found, try \"help\"\n", cmd_tokens[0]);
+			resp_printf(response, "Command %s not found, try \"help\"\n", cmd_tokens[0]);
 		}
+		response->Status = found ? retVal : EINVAL;
 	}
 
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	response->Usecs = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
 	return retVal;
 }
+
+/*****************************************************************************/
+/**
+*
+* Tells whether a command must be run by the main loop rather than by the
+* worker threads: "quit" ends the loop, and the commands listed in
+* main_thread_cmds take over the connection they came from.
+* 
+*
+* @param [in]	command		String of space separated command tokens.
+*
+* @return
+*		- 1 if the command must run in the main loop.
+*		- 0 if it may run in any thread.
+*
+******************************************************************************/
+int parse_command_is_inline(const char *command)
+{
+	int len;
+	int i;
+
+	command += strspn(command, " ");
+	len = strcspn(command, " ");
+
+	if (len == 0)
+	{
+		return 0;
+	}
+
+	for (i = 0; main_thread_cmds[i] != NULL; i++)
+	{
+		if (((int)strlen(main_thread_cmds[i]) == len) && !strncmp(command, main_thread_cmds[i], len))
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
 /** @} */
\ No newline at end of file
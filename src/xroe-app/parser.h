@@ -14,6 +14,8 @@
 *
 ******************************************************************************/
 
+#include <response.h>
+
 /**
  * MAX_NUMBER_TOKENS Maximum number of tokens a command string may contain.
  */
@@ -21,5 +23,6 @@
 
 /************************** Function Prototypes ******************************/
 int tokenise_input(char *in_str, char **cmd_tokens);
-int parse_command(int nohw, char *command, char *response);
+int parse_command(int nohw, char *command, response_t *response);
+int parse_command_is_inline(const char *command);
 /** @} */
\ No newline at end of file
@@ -27,31 +27,45 @@
 #include <xroe_types.h>
 #include <radio_ctrl_str.h>
 #include <roe_radio_ctrl.h>
-#include <roe_framer_ctrl.h>
+#include <roe_framer_fields.h>
 #include <errno.h>
 #include <inttypes.h>
 #include <xroe_api.h>
+#include <radio_ctrl.h>
+#include <comms.h>
+#include <buf_state.h>
 
 /**
  * RADIO_MAX_COMMANDS Number of commands handled by the radio_ctrl module.
  */
-#define RADIO_MAX_COMMANDS 7
+#define RADIO_MAX_COMMANDS 9
 
 /**
- * MAX_NUMBER_OF_ANTENNAS Number of antennae supported by the radio_ctrl module.
+ * RADIO_ANT_BUF_STATE_FIELDS Number of buffer state fields read per antenna.
  */
-#define MAX_NUMBER_OF_ANTENNAS 8
+#define RADIO_ANT_BUF_STATE_FIELDS 6
+
+/**
+ * Position of each buffer state field in an antenna's block of the batch.
+ */
+#define RADIO_BUF_STATE_ALIGN		0
+#define RADIO_BUF_STATE_REGULAR		1
+#define RADIO_BUF_STATE_OVERFLOW	2
+#define RADIO_BUF_STATE_UNDERFLOW	3
+#define RADIO_BUF_STATE_RWIN		4
+#define RADIO_BUF_STATE_LATENCY		5
 
 /************************** Function Prototypes ******************************/
-int RADIO_CTRL_CalulateBufStateLatency(int index, unsigned int *pBufStateLatency);
-int radio_ctrl_update_values(void);
+int radio_ctrl_update_values(radio_ctrl_struct *pRadio, antennas_status_struct *pAntennas);
 
-int radio_ctrl_help_func(int argc, char **argv, char *resp);
-int radio_ctrl_radio_id_func(int argc, char **argv, char *resp);
-int radio_ctrl_status_func(int argc, char **argv, char *resp);
-int radio_ctrl_loopback_en_func(int argc, char **argv, char *resp);
-int radio_ctrl_loopback_dis_func(int argc, char **argv, char *resp);
-int radio_ctrl_gui_func(int argc, char **argv, char *resp);
+int radio_ctrl_help_func(int argc, char **argv, response_t *resp);
+int radio_ctrl_radio_id_func(int argc, char **argv, response_t *resp);
+int radio_ctrl_status_func(int argc, char **argv, response_t *resp);
+int radio_ctrl_loopback_en_func(int argc, char **argv, response_t *resp);
+int radio_ctrl_loopback_dis_func(int argc, char **argv, response_t *resp);
+int radio_ctrl_gui_func(int argc, char **argv, response_t *resp);
+int radio_ctrl_track_func(int argc, char **argv, response_t *resp);
+int radio_ctrl_history_func(int argc, char **argv, response_t *resp);
 
 /**
  * radio_ctrl_cmds The commands handled by the radio_ctrl module.
@@ -64,52 +78,13 @@ commands_t radio_ctrl_cmds[RADIO_MAX_COMMANDS] = {
 	{"loopback_dis", RADIO_CTRL_LOOPBACK_DIS_STR, radio_ctrl_loopback_dis_func},
 	{"id", RADIO_CTRL_RADIO_ID_STR, radio_ctrl_radio_id_func},
 	{"gui", RADIO_CTRL_GUI_STR, radio_ctrl_gui_func},
+	{"track", RADIO_CTRL_TRACK_STR, radio_ctrl_track_func},
+	{"history", RADIO_CTRL_HISTORY_STR, radio_ctrl_history_func},
 	/* Insert commands here */
 	/* Keep this last - insert commands above */
 	{NULL, NULL, NULL}
 };
 
-/**
- * single_antenna_status_struct Status values for an antenna.
- */
-typedef struct single_antenna_status_struct{
-	unsigned int Align;
-	unsigned int Regular;
-	unsigned int Overflow;
-	unsigned int Underflow;
-	unsigned int CheckError;
-	unsigned int BufStateLatency;
-} single_antenna_status_struct;
-
-/**
- * antennas_status_struct Status values for an antenna array.
- */
-typedef struct antennas_status_struct{
-single_antenna_status_struct Antenna[MAX_NUMBER_OF_ANTENNAS];
-int NumOfAntennas;
-} antennas_status_struct;
-
-
-/**
- * radio_ctrl_struct Control/status structure for the radio.
- */
-typedef struct radio_ctrl_struct{
-	unsigned int Enable;
-	unsigned int Error;
-	unsigned int Status;
-	unsigned int Loopback;
-} radio_ctrl_struct;
-
-/**
- * RadioStatus Radio control/status variable.
- */
-static radio_ctrl_struct RadioStatus;
-
-/**
- * AntennasStatus Antennae status variable.
- */
-static antennas_status_struct AntennasStatus;
-
 /*****************************************************************************/
 /**
 *
@@ -118,22 +93,23 @@ static antennas_status_struct AntennasStatus;
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int radio_ctrl_gui_func(int argc, char **argv, char *resp)
+int radio_ctrl_gui_func(int argc, char **argv, response_t *resp)
 {
+	radio_ctrl_struct RadioStatus;
+	antennas_status_struct AntennasStatus;
 	int read = 0;
-	char *str = resp;
 	int i;
 
-	read = radio_ctrl_update_values();
+	read = radio_ctrl_update_values(&RadioStatus, &AntennasStatus);
 	if(!read)
 	{
-		str += sprintf(str, "{\"Enable\": %d, \"Error\": %d, \"Status\": %d, \"Loopback\": %d"
+		resp_printf(resp, "{\"Enable\": %d, \"Error\": %d, \"Status\": %d, \"Loopback\": %d"
 		,RadioStatus.Enable,
 		RadioStatus.Error,
 		RadioStatus.Status,
@@ -142,7 +118,7 @@ int radio_ctrl_gui_func(int argc, char **argv, char *resp)
 		//for(i=0; i<AntennasStatus.NumOfAntennas; i++)
 		for(i=0; i<MAX_NUMBER_OF_ANTENNAS; i++)
 		{
-			str += sprintf(str, ", \"Antenna%d\": {\"Align\": %u, \"Regular\": %u, \"Overflow\": %u, \"Underflow\": %u, \"CheckError\": %u, \"BufStateLatency\": %u}"
+			resp_printf(resp, ", \"Antenna%d\": {\"Align\": %u, \"Regular\": %u, \"Overflow\": %u, \"Underflow\": %u, \"CheckError\": %u, \"BufStateLatency\": %u}"
 			,i,
 			AntennasStatus.Antenna[i].Align,
 			AntennasStatus.Antenna[i].Regular,
@@ -151,12 +127,12 @@ int radio_ctrl_gui_func(int argc, char **argv, char *resp)
 			AntennasStatus.Antenna[i].CheckError,
 			AntennasStatus.Antenna[i].BufStateLatency);
 		}
-		str += sprintf(str, "}\n");
+		resp_printf(resp, "}\n");
 	}
 
 	else
 	{
-		str += sprintf(str, "/sys/kernel/traffic not opened gui read - radio_ctrl_gui_func\n");
+		resp_printf(resp, "/sys/kernel/traffic not opened gui read - radio_ctrl_gui_func\n");
 	}
 
 
@@ -164,6 +140,159 @@ int radio_ctrl_gui_func(int argc, char **argv, char *resp)
 
 }
 
+/*****************************************************************************/
+/**
+*
+* Shows or sets the period of the deframer buffer state tracker.
+* 
+*
+* @param [in]	argc   Number of string arguments.
+* @param [in]	argv   Array of strings containg arguments.
+* @param [in,out]	resp   Response to append the reply text to.
+*
+* @return
+*		- 0 on success
+*		- 1 on an invalid period or no buffer state in this IP version
+*
+******************************************************************************/
+int radio_ctrl_track_func(int argc, char **argv, response_t *resp)
+{
+	int period = 0;
+	int ret;
+
+	if(argc > 0)
+	{
+		period = (strcmp(argv[0], "off") == 0) ? 0 : (int)strtol(argv[0], NULL, 0);
+		ret = BUFSTATE_API_Start(period);
+		if(ret == ENODEV)
+		{
+			resp_printf(resp, "No per-antenna buffer state in the %s layout\n", XROE_FIELDS_Get_Layout()->name);
+			return(1);
+		}
+		else if(ret)
+		{
+			resp_printf(resp, "\t%s", RADIO_CTRL_TRACK_STR);
+			return(1);
+		}
+	}
+
+	period = BUFSTATE_API_Period();
+	if(period)
+	{
+		resp_printf(resp, "buffer state tracker: %d antennas every %d ms\n", BUFSTATE_API_Num_Antennas(), period);
+	}
+	else
+	{
+		resp_printf(resp, "buffer state tracker: off\n");
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the buffer state history of an antenna: the samples and rising
+* edges of each state flag, and the latency histogram per receive window.
+* 
+*
+* @param [in]	argc   Number of string arguments.
+* @param [in]	argv   Array of strings containg arguments.
+* @param [in,out]	resp   Response to append the reply text to.
+*
+* @return
+*		- 0 on success
+*		- 1 on invalid arguments
+*		- 3 if the tracker was never started
+*
+******************************************************************************/
+int radio_ctrl_history_func(int argc, char **argv, response_t *resp)
+{
+	bufstate_history_t history;
+	const bufstate_flag_history_t *pFlag;
+	uint64_t since;
+	int buffer = BUFSTATE_DATA;
+	int antenna;
+	int rwin;
+	int bucket;
+	int i;
+
+	if((argc < 1) || (argc > 2) || ((argc == 2) && strcmp(argv[1], "data") && strcmp(argv[1], "ctrl")))
+	{
+		resp_printf(resp, "\t%s", RADIO_CTRL_HISTORY_STR);
+		return(1);
+	}
+
+	if(!BUFSTATE_API_Num_Antennas())
+	{
+		resp_printf(resp, RADIO_CTRL_NO_HISTORY_STR);
+		return(3);
+	}
+
+	antenna = (int)strtol(argv[0], NULL, 0);
+	if((argc == 2) && !strcmp(argv[1], "ctrl"))
+	{
+		buffer = BUFSTATE_CTRL;
+	}
+	if(BUFSTATE_API_History(antenna, buffer, &history))
+	{
+		resp_printf(resp, "Antenna %s not tracked, %d antennas\n", argv[0], BUFSTATE_API_Num_Antennas());
+		return(1);
+	}
+
+	since = BUFSTATE_API_Start_Time();
+	resp_printf(resp, "antenna %d %s buffer: %" PRIu64 " samples since %" PRIu64 ".%03" PRIu64 "%s\n",
+		antenna, (buffer == BUFSTATE_DATA) ? "data" : "ctrl", history.Samples,
+		since / 1000, since % 1000, BUFSTATE_API_Period() ? "" : ", tracker stopped");
+	if(!history.Samples)
+	{
+		return 0;
+	}
+
+	resp_printf(resp, "latency last %u min %u max %u, rwin %u\n",
+		history.Latency, history.LatencyMin, history.LatencyMax, history.Rwin);
+
+	resp_printf(resp, "%-10s %4s %12s %10s %s\n", "flag", "now", "set_samples", "rises", "last_rise");
+	for(i = 0; i < BUFSTATE_NUM_FLAGS; i++)
+	{
+		pFlag = &history.FlagHistory[i];
+		resp_printf(resp, "%-10s %4d %12" PRIu64 " %10" PRIu64 " ",
+			BUFSTATE_API_Flag_Name(i), (history.Flags >> i) & 1, pFlag->SetSamples, pFlag->Rises);
+		if(pFlag->LastRiseMs)
+		{
+			resp_printf(resp, "%" PRIu64 ".%03" PRIu64 "\n", pFlag->LastRiseMs / 1000, pFlag->LastRiseMs % 1000);
+		}
+		else
+		{
+			resp_printf(resp, "never\n");
+		}
+	}
+
+	resp_printf(resp, "%-4s %-20s %12s\n", "rwin", "latency", "samples");
+	for(rwin = 0; rwin < BUFSTATE_RWIN_VALUES; rwin++)
+	{
+		for(bucket = 0; bucket < BUFSTATE_LATENCY_BUCKETS; bucket++)
+		{
+			if(!history.Histogram[rwin][bucket])
+			{
+				continue;
+			}
+			if(bucket)
+			{
+				char range[24];
+
+				snprintf(range, sizeof(range), "[%u,%u)", BUFSTATE_API_Bucket_Low(bucket), BUFSTATE_API_Bucket_Low(bucket) * 2);
+				resp_printf(resp, "%-4d %-20s %12" PRIu64 "\n", rwin, range, history.Histogram[rwin][bucket]);
+			}
+			else
+			{
+				resp_printf(resp, "%-4d %-20s %12" PRIu64 "\n", rwin, "0", history.Histogram[rwin][bucket]);
+			}
+		}
+	}
+
+	return 0;
+}
 
 /*****************************************************************************/
 /**
@@ -173,22 +302,21 @@ int radio_ctrl_gui_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int radio_ctrl_loopback_en_func(int argc, char **argv, char *resp)
+int radio_ctrl_loopback_en_func(int argc, char **argv, response_t *resp)
 {
 	int ret = 0;
-	char *str = resp;
 
 	ret = TRAFGEN_SYSFS_API_Write("radio_loopback", "enabled");
 
 	if(ret)
 	{
-		str += sprintf(str, "Error writing to xroe_traffic_gen/radio_loopback\n");
+		resp_printf(resp, "Error writing to xroe_traffic_gen/radio_loopback\n");
 	}
 
 	return 0;
@@ -203,22 +331,21 @@ int radio_ctrl_loopback_en_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int radio_ctrl_loopback_dis_func(int argc, char **argv, char *resp)
+int radio_ctrl_loopback_dis_func(int argc, char **argv, response_t *resp)
 {
 	int ret = 0;
-	char *str = resp;
 
 	ret = TRAFGEN_SYSFS_API_Write("radio_loopback", "disabled");
 
 	if(ret)
 	{
-		str += sprintf(str, "Error writing to xroe_traffic_gen/radio_loopback\n");
+		resp_printf(resp, "Error writing to xroe_traffic_gen/radio_loopback\n");
 	}
 
 	return 0;
@@ -233,43 +360,44 @@ int radio_ctrl_loopback_dis_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int radio_ctrl_status_func(int argc, char **argv, char *resp)
+int radio_ctrl_status_func(int argc, char **argv, response_t *resp)
 {
+	radio_ctrl_struct RadioStatus;
+	antennas_status_struct AntennasStatus;
 	int read = 0;
 	int i;
-	char *str = resp;
 
-	read = radio_ctrl_update_values();
+	read = radio_ctrl_update_values(&RadioStatus, &AntennasStatus);
 	if(!read)
 	{
-		str += sprintf(str, "\nEnable: %u\n",  RadioStatus.Enable);
-		str += sprintf(str, "Error: %u\n", RadioStatus.Error);
-		str += sprintf(str, "Status: %u\n", RadioStatus.Status);
-		str += sprintf(str, "Loopback: %u\n", RadioStatus.Loopback);
+		resp_printf(resp, "\nEnable: %u\n",  RadioStatus.Enable);
+		resp_printf(resp, "Error: %u\n", RadioStatus.Error);
+		resp_printf(resp, "Status: %u\n", RadioStatus.Status);
+		resp_printf(resp, "Loopback: %u\n", RadioStatus.Loopback);
 
 		//for(i=0; i<AntennasStatus.NumOfAntennas; i++)
 		for(i=0; i<MAX_NUMBER_OF_ANTENNAS; i++)
 		{
-			str += sprintf(str, "\nAntenna no.%d\n",  i);
-
-			str += sprintf(str, "Align: %u\n",  AntennasStatus.Antenna[i].Align);
-			str += sprintf(str, "Regular: %u\n",  AntennasStatus.Antenna[i].Regular);
-			str += sprintf(str, "Overflow: %u\n", AntennasStatus.Antenna[i].Overflow);
-			str += sprintf(str, "Underflow: %u\n", AntennasStatus.Antenna[i].Underflow);
-			str += sprintf(str, "CheckError: %u\n", AntennasStatus.Antenna[i].CheckError);
-			str += sprintf(str, "BufStateLatency: %u\n", AntennasStatus.Antenna[i].BufStateLatency);
+			resp_printf(resp, "\nAntenna no.%d\n",  i);
+
+			resp_printf(resp, "Align: %u\n",  AntennasStatus.Antenna[i].Align);
+			resp_printf(resp, "Regular: %u\n",  AntennasStatus.Antenna[i].Regular);
+			resp_printf(resp, "Overflow: %u\n", AntennasStatus.Antenna[i].Overflow);
+			resp_printf(resp, "Underflow: %u\n", AntennasStatus.Antenna[i].Underflow);
+			resp_printf(resp, "CheckError: %u\n", AntennasStatus.Antenna[i].CheckError);
+			resp_printf(resp, "BufStateLatency: %u\n", AntennasStatus.Antenna[i].BufStateLatency);
 		}
 	}
 
 	else
 	{
-		str += sprintf(str, "/sys/kernel/traffic not opened radio_ctrl_status_func\n");
+		resp_printf(resp, "/sys/kernel/traffic not opened radio_ctrl_status_func\n");
 	}
 
 	return 0;
@@ -284,26 +412,25 @@ int radio_ctrl_status_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int radio_ctrl_radio_id_func(int argc, char **argv, char *resp)
+int radio_ctrl_radio_id_func(int argc, char **argv, response_t *resp)
 {
 	int read = 0;
-	char *str = resp;
 	char buff[256];
 
 	read = TRAFGEN_SYSFS_API_Read("radio_id", buff);
 	if(!read)
 	{
-		strncat(str, buff, 256);
+		resp_printf(resp, "%.256s", buff);
 	}
 	else
 	{
-		str += sprintf(str, "/sys/kernel/traffic/ not opened radio_ctrl_radio_id_func\n");
+		resp_printf(resp, "/sys/kernel/traffic/ not opened radio_ctrl_radio_id_func\n");
 	}
 
 	return 0;
@@ -318,22 +445,21 @@ int radio_ctrl_radio_id_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int radio_ctrl_help_func(int argc, char **argv, char *resp)
+int radio_ctrl_help_func(int argc, char **argv, response_t *resp)
 {
 	int i;
-	char *str = resp;
 
-	str += sprintf(str, "radio_ctrl help:\n");
+	resp_printf(resp, "radio_ctrl help:\n");
 
 	for(i=0; radio_ctrl_cmds[i].cmd != NULL; i++)
 	{
-		str += sprintf(str, "\t%s\t : %s", radio_ctrl_cmds[i].cmd, radio_ctrl_cmds[i].helptxt);
+		resp_printf(resp, "\t%s\t : %s", radio_ctrl_cmds[i].cmd, radio_ctrl_cmds[i].helptxt);
 	}
 	return 0;
 }
@@ -346,23 +472,23 @@ int radio_ctrl_help_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 1 if no commands tokens found.
 *		- 2 if no handler found for command.
-*		- 0 otherwise.
+*		- the return value of the command handler otherwise.
 *
 ******************************************************************************/
-int radio_ctrl_func(int argc, char **argv, char *resp)
+int radio_ctrl_func(int argc, char **argv, response_t *resp)
 {
 	int count = 0;
 	int found = 0;
-	char *str = resp;
+	int ret = 0;
 
 	if(argc == 0)
 	{
-		sprintf(str, "\t%s", RADIO_CTRL_USAGE_STR);
+		resp_printf(resp, "\t%s", RADIO_CTRL_USAGE_STR);
 		return(1);
 	}
 
@@ -372,29 +498,75 @@ int radio_ctrl_func(int argc, char **argv, char *resp)
 		{
 			found = 1;
 			/* Call the handler function for the command given */
-			radio_ctrl_cmds[count].func(argc-1, &argv[1], resp);
+			ret = radio_ctrl_cmds[count].func(argc-1, &argv[1], resp);
 		}
 	}
 
 	if(!found)
 	{
-		str += sprintf(str, "Command %s not found, try \"help\"\n", argv[0]);
+		resp_printf(resp, "Command %s not found, try \"help\"\n", argv[0]);
 		return(2);
 	}
 
-	return 0;
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Fills in the batch operations reading the buffer state of an antenna.
+*
+* @param [in]	index   Index of the antenna.
+* @param [out]	ops     RADIO_ANT_BUF_STATE_FIELDS operations to fill in.
+*
+* @return
+*		- 0 on success
+*		- ENODEV if the IP version has no per-antenna buffer state
+*
+******************************************************************************/
+static int radio_ctrl_buf_state_ops(int index, xroe_reg_op_t *ops)
+{
+	int ret = 0;
+
+	ret |= xroe_op_defm_dbs_alignment(index, &ops[RADIO_BUF_STATE_ALIGN]);
+	ret |= xroe_op_defm_dbs_regular(index, &ops[RADIO_BUF_STATE_REGULAR]);
+	ret |= xroe_op_defm_dbs_overflow(index, &ops[RADIO_BUF_STATE_OVERFLOW]);
+	ret |= xroe_op_defm_dbs_underflow(index, &ops[RADIO_BUF_STATE_UNDERFLOW]);
+	ret |= xroe_op_defm_dbs_rwin(index, &ops[RADIO_BUF_STATE_RWIN]);
+	ret |= xroe_op_defm_dbs_latency(index, &ops[RADIO_BUF_STATE_LATENCY]);
+
+	return ret ? ENODEV : 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Calculates the buffer state latency from the deframer buffer state fields.
+*
+* @param [in]	rwin    Value of the buffer state RWIN field.
+* @param [in]	pdu     Value of the buffer state LATENCY field.
+*
+* @return
+*		- Buffer state latency.
+*
+******************************************************************************/
+static unsigned int radio_ctrl_buf_state_latency(unsigned int rwin, unsigned int pdu)
+{
+	return (2*rwin + 2) * pdu;
 }
 
 /*****************************************************************************/
 /**
 *
-* Updates the internal radio and antennae status variables.
+* Reads the radio and antennae status.
 * 
 *
+* @param [out]	pRadio      Pointer to place the radio status in.
+* @param [out]	pAntennas   Pointer to place the antennae status in.
+*
 * @return
 *		- Return value of TRAFGEN_SYSFS_API_Read() on error.
-*		- Return value of IP_API_Read_Register() on error.
-*		- Return value of RADIO_CTRL_CalulateBufStateLatency() on error.
+*		- Return value of IP_API_Batch() on error.
 *		- Return value of TRAFGEN_SYSFS_API_Read() otherwise.
 *
 /sys/kernel/traffic not opened gui read - radio_ctrl_gui_func
@@ -430,38 +602,40 @@ root@om0_pl00:~# find /sys/kernel/traffic
 /sys/kernel/traffic/radio_app_scratch_reg_1
 
 ******************************************************************************/
-int radio_ctrl_update_values(void)
+int radio_ctrl_update_values(radio_ctrl_struct *pRadio, antennas_status_struct *pAntennas)
 {
 	int ret = -1;
 	int i;
 	char buff[256];
 	unsigned int ant_error[4];
+	xroe_reg_op_t ops[MAX_NUMBER_OF_ANTENNAS*RADIO_ANT_BUF_STATE_FIELDS];
+	xroe_reg_op_t *op;
 
-	AntennasStatus.NumOfAntennas = MAX_NUMBER_OF_ANTENNAS; // hardcoded "8" for the Demo
+	pAntennas->NumOfAntennas = MAX_NUMBER_OF_ANTENNAS; // hardcoded "8" for the Demo
 
 
 	ret = TRAFGEN_SYSFS_API_Read("radio_source_enable", buff);
 	if(!ret)
 	{
-		RadioStatus.Enable = strtoul(buff, NULL, 0);
+		pRadio->Enable = strtoul(buff, NULL, 0);
 
 		ret = TRAFGEN_SYSFS_API_Read("radio_cdc_error_31_0", buff);
 	}
 	if(!ret)
 	{
-		RadioStatus.Error = strtoul(buff, NULL, 0);
+		pRadio->Error = strtoul(buff, NULL, 0);
 
 		ret = TRAFGEN_SYSFS_API_Read("radio_cdc_status_31_0", buff);
 	}
 	if(!ret)
 	{
-		RadioStatus.Status = strtoul(buff, NULL, 0);
+		pRadio->Status = strtoul(buff, NULL, 0);
 
 		ret = TRAFGEN_SYSFS_API_Read("radio_cdc_loopback", buff);
 	}
 	if(!ret)
 	{
-		RadioStatus.Loopback = strtoul(buff, NULL, 0);
+		pRadio->Loopback = strtoul(buff, NULL, 0);
 
 		ret = TRAFGEN_SYSFS_API_Read("radio_cdc_error_31_0", buff);
 	}
@@ -476,33 +650,34 @@ int radio_ctrl_update_values(void)
 	
 	if(!ret)
 	{
-		for(i=0; i<AntennasStatus.NumOfAntennas; i++)
+		/* Read the buffer state of all antennas in one register transaction */
+		for(i=0; i<pAntennas->NumOfAntennas && !ret; i++)
 		{
-			ret = IP_API_Read_Register(DEFM_DRPDEFM_DATA_BUFFER_STATE_ALIGNMENT_ADDR + (i*4), &AntennasStatus.Antenna[i].Align, DEFM_DRPDEFM_DATA_BUFFER_STATE_ALIGNMENT_MASK, DEFM_DRPDEFM_DATA_BUFFER_STATE_ALIGNMENT_OFFSET);
-			if(!ret)
-			{
-				ret = IP_API_Read_Register(DEFM_DRPDEFM_DATA_BUFFER_STATE_REGULAR_ADDR + (i*4), &AntennasStatus.Antenna[i].Regular, DEFM_DRPDEFM_DATA_BUFFER_STATE_REGULAR_MASK, DEFM_DRPDEFM_DATA_BUFFER_STATE_REGULAR_OFFSET);
-			}
-			if(!ret)
-			{
-				ret = IP_API_Read_Register(DEFM_DRPDEFM_DATA_BUFFER_STATE_OVERFLOW_ADDR + (i*4), &AntennasStatus.Antenna[i].Overflow, DEFM_DRPDEFM_DATA_BUFFER_STATE_OVERFLOW_MASK, DEFM_DRPDEFM_DATA_BUFFER_STATE_OVERFLOW_OFFSET);
-			}
-			if(!ret)
-			{
-				ret = IP_API_Read_Register(DEFM_DRPDEFM_DATA_BUFFER_STATE_UNDERFLOW_ADDR + (i*4), &AntennasStatus.Antenna[i].Overflow, DEFM_DRPDEFM_DATA_BUFFER_STATE_UNDERFLOW_MASK, DEFM_DRPDEFM_DATA_BUFFER_STATE_UNDERFLOW_OFFSET);
-			}
-			if(!ret)
-			{
-				AntennasStatus.Antenna[i].CheckError = (ant_error[i/32] & 1<<(i%32)) >> (i%32);
-			}
-			if(!ret)
-			{
-				ret = RADIO_CTRL_CalulateBufStateLatency(i, &AntennasStatus.Antenna[i].BufStateLatency);
-			}
-			if(ret)
-			{
-				break;
-			}
+			ret = radio_ctrl_buf_state_ops(i, &ops[i*RADIO_ANT_BUF_STATE_FIELDS]);
+		}
+		if(!ret)
+		{
+			ret = IP_API_Batch(ops, pAntennas->NumOfAntennas*RADIO_ANT_BUF_STATE_FIELDS);
+		}
+		else
+		{
+			/* No per-antenna buffer state in this IP version, report zeros */
+			memset(ops, 0, sizeof(ops));
+			ret = 0;
+		}
+	}
+
+	if(!ret)
+	{
+		for(i=0; i<pAntennas->NumOfAntennas; i++)
+		{
+			op = &ops[i*RADIO_ANT_BUF_STATE_FIELDS];
+			pAntennas->Antenna[i].Align = op[RADIO_BUF_STATE_ALIGN].value;
+			pAntennas->Antenna[i].Regular = op[RADIO_BUF_STATE_REGULAR].value;
+			pAntennas->Antenna[i].Overflow = op[RADIO_BUF_STATE_OVERFLOW].value;
+			pAntennas->Antenna[i].Underflow = op[RADIO_BUF_STATE_UNDERFLOW].value;
+			pAntennas->Antenna[i].CheckError = (ant_error[i/32] & 1<<(i%32)) >> (i%32);
+			pAntennas->Antenna[i].BufStateLatency = radio_ctrl_buf_state_latency(op[RADIO_BUF_STATE_RWIN].value, op[RADIO_BUF_STATE_LATENCY].value);
 		}
 	}
 
@@ -511,7 +686,7 @@ int radio_ctrl_update_values(void)
 		ret = TRAFGEN_SYSFS_API_Read("radio_cdc_loopback", buff);
 		if(!ret)
 		{		
-			RadioStatus.Loopback = strtoul(buff, NULL, 0);
+			pRadio->Loopback = strtoul(buff, NULL, 0);
 		}
 	}
 
@@ -530,6 +705,7 @@ int radio_ctrl_update_values(void)
 *
 * @return
 *		- -1 if index out of range.
+*		- ENODEV if the IP version has no per-antenna buffer state.
 *		- Return value of IP_API_Read_Register() otherwise.
 *
 ******************************************************************************/
@@ -547,20 +723,49 @@ int RADIO_CTRL_CalulateBufStateLatency(int index, unsigned int *pBufStateLatency
 
 	if(!ret)
 	{
-		ret =	IP_API_Read_Register(DEFM_DRPDEFM_DATA_BUFFER_STATE_RWIN_ADDR + (index*4), &readValue, DEFM_DRPDEFM_DATA_BUFFER_STATE_RWIN_MASK, DEFM_DRPDEFM_DATA_BUFFER_STATE_RWIN_OFFSET);
+		ret = xroe_get_defm_dbs_rwin(index, &readValue);
 	}
 	if(!ret)
 	{
 		Defm_Rwin = readValue;
-		ret =	IP_API_Read_Register(DEFM_DRPDEFM_DATA_BUFFER_STATE_LATENCY_ADDR + (index*4), &readValue, DEFM_DRPDEFM_DATA_BUFFER_STATE_LATENCY_MASK, DEFM_DRPDEFM_DATA_BUFFER_STATE_LATENCY_OFFSET);
+		ret = xroe_get_defm_dbs_latency(index, &readValue);
 	}
 
 	if(!ret)
 	{
 		Defm_Pdu = readValue;
-		*pBufStateLatency = (2*Defm_Rwin + 2) * Defm_Pdu;
+		*pBufStateLatency = radio_ctrl_buf_state_latency(Defm_Rwin, Defm_Pdu);
+	}
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the radio and antennae status.
+* 
+*
+* @param [out]	pRadio      Pointer to place the radio status in.
+* @param [out]	pAntennas   Pointer to place the antennae status in.
+*
+* @return
+*		- Return value of radio_ctrl_update_values().
+*
+******************************************************************************/
+int RADIO_CTRL_Get_Status(radio_ctrl_struct *pRadio, antennas_status_struct *pAntennas)
+{
+	radio_ctrl_struct radio;
+	antennas_status_struct antennas;
+	int ret;
+
+	ret = radio_ctrl_update_values(&radio, &antennas);
+	if(!ret)
+	{
+		*pRadio = radio;
+		*pAntennas = antennas;
 	}
 
 	return ret;
 }
-/** @} */
\ No newline at end of file
+/** @} */
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file radio_ctrl.h
+* @addtogroup command_parser
+* @{
+*
+*  Radio and antenna status of the RoE Framer software modules.
+*
+******************************************************************************/
+#ifndef RADIO_CTRL_H		/* prevent circular inclusions */
+#define RADIO_CTRL_H		/* by using protection macros */
+
+/**
+ * MAX_NUMBER_OF_ANTENNAS Number of antennae supported by the radio_ctrl module.
+ */
+#define MAX_NUMBER_OF_ANTENNAS 8
+
+/***************************** Type Definitions ******************************/
+/**
+ * single_antenna_status_struct Status values for an antenna.
+ */
+typedef struct single_antenna_status_struct{
+	unsigned int Align;
+	unsigned int Regular;
+	unsigned int Overflow;
+	unsigned int Underflow;
+	unsigned int CheckError;
+	unsigned int BufStateLatency;
+} single_antenna_status_struct;
+
+/**
+ * antennas_status_struct Status values for an antenna array.
+ */
+typedef struct antennas_status_struct{
+single_antenna_status_struct Antenna[MAX_NUMBER_OF_ANTENNAS];
+int NumOfAntennas;
+} antennas_status_struct;
+
+
+/**
+ * radio_ctrl_struct Control/status structure for the radio.
+ */
+typedef struct radio_ctrl_struct{
+	unsigned int Enable;
+	unsigned int Error;
+	unsigned int Status;
+	unsigned int Loopback;
+} radio_ctrl_struct;
+
+/************************** Function Prototypes ******************************/
+int RADIO_CTRL_CalulateBufStateLatency(int index, unsigned int *pBufStateLatency);
+int RADIO_CTRL_Get_Status(radio_ctrl_struct *pRadio, antennas_status_struct *pAntennas);
+#endif /* end of protection macro */
+/** @} */
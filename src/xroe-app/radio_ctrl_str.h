@@ -49,6 +49,21 @@
  */
 #define RADIO_CTRL_GUI_STR "[DEV] all radio output for GUI\n"
 
+/**
+ * RADIO_CTRL_TRACK_STR Help text for the radio_ctrl module "track" option.
+ */
+#define RADIO_CTRL_TRACK_STR "radio track [period_ms|off] : shows or sets the period of the buffer state tracker\n"
+
+/**
+ * RADIO_CTRL_HISTORY_STR Help text for the radio_ctrl module "history" option.
+ */
+#define RADIO_CTRL_HISTORY_STR "radio history <antenna> [data|ctrl] : buffer state flags and latency histogram\n"
+
+/**
+ * RADIO_CTRL_NO_HISTORY_STR Response when the buffer state was never tracked.
+ */
+#define RADIO_CTRL_NO_HISTORY_STR "No buffer state history, start the tracker with \"radio track <period_ms>\"\n"
+
 /**
  * RADIO_CTRL_PEEK_STR Help text for the radio_ctrl module "peek" option.
  */
@@ -0,0 +1,284 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file response.c
+* @addtogroup command_parser
+* @{
+*
+*  Response text of a command
+*
+*  Text is only ever appended at the end of the last chunk. When it does not
+*  fit, a chunk of twice the size of the last one, or of the text if larger,
+*  is allocated with its header. A formatted string is never split over two
+*  chunks. Resetting a response frees all chunks but the first, so that a
+*  response reused for each command only allocates for long replies.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <syslog.h>
+
+#include <response.h>
+
+/*****************************************************************************/
+/**
+*
+* Makes room at the end of a response, adding a chunk if the last one is
+* too short.
+*
+* @param [in,out]	resp   Response.
+* @param [in]		len    Bytes needed, including a terminating NUL.
+*
+* @return
+*		- Chunk with room for len bytes
+*		- NULL if the response would be too long, or out of memory
+*
+******************************************************************************/
+static resp_chunk_struct *resp_room(response_t *resp, size_t len)
+{
+	resp_chunk_struct *pChunk = resp->Tail;
+	size_t size;
+
+	if(resp->Len + len > RESP_MAX_LENGTH + 1)
+	{
+		return NULL;
+	}
+	if(pChunk->Size - pChunk->Len >= len)
+	{
+		return pChunk;
+	}
+	if(resp->NumChunks >= RESP_MAX_CHUNKS)
+	{
+		return NULL;
+	}
+
+	size = pChunk->Size * 2;
+	if(size < len)
+	{
+		size = len;
+	}
+	pChunk = malloc(sizeof(*pChunk) + size);
+	if(!pChunk)
+	{
+		return NULL;
+	}
+	pChunk->Next = NULL;
+	pChunk->Len = 0;
+	pChunk->Size = size;
+	pChunk->Data = (char *)(pChunk + 1);
+	pChunk->Data[0] = 0;
+
+	resp->Tail->Next = pChunk;
+	resp->Tail = pChunk;
+	resp->NumChunks++;
+	return pChunk;
+}
+
+/*****************************************************************************/
+/**
+*
+* Marks a response as truncated, logging it the first time.
+*
+* @param [in,out]	resp   Response.
+*
+******************************************************************************/
+static void resp_truncate(response_t *resp)
+{
+	if(!resp->Truncated)
+	{
+		syslog(LOG_ERR, "Response truncated at %zu bytes\n", resp->Len);
+	}
+	resp->Truncated = 1;
+}
+
+/*****************************************************************************/
+/**
+*
+* Initialises an empty response.
+*
+* @param [out]	resp   Response.
+*
+******************************************************************************/
+void resp_init(response_t *resp)
+{
+	resp->First.Next = NULL;
+	resp->First.Len = 0;
+	resp->First.Size = sizeof(resp->Inline);
+	resp->First.Data = resp->Inline;
+	resp->Inline[0] = 0;
+	resp->Tail = &resp->First;
+	resp->Len = 0;
+	resp->NumChunks = 1;
+	resp->Truncated = 0;
+	resp->Status = 0;
+	resp->Usecs = 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Empties a response, freeing the chunks allocated for it.
+*
+* @param [in,out]	resp   Response.
+*
+******************************************************************************/
+void resp_reset(response_t *resp)
+{
+	resp_chunk_struct *pChunk = resp->First.Next;
+	resp_chunk_struct *pNext;
+
+	while(pChunk)
+	{
+		pNext = pChunk->Next;
+		free(pChunk);
+		pChunk = pNext;
+	}
+	resp_init(resp);
+}
+
+/*****************************************************************************/
+/**
+*
+* Appends formatted text to a response.
+*
+* @param [in,out]	resp   Response.
+* @param [in]		fmt    printf() format.
+*
+* @return
+*		- Number of characters appended
+*		- -1 if the response is full, the text is dropped
+*
+******************************************************************************/
+int resp_printf(response_t *resp, const char *fmt, ...)
+{
+	resp_chunk_struct *pChunk = resp->Tail;
+	resp_chunk_struct *pRoom;
+	va_list args;
+	int len;
+
+	if(resp->Truncated)
+	{
+		return -1;
+	}
+
+	va_start(args, fmt);
+	len = vsnprintf(pChunk->Data + pChunk->Len, pChunk->Size - pChunk->Len, fmt, args);
+	va_end(args);
+	if(len < 0)
+	{
+		pChunk->Data[pChunk->Len] = 0;
+		return -1;
+	}
+
+	pRoom = resp_room(resp, len + 1);
+	if(pRoom != pChunk)
+	{
+		/* Undo the partial text and format again in a new chunk */
+		pChunk->Data[pChunk->Len] = 0;
+		if(!pRoom)
+		{
+			resp_truncate(resp);
+			return -1;
+		}
+		pChunk = pRoom;
+		va_start(args, fmt);
+		vsnprintf(pChunk->Data + pChunk->Len, pChunk->Size - pChunk->Len, fmt, args);
+		va_end(args);
+	}
+
+	pChunk->Len += len;
+	resp->Len += len;
+	return len;
+}
+
+/*****************************************************************************/
+/**
+*
+* Appends bytes to a response.
+*
+* @param [in,out]	resp   Response.
+* @param [in]		data   Bytes.
+* @param [in]		len    Number of bytes.
+*
+* @return
+*		- 0 on success
+*		- -1 if the response is full, the bytes are dropped
+*
+******************************************************************************/
+int resp_write(response_t *resp, const void *data, size_t len)
+{
+	resp_chunk_struct *pChunk;
+
+	if(resp->Truncated)
+	{
+		return -1;
+	}
+
+	pChunk = resp_room(resp, len + 1);
+	if(!pChunk)
+	{
+		resp_truncate(resp);
+		return -1;
+	}
+	memcpy(pChunk->Data + pChunk->Len, data, len);
+	pChunk->Len += len;
+	pChunk->Data[pChunk->Len] = 0;
+	resp->Len += len;
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the length of a response.
+*
+* @param [in]	resp   Response.
+*
+* @return
+*		- Length (bytes)
+*
+******************************************************************************/
+size_t resp_len(const response_t *resp)
+{
+	return resp->Len;
+}
+
+/*****************************************************************************/
+/**
+*
+* Describes the text of a response for writev(), one entry per chunk.
+*
+* @param [in]	resp   Response.
+* @param [out]	iov    Entries.
+* @param [in]	max    Number of entries, RESP_MAX_CHUNKS is always enough.
+*
+* @return
+*		- Number of entries used
+*
+******************************************************************************/
+int resp_iov(const response_t *resp, struct iovec *iov, int max)
+{
+	const resp_chunk_struct *pChunk;
+	int count = 0;
+
+	for(pChunk = &resp->First; pChunk && (count < max); pChunk = pChunk->Next)
+	{
+		if(pChunk->Len)
+		{
+			iov[count].iov_base = pChunk->Data;
+			iov[count].iov_len = pChunk->Len;
+			count++;
+		}
+	}
+	return count;
+}
+/** @} */
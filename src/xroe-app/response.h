@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file response.h
+* @addtogroup command_parser
+* @{
+*
+*  Response text of a command
+*
+*  Commands append their reply to a response, which starts in a buffer of its
+*  own and grows by chunks allocated as needed. The chunks are sent as they
+*  are, with writev(), without gathering them in one buffer first.
+*
+******************************************************************************/
+#ifndef RESPONSE_H		/* prevent circular inclusions */
+#define RESPONSE_H		/* by using protection macros */
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+/* Size of the chunk held in the response itself, enough for most replies */
+#define RESP_CHUNK_SIZE 1024
+
+/* Most chunks in a response, each one twice the size of the one before */
+#define RESP_MAX_CHUNKS 16
+
+/* Longest response, the text beyond it is dropped */
+#define RESP_MAX_LENGTH (1024 * 1024)
+
+/**
+ * resp_chunk_struct Part of a response, its text follows the header for
+ * the chunks allocated.
+ */
+typedef struct resp_chunk_struct{
+	struct resp_chunk_struct *Next;
+	size_t Len;
+	size_t Size;
+	char *Data;
+} resp_chunk_struct;
+
+/**
+ * response_t Response text, not to be copied as the first chunk points into it.
+ */
+typedef struct response_struct{
+	resp_chunk_struct *Tail;
+	size_t Len;                  /**< Length of the whole text */
+	int NumChunks;
+	int Truncated;               /**< Text was dropped */
+	int Status;                  /**< Return value of the command */
+	unsigned long Usecs;         /**< Time the command took (microseconds) */
+	resp_chunk_struct First;
+	char Inline[RESP_CHUNK_SIZE];
+} response_t;
+
+/************************** Function Prototypes ******************************/
+void resp_init(response_t *resp);
+void resp_reset(response_t *resp);
+int resp_printf(response_t *resp, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+int resp_write(response_t *resp, const void *data, size_t len);
+size_t resp_len(const response_t *resp);
+int resp_iov(const response_t *resp, struct iovec *iov, int max);
+#endif /* end of protection macro */
+/** @} */
@@ -36,8 +36,8 @@
 #define RESTART_MAX_COMMANDS 4
 
 /************************** Function Prototypes ******************************/
-int restart_help_func(int argc, char **argv, char *resp);
-int restart_xxv_func(int argc, char **argv, char *resp);
+int restart_help_func(int argc, char **argv, response_t *resp);
+int restart_xxv_func(int argc, char **argv, response_t *resp);
 
 /**
  * restart_cmds The commands handled by the restart module.
@@ -60,13 +60,13 @@ commands_t restart_cmds[RESTART_MAX_COMMANDS] = {
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- Return value of XXV_API_Reset()
 *
 ******************************************************************************/
-int restart_xxv_func(int argc, char **argv, char *resp)
+int restart_xxv_func(int argc, char **argv, response_t *resp)
 {
 	return(XXV_API_Reset());
 }
@@ -80,22 +80,21 @@ int restart_xxv_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int restart_help_func(int argc, char **argv, char *resp)
+int restart_help_func(int argc, char **argv, response_t *resp)
 {
 	int i;
-	char *str = resp;
 
-	str += sprintf(str, "restart help:\n");
+	resp_printf(resp, "restart help:\n");
 
 	for (i = 0; restart_cmds[i].cmd != NULL; i++)
 	{
-		str += sprintf(str, "\t%s\t : %s", restart_cmds[i].cmd, restart_cmds[i].helptxt);
+		resp_printf(resp, "\t%s\t : %s", restart_cmds[i].cmd, restart_cmds[i].helptxt);
 	}
 	return 0;
 }
@@ -109,23 +108,23 @@ int restart_help_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 1 if no commands tokens found.
 *		- 2 if no handler found for command.
-*		- 0 otherwise.
+*		- the return value of the command handler otherwise.
 *
 ******************************************************************************/
-int restart_func(int argc, char **argv, char *resp)
+int restart_func(int argc, char **argv, response_t *resp)
 {
 	int count = 0;
 	int found = 0;
-	char *str = resp;
+	int ret = 0;
 
 	if (argc == 0)
 	{
-		sprintf(str, "\t%s", RESTART_USAGE_STR);
+		resp_printf(resp, "\t%s", RESTART_USAGE_STR);
 		return(1);
 	}
 
@@ -135,16 +134,16 @@ int restart_func(int argc, char **argv, char *resp)
 		{
 			found = 1;
 			/* Call the handler function for the command given */
-			restart_cmds[count].func(argc - 1, &argv[1], resp);
+			ret = restart_cmds[count].func(argc - 1, &argv[1], resp);
 		}
 	}
 
 	if (!found)
 	{
-		str += sprintf(str, "Command %s not found, try \"help\"\n", argv[0]);
+		resp_printf(resp, "Command %s not found, try \"help\"\n", argv[0]);
 		return(2);
 	}
 
-	return 0;
+	return ret;
 }
 /** @} */
\ No newline at end of file
@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/ 
+
+/** 
+* @file roe_framer_fields.c
+* @addtogroup framer_driver_api
+* @{
+*
+*  Register layouts and name lookup tables for the Radio over Ethernet Framer
+*  register fields
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <roe_framer_fields.h>
+
+/* Layout entry for a field of the V1_0 map in roe_framer_ctrl.h */
+#define XROE_V1_0_LAYOUT(_id, _name, _reg, _stride, _access) \
+	[XROE_FIELD_##_id] = {_reg##_ADDR, _reg##_MASK, _reg##_OFFSET, _stride},
+
+/* Layout entry for a field given by its location */
+#define XROE_LAYOUT(_id, _addr, _mask, _offset, _stride) \
+	[XROE_FIELD_##_id] = {_addr, _mask, _offset, _stride},
+
+/**
+ * xroe_layout_v1_0 Field layout of the V1_0 IP, the map of roe_framer_ctrl.h.
+ */
+static const xroe_field_layout_t xroe_layout_v1_0[XROE_NUM_FIELDS] = {
+	XROE_CTRL_FIELDS(XROE_V1_0_LAYOUT)
+	XROE_FRAM_DRP_FIELDS(XROE_V1_0_LAYOUT)
+	XROE_DEFM_DRP_FIELDS(XROE_V1_0_LAYOUT)
+};
+
+/**
+ * xroe_layout_v2_2 Field layout of the V2_2 IP, as used by the staging driver.
+ * The V2_2 IP replaces the per-antenna DRP banks with the ORAN block and has
+ * no restart counter, fields left out here are reported as not present.
+ */
+static const xroe_field_layout_t xroe_layout_v2_2[XROE_NUM_FIELDS] = {
+	XROE_LAYOUT(cfg_major_revision, 0x0, 0xff000000, 24, 0)
+	XROE_LAYOUT(cfg_minor_revision, 0x0, 0xff0000, 16, 0)
+	XROE_LAYOUT(cfg_version_revision, 0x0, 0xff00, 8, 0)
+	XROE_LAYOUT(cfg_user_rw_out, 0xc, 0xff, 0, 0)
+	XROE_LAYOUT(cfg_no_of_fram_ants, 0x20, 0xffff, 0, 0)
+	XROE_LAYOUT(cfg_no_of_defm_ants, 0x20, 0xffff0000, 16, 0)
+	XROE_LAYOUT(cfg_no_of_eth_ports, 0x24, 0x3ff, 0, 0)
+	/* FRAM_DISABLE and DEFM_DISABLE hold the framers in reset like restart */
+	XROE_LAYOUT(fram_restart, 0x2000, 0x1, 0, 0)
+	XROE_LAYOUT(fram_ready, 0x2000, 0x2, 1, 0)
+	XROE_LAYOUT(defm_restart, 0x6000, 0x1, 0, 0)
+	XROE_LAYOUT(defm_ready, 0x6000, 0x2, 1, 0)
+	XROE_LAYOUT(stats_rx_good_pkt_cnt, 0xc000, 0xffffffff, 0, 0)
+	XROE_LAYOUT(stats_rx_bad_pkt_cnt, 0xc004, 0xffffffff, 0, 0)
+};
+
+/**
+ * xroe_cache_ranges_v1_0 Configuration registers of the V1_0 IP that may be
+ * held in the shadow cache. Restart/ready controls, buffer state, auto
+ * restart counts and the statistics counters are deliberately left out and
+ * always hit the framer. The V2_2 map is not described fully enough here to
+ * tell them apart, so its layout has no cacheable registers.
+ */
+static const xroe_reg_range_t xroe_cache_ranges_v1_0[] = {
+	{FRAM_SN_DATA_LOW_CNT_MIN_ADDR, FRAM_SN_CTRL_HIGH_CNT_INCVAL_ADDR + 4},
+	{FRAM_PROTOCOL_DEFINITION_ADDR, FRAM_PROTOCOL_DEFINITION_ADDR + 4},
+	{ROE_FRAMER_V1_0_FRAM_DRP_BASE_ADDR, ROE_FRAMER_V1_0_DEFM_BASE_ADDR},
+	{DEFM_ERR_PACKET_FILTER_ADDR, DEFM_CTRL_PKT_MESSAGE_TYPE_ADDR + 4},
+	{DEFM_SN_DATA_LOW_CNT_MIN_ADDR, DEFM_SN_CTRL_HIGH_CNT_INCVAL_ADDR + 4},
+	{DEFM_USER_DATA_FILTER_W0_31_0_ADDR, DEFM_USER_DATA_FILTER_W3_MASK_ADDR + 4},
+	{DEFM_DRPDEFM_DATA_PC_ID_ADDR, DEFM_DRPDEFM_DATA_BUFFER_STATE_ALIGNMENT_ADDR},
+	{ROE_FRAMER_V1_0_ETH_BASE_ADDR, ROE_FRAMER_V1_0_STATS_BASE_ADDR}
+};
+
+/**
+ * xroe_layouts Register layouts of the supported IP versions, the first entry
+ * is used when the IP version is not recognised.
+ */
+static const xroe_layout_t xroe_layouts[] = {
+	{"V1_0", 1, 0, xroe_layout_v1_0, xroe_cache_ranges_v1_0,
+	 sizeof(xroe_cache_ranges_v1_0) / sizeof(xroe_cache_ranges_v1_0[0])},
+	{"V2_2", 2, 2, xroe_layout_v2_2, NULL, 0}
+};
+
+/**
+ * XroeLayout The register layout of the detected IP version.
+ */
+static const xroe_layout_t *XroeLayout = &xroe_layouts[0];
+
+/**
+ * XroeFields The field layout table of the detected IP version.
+ */
+const xroe_field_layout_t *XroeFields = xroe_layout_v1_0;
+
+/**
+ * xroe_fram_drp_fields Per-antenna framer fields, sorted by name.
+ */
+const xroe_field_t xroe_fram_drp_fields[] = {
+	XROE_FRAM_DRP_FIELDS(XROE_FIELD_ENTRY)
+};
+
+/**
+ * xroe_fram_drp_num_fields Number of entries in xroe_fram_drp_fields.
+ */
+const int xroe_fram_drp_num_fields = sizeof(xroe_fram_drp_fields) / sizeof(xroe_fram_drp_fields[0]);
+
+/**
+ * xroe_defm_drp_fields Per-antenna deframer fields, sorted by name.
+ */
+const xroe_field_t xroe_defm_drp_fields[] = {
+	XROE_DEFM_DRP_FIELDS(XROE_FIELD_ENTRY)
+};
+
+/**
+ * xroe_defm_drp_num_fields Number of entries in xroe_defm_drp_fields.
+ */
+const int xroe_defm_drp_num_fields = sizeof(xroe_defm_drp_fields) / sizeof(xroe_defm_drp_fields[0]);
+
+/*****************************************************************************/
+/**
+*
+* Reads the IP revision and selects the register layout for it, the newest
+* layout with the same major revision and a minor revision not above the IP's.
+* Unknown IP versions keep the V1_0 layout. The shadow cache is given the
+* cacheable registers of the layout selected.
+*
+* @return
+*		- 0 on success
+*		- ENODEV if the IP version is not known
+*		- Return value of IP_API_Read_Register() on error
+*
+******************************************************************************/
+int XROE_FIELDS_Detect(void)
+{
+	const xroe_layout_t *layout = NULL;
+	unsigned int major = 0;
+	unsigned int minor = 0;
+	int i;
+	int ret;
+
+	/* The revision register is at the same place in all IP versions */
+	ret = IP_API_Read_Register(CFG_MAJOR_REVISION_ADDR, &major, CFG_MAJOR_REVISION_MASK, CFG_MAJOR_REVISION_OFFSET);
+	if(!ret)
+	{
+		ret = IP_API_Read_Register(CFG_MINOR_REVISION_ADDR, &minor, CFG_MINOR_REVISION_MASK, CFG_MINOR_REVISION_OFFSET);
+	}
+	if(ret)
+	{
+		syslog(LOG_ERR, "%s:%d Failed to read the IP revision (%d), using the %s layout\n", __FILE__, __LINE__, ret, XroeLayout->name);
+		IP_API_Cache_Set_Ranges(XroeLayout->cache_ranges, XroeLayout->num_cache_ranges);
+		return ret;
+	}
+
+	for(i = 0; i < sizeof(xroe_layouts) / sizeof(xroe_layouts[0]); i++)
+	{
+		if(xroe_layouts[i].major != major || xroe_layouts[i].minor > minor)
+		{
+			continue;
+		}
+		if(layout == NULL || xroe_layouts[i].minor > layout->minor)
+		{
+			layout = &xroe_layouts[i];
+		}
+	}
+
+	if(layout == NULL)
+	{
+		syslog(LOG_ERR, "%s:%d Unknown IP version %u.%u, using the %s layout\n", __FILE__, __LINE__, major, minor, xroe_layouts[0].name);
+		layout = &xroe_layouts[0];
+		ret = ENODEV;
+	}
+	else
+	{
+		syslog(LOG_NOTICE, "IP version %u.%u, using the %s layout\n", major, minor, layout->name);
+	}
+
+	XroeLayout = layout;
+	XroeFields = layout->fields;
+	IP_API_Cache_Set_Ranges(layout->cache_ranges, layout->num_cache_ranges);
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the register layout in use.
+*
+* @return
+*		- Pointer to the layout selected by XROE_FIELDS_Detect()
+*
+******************************************************************************/
+const xroe_layout_t *XROE_FIELDS_Get_Layout(void)
+{
+	return XroeLayout;
+}
+
+/*****************************************************************************/
+/**
+*
+* Compares a field name with a lookup table entry, for bsearch().
+*
+* @param [in]	key    Field name
+* @param [in]	entry  Lookup table entry
+*
+* @return
+*		- strcmp() of the name and the entry's name
+*
+******************************************************************************/
+static int xroe_field_cmp(const void *key, const void *entry)
+{
+	return strcmp((const char *)key, ((const xroe_field_t *)entry)->name);
+}
+
+/*****************************************************************************/
+/**
+*
+* Finds a field by name in a lookup table.
+*
+* @param [in]	fields     Lookup table, sorted by name
+* @param [in]	num_fields Number of entries in fields
+* @param [in]	name       Field name
+*
+* @return
+*		- Pointer to the field, NULL if not found
+*
+******************************************************************************/
+const xroe_field_t *xroe_field_find(const xroe_field_t *fields, int num_fields, const char *name)
+{
+	return bsearch(name, fields, num_fields, sizeof(*fields), xroe_field_cmp);
+}
+/** @} */
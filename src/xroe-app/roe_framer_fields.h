@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/ 
+
+/** 
+* @file roe_framer_fields.h
+* @addtogroup framer_driver_api
+* @{
+*
+*  Typed register field accessors for the Radio over Ethernet Framer
+*
+*  The fields used by the application are listed once in the X-macro tables
+*  below. Each entry is X(id, name, reg, stride, access) where reg is the
+*  register prefix in roe_framer_ctrl.h (the V1_0 map), stride the address
+*  step between antennas (0 for single registers) and access XROE_FIELD_RO or
+*  XROE_FIELD_RW. Entries of the per-antenna lists must be kept sorted by
+*  name, as the name lookup tables are searched with bsearch().
+*
+*  Each supported IP version has a layout table giving the address, mask,
+*  offset and stride of every field, or a zero mask if the version does not
+*  have it. XROE_FIELDS_Detect() reads the IP revision at startup and selects
+*  the matching layout, which the generated accessors then use:
+*  - xroe_get_<id>() and xroe_set_<id>() (set_ is read-modify-write)
+*  - xroe_op_<id>() to fill in a read operation for IP_API_Batch()
+*  They return ENODEV for fields missing from the detected IP version.
+*
+******************************************************************************/
+#ifndef ROE_FRAMER_FIELDS_H	/* prevent circular inclusions */
+#define ROE_FRAMER_FIELDS_H	/* by using protection macros */
+
+#include <stdint.h>
+#include <errno.h>
+#include <roe_framer_ctrl.h>
+#include <xroe_api.h>
+
+/* Field access types */
+#define XROE_FIELD_RO 0
+#define XROE_FIELD_RW 1
+
+/* Address step between per-antenna DRP registers */
+#define XROE_ANT_STRIDE 4
+
+/**
+ * XROE_CTRL_FIELDS Single (not per-antenna) fields used by the application.
+ */
+#define XROE_CTRL_FIELDS(X) \
+	X(cfg_major_revision, "major_revision", CFG_MAJOR_REVISION, 0, XROE_FIELD_RO) \
+	X(cfg_minor_revision, "minor_revision", CFG_MINOR_REVISION, 0, XROE_FIELD_RO) \
+	X(cfg_version_revision, "version_revision", CFG_VERSION_REVISION, 0, XROE_FIELD_RO) \
+	X(cfg_user_rw_out, "user_rw_out", CFG_USER_RW_OUT, 0, XROE_FIELD_RW) \
+	X(cfg_no_of_fram_ants, "no_of_fram_ants", CFG_CONFIG_NO_OF_FRAM_ANTS, 0, XROE_FIELD_RO) \
+	X(cfg_no_of_defm_ants, "no_of_defm_ants", CFG_CONFIG_NO_OF_DEFM_ANTS, 0, XROE_FIELD_RO) \
+	X(cfg_no_of_eth_ports, "no_of_eth_ports", CFG_CONFIG_NO_OF_ETH_PORTS, 0, XROE_FIELD_RO) \
+	X(fram_restart, "fram_restart", FRAM_RESTART, 0, XROE_FIELD_RW) \
+	X(fram_ready, "fram_ready", FRAM_READY, 0, XROE_FIELD_RO) \
+	X(fram_auto_restart_cnt, "fram_auto_restart_cnt", FRAM_AUTO_RESTART_CNT, 0, XROE_FIELD_RO) \
+	X(defm_restart, "defm_restart", DEFM_RESTART, 0, XROE_FIELD_RW) \
+	X(defm_ready, "defm_ready", DEFM_READY, 0, XROE_FIELD_RO) \
+	X(stats_rx_good_pkt_cnt, "rx_good_pkt_cnt", STATS_TOTAL_RX_GOOD_PKT_CNT, 0, XROE_FIELD_RO) \
+	X(stats_rx_bad_pkt_cnt, "rx_bad_pkt_cnt", STATS_TOTAL_RX_BAD_PKT_CNT, 0, XROE_FIELD_RO)
+
+/**
+ * XROE_FRAM_DRP_FIELDS Per-antenna framer fields, sorted by name.
+ */
+#define XROE_FRAM_DRP_FIELDS(X) \
+	X(fram_ctrl_pc_id, "ctrl_pc_id", FRAM_DRPFRAM_CTRL_PC_ID, XROE_ANT_STRIDE, XROE_FIELD_RW) \
+	X(fram_ctrl_port, "ctrl_port", FRAM_DRPFRAM_CTRL_ETHERNET_PORT, XROE_ANT_STRIDE, XROE_FIELD_RW) \
+	X(fram_ctrl_type, "ctrl_type", FRAM_DRPFRAM_CTRL_MESSAGE_TYPE, XROE_ANT_STRIDE, XROE_FIELD_RW) \
+	X(fram_data_pc_id, "data_pc_id", FRAM_DRPFRAM_DATA_PC_ID, XROE_ANT_STRIDE, XROE_FIELD_RW) \
+	X(fram_data_port, "data_port", FRAM_DRPFRAM_DATA_ETHERNET_PORT, XROE_ANT_STRIDE, XROE_FIELD_RW) \
+	X(fram_data_type, "data_type", FRAM_DRPFRAM_DATA_MESSAGE_TYPE, XROE_ANT_STRIDE, XROE_FIELD_RW)
+
+/**
+ * XROE_DEFM_DRP_FIELDS Per-antenna deframer fields, sorted by name.
+ */
+#define XROE_DEFM_DRP_FIELDS(X) \
+	X(defm_cbs_alignment, "cbs_alignment", DEFM_DRPDEFM_CTRL_BUFFER_STATE_ALIGNMENT, XROE_ANT_STRIDE, XROE_FIELD_RO) \
+	X(defm_cbs_latency, "cbs_latency", DEFM_DRPDEFM_CTRL_BUFFER_STATE_LATENCY, XROE_ANT_STRIDE, XROE_FIELD_RO) \
+	X(defm_cbs_overflow, "cbs_overflow", DEFM_DRPDEFM_CTRL_BUFFER_STATE_OVERFLOW, XROE_ANT_STRIDE, XROE_FIELD_RO) \
+	X(defm_cbs_regular, "cbs_regular", DEFM_DRPDEFM_CTRL_BUFFER_STATE_REGULAR, XROE_ANT_STRIDE, XROE_FIELD_RO) \
+	X(defm_cbs_rwin, "cbs_rwin", DEFM_DRPDEFM_CTRL_BUFFER_STATE_RWIN, XROE_ANT_STRIDE, XROE_FIELD_RO) \
+	X(defm_cbs_underflow, "cbs_underflow", DEFM_DRPDEFM_CTRL_BUFFER_STATE_UNDERFLOW, XROE_ANT_STRIDE, XROE_FIELD_RO) \
+	X(defm_ctrl_pc_id, "ctrl_pc_id", DEFM_DRPDEFM_CTRL_PC_ID, XROE_ANT_STRIDE, XROE_FIELD_RW) \
+	X(defm_data_pc_id, "data_pc_id", DEFM_DRPDEFM_DATA_PC_ID, XROE_ANT_STRIDE, XROE_FIELD_RW) \
+	X(defm_dbs_alignment, "dbs_alignment", DEFM_DRPDEFM_DATA_BUFFER_STATE_ALIGNMENT, XROE_ANT_STRIDE, XROE_FIELD_RO) \
+	X(defm_dbs_latency, "dbs_latency", DEFM_DRPDEFM_DATA_BUFFER_STATE_LATENCY, XROE_ANT_STRIDE, XROE_FIELD_RO) \
+	X(defm_dbs_overflow, "dbs_overflow", DEFM_DRPDEFM_DATA_BUFFER_STATE_OVERFLOW, XROE_ANT_STRIDE, XROE_FIELD_RO) \
+	X(defm_dbs_regular, "dbs_regular", DEFM_DRPDEFM_DATA_BUFFER_STATE_REGULAR, XROE_ANT_STRIDE, XROE_FIELD_RO) \
+	X(defm_dbs_rwin, "dbs_rwin", DEFM_DRPDEFM_DATA_BUFFER_STATE_RWIN, XROE_ANT_STRIDE, XROE_FIELD_RO) \
+	X(defm_dbs_underflow, "dbs_underflow", DEFM_DRPDEFM_DATA_BUFFER_STATE_UNDERFLOW, XROE_ANT_STRIDE, XROE_FIELD_RO)
+
+/***************************** Type Definitions ******************************/
+/* Field identifier for an entry of the field lists */
+#define XROE_FIELD_ID(_id, _name, _reg, _stride, _access) XROE_FIELD_##_id,
+
+/**
+ * xroe_field_id_t Identifiers of all fields, used to index layout tables.
+ */
+typedef enum xroe_field_id_t{
+	XROE_CTRL_FIELDS(XROE_FIELD_ID)
+	XROE_FRAM_DRP_FIELDS(XROE_FIELD_ID)
+	XROE_DEFM_DRP_FIELDS(XROE_FIELD_ID)
+	XROE_NUM_FIELDS
+} xroe_field_id_t;
+
+/**
+ * xroe_field_layout_t Location of a field in one IP version.
+ */
+typedef struct xroe_field_layout_t{
+	uint32_t addr;
+	uint32_t mask; /**< 0 if the IP version does not have the field */
+	uint32_t offset;
+	uint32_t stride;
+} xroe_field_layout_t;
+
+/**
+ * xroe_layout_t Register layout of one IP version.
+ */
+typedef struct xroe_layout_t{
+	const char *name;
+	unsigned int major;
+	unsigned int minor;
+	const xroe_field_layout_t *fields; /**< XROE_NUM_FIELDS entries */
+	const xroe_reg_range_t *cache_ranges; /**< Registers the shadow cache may hold */
+	int num_cache_ranges; /**< 0 if the shadow cache is not supported */
+} xroe_layout_t;
+
+/**
+ * xroe_field_t A register field as listed in the name lookup tables.
+ */
+typedef struct xroe_field_t{
+	const char *name;
+	xroe_field_id_t id;
+	int access;
+} xroe_field_t;
+
+/* Lookup table entry for a field */
+#define XROE_FIELD_ENTRY(_id, _name, _reg, _stride, _access) \
+	{_name, XROE_FIELD_##_id, _access},
+
+/************************** Variable Definitions *****************************/
+extern const xroe_field_layout_t *XroeFields;
+extern const xroe_field_t xroe_fram_drp_fields[];
+extern const int xroe_fram_drp_num_fields;
+extern const xroe_field_t xroe_defm_drp_fields[];
+extern const int xroe_defm_drp_num_fields;
+
+/************************** Function Prototypes ******************************/
+int XROE_FIELDS_Detect(void);
+const xroe_layout_t *XROE_FIELDS_Get_Layout(void);
+const xroe_field_t *xroe_field_find(const xroe_field_t *fields, int num_fields, const char *name);
+
+/**************************** Field Accessors ********************************/
+/* Reads a field, index selects the antenna for per-antenna fields */
+static inline int xroe_field_get(xroe_field_id_t id, int index, unsigned int *pValue)
+{
+	const xroe_field_layout_t *field = &XroeFields[id];
+
+	if(!field->mask)
+	{
+		*pValue = 0;
+		return ENODEV;
+	}
+	return IP_API_Read_Register(field->addr + index * field->stride, pValue, field->mask, field->offset);
+}
+
+/* Read-modify-writes a field, index selects the antenna for per-antenna fields */
+static inline int xroe_field_set(xroe_field_id_t id, int index, unsigned int value)
+{
+	const xroe_field_layout_t *field = &XroeFields[id];
+
+	if(!field->mask)
+	{
+		return ENODEV;
+	}
+	return IP_API_Update_Register(field->addr + index * field->stride, value, field->mask, field->offset);
+}
+
+/* Fills in a batch read operation for a field */
+static inline int xroe_field_op(xroe_field_id_t id, int index, xroe_reg_op_t *op)
+{
+	const xroe_field_layout_t *field = &XroeFields[id];
+
+	if(!field->mask)
+	{
+		return ENODEV;
+	}
+	op->addr = field->addr + index * field->stride;
+	op->mask = field->mask;
+	op->offset = field->offset;
+	op->value = 0;
+	op->op = XROE_REG_OP_READ;
+	return 0;
+}
+
+/* Typed accessors for a field */
+#define XROE_FIELD_ACCESSORS(_id, _name, _reg, _stride, _access) \
+static inline int xroe_get_##_id(int index, unsigned int *pValue) \
+{ \
+	return xroe_field_get(XROE_FIELD_##_id, index, pValue); \
+} \
+static inline int xroe_set_##_id(int index, unsigned int value) \
+{ \
+	return xroe_field_set(XROE_FIELD_##_id, index, value); \
+} \
+static inline int xroe_op_##_id(int index, xroe_reg_op_t *op) \
+{ \
+	return xroe_field_op(XROE_FIELD_##_id, index, op); \
+}
+
+XROE_CTRL_FIELDS(XROE_FIELD_ACCESSORS)
+XROE_FRAM_DRP_FIELDS(XROE_FIELD_ACCESSORS)
+XROE_DEFM_DRP_FIELDS(XROE_FIELD_ACCESSORS)
+#endif /* end of protection macro */
+/** @} */
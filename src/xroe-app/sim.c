@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/ 
+
+/** 
+* @file sim.c
+* @addtogroup command_parser
+* @{
+*
+*  A sample command parser for the RoE Framer software modules.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <xroe_types.h>
+#include <sim_str.h>
+#include <roe_framer_fields.h>
+#include <xroe_api.h>
+#include <xroe_sim.h>
+
+/**
+ * SIM_MAX_COMMANDS Number of commands handled by the sim module.
+ */
+#define SIM_MAX_COMMANDS 5
+
+/************************** Function Prototypes ******************************/
+int sim_help_func(int argc, char **argv, response_t *resp);
+int sim_rate_func(int argc, char **argv, response_t *resp);
+int sim_status_func(int argc, char **argv, response_t *resp);
+int sim_reset_func(int argc, char **argv, response_t *resp);
+
+/**
+ * sim_cmds The commands handled by the sim module.
+ */
+commands_t sim_cmds[SIM_MAX_COMMANDS] = {
+	/* Keep this first */
+	{"help", SIM_HELP_STR, sim_help_func},
+	/* Insert commands here */
+	{"rate", SIM_RATE_STR, sim_rate_func},
+	{"status", SIM_STATUS_STR, sim_status_func},
+	{"reset", SIM_RESET_STR, sim_reset_func},
+	/* Keep this last - insert commands above */
+	{NULL, NULL, NULL}
+};
+
+/*****************************************************************************/
+/**
+*
+* Returns help strings for sim commands.
+* 
+*
+* @param [in]	argc   Number of string arguments.
+* @param [in]	argv   Array of strings containg arguments.
+* @param [in,out]	resp   Response to append the reply text to.
+*
+* @return
+*		- 0
+*
+******************************************************************************/
+int sim_help_func(int argc, char **argv, response_t *resp)
+{
+	int i;
+
+	resp_printf(resp, "sim help:\n");
+
+	for(i=0; sim_cmds[i].cmd != NULL; i++)
+	{
+		resp_printf(resp, "\t%s\t : %s", sim_cmds[i].cmd, sim_cmds[i].helptxt);
+	}
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets or shows the packet rates of the simulated deframer.
+* 
+*
+* @param [in]	argc   Number of string arguments.
+* @param [in]	argv   Array of strings containg arguments.
+* @param [in,out]	resp   Response to append the reply text to.
+*
+* @return
+*		- 0
+*
+******************************************************************************/
+int sim_rate_func(int argc, char **argv, response_t *resp)
+{
+	uint32_t data_pps, ctrl_pps, bad_pps;
+
+	SIM_API_Get_Rates(&data_pps, &ctrl_pps, &bad_pps);
+
+	if(argc > 0)
+	{
+		data_pps = (uint32_t)strtoul(argv[0], NULL, 0);
+	}
+	if(argc > 1)
+	{
+		ctrl_pps = (uint32_t)strtoul(argv[1], NULL, 0);
+	}
+	if(argc > 2)
+	{
+		bad_pps = (uint32_t)strtoul(argv[2], NULL, 0);
+	}
+	if(argc > 0)
+	{
+		SIM_API_Set_Rates(data_pps, ctrl_pps, bad_pps);
+	}
+
+	resp_printf(resp, "data_pps:%u ctrl_pps:%u bad_pps:%u\n", data_pps, ctrl_pps, bad_pps);
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Shows the state of the simulated framer.
+* 
+*
+* @param [in]	argc   Number of string arguments.
+* @param [in]	argv   Array of strings containg arguments.
+* @param [in,out]	resp   Response to append the reply text to.
+*
+* @return
+*		- 0
+*
+******************************************************************************/
+int sim_status_func(int argc, char **argv, response_t *resp)
+{
+	uint32_t data_pps, ctrl_pps, bad_pps;
+	unsigned int fram_restart = 0, fram_ready = 0;
+	unsigned int defm_restart = 0, defm_ready = 0;
+	unsigned int good = 0, bad = 0;
+
+	SIM_API_Get_Rates(&data_pps, &ctrl_pps, &bad_pps);
+
+	resp_printf(resp, "Backend: %s\n", (IP_API_Get_Backend() == SIM_API_Backend()) ? "simulated" : "hardware");
+
+	xroe_get_fram_restart(0, &fram_restart);
+	xroe_get_fram_ready(0, &fram_ready);
+	xroe_get_defm_restart(0, &defm_restart);
+	xroe_get_defm_ready(0, &defm_ready);
+	xroe_get_stats_rx_good_pkt_cnt(0, &good);
+	xroe_get_stats_rx_bad_pkt_cnt(0, &bad);
+
+	resp_printf(resp, "Framer: restart %u, ready %u\n", fram_restart, fram_ready);
+	resp_printf(resp, "Deframer: restart %u, ready %u\n", defm_restart, defm_ready);
+	resp_printf(resp, "Rates: data %u, ctrl %u, bad %u pps\n", data_pps, ctrl_pps, bad_pps);
+	resp_printf(resp, "Received: good %u, bad %u\n", good, bad);
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Restores the simulated register reset values and clears the counters.
+* 
+*
+* @param [in]	argc   Number of string arguments.
+* @param [in]	argv   Array of strings containg arguments.
+* @param [in,out]	resp   Response to append the reply text to.
+*
+* @return
+*		- 0
+*
+******************************************************************************/
+int sim_reset_func(int argc, char **argv, response_t *resp)
+{
+	/* Flush the register cache, its copies are stale after the reset */
+	IP_API_Set_Backend(IP_API_Get_Backend());
+	SIM_API_Reset();
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Parses the input command string and calls a handler function (if found).
+* 
+*
+* @param [in]	argc   Number of string arguments.
+* @param [in]	argv   Array of strings containg arguments.
+* @param [in,out]	resp   Response to append the reply text to.
+*
+* @return
+*		- 1 if no commands tokens found.
+*		- 2 if no handler found for command.
+*		- 3 if the simulated backend is not in use.
+*		- the return value of the command handler otherwise.
+*
+******************************************************************************/
+int sim_func(int argc, char **argv, response_t *resp)
+{
+	int count = 0;
+	int found = 0;
+	int ret = 0;
+
+	if(argc == 0)
+	{
+		resp_printf(resp, "\t%s", SIM_USAGE_STR);
+		return(1);
+	}
+
+	if(IP_API_Get_Backend() != SIM_API_Backend())
+	{
+		resp_printf(resp, "Simulated framer not in use, start the server with -s\n");
+		return(3);
+	}
+
+	for(count=0; sim_cmds[count].cmd != NULL; count++)
+	{
+		if(strcmp(argv[0], sim_cmds[count].cmd)==0)
+		{
+			found = 1;
+			/* Call the handler function for the command given */
+			ret = sim_cmds[count].func(argc-1, &argv[1], resp);
+		}
+	}
+
+	if(!found)
+	{
+		resp_printf(resp, "Command %s not found, try \"help\"\n", argv[0]);
+		return(2);
+	}
+
+	return ret;
+}
+/** @} */
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/ 
+
+/** 
+* @file sim_str.h
+* @addtogroup command_parser
+* @{
+*
+*  A sample command parser for the RoE Framer software modules.
+*
+******************************************************************************/
+
+/**
+ * SIM_USAGE_STR Help text for the sim module.
+ */
+#define SIM_USAGE_STR "Usage \"sim <options>\", try \"sim help\" for command list\n"
+
+/**
+ * SIM_HELP_STR Help text for the sim module "help" option.
+ */
+#define SIM_HELP_STR "generates this list of commands\n"
+
+/**
+ * SIM_RATE_STR Help text for the sim module "rate" option.
+ */
+#define SIM_RATE_STR "Set simulated deframer packet rates, usage \"sim rate <data_pps> [<ctrl_pps> [<bad_pps>]]\"\n" \
+"\t\t\twith no arguments shows the current rates\n"
+
+/**
+ * SIM_STATUS_STR Help text for the sim module "status" option.
+ */
+#define SIM_STATUS_STR "Show the simulated framer state\n"
+
+/**
+ * SIM_RESET_STR Help text for the sim module "reset" option.
+ */
+#define SIM_RESET_STR "Restore simulated register reset values and clear counters\n"
+/** @} */
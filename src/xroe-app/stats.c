@@ -25,34 +25,48 @@
 #include <sys/stat.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <syslog.h>
 
 #include <xroe_types.h>
 #include <stats_str.h>
-#include <roe_framer_ctrl.h>
+#include <roe_framer_fields.h>
 #include <xroe_api.h>
+#include <comms.h>
+#include <stats_sampler.h>
 
 /**
  * STATS_MAX_COMMANDS Number of commands handled by the stats module.
  */
-#define STATS_MAX_COMMANDS 8
+#define STATS_MAX_COMMANDS 12
+
+/**
+ * STATS_HISTORY_DEFAULT_POINTS Number of samples returned by "stats history".
+ */
+#define STATS_HISTORY_DEFAULT_POINTS 10
+
+/**
+ * STATS_HISTORY_MAX_POINTS Most samples returned by "stats history", all
+ * those kept by the sampler.
+ */
+#define STATS_HISTORY_MAX_POINTS SAMPLER_HISTORY_LENGTH
 
 /**
  * total_packets_struct Totals packets count.
  */
 typedef struct total_packets_struct {
-	unsigned int GoodPacketsCount;
-	unsigned int BadPacketsCount;
-	unsigned int PacketsWithBadFCSCount;
+	uint64_t GoodPacketsCount;
+	uint64_t BadPacketsCount;
+	uint64_t PacketsWithBadFCSCount;
 } total_packets_struct;
 
 /**
  * packets_struct Packet type count.
  */
 typedef struct packets_struct {
-	unsigned int TotalPacketsCount;
-	unsigned int GoodPacketsCount;
-	unsigned int BadPacketsCount;
-	unsigned int PacketsWithBadFCSCount;
+	uint64_t TotalPacketsCount;
+	uint64_t GoodPacketsCount;
+	uint64_t BadPacketsCount;
+	uint64_t PacketsWithBadFCSCount;
 } packets_struct;
 
 /**
@@ -70,21 +84,21 @@ typedef struct stats_struct {
 	unsigned int XXV_Reset;
 } stats_struct;
 
-/**
- * Stats Statistics variable.
- */
-static stats_struct Stats;
 
 /************************** Function Prototypes ******************************/
-int stats_help_func(int argc, char **argv, char *resp);
-int stats_sw_func(int argc, char **argv, char *resp);
-int stats_user_func(int argc, char **argv, char *resp);
-int stats_ctrl_func(int argc, char **argv, char *resp);
-int stats_rate_func(int argc, char **argv, char *resp);
-int stats_all_func(int argc, char **argv, char *resp);
-int stats_all_gui_func(int argc, char **argv, char *resp);
-
-int stats_update_values(void);
+int stats_help_func(int argc, char **argv, response_t *resp);
+int stats_sw_func(int argc, char **argv, response_t *resp);
+int stats_user_func(int argc, char **argv, response_t *resp);
+int stats_ctrl_func(int argc, char **argv, response_t *resp);
+int stats_rate_func(int argc, char **argv, response_t *resp);
+int stats_all_func(int argc, char **argv, response_t *resp);
+int stats_all_gui_func(int argc, char **argv, response_t *resp);
+int stats_history_func(int argc, char **argv, response_t *resp);
+int stats_sampler_func(int argc, char **argv, response_t *resp);
+int stats_totals_func(int argc, char **argv, response_t *resp);
+int stats_reset_func(int argc, char **argv, response_t *resp);
+
+int stats_update_values(int port, stats_struct *pStats);
 
 /**
  * stats_cmds The commands handled by the stats module.
@@ -99,10 +113,74 @@ commands_t stats_cmds[STATS_MAX_COMMANDS] = {
 	{ "rate", STATS_RATE_STR, stats_rate_func },
 	{ "all", STATS_ALL_STR, stats_all_func },
 	{ "gui", STATS_GUI_NUM_STR, stats_all_gui_func },
+	{ "history", STATS_HISTORY_STR, stats_history_func },
+	{ "sampler", STATS_SAMPLER_STR, stats_sampler_func },
+	{ "totals", STATS_TOTALS_STR, stats_totals_func },
+	{ "reset", STATS_RESET_STR, stats_reset_func },
 	/* Keep this last - insert commands above */
 	{ NULL, NULL, NULL }
 };
 
+/*****************************************************************************/
+/**
+*
+* Returns the 64-bit total of a counter kept by the sampler, or the value of
+* a rate register.
+* 
+*
+* @param [in]	port      Ethernet port, SAMPLER_ALL_PORTS for all summed.
+* @param [in]	counter   Sampler counter identifier.
+*
+* @return
+*		- Total of the counter since the start or the last "stats reset".
+*
+******************************************************************************/
+static uint64_t stats_total(int port, sampler_counter_id_t counter)
+{
+	sampler_total_t total;
+
+	if (SAMPLER_API_Total(port, counter, &total) == EINVAL)
+	{
+		return 0;
+	}
+	return total.Total;
+}
+
+/*****************************************************************************/
+/**
+*
+* Parses the optional Ethernet port argument of a command.
+*
+* @param [in]	argc    Number of string arguments.
+* @param [in]	argv    Array of strings containg arguments.
+* @param [out]	pPort   Port given, SAMPLER_ALL_PORTS if none.
+* @param [in,out]	resp    Response to append the error text to.
+*
+* @return
+*		- 0 Success
+*       - 2 Port not present
+*
+******************************************************************************/
+static int stats_port_arg(int argc, char **argv, int *pPort, response_t *resp)
+{
+	char *end;
+
+	*pPort = SAMPLER_ALL_PORTS;
+	if (argc < 1)
+	{
+		return 0;
+	}
+
+	*pPort = (int)strtol(argv[0], &end, 0);
+	if (*end || *pPort < 0 || *pPort >= SAMPLER_API_Num_Ports())
+	{
+		resp_printf(resp, "Port %s not present, %d port(s)\n", argv[0], SAMPLER_API_Num_Ports());
+		return(2);
+	}
+
+	return 0;
+}
+
 /*****************************************************************************/
 /**
 *
@@ -111,15 +189,15 @@ commands_t stats_cmds[STATS_MAX_COMMANDS] = {
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0.
 *
 ******************************************************************************/
-int stats_sw_func(int argc, char **argv, char *resp)
+int stats_sw_func(int argc, char **argv, response_t *resp)
 {
-	sprintf(resp, STATS_SW_STR);
+	resp_printf(resp, STATS_SW_STR);
 	return 0;
 }
 
@@ -131,29 +209,35 @@ int stats_sw_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0.
 *
 ******************************************************************************/
-int stats_user_func(int argc, char **argv, char *resp)
+int stats_user_func(int argc, char **argv, response_t *resp)
 {
+	stats_struct stats;
 	int read = 0;
-	char *str = resp;
+	int port;
+
+	if (stats_port_arg(argc, argv, &port, resp))
+	{
+		return(2);
+	}
 
-	read = stats_update_values();
+	read = stats_update_values(port, &stats);
 	if (!read)
 	{
-		str += sprintf(str, "\nTotal user data packets count: %u\n", Stats.UserPackets.TotalPacketsCount);
-		str += sprintf(str, "Good user data packets: %u\n", Stats.UserPackets.GoodPacketsCount);
-		str += sprintf(str, "Bad user data packets: %u\n", Stats.UserPackets.BadPacketsCount);
-		str += sprintf(str, "User data packets with bad FCS: %u\n", Stats.UserPackets.PacketsWithBadFCSCount);
+		resp_printf(resp, "\nTotal user data packets count: %" PRIu64 "\n", stats.UserPackets.TotalPacketsCount);
+		resp_printf(resp, "Good user data packets: %" PRIu64 "\n", stats.UserPackets.GoodPacketsCount);
+		resp_printf(resp, "Bad user data packets: %" PRIu64 "\n", stats.UserPackets.BadPacketsCount);
+		resp_printf(resp, "User data packets with bad FCS: %" PRIu64 "\n", stats.UserPackets.PacketsWithBadFCSCount);
 	}
 
 	else
 	{
-		str += sprintf(str, "/dev/xroe/stats not opened\n");
+		resp_printf(resp, "/dev/xroe/stats not opened\n");
 	}
 
 	return 0;
@@ -168,29 +252,35 @@ int stats_user_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0.
 *
 ******************************************************************************/
-int stats_ctrl_func(int argc, char **argv, char *resp)
+int stats_ctrl_func(int argc, char **argv, response_t *resp)
 {
+	stats_struct stats;
 	int read = 0;
-	char *str = resp;
+	int port;
+
+	if (stats_port_arg(argc, argv, &port, resp))
+	{
+		return(2);
+	}
 
-	read = stats_update_values();
+	read = stats_update_values(port, &stats);
 	if (!read)
 	{
-		str += sprintf(str, "Total control packets: %u\n", Stats.ControlPackets.TotalPacketsCount);
-		str += sprintf(str, "Good control packets: %u\n", Stats.ControlPackets.GoodPacketsCount);
-		str += sprintf(str, "Bad control packets: %u\n", Stats.ControlPackets.BadPacketsCount);
-		str += sprintf(str, "Control packets with bad FCS: %u\n", Stats.ControlPackets.PacketsWithBadFCSCount);
+		resp_printf(resp, "Total control packets: %" PRIu64 "\n", stats.ControlPackets.TotalPacketsCount);
+		resp_printf(resp, "Good control packets: %" PRIu64 "\n", stats.ControlPackets.GoodPacketsCount);
+		resp_printf(resp, "Bad control packets: %" PRIu64 "\n", stats.ControlPackets.BadPacketsCount);
+		resp_printf(resp, "Control packets with bad FCS: %" PRIu64 "\n", stats.ControlPackets.PacketsWithBadFCSCount);
 	}
 
 	else
 	{
-		str += sprintf(str, "/dev/xroe/stats not opened\n");
+		resp_printf(resp, "/dev/xroe/stats not opened\n");
 	}
 
 	return 0;
@@ -205,27 +295,59 @@ int stats_ctrl_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0.
 *
 ******************************************************************************/
-int stats_rate_func(int argc, char **argv, char *resp)
+int stats_rate_func(int argc, char **argv, response_t *resp)
 {
+	stats_struct stats;
 	int read = 0;
-	char *str = resp;
+	int counter;
+	int i;
+	sampler_rate_t rate;
 
-	read = stats_update_values();
+	if (argc > 0)
+	{
+		counter = SAMPLER_API_Find_Counter(argv[0]);
+		if (counter < 0)
+		{
+			resp_printf(resp, "Counter %s not found\n", argv[0]);
+			return(2);
+		}
+		if (SAMPLER_API_Rate(counter, &rate))
+		{
+			resp_printf(resp, "%s", STATS_NO_SAMPLES_STR);
+			return(3);
+		}
+		resp_printf(resp, "%s: last %.1f ewma %.1f min %.1f max %.1f per second, %d samples\n",
+			argv[0], rate.Last, rate.Ewma, rate.Min, rate.Max, rate.Samples);
+		return 0;
+	}
+
+	read = stats_update_values(SAMPLER_ALL_PORTS, &stats);
 	if (!read)
 	{
-		str += sprintf(str, "Data packets rate: %u\n", Stats.DataPacketsRate);
-		str += sprintf(str, "Control packets rate: %u\n\n", Stats.ControlPacketsRate);
+		resp_printf(resp, "Data packets rate: %u\n", stats.DataPacketsRate);
+		resp_printf(resp, "Control packets rate: %u\n\n", stats.ControlPacketsRate);
 	}
 
 	else
 	{
-		str += sprintf(str, "/dev/xroe/stats not opened\n");
+		resp_printf(resp, "/dev/xroe/stats not opened\n");
+	}
+
+	/* Rates computed by the sampler, per second */
+	if (!SAMPLER_API_Rate(0, &rate))
+	{
+		resp_printf(resp, "%-27s %10s %10s %10s\n", "counter", "ewma", "min", "max");
+		for (i = 0; i < SAMPLER_API_Num_Counters(); i++)
+		{
+			SAMPLER_API_Rate(i, &rate);
+			resp_printf(resp, "%-27s %10.0f %10.0f %10.0f\n", SAMPLER_API_Counter_Name(i), rate.Ewma, rate.Min, rate.Max);
+		}
 	}
 
 	return 0;
@@ -240,44 +362,66 @@ int stats_rate_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0.
 *
 ******************************************************************************/
-int stats_all_func(int argc, char **argv, char *resp)
+int stats_all_func(int argc, char **argv, response_t *resp)
 {
+	stats_struct stats;
 	int read = 0;
-	char *str = resp;
+	int port;
+	int i;
+
+	if (stats_port_arg(argc, argv, &port, resp))
+	{
+		return(2);
+	}
 
-	read = stats_update_values();
+	read = stats_update_values(port, &stats);
 	if (!read)
 	{
-		str += sprintf(str, "Total packets count: %u\n", Stats.TotalPackets.GoodPacketsCount + Stats.TotalPackets.BadPacketsCount);
-		str += sprintf(str, "Good packets: %u\n", Stats.TotalPackets.GoodPacketsCount);
-		str += sprintf(str, "Bad packets: %u\n", Stats.TotalPackets.BadPacketsCount);
-		str += sprintf(str, "Total packets with bad FCS: %u\n", Stats.TotalPackets.PacketsWithBadFCSCount);
+		if (port != SAMPLER_ALL_PORTS)
+		{
+			resp_printf(resp, "Ethernet port %d\n", port);
+		}
+		else if (SAMPLER_API_Num_Ports() > 1)
+		{
+			resp_printf(resp, "All %d Ethernet ports\n", SAMPLER_API_Num_Ports());
+		}
 
-		str += sprintf(str, "\nTotal user data packets count: %u\n", Stats.UserPackets.TotalPacketsCount);
-		str += sprintf(str, "Good user data packets: %u\n", Stats.UserPackets.GoodPacketsCount);
-		str += sprintf(str, "Bad user data packets: %u\n", Stats.UserPackets.BadPacketsCount);
-		str += sprintf(str, "User data packets with bad FCS: %u\n", Stats.UserPackets.PacketsWithBadFCSCount);
+		resp_printf(resp, "Total packets count: %" PRIu64 "\n", stats.TotalPackets.GoodPacketsCount + stats.TotalPackets.BadPacketsCount);
+		resp_printf(resp, "Good packets: %" PRIu64 "\n", stats.TotalPackets.GoodPacketsCount);
+		resp_printf(resp, "Bad packets: %" PRIu64 "\n", stats.TotalPackets.BadPacketsCount);
+		resp_printf(resp, "Total packets with bad FCS: %" PRIu64 "\n", stats.TotalPackets.PacketsWithBadFCSCount);
 
-		str += sprintf(str, "\nTotal control packets: %u\n", Stats.ControlPackets.TotalPacketsCount);
-		str += sprintf(str, "Good control packets: %u\n", Stats.ControlPackets.GoodPacketsCount);
-		str += sprintf(str, "Bad control packets: %u\n", Stats.ControlPackets.BadPacketsCount);
-		str += sprintf(str, "Control packets with bad FCS: %u\n", Stats.ControlPackets.PacketsWithBadFCSCount);
+		resp_printf(resp, "\nTotal user data packets count: %" PRIu64 "\n", stats.UserPackets.TotalPacketsCount);
+		resp_printf(resp, "Good user data packets: %" PRIu64 "\n", stats.UserPackets.GoodPacketsCount);
+		resp_printf(resp, "Bad user data packets: %" PRIu64 "\n", stats.UserPackets.BadPacketsCount);
+		resp_printf(resp, "User data packets with bad FCS: %" PRIu64 "\n", stats.UserPackets.PacketsWithBadFCSCount);
 
-		str += sprintf(str, "\nData packets rate: %u\n", Stats.DataPacketsRate);
-		str += sprintf(str, "Control packets rate: %u\n\n", Stats.ControlPacketsRate);
+		resp_printf(resp, "\nTotal control packets: %" PRIu64 "\n", stats.ControlPackets.TotalPacketsCount);
+		resp_printf(resp, "Good control packets: %" PRIu64 "\n", stats.ControlPackets.GoodPacketsCount);
+		resp_printf(resp, "Bad control packets: %" PRIu64 "\n", stats.ControlPackets.BadPacketsCount);
+		resp_printf(resp, "Control packets with bad FCS: %" PRIu64 "\n", stats.ControlPackets.PacketsWithBadFCSCount);
 
+		resp_printf(resp, "\nData packets rate: %u\n", stats.DataPacketsRate);
+		resp_printf(resp, "Control packets rate: %u\n\n", stats.ControlPacketsRate);
 
+		/* Per port summary, "stats all <port>" has the details */
+		for (i = 0; (port == SAMPLER_ALL_PORTS) && (SAMPLER_API_Num_Ports() > 1) && (i < SAMPLER_API_Num_Ports()); i++)
+		{
+			resp_printf(resp, "Port %d: good %" PRIu64 ", bad %" PRIu64 ", bad FCS %" PRIu64 ", data rate %u, control rate %u\n", i,
+				stats_total(i, SAMPLER_TOTAL_RX_GOOD_PKT), stats_total(i, SAMPLER_TOTAL_RX_BAD_PKT), stats_total(i, SAMPLER_TOTAL_RX_BAD_FCS),
+				(unsigned int)stats_total(i, SAMPLER_RX_USER_PKT_RATE), (unsigned int)stats_total(i, SAMPLER_RX_USER_CTRL_PKT_RATE));
+		}
 	}
 
 	else
 	{
-		str += sprintf(str, "/dev/xroe/stats not opened\n");
+		resp_printf(resp, "/dev/xroe/stats not opened\n");
 	}
 
 	return 0;
@@ -292,43 +436,57 @@ int stats_all_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0.
 *
 ******************************************************************************/
-int stats_all_gui_func(int argc, char **argv, char *resp)
+int stats_all_gui_func(int argc, char **argv, response_t *resp)
 {
+	stats_struct stats;
 	int read = 0;
-	char *str = resp;
+	int port;
 
-	read = stats_update_values();
+	if (stats_port_arg(argc, argv, &port, resp))
+	{
+		return(2);
+	}
+
+	read = stats_update_values(port, &stats);
 	if (!read)
 	{
-		str += sprintf(str, "{\"DataPacketsRate\": %u, \"UserPackets\": {\"PacketsWithBadFCSCount\": %u, \"BadPacketsCount\": %u, \"TotalPacketsCount\": %u, \"GoodPacketsCount\": %u}, \"ControlPacketsRate\": %u, \"FramerRestartCount\": %u, \"FramerEnable\": %u, \"DeFramerEnable\": %u, \"XXV_Reset\": %u, \"ControlPackets\": {\"PacketsWithBadFCSCount\": %u, \"BadPacketsCount\": %u, \"TotalPacketsCount\": %u, \"GoodPacketsCount\": %u}, \"TotalPackets\": {\"PacketsWithBadFCSCount\": %u, \"BadPacketsCount\": %u, \"GoodPacketsCount\": %u}}\n"
-			, Stats.DataPacketsRate,
-			Stats.UserPackets.PacketsWithBadFCSCount,
-			Stats.UserPackets.BadPacketsCount,
-			Stats.UserPackets.TotalPacketsCount,
-			Stats.UserPackets.GoodPacketsCount,
-			Stats.ControlPacketsRate,
-			Stats.FramerRestartCount,
-			Stats.FramerEnable,
-			Stats.DeFramerEnable,
-			Stats.XXV_Reset,
-			Stats.ControlPackets.PacketsWithBadFCSCount,
-			Stats.ControlPackets.BadPacketsCount,
-			Stats.ControlPackets.TotalPacketsCount,
-			Stats.ControlPackets.GoodPacketsCount,
-			Stats.TotalPackets.PacketsWithBadFCSCount,
-			Stats.TotalPackets.BadPacketsCount,
-			Stats.TotalPackets.GoodPacketsCount);
+		if (port != SAMPLER_ALL_PORTS)
+		{
+			resp_printf(resp, "{\"Port\": %d, ", port);
+		}
+		else
+		{
+			resp_printf(resp, "{");
+		}
+		resp_printf(resp, "\"NumPorts\": %d, \"DataPacketsRate\": %u, \"UserPackets\": {\"PacketsWithBadFCSCount\": %" PRIu64 ", \"BadPacketsCount\": %" PRIu64 ", \"TotalPacketsCount\": %" PRIu64 ", \"GoodPacketsCount\": %" PRIu64 "}, \"ControlPacketsRate\": %u, \"FramerRestartCount\": %u, \"FramerEnable\": %u, \"DeFramerEnable\": %u, \"XXV_Reset\": %u, \"ControlPackets\": {\"PacketsWithBadFCSCount\": %" PRIu64 ", \"BadPacketsCount\": %" PRIu64 ", \"TotalPacketsCount\": %" PRIu64 ", \"GoodPacketsCount\": %" PRIu64 "}, \"TotalPackets\": {\"PacketsWithBadFCSCount\": %" PRIu64 ", \"BadPacketsCount\": %" PRIu64 ", \"GoodPacketsCount\": %" PRIu64 "}}\n"
+			, SAMPLER_API_Num_Ports(), stats.DataPacketsRate,
+			stats.UserPackets.PacketsWithBadFCSCount,
+			stats.UserPackets.BadPacketsCount,
+			stats.UserPackets.TotalPacketsCount,
+			stats.UserPackets.GoodPacketsCount,
+			stats.ControlPacketsRate,
+			stats.FramerRestartCount,
+			stats.FramerEnable,
+			stats.DeFramerEnable,
+			stats.XXV_Reset,
+			stats.ControlPackets.PacketsWithBadFCSCount,
+			stats.ControlPackets.BadPacketsCount,
+			stats.ControlPackets.TotalPacketsCount,
+			stats.ControlPackets.GoodPacketsCount,
+			stats.TotalPackets.PacketsWithBadFCSCount,
+			stats.TotalPackets.BadPacketsCount,
+			stats.TotalPackets.GoodPacketsCount);
 	}
 
 	else
 	{
-		str += sprintf(str, "/dev/xroe/stats not opened\n");
+		resp_printf(resp, "/dev/xroe/stats not opened\n");
 	}
 
 
@@ -345,22 +503,21 @@ int stats_all_gui_func(int argc, char **argv, char *resp)
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
 *		- 0
 *
 ******************************************************************************/
-int stats_help_func(int argc, char **argv, char *resp)
+int stats_help_func(int argc, char **argv, response_t *resp)
 {
 	int i;
-	char *str = resp;
 
-	str += sprintf(str, "stats help:\n");
+	resp_printf(resp, "stats help:\n");
 
 	for (i = 0; stats_cmds[i].cmd != NULL; i++)
 	{
-		str += sprintf(str, "\t%s\t : %s", stats_cmds[i].cmd, stats_cmds[i].helptxt);
+		resp_printf(resp, "\t%s\t : %s", stats_cmds[i].cmd, stats_cmds[i].helptxt);
 	}
 	return 0;
 }
@@ -369,154 +526,331 @@ int stats_help_func(int argc, char **argv, char *resp)
 /*****************************************************************************/
 /**
 *
-* Parses the input command string and calls a handler function (if found).
+* Returns the most recent samples of a counter taken by the sampler.
 * 
 *
 * @param [in]	argc   Number of string arguments.
 * @param [in]	argv   Array of strings containg arguments.
-* @param [out]	resp   Pointer to string to place response text in.
+* @param [in,out]	resp   Response to append the reply text to.
 *
 * @return
-*		- 1 if no commands tokens found.
-*		- 2 if no handler found for command.
-*		- 0 otherwise.
+*		- 0 Success
+*       - 2 Counter not found
+*       - 3 No samples taken
 *
 ******************************************************************************/
-int stats_func(int argc, char **argv, char *resp)
+int stats_history_func(int argc, char **argv, response_t *resp)
 {
-	int count = 0;
-	int found = 0;
-	char *str = resp;
+	sampler_point_t points[STATS_HISTORY_MAX_POINTS];
+	const char *name = SAMPLER_API_Counter_Name(0);
+	int num_points = STATS_HISTORY_DEFAULT_POINTS;
+	int counter = 0;
+	int i;
 
-	if (argc == 0)
+	if (argc > 0)
 	{
-		sprintf(str, "\t%s", STATS_USAGE_STR);
-		return(1);
+		name = argv[0];
+		counter = SAMPLER_API_Find_Counter(name);
+		if (counter < 0)
+		{
+			resp_printf(resp, "Counter %s not found\n", name);
+			return(2);
+		}
 	}
-
-	for (count = 0; stats_cmds[count].cmd != NULL; count++)
+	if (argc > 1)
 	{
-		if (strcmp(argv[0], stats_cmds[count].cmd) == 0)
+		num_points = (int)strtol(argv[1], NULL, 0);
+		if (num_points < 1 || num_points > STATS_HISTORY_MAX_POINTS)
 		{
-			found = 1;
-			/* Call the handler function for the command given */
-			stats_cmds[count].func(argc - 1, &argv[1], resp);
+			num_points = STATS_HISTORY_MAX_POINTS;
 		}
 	}
 
-	if (!found)
+	num_points = SAMPLER_API_History(counter, points, num_points);
+	if (num_points <= 0)
 	{
-		str += sprintf(str, "Command %s not found, try \"help\"\n", argv[0]);
-		return(2);
+		resp_printf(resp, "%s", STATS_NO_SAMPLES_STR);
+		return(3);
+	}
+
+	resp_printf(resp, "%s, every %d ms: time value delta rate\n", name, SAMPLER_API_Period());
+	for (i = 0; i < num_points; i++)
+	{
+		resp_printf(resp, "%llu.%03llu %u %u %.0f\n",
+			(unsigned long long)(points[i].TimestampMs / 1000), (unsigned long long)(points[i].TimestampMs % 1000),
+			points[i].Value, points[i].Delta, points[i].Rate);
 	}
 
 	return 0;
 }
 
-
 /*****************************************************************************/
 /**
 *
-* Updates the internal status variables.
+* Shows, starts or stops the background statistics sampler.
 * 
 *
+* @param [in]	argc   Number of string arguments.
+* @param [in]	argv   Array of strings containg arguments.
+* @param [in,out]	resp   Response to append the reply text to.
+*
 * @return
-*		- Return value of STATS_SYSFS_API_Read() on error.
-*		- Return value of IP_API_Read_Register() on error.
-*		- Return value of IP_API_Read_Register() otherwise.
+*		- 0 Success
+*       - 1 Invalid period
 *
 ******************************************************************************/
-int stats_update_values(void)
+int stats_sampler_func(int argc, char **argv, response_t *resp)
 {
-	int ret = -1;
-	char buff[256];
+	int period = 0;
 
-	ret = STATS_SYSFS_API_Read("total_rx_good_pkt", buff);
-	Stats.TotalPackets.GoodPacketsCount = strtoul(buff, NULL, 0);
-	if (!ret)
-	{
-		ret = STATS_SYSFS_API_Read("total_rx_bad_pkt", buff);
-		Stats.TotalPackets.BadPacketsCount = strtoul(buff, NULL, 0);
-	}
-	if (!ret)
+	if (argc > 0)
 	{
-		ret = STATS_SYSFS_API_Read("total_rx_bad_fcs", buff);
-		Stats.TotalPackets.PacketsWithBadFCSCount = strtoul(buff, NULL, 0);
+		period = (strcmp(argv[0], "off") == 0) ? 0 : (int)strtol(argv[0], NULL, 0);
+		if (SAMPLER_API_Start(period))
+		{
+			resp_printf(resp, "\t%s", STATS_SAMPLER_STR);
+			return(1);
+		}
 	}
 
-	if (!ret)
+	period = SAMPLER_API_Period();
+	if (period)
 	{
-		ret = STATS_SYSFS_API_Read("total_rx_user_pkt", buff);
-		Stats.UserPackets.TotalPacketsCount = strtoul(buff, NULL, 0);
+		resp_printf(resp, "sampler: every %d ms\n", period);
 	}
-	if (!ret)
+	else
 	{
-		ret = STATS_SYSFS_API_Read("total_rx_good_user_pkt", buff);
-		Stats.UserPackets.GoodPacketsCount = strtoul(buff, NULL, 0);
+		resp_printf(resp, "sampler: off, counter wraps checked every %d ms\n", SAMPLER_WRAP_CHECK_MS);
 	}
-	if (!ret)
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the 64-bit totals of the packet counters of a port or of all ports,
+* with the number of hardware counter wraps and the time of the last one.
+* 
+*
+* @param [in]	argc   Number of string arguments.
+* @param [in]	argv   Array of strings containg arguments.
+* @param [in,out]	resp   Response to append the reply text to.
+*
+* @return
+*		- 0 Success
+*       - 3 Counters not readable
+*
+******************************************************************************/
+int stats_totals_func(int argc, char **argv, response_t *resp)
+{
+	sampler_total_t total;
+	uint64_t since;
+	int port;
+	int i;
+
+	if (SAMPLER_API_Refresh())
 	{
-		ret = STATS_SYSFS_API_Read("total_rx_bad_user_pkt", buff);
-		Stats.UserPackets.BadPacketsCount = strtoul(buff, NULL, 0);
+		resp_printf(resp, "/dev/xroe/stats not opened\n");
+		return(3);
 	}
-	if (!ret)
+
+	if (stats_port_arg(argc, argv, &port, resp))
 	{
-		ret = STATS_SYSFS_API_Read("total_rx_bad_user_fcs", buff);
-		Stats.UserPackets.PacketsWithBadFCSCount = strtoul(buff, NULL, 0);
+		return(2);
 	}
 
-	if (!ret)
+	since = SAMPLER_API_Reset_Time();
+	if (port == SAMPLER_ALL_PORTS)
 	{
-		ret = STATS_SYSFS_API_Read("total_rx_user_ctrl_pkt", buff);
-		Stats.ControlPackets.TotalPacketsCount = strtoul(buff, NULL, 0);
+		resp_printf(resp, "%d port(s), ", SAMPLER_API_Num_Ports());
 	}
-	if (!ret)
+	else
 	{
-		ret = STATS_SYSFS_API_Read("total_rx_good_user_ctrl_pkt", buff);
-		Stats.ControlPackets.GoodPacketsCount = strtoul(buff, NULL, 0);
+		resp_printf(resp, "port %d, ", port);
 	}
-	if (!ret)
+	resp_printf(resp, "since %llu.%03llu: counter total wraps last_wrap\n",
+		(unsigned long long)(since / 1000), (unsigned long long)(since % 1000));
+	for (i = 0; i < SAMPLER_API_Num_Counters(); i++)
 	{
-		ret = STATS_SYSFS_API_Read("total_rx_bad_user_ctrl_pkt", buff);
-		Stats.ControlPackets.BadPacketsCount = strtoul(buff, NULL, 0);
+		SAMPLER_API_Total(port, i, &total);
+		resp_printf(resp, "%-27s %20" PRIu64 " %5u ", SAMPLER_API_Counter_Name(i), total.Total, total.Wraps);
+		if (total.LastWrapMs)
+		{
+			resp_printf(resp, "%llu.%03llu\n",
+				(unsigned long long)(total.LastWrapMs / 1000), (unsigned long long)(total.LastWrapMs % 1000));
+		}
+		else
+		{
+			resp_printf(resp, "never\n");
+		}
 	}
-	if (!ret)
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Restarts the 64-bit packet counter totals from zero.
+* 
+*
+* @param [in]	argc   Number of string arguments.
+* @param [in]	argv   Array of strings containg arguments.
+* @param [in,out]	resp   Response to append the reply text to.
+*
+* @return
+*		- 0 Success
+*       - 3 Counters not readable
+*
+******************************************************************************/
+int stats_reset_func(int argc, char **argv, response_t *resp)
+{
+
+	if (SAMPLER_API_Reset_Totals())
 	{
-		ret = STATS_SYSFS_API_Read("total_rx_bad_user_ctrl_fcs", buff);
-		Stats.ControlPackets.PacketsWithBadFCSCount = strtoul(buff, NULL, 0);
+		resp_printf(resp, "/dev/xroe/stats not opened\n");
+		return(3);
 	}
-	if (!ret)
+
+	resp_printf(resp, "Totals reset\n");
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Parses the input command string and calls a handler function (if found).
+* 
+*
+* @param [in]	argc   Number of string arguments.
+* @param [in]	argv   Array of strings containg arguments.
+* @param [in,out]	resp   Response to append the reply text to.
+*
+* @return
+*		- 1 if no commands tokens found.
+*		- 2 if no handler found for command.
+*		- the return value of the command handler otherwise.
+*
+******************************************************************************/
+int stats_func(int argc, char **argv, response_t *resp)
+{
+	int count = 0;
+	int found = 0;
+	int ret = 0;
+
+	if (argc == 0)
 	{
-		ret = STATS_SYSFS_API_Read("rx_user_pkt_rate", buff);
-		Stats.DataPacketsRate = strtoul(buff, NULL, 0);
+		resp_printf(resp, "\t%s", STATS_USAGE_STR);
+		return(1);
 	}
-	if (!ret)
+
+	for (count = 0; stats_cmds[count].cmd != NULL; count++)
 	{
-		ret = STATS_SYSFS_API_Read("rx_user_ctrl_pkt_rate", buff);
-		Stats.ControlPacketsRate = strtoul(buff, NULL, 0);
+		if (strcmp(argv[0], stats_cmds[count].cmd) == 0)
+		{
+			found = 1;
+			/* Call the handler function for the command given */
+			ret = stats_cmds[count].func(argc - 1, &argv[1], resp);
+		}
 	}
 
-
-	if (!ret)
+	if (!found)
 	{
-		ret = IP_API_Read_Register(FRAM_AUTO_RESTART_CNT_ADDR, &Stats.FramerRestartCount, FRAM_AUTO_RESTART_CNT_MASK, FRAM_AUTO_RESTART_CNT_OFFSET);
+		resp_printf(resp, "Command %s not found, try \"help\"\n", argv[0]);
+		return(2);
 	}
 
-	if (!ret)
+	return ret;
+}
+
+
+/*****************************************************************************/
+/**
+*
+* Updates the framer state variables in one register transaction.
+* 
+*
+* @param [out]	pStats   Pointer to the statistics to update.
+*
+* @return
+*		- Return value of IP_API_Batch().
+*
+******************************************************************************/
+static int stats_update_registers(stats_struct *pStats)
+{
+	xroe_reg_op_t ops[4];
+	unsigned int *values[4] = {&pStats->FramerEnable, &pStats->DeFramerEnable, &pStats->XXV_Reset, &pStats->FramerRestartCount};
+	int num_ops = 3;
+	int ret = 0;
+	int i;
+
+	xroe_op_fram_restart(0, &ops[0]);
+	xroe_op_defm_restart(0, &ops[1]);
+	xroe_op_cfg_user_rw_out(0, &ops[2]);
+
+	/* Not counted by all IP versions, reported as 0 */
+	pStats->FramerRestartCount = 0;
+	if (!xroe_op_fram_auto_restart_cnt(0, &ops[3]))
 	{
-		ret = IP_API_Read_Register(FRAM_RESTART_ADDR, &Stats.FramerEnable, FRAM_RESTART_MASK, FRAM_RESTART_OFFSET);
+		num_ops++;
 	}
 
+	ret = IP_API_Batch(ops, num_ops);
 	if (!ret)
 	{
-		ret = IP_API_Read_Register(DEFM_RESTART_ADDR, &Stats.DeFramerEnable, DEFM_RESTART_MASK, DEFM_RESTART_OFFSET);
+		for (i = 0; i < num_ops; i++)
+		{
+			*values[i] = ops[i].value;
+		}
 	}
 
-	if (!ret)
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the statistics of a port.
+* The packet counters are the sampler's 64-bit totals, refreshed from the
+* hardware first.
+* 
+*
+* @param [in]	port   Ethernet port, SAMPLER_ALL_PORTS for all summed.
+* @param [out]	pStats Pointer to the statistics to update.
+*
+* @return
+*		- Return value of SAMPLER_API_Refresh() on error.
+*		- Return value of IP_API_Batch() otherwise.
+*
+******************************************************************************/
+int stats_update_values(int port, stats_struct *pStats)
+{
+	int ret = -1;
+
+	ret = SAMPLER_API_Refresh();
+	if (ret)
 	{
-		ret = IP_API_Read_Register(CFG_USER_RW_OUT_ADDR, &Stats.XXV_Reset, CFG_USER_RW_OUT_MASK, CFG_USER_RW_OUT_OFFSET);
+		return ret;
 	}
 
-	return ret;
+	pStats->TotalPackets.GoodPacketsCount = stats_total(port, SAMPLER_TOTAL_RX_GOOD_PKT);
+	pStats->TotalPackets.BadPacketsCount = stats_total(port, SAMPLER_TOTAL_RX_BAD_PKT);
+	pStats->TotalPackets.PacketsWithBadFCSCount = stats_total(port, SAMPLER_TOTAL_RX_BAD_FCS);
+
+	pStats->UserPackets.TotalPacketsCount = stats_total(port, SAMPLER_TOTAL_RX_USER_PKT);
+	pStats->UserPackets.GoodPacketsCount = stats_total(port, SAMPLER_TOTAL_RX_GOOD_USER_PKT);
+	pStats->UserPackets.BadPacketsCount = stats_total(port, SAMPLER_TOTAL_RX_BAD_USER_PKT);
+	pStats->UserPackets.PacketsWithBadFCSCount = stats_total(port, SAMPLER_TOTAL_RX_BAD_USER_FCS);
+
+	pStats->ControlPackets.TotalPacketsCount = stats_total(port, SAMPLER_TOTAL_RX_USER_CTRL_PKT);
+	pStats->ControlPackets.GoodPacketsCount = stats_total(port, SAMPLER_TOTAL_RX_GOOD_USER_CTRL_PKT);
+	pStats->ControlPackets.BadPacketsCount = stats_total(port, SAMPLER_TOTAL_RX_BAD_USER_CTRL_PKT);
+	pStats->ControlPackets.PacketsWithBadFCSCount = stats_total(port, SAMPLER_TOTAL_RX_BAD_USER_CTRL_FCS);
+
+	pStats->DataPacketsRate = stats_total(port, SAMPLER_RX_USER_PKT_RATE);
+	pStats->ControlPacketsRate = stats_total(port, SAMPLER_RX_USER_CTRL_PKT_RATE);
+
+	return stats_update_registers(pStats);
 }
-/** @} */
\ No newline at end of file
+/** @} */
@@ -0,0 +1,975 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file stats_sampler.c
+* @addtogroup framer_driver_api
+* @{
+*
+*  Background sampler of the Radio over Ethernet Framer statistics
+*
+*  SAMPLER_API_Timeout() and SAMPLER_API_Poll() are called from the main
+*  loop, in the same way as the register cache. Each sample holds every
+*  statistics counter, read from the driver's statistics snapshot (or the
+*  individual sysfs entries with older drivers) and the framer restart count.
+*  Every read of the counters, sampled or not, also updates the 64-bit totals.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+#define _GNU_SOURCE /* PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <syslog.h>
+
+#include <roe_framer_fields.h>
+#include <xroe_api.h>
+#include <stats_sampler.h>
+
+/* Weight of a new rate in the rates' exponentially weighted moving average */
+#define SAMPLER_EWMA_WEIGHT 0.125
+
+#define SAMPLER_NS_PER_SEC 1000000000ULL
+#define SAMPLER_NS_PER_MS 1000000ULL
+
+/**
+ * sampler_counter_struct A counter taken in every sample.
+ */
+typedef struct sampler_counter_struct{
+	const char *name; /**< Name, also the name of the stats sysfs entry */
+	int word;         /**< Index in the stats snapshot words */
+	int gauge;        /**< Set for registers holding a rate, not a count */
+} sampler_counter_struct;
+
+/* Table entry for a counter of SAMPLER_COUNTERS */
+#define SAMPLER_COUNTER_ENTRY(_id, _name, _word, _gauge) \
+	[SAMPLER_##_id] = {#_name, _word, _gauge},
+
+/**
+ * SamplerCounters The counters taken in every sample.
+ */
+static const sampler_counter_struct SamplerCounters[SAMPLER_NUM_COUNTERS] = {
+	SAMPLER_COUNTERS(SAMPLER_COUNTER_ENTRY)
+};
+
+/* Stats sysfs entry of a counter of SAMPLER_COUNTERS, NULL if it has none */
+#define SAMPLER_SYSFS_ENTRY(_id, _name, _word, _gauge) \
+	[SAMPLER_##_id] = ((_word) == SAMPLER_WORD_RESTART_CNT) ? NULL : #_name,
+
+/**
+ * SamplerSysfsNames The stats sysfs entries read without a stats snapshot.
+ */
+static const char * const SamplerSysfsNames[SAMPLER_NUM_COUNTERS] = {
+	SAMPLER_COUNTERS(SAMPLER_SYSFS_ENTRY)
+};
+
+/**
+ * sampler_sample_struct One entry of the ring buffer.
+ */
+typedef struct sampler_sample_struct{
+	uint64_t MonotonicNs; /**< Used for the rates */
+	uint64_t RealtimeMs;  /**< Reported to clients */
+	uint32_t Values[SAMPLER_NUM_COUNTERS];
+} sampler_sample_struct;
+
+/**
+ * sampler_struct State of the sampler.
+ */
+typedef struct sampler_struct{
+	int PeriodMs;   /**< 0 when stopped */
+	uint64_t NextNs;
+	int NoSnapshot; /**< Set when the driver has no statistics snapshot */
+	int Head;       /**< Slot of the next sample */
+	int Count;      /**< Number of valid samples */
+	sampler_sample_struct Samples[SAMPLER_HISTORY_LENGTH];
+	sampler_rate_t Rates[SAMPLER_NUM_COUNTERS];
+} sampler_struct;
+
+/**
+ * Sampler Sampler state and ring buffer.
+ */
+static sampler_struct Sampler;
+
+/**
+ * sampler_totals_struct 64-bit extension of the hardware counters, kept when
+ * the sampler is restarted.
+ */
+typedef struct sampler_totals_struct{
+	int Valid;           /**< Set once the counters were read */
+	int NumPorts;        /**< Ethernet ports counted, found on the first read */
+	uint64_t NextNs;     /**< Next wrap check while the sampler is stopped */
+	uint64_t ResetMs;    /**< Wall clock time of the start or last reset */
+	sampler_total_t Counters[XROE_STATS_SNAPSHOT_MAX_PORTS][SAMPLER_NUM_COUNTERS];
+} sampler_totals_struct;
+
+/**
+ * SamplerTotals 64-bit counter totals.
+ */
+static sampler_totals_struct SamplerTotals;
+
+/**
+ * SamplerLock Serialises the sampler between the main loop and the command
+ * threads. Recursive, as the API functions call each other.
+ */
+static pthread_mutex_t SamplerLock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+/*****************************************************************************/
+/**
+*
+* Returns the time of a clock in nanoseconds.
+*
+* @param [in]	clock   Clock to read.
+*
+* @return
+*		- Clock time in nanoseconds
+*
+******************************************************************************/
+static uint64_t sampler_clock_ns(clockid_t clock)
+{
+	struct timespec now;
+
+	clock_gettime(clock, &now);
+	return (uint64_t)now.tv_sec * SAMPLER_NS_PER_SEC + now.tv_nsec;
+}
+
+/*****************************************************************************/
+/**
+*
+* Adds the change of every counter since the previous read to its 64-bit
+* total. A counter lower than at the previous read has wrapped once, which
+* holds as long as the counters are read more often than they can wrap.
+* Gauges are copied.
+*
+* @param [in]	values   SAMPLER_NUM_COUNTERS values just read, per port.
+*
+******************************************************************************/
+static void sampler_extend(uint32_t values[][SAMPLER_NUM_COUNTERS])
+{
+	sampler_total_t *total;
+	uint64_t now_ms = sampler_clock_ns(CLOCK_REALTIME) / SAMPLER_NS_PER_MS;
+	int port;
+	int i;
+
+	for(port = 0; port < SamplerTotals.NumPorts; port++)
+	{
+		for(i = 0; i < SAMPLER_NUM_COUNTERS; i++)
+		{
+			total = &SamplerTotals.Counters[port][i];
+			if(!SamplerTotals.Valid || SamplerCounters[i].gauge)
+			{
+				/* Counts before the first read are taken as they are */
+				total->Total = values[port][i];
+			}
+			else
+			{
+				if(values[port][i] < total->Value)
+				{
+					total->Wraps++;
+					total->LastWrapMs = now_ms;
+				}
+				total->Total += (uint32_t)(values[port][i] - total->Value);
+			}
+			total->Value = values[port][i];
+		}
+	}
+
+	if(!SamplerTotals.Valid)
+	{
+		SamplerTotals.ResetMs = now_ms;
+		SamplerTotals.Valid = 1;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the number of Ethernet ports of the framer.
+*
+* @return
+*		- CFG_CONFIG_NO_OF_ETH_PORTS, between 1 and
+*		  XROE_STATS_SNAPSHOT_MAX_PORTS
+*
+******************************************************************************/
+static int sampler_num_ports(void)
+{
+	uint32_t num_ports = 0;
+
+	if(xroe_get_cfg_no_of_eth_ports(0, &num_ports) || (num_ports < 1))
+	{
+		return 1;
+	}
+
+	return (num_ports < XROE_STATS_SNAPSHOT_MAX_PORTS) ? num_ports : XROE_STATS_SNAPSHOT_MAX_PORTS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads all counters of every Ethernet port and updates their 64-bit totals.
+* The framer restart count is not per port, and is taken as port 0's.
+*
+* @param [out]	values   SAMPLER_NUM_COUNTERS values to fill in, per port.
+*
+* @return
+*		- 0 on success
+*		- Return value of STATS_SYSFS_API_Read_Counters() or of the register
+*		  read on error
+*
+******************************************************************************/
+static int sampler_read(uint32_t values[][SAMPLER_NUM_COUNTERS])
+{
+	xroe_stats_snapshot_t snapshot;
+	int ret = 0;
+	int port;
+	int i;
+
+	if(!SamplerTotals.Valid)
+	{
+		SamplerTotals.NumPorts = sampler_num_ports();
+	}
+
+	if(!Sampler.NoSnapshot)
+	{
+		ret = STATS_API_Read_Snapshot(&snapshot);
+		if((ret == ENOENT) || (ret == EPROTO))
+		{
+			/* Older driver, do not try again */
+			syslog(LOG_NOTICE, "%s:%d No stats snapshot (%d), sampling sysfs entries\n", __FILE__, __LINE__, ret);
+			Sampler.NoSnapshot = 1;
+			ret = 0;
+		}
+		else if(!ret && (snapshot.num_ports < SamplerTotals.NumPorts))
+		{
+			/* Driver built for fewer ports than the IP has */
+			syslog(LOG_NOTICE, "%s:%d Stats snapshot of %u ports, IP has %d\n", __FILE__, __LINE__, snapshot.num_ports, SamplerTotals.NumPorts);
+			SamplerTotals.NumPorts = snapshot.num_ports ? snapshot.num_ports : 1;
+		}
+	}
+
+	memset(values, 0, SamplerTotals.NumPorts * sizeof(values[0]));
+	for(port = 0; port < SamplerTotals.NumPorts && !ret; port++)
+	{
+		if(Sampler.NoSnapshot)
+		{
+			/* All entries of the port at once, see IP_API_Use_Uring() */
+			ret = STATS_SYSFS_API_Read_Counters(port, SamplerSysfsNames, SAMPLER_NUM_COUNTERS, values[port]);
+		}
+		for(i = 0; i < SAMPLER_NUM_COUNTERS && !ret; i++)
+		{
+			if(SamplerCounters[i].word == SAMPLER_WORD_RESTART_CNT)
+			{
+				ret = port ? 0 : xroe_get_fram_auto_restart_cnt(0, &values[port][i]);
+				if(ret == ENODEV)
+				{
+					/* Not counted by all IP versions */
+					ret = 0;
+				}
+			}
+			else if(!Sampler.NoSnapshot)
+			{
+				values[port][i] = snapshot.words[port][SamplerCounters[i].word];
+			}
+		}
+	}
+
+	if(!ret)
+	{
+		sampler_extend(values);
+	}
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the rate of a counter between two samples.
+*
+* @param [in]	counter   Index of the counter.
+* @param [in]	prev      Earlier sample.
+* @param [in]	cur       Later sample.
+*
+* @return
+*		- Change per second, or the value of a gauge in cur
+*
+******************************************************************************/
+static double sampler_rate(int counter, const sampler_sample_struct *prev, const sampler_sample_struct *cur)
+{
+	/* Unsigned 32-bit difference, right across a single counter wrap */
+	uint32_t delta = cur->Values[counter] - prev->Values[counter];
+	uint64_t ns = cur->MonotonicNs - prev->MonotonicNs;
+
+	if(SamplerCounters[counter].gauge)
+	{
+		return cur->Values[counter];
+	}
+
+	return ns ? ((double)delta * SAMPLER_NS_PER_SEC) / ns : 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Starts sampling, with SamplerLock held. See SAMPLER_API_Start().
+*
+******************************************************************************/
+static int sampler_api_start(int period_ms)
+{
+	if(period_ms == 0)
+	{
+		SAMPLER_API_Stop();
+		return 0;
+	}
+
+	if(period_ms < SAMPLER_MIN_PERIOD_MS)
+	{
+		return EINVAL;
+	}
+
+	memset(&Sampler, 0, sizeof(Sampler));
+	Sampler.PeriodMs = period_ms;
+	Sampler.NextNs = sampler_clock_ns(CLOCK_MONOTONIC);
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Starts sampling, or changes the sampling period. The ring buffer and the
+* rate summaries are cleared.
+*
+* @param [in]	period_ms   Sampling period, 0 stops the sampler.
+*
+* @return
+*		- 0 on success
+*		- EINVAL if the period is below SAMPLER_MIN_PERIOD_MS
+*
+******************************************************************************/
+int SAMPLER_API_Start(int period_ms)
+{
+	int ret;
+
+	pthread_mutex_lock(&SamplerLock);
+	ret = sampler_api_start(period_ms);
+	pthread_mutex_unlock(&SamplerLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Stops sampling, with SamplerLock held. See SAMPLER_API_Stop().
+*
+******************************************************************************/
+static void sampler_api_stop(void)
+{
+	Sampler.PeriodMs = 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Stops sampling. The samples taken so far can still be queried.
+*
+******************************************************************************/
+void SAMPLER_API_Stop(void)
+{
+	pthread_mutex_lock(&SamplerLock);
+	sampler_api_stop();
+	pthread_mutex_unlock(&SamplerLock);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the sampling period, with SamplerLock held. See SAMPLER_API_Period().
+*
+******************************************************************************/
+static int sampler_api_period(void)
+{
+	return Sampler.PeriodMs;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the sampling period.
+*
+* @return
+*		- Sampling period in milliseconds, 0 when stopped
+*
+******************************************************************************/
+int SAMPLER_API_Period(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&SamplerLock);
+	ret = sampler_api_period();
+	pthread_mutex_unlock(&SamplerLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the time until the next sample, with SamplerLock held. See SAMPLER_API_Timeout().
+*
+******************************************************************************/
+static int sampler_api_timeout(void)
+{
+	uint64_t now;
+	uint64_t next = Sampler.PeriodMs ? Sampler.NextNs : SamplerTotals.NextNs;
+
+	now = sampler_clock_ns(CLOCK_MONOTONIC);
+	if(now >= next)
+	{
+		return 0;
+	}
+
+	return (next - now + SAMPLER_NS_PER_MS - 1) / SAMPLER_NS_PER_MS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns how long the main loop may wait before SAMPLER_API_Poll() is due.
+*
+* @return
+*		- Milliseconds until the next sample, or the next wrap check if the
+*		  sampler is stopped
+*
+******************************************************************************/
+int SAMPLER_API_Timeout(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&SamplerLock);
+	ret = sampler_api_timeout();
+	pthread_mutex_unlock(&SamplerLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes a sample if one is due, with SamplerLock held. See SAMPLER_API_Poll().
+*
+******************************************************************************/
+static int sampler_api_poll(void)
+{
+	uint32_t values[XROE_STATS_SNAPSHOT_MAX_PORTS][SAMPLER_NUM_COUNTERS];
+	sampler_sample_struct *cur;
+	sampler_sample_struct *prev;
+	sampler_rate_t *rate;
+	uint64_t now;
+	double value;
+	int port;
+	int ret;
+	int i;
+
+	if(SAMPLER_API_Timeout() != 0)
+	{
+		return 0;
+	}
+
+	now = sampler_clock_ns(CLOCK_MONOTONIC);
+	if(!Sampler.PeriodMs)
+	{
+		/* Only keep the totals up to date */
+		SamplerTotals.NextNs = now + SAMPLER_WRAP_CHECK_MS * SAMPLER_NS_PER_MS;
+		return SAMPLER_API_Refresh();
+	}
+
+	/* Keep to the period, unless samples were missed altogether */
+	Sampler.NextNs += Sampler.PeriodMs * SAMPLER_NS_PER_MS;
+	if(Sampler.NextNs <= now)
+	{
+		Sampler.NextNs = now + Sampler.PeriodMs * SAMPLER_NS_PER_MS;
+	}
+
+	ret = sampler_read(values);
+	if(ret)
+	{
+		return ret;
+	}
+
+	/* Samples hold the counters of all ports summed, with the same wraps */
+	cur = &Sampler.Samples[Sampler.Head];
+	memset(cur->Values, 0, sizeof(cur->Values));
+	for(port = 0; port < SamplerTotals.NumPorts; port++)
+	{
+		for(i = 0; i < SAMPLER_NUM_COUNTERS; i++)
+		{
+			cur->Values[i] += values[port][i];
+		}
+	}
+	cur->MonotonicNs = sampler_clock_ns(CLOCK_MONOTONIC);
+	cur->RealtimeMs = sampler_clock_ns(CLOCK_REALTIME) / SAMPLER_NS_PER_MS;
+
+	if(Sampler.Count)
+	{
+		prev = &Sampler.Samples[(Sampler.Head + SAMPLER_HISTORY_LENGTH - 1) % SAMPLER_HISTORY_LENGTH];
+		for(i = 0; i < SAMPLER_NUM_COUNTERS; i++)
+		{
+			value = sampler_rate(i, prev, cur);
+			rate = &Sampler.Rates[i];
+			if(!rate->Samples)
+			{
+				rate->Ewma = rate->Min = rate->Max = value;
+			}
+			else
+			{
+				rate->Ewma += (value - rate->Ewma) * SAMPLER_EWMA_WEIGHT;
+				rate->Min = (value < rate->Min) ? value : rate->Min;
+				rate->Max = (value > rate->Max) ? value : rate->Max;
+			}
+			rate->Last = value;
+			rate->Samples++;
+		}
+	}
+
+	Sampler.Head = (Sampler.Head + 1) % SAMPLER_HISTORY_LENGTH;
+	if(Sampler.Count < SAMPLER_HISTORY_LENGTH)
+	{
+		Sampler.Count++;
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes a sample if one is due, and updates the rate summaries. While the
+* sampler is stopped, only updates the 64-bit totals every
+* SAMPLER_WRAP_CHECK_MS.
+*
+* @return
+*		- 0 if nothing was due or on success
+*		- Return value of sampler_read() on error, no sample is stored
+*
+******************************************************************************/
+int SAMPLER_API_Poll(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&SamplerLock);
+	ret = sampler_api_poll();
+	pthread_mutex_unlock(&SamplerLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the number of counters taken in every sample.
+*
+* @return
+*		- Number of counters
+*
+******************************************************************************/
+int SAMPLER_API_Num_Counters(void)
+{
+	return SAMPLER_NUM_COUNTERS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the name of a counter.
+*
+* @param [in]	counter   Index of the counter.
+*
+* @return
+*		- Counter name, NULL if the index is out of range
+*
+******************************************************************************/
+const char *SAMPLER_API_Counter_Name(int counter)
+{
+	if(counter < 0 || counter >= SAMPLER_NUM_COUNTERS)
+	{
+		return NULL;
+	}
+
+	return SamplerCounters[counter].name;
+}
+
+/*****************************************************************************/
+/**
+*
+* Finds a counter by name.
+*
+* @param [in]	name   Counter name.
+*
+* @return
+*		- Index of the counter, -1 if not found
+*
+******************************************************************************/
+int SAMPLER_API_Find_Counter(const char *name)
+{
+	int i;
+
+	for(i = 0; i < SAMPLER_NUM_COUNTERS; i++)
+	{
+		if(strcmp(SamplerCounters[i].name, name) == 0)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/*****************************************************************************/
+/**
+*
+* Copies the latest samples of a counter, with SamplerLock held. See SAMPLER_API_History().
+*
+******************************************************************************/
+static int sampler_api_history(int counter, sampler_point_t *points, int num_points)
+{
+	const sampler_sample_struct *cur;
+	const sampler_sample_struct *prev;
+	int first;
+	int slot;
+	int i;
+
+	if(counter < 0 || counter >= SAMPLER_NUM_COUNTERS)
+	{
+		return -1;
+	}
+
+	if(num_points > Sampler.Count)
+	{
+		num_points = Sampler.Count;
+	}
+
+	/* Index, counting from the oldest sample, of the first one returned */
+	first = Sampler.Count - num_points;
+	for(i = 0; i < num_points; i++)
+	{
+		slot = (Sampler.Head + SAMPLER_HISTORY_LENGTH - Sampler.Count + first + i) % SAMPLER_HISTORY_LENGTH;
+		cur = &Sampler.Samples[slot];
+		points[i].TimestampMs = cur->RealtimeMs;
+		points[i].Value = cur->Values[counter];
+		points[i].Delta = 0;
+		points[i].Rate = 0;
+		if(first + i > 0)
+		{
+			prev = &Sampler.Samples[(slot + SAMPLER_HISTORY_LENGTH - 1) % SAMPLER_HISTORY_LENGTH];
+			points[i].Delta = cur->Values[counter] - prev->Values[counter];
+			points[i].Rate = sampler_rate(counter, prev, cur);
+		}
+	}
+
+	return num_points;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the most recent samples of a counter, oldest first. The delta and
+* rate of the oldest sample in the ring buffer are 0.
+*
+* @param [in]	counter      Index of the counter.
+* @param [out]	points       Array to fill in.
+* @param [in]	num_points   Size of points.
+*
+* @return
+*		- Number of samples returned
+*		- -1 if the counter index is out of range
+*
+******************************************************************************/
+int SAMPLER_API_History(int counter, sampler_point_t *points, int num_points)
+{
+	int ret;
+
+	pthread_mutex_lock(&SamplerLock);
+	ret = sampler_api_history(counter, points, num_points);
+	pthread_mutex_unlock(&SamplerLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Gets the rate summary of a counter, with SamplerLock held. See SAMPLER_API_Rate().
+*
+******************************************************************************/
+static int sampler_api_rate(int counter, sampler_rate_t *pRate)
+{
+	if(counter < 0 || counter >= SAMPLER_NUM_COUNTERS)
+	{
+		return EINVAL;
+	}
+
+	*pRate = Sampler.Rates[counter];
+
+	return pRate->Samples ? 0 : EAGAIN;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the rate summary of a counter.
+*
+* @param [in]	counter   Index of the counter.
+* @param [out]	pRate     Pointer to store the summary in.
+*
+* @return
+*		- 0 on success
+*		- EINVAL if the counter index is out of range
+*		- EAGAIN if fewer than two samples were taken yet
+*
+******************************************************************************/
+int SAMPLER_API_Rate(int counter, sampler_rate_t *pRate)
+{
+	int ret;
+
+	pthread_mutex_lock(&SamplerLock);
+	ret = sampler_api_rate(counter, pRate);
+	pthread_mutex_unlock(&SamplerLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Updates the 64-bit totals, with SamplerLock held. See SAMPLER_API_Refresh().
+*
+******************************************************************************/
+static int sampler_api_refresh(void)
+{
+	uint32_t values[XROE_STATS_SNAPSHOT_MAX_PORTS][SAMPLER_NUM_COUNTERS];
+
+	return sampler_read(values);
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads all counters now and updates their 64-bit totals, without storing a
+* sample.
+*
+* @return
+*		- 0 on success
+*		- Return value of sampler_read() on error
+*
+******************************************************************************/
+int SAMPLER_API_Refresh(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&SamplerLock);
+	ret = sampler_api_refresh();
+	pthread_mutex_unlock(&SamplerLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the number of ports counted, with SamplerLock held. See SAMPLER_API_Num_Ports().
+*
+******************************************************************************/
+static int sampler_api_num_ports(void)
+{
+	return SamplerTotals.NumPorts ? SamplerTotals.NumPorts : 1;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the number of Ethernet ports whose counters are read.
+*
+* @return
+*		- Number of ports, 1 until the counters are first read
+*
+******************************************************************************/
+int SAMPLER_API_Num_Ports(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&SamplerLock);
+	ret = sampler_api_num_ports();
+	pthread_mutex_unlock(&SamplerLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Gets the 64-bit total of a counter, with SamplerLock held. See SAMPLER_API_Total().
+*
+******************************************************************************/
+static int sampler_api_total(int port, int counter, sampler_total_t *pTotal)
+{
+	const sampler_total_t *total;
+	int i;
+
+	if(counter < 0 || counter >= SAMPLER_NUM_COUNTERS ||
+	   port < SAMPLER_ALL_PORTS || port >= SAMPLER_API_Num_Ports())
+	{
+		return EINVAL;
+	}
+
+	if(port != SAMPLER_ALL_PORTS)
+	{
+		*pTotal = SamplerTotals.Counters[port][counter];
+		return SamplerTotals.Valid ? 0 : EAGAIN;
+	}
+
+	memset(pTotal, 0, sizeof(*pTotal));
+	for(i = 0; i < SamplerTotals.NumPorts; i++)
+	{
+		total = &SamplerTotals.Counters[i][counter];
+		pTotal->Total += total->Total;
+		pTotal->Value += total->Value;
+		pTotal->Wraps += total->Wraps;
+		if(total->LastWrapMs > pTotal->LastWrapMs)
+		{
+			pTotal->LastWrapMs = total->LastWrapMs;
+		}
+	}
+
+	return SamplerTotals.Valid ? 0 : EAGAIN;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the 64-bit total of a counter, as of the last read.
+*
+* @param [in]	port      Ethernet port, or SAMPLER_ALL_PORTS for the sum of
+*                         all ports with their last wrap.
+* @param [in]	counter   Index of the counter.
+* @param [out]	pTotal    Pointer to store the total in.
+*
+* @return
+*		- 0 on success
+*		- EINVAL if the port or counter index is out of range
+*		- EAGAIN if the counters were not read yet
+*
+******************************************************************************/
+int SAMPLER_API_Total(int port, int counter, sampler_total_t *pTotal)
+{
+	int ret;
+
+	pthread_mutex_lock(&SamplerLock);
+	ret = sampler_api_total(port, counter, pTotal);
+	pthread_mutex_unlock(&SamplerLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Resets the 64-bit totals, with SamplerLock held. See SAMPLER_API_Reset_Totals().
+*
+******************************************************************************/
+static int sampler_api_reset_totals(void)
+{
+	sampler_total_t *total;
+	int ret;
+	int port;
+	int i;
+
+	SamplerTotals.Valid = 0;
+	ret = SAMPLER_API_Refresh();
+	if(ret)
+	{
+		return ret;
+	}
+
+	/* Keep the hardware values just read as the baseline */
+	for(port = 0; port < SamplerTotals.NumPorts; port++)
+	{
+		for(i = 0; i < SAMPLER_NUM_COUNTERS; i++)
+		{
+			total = &SamplerTotals.Counters[port][i];
+			if(!SamplerCounters[i].gauge)
+			{
+				total->Total = 0;
+			}
+			total->Wraps = 0;
+			total->LastWrapMs = 0;
+		}
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Restarts the 64-bit totals of all counters from zero, taking the current
+* hardware values as the baseline. Wrap records are cleared too, and the
+* number of Ethernet ports is read again.
+*
+* @return
+*		- 0 on success
+*		- Return value of SAMPLER_API_Refresh() on error, the totals then
+*		  restart from the next successful read
+*
+******************************************************************************/
+int SAMPLER_API_Reset_Totals(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&SamplerLock);
+	ret = sampler_api_reset_totals();
+	pthread_mutex_unlock(&SamplerLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the time of the last reset, with SamplerLock held. See SAMPLER_API_Reset_Time().
+*
+******************************************************************************/
+static uint64_t sampler_api_reset_time(void)
+{
+	return SamplerTotals.ResetMs;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the time the 64-bit totals count from.
+*
+* @return
+*		- Wall clock time in milliseconds of the first read of the counters
+*		  or of the last SAMPLER_API_Reset_Totals(), 0 if not read yet
+*
+******************************************************************************/
+uint64_t SAMPLER_API_Reset_Time(void)
+{
+	uint64_t ret;
+
+	pthread_mutex_lock(&SamplerLock);
+	ret = sampler_api_reset_time();
+	pthread_mutex_unlock(&SamplerLock);
+
+	return ret;
+}
+/** @} */
@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file stats_sampler.h
+* @addtogroup framer_driver_api
+* @{
+*
+*  Background sampler of the Radio over Ethernet Framer statistics
+*
+*  The sampler reads all statistics counters at a fixed period from the
+*  application's main loop into a ring buffer of timestamped samples, and
+*  keeps the EWMA, minimum and maximum of each counter's rate. Queries are
+*  answered from memory without accessing the hardware.
+*
+*  The 32-bit hardware counters are also extended to 64-bit totals. Each read
+*  of the counters adds the change since the previous one, and while the
+*  sampler is stopped the counters are still read every
+*  SAMPLER_WRAP_CHECK_MS so that no wrap is missed.
+*
+*  Totals are kept per Ethernet port, while samples and rates are of all
+*  ports summed.
+*
+******************************************************************************/
+#ifndef STATS_SAMPLER_H		/* prevent circular inclusions */
+#define STATS_SAMPLER_H		/* by using protection macros */
+
+#include <stdint.h>
+#include <roe_framer_fields.h>
+#include <xroe_api.h>
+
+/* Number of samples kept in the ring buffer */
+#define SAMPLER_HISTORY_LENGTH 600
+
+/* Shortest sampling period accepted, in milliseconds */
+#define SAMPLER_MIN_PERIOD_MS 10
+
+/*
+ * Period of the counter reads while the sampler is stopped, in milliseconds.
+ * The fastest counters wrap after about 2 minutes at 25G line rate.
+ */
+#define SAMPLER_WRAP_CHECK_MS 1000
+
+/* Port index of the totals of all Ethernet ports summed */
+#define SAMPLER_ALL_PORTS -1
+
+/* Snapshot word index used for the framer restart count register */
+#define SAMPLER_WORD_RESTART_CNT -1
+
+/**
+ * SAMPLER_COUNTERS The counters taken in every sample, as
+ * X(id, name, word, gauge) where name is also the name of the stats sysfs
+ * entry, word the index in the stats snapshot words and gauge set for
+ * registers holding a rate instead of a count.
+ */
+#define SAMPLER_COUNTERS(X) \
+	X(TOTAL_RX_GOOD_PKT, total_rx_good_pkt, XROE_STATS_WORD(STATS_TOTAL_RX_GOOD_PKT_CNT), 0) \
+	X(TOTAL_RX_BAD_PKT, total_rx_bad_pkt, XROE_STATS_WORD(STATS_TOTAL_RX_BAD_PKT_CNT), 0) \
+	X(TOTAL_RX_BAD_FCS, total_rx_bad_fcs, XROE_STATS_WORD(STATS_TOTAL_RX_BAD_FCS_CNT), 0) \
+	X(TOTAL_RX_USER_PKT, total_rx_user_pkt, XROE_STATS_WORD(STATS_USER_DATA_RX_PACKETS_CNT), 0) \
+	X(TOTAL_RX_GOOD_USER_PKT, total_rx_good_user_pkt, XROE_STATS_WORD(STATS_USER_DATA_RX_GOOD_PKT_CNT), 0) \
+	X(TOTAL_RX_BAD_USER_PKT, total_rx_bad_user_pkt, XROE_STATS_WORD(STATS_USER_DATA_RX_BAD_PKT_CNT), 0) \
+	X(TOTAL_RX_BAD_USER_FCS, total_rx_bad_user_fcs, XROE_STATS_WORD(STATS_USER_DATA_RX_BAD_FCS_CNT), 0) \
+	X(TOTAL_RX_USER_CTRL_PKT, total_rx_user_ctrl_pkt, XROE_STATS_WORD(STATS_USER_CTRL_RX_PACKETS_CNT), 0) \
+	X(TOTAL_RX_GOOD_USER_CTRL_PKT, total_rx_good_user_ctrl_pkt, XROE_STATS_WORD(STATS_USER_CTRL_RX_GOOD_PKT_CNT), 0) \
+	X(TOTAL_RX_BAD_USER_CTRL_PKT, total_rx_bad_user_ctrl_pkt, XROE_STATS_WORD(STATS_USER_CTRL_RX_BAD_PKT_CNT), 0) \
+	X(TOTAL_RX_BAD_USER_CTRL_FCS, total_rx_bad_user_ctrl_fcs, XROE_STATS_WORD(STATS_USER_CTRL_RX_BAD_FCS_CNT), 0) \
+	X(RX_USER_PKT_RATE, rx_user_pkt_rate, XROE_STATS_WORD(STATS_USER_DATA_RX_PKTS_RATE), 1) \
+	X(RX_USER_CTRL_PKT_RATE, rx_user_ctrl_pkt_rate, XROE_STATS_WORD(STATS_USER_CTRL_RX_PKTS_RATE), 1) \
+	X(FRAM_AUTO_RESTART_CNT, fram_auto_restart_cnt, SAMPLER_WORD_RESTART_CNT, 0)
+
+/***************************** Type Definitions ******************************/
+/* Counter identifier for an entry of SAMPLER_COUNTERS */
+#define SAMPLER_COUNTER_ID(_id, _name, _word, _gauge) SAMPLER_##_id,
+
+/**
+ * sampler_counter_id_t Identifiers of the sampled counters.
+ */
+typedef enum sampler_counter_id_t{
+	SAMPLER_COUNTERS(SAMPLER_COUNTER_ID)
+	SAMPLER_NUM_COUNTERS
+} sampler_counter_id_t;
+
+/**
+ * sampler_total_t 64-bit total of a counter.
+ */
+typedef struct sampler_total_t{
+	uint64_t Total;      /**< Count since the start or the last reset */
+	uint32_t Value;      /**< Last hardware value */
+	uint32_t Wraps;      /**< Hardware counter wraps seen */
+	uint64_t LastWrapMs; /**< Wall clock time of the last wrap, 0 if none */
+} sampler_total_t;
+
+/**
+ * sampler_point_t One sample of a counter.
+ */
+typedef struct sampler_point_t{
+	uint64_t TimestampMs; /**< Wall clock time of the sample */
+	uint32_t Value;       /**< Counter value */
+	uint32_t Delta;       /**< Change since the previous sample */
+	double Rate;          /**< Delta per second, the value for gauges */
+} sampler_point_t;
+
+/**
+ * sampler_rate_t Rate summary of a counter since the sampler was started.
+ */
+typedef struct sampler_rate_t{
+	double Last;
+	double Ewma;
+	double Min;
+	double Max;
+	int Samples;
+} sampler_rate_t;
+
+/************************** Function Prototypes ******************************/
+int SAMPLER_API_Start(int period_ms);
+void SAMPLER_API_Stop(void);
+int SAMPLER_API_Period(void);
+int SAMPLER_API_Timeout(void);
+int SAMPLER_API_Poll(void);
+int SAMPLER_API_Num_Counters(void);
+const char *SAMPLER_API_Counter_Name(int counter);
+int SAMPLER_API_Find_Counter(const char *name);
+int SAMPLER_API_History(int counter, sampler_point_t *points, int num_points);
+int SAMPLER_API_Rate(int counter, sampler_rate_t *pRate);
+int SAMPLER_API_Refresh(void);
+int SAMPLER_API_Num_Ports(void);
+int SAMPLER_API_Total(int port, int counter, sampler_total_t *pTotal);
+int SAMPLER_API_Reset_Totals(void);
+uint64_t SAMPLER_API_Reset_Time(void);
+#endif /* end of protection macro */
+/** @} */
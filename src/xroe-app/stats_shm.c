@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file stats_shm.c
+* @addtogroup framer_driver_api
+* @{
+*
+*  Publication of the statistics in shared memory
+*
+*  The segment is only written by the main loop. Each publication gathers the
+*  values first, then copies them into the segment between two increments of
+*  its sequence number, so that readers spinning on an odd sequence number
+*  wait only for the copy and never for the hardware accesses.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <syslog.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <roe_framer_fields.h>
+#include <xroe_api.h>
+#include <stats_sampler.h>
+#include <radio_ctrl.h>
+#include <ecpri_proto.h>
+#include <stats_shm.h>
+
+#define SHM_NS_PER_SEC 1000000000ULL
+#define SHM_NS_PER_MS 1000000ULL
+
+#if (SAMPLER_NUM_COUNTERS > XROE_SHM_MAX_COUNTERS)
+#error "XROE_SHM_MAX_COUNTERS is lower than the number of sampled counters"
+#endif
+
+#if (XROE_STATS_SNAPSHOT_MAX_PORTS > XROE_SHM_MAX_PORTS)
+#error "XROE_SHM_MAX_PORTS is lower than the number of statistics ports"
+#endif
+
+#if (MAX_NUMBER_OF_ANTENNAS > XROE_SHM_MAX_ANTENNAS)
+#error "XROE_SHM_MAX_ANTENNAS is lower than the number of antennas"
+#endif
+
+/**
+ * shm_struct State of the publication.
+ */
+typedef struct shm_struct{
+	xroe_shm_stats_t *Segment; /**< NULL when not publishing */
+	uint64_t NextNs;
+	xroe_shm_stats_t Staging;  /**< Values gathered before the copy */
+} shm_struct;
+
+/**
+ * Shm Shared memory publication state.
+ */
+static shm_struct Shm;
+
+/*****************************************************************************/
+/**
+*
+* Returns the time of a clock in nanoseconds.
+*
+* @param [in]	clock   Clock to read.
+*
+* @return
+*		- Clock time in nanoseconds
+*
+******************************************************************************/
+static uint64_t shm_clock_ns(clockid_t clock)
+{
+	struct timespec now;
+
+	clock_gettime(clock, &now);
+	return (uint64_t)now.tv_sec * SHM_NS_PER_SEC + now.tv_nsec;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the period of the publications, following the sampler.
+*
+* @return
+*		- Period in milliseconds
+*
+******************************************************************************/
+static int shm_period_ms(void)
+{
+	int period = SAMPLER_API_Period() ? SAMPLER_API_Period() : SAMPLER_WRAP_CHECK_MS;
+
+	return (period < SHM_MIN_PERIOD_MS) ? SHM_MIN_PERIOD_MS : period;
+}
+
+/*****************************************************************************/
+/**
+*
+* Gathers the values to publish into the staging copy.
+*
+******************************************************************************/
+static void shm_gather(void)
+{
+	xroe_shm_stats_t *pStaging = &Shm.Staging;
+	ecpri_owdm_direction_type direction = TO_REMOTE;
+	antennas_status_struct antennas;
+	radio_ctrl_struct radio;
+	sampler_total_t total;
+	struct in_addr node;
+	unsigned long long secs = 0;
+	unsigned long nsecs = 0;
+	int req_no = 0;
+	int resp_no = 0;
+	int port;
+	int i;
+
+	pStaging->TimestampMs = shm_clock_ns(CLOCK_REALTIME) / SHM_NS_PER_MS;
+
+	/* Statistics totals, as kept up to date by the sampler */
+	pStaging->NumPorts = SAMPLER_API_Num_Ports();
+	for(port = 0; port < (int)pStaging->NumPorts; port++)
+	{
+		for(i = 0; i < SAMPLER_NUM_COUNTERS; i++)
+		{
+			if(!SAMPLER_API_Total(port, i, &total))
+			{
+				pStaging->Totals[port][i] = total.Total;
+				pStaging->Wraps[port][i] = total.Wraps;
+			}
+		}
+	}
+
+	/* Radio and antenna status */
+	memset(&antennas, 0, sizeof(antennas));
+	memset(&radio, 0, sizeof(radio));
+	pStaging->RadioValid = !RADIO_CTRL_Get_Status(&radio, &antennas);
+	pStaging->RadioEnable = radio.Enable;
+	pStaging->RadioError = radio.Error;
+	pStaging->RadioStatus = radio.Status;
+	pStaging->RadioLoopback = radio.Loopback;
+	pStaging->NumAntennas = antennas.NumOfAntennas;
+	for(i = 0; i < antennas.NumOfAntennas; i++)
+	{
+		pStaging->Antennas[i].Align = antennas.Antenna[i].Align;
+		pStaging->Antennas[i].Regular = antennas.Antenna[i].Regular;
+		pStaging->Antennas[i].Overflow = antennas.Antenna[i].Overflow;
+		pStaging->Antennas[i].Underflow = antennas.Antenna[i].Underflow;
+		pStaging->Antennas[i].CheckError = antennas.Antenna[i].CheckError;
+		pStaging->Antennas[i].BufStateLatency = antennas.Antenna[i].BufStateLatency;
+	}
+
+	/* Latest eCPRI One-Way Delay Measurement */
+	node.s_addr = 0;
+	proto_ecpri_get_owdm_result(&req_no, &resp_no, &direction, &node, &secs, &nsecs);
+	pStaging->OwdmRequests = req_no;
+	pStaging->OwdmResponses = resp_no;
+	pStaging->OwdmDirection = direction;
+	pStaging->OwdmNode = node.s_addr;
+	pStaging->OwdmDelaySec = secs;
+	pStaging->OwdmDelayNsec = nsecs;
+}
+
+/*****************************************************************************/
+/**
+*
+* Creates the shared memory segment and publishes the current statistics.
+*
+* @return
+*		- 0 on success
+*		- errno of the failing call otherwise
+*
+******************************************************************************/
+int SHM_API_Open(void)
+{
+	void *segment;
+	int ret;
+	int fd;
+	int i;
+
+	if(Shm.Segment)
+	{
+		return 0;
+	}
+
+	fd = shm_open(XROE_SHM_NAME, O_RDWR | O_CREAT, 0644);
+	if(fd < 0)
+	{
+		ret = errno;
+		syslog(LOG_ERR, "shm_open %s: %s\n", XROE_SHM_NAME, strerror(ret));
+		return ret;
+	}
+
+	if(ftruncate(fd, sizeof(xroe_shm_stats_t)) < 0)
+	{
+		ret = errno;
+		syslog(LOG_ERR, "ftruncate %s: %s\n", XROE_SHM_NAME, strerror(ret));
+		close(fd);
+		shm_unlink(XROE_SHM_NAME);
+		return ret;
+	}
+
+	segment = mmap(NULL, sizeof(xroe_shm_stats_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	ret = errno;
+	close(fd);
+	if(segment == MAP_FAILED)
+	{
+		syslog(LOG_ERR, "mmap %s: %s\n", XROE_SHM_NAME, strerror(ret));
+		shm_unlink(XROE_SHM_NAME);
+		return ret;
+	}
+
+	/* A segment left by a previous server is cleared, sequence included */
+	memset(segment, 0, sizeof(xroe_shm_stats_t));
+	Shm.Segment = segment;
+
+	memset(&Shm.Staging, 0, sizeof(Shm.Staging));
+	Shm.Staging.Version = XROE_SHM_VERSION;
+	Shm.Staging.Size = sizeof(xroe_shm_stats_t);
+	Shm.Staging.NumCounters = SAMPLER_NUM_COUNTERS;
+	for(i = 0; i < SAMPLER_NUM_COUNTERS; i++)
+	{
+		strncpy(Shm.Staging.CounterNames[i], SAMPLER_API_Counter_Name(i), XROE_SHM_NAME_LENGTH - 1);
+	}
+
+	SAMPLER_API_Refresh();
+	return SHM_API_Publish();
+}
+
+/*****************************************************************************/
+/**
+*
+* Stops publishing and removes the shared memory segment. Readers still
+* mapping it keep the last published statistics.
+*
+******************************************************************************/
+void SHM_API_Close(void)
+{
+	if(!Shm.Segment)
+	{
+		return;
+	}
+
+	munmap(Shm.Segment, sizeof(xroe_shm_stats_t));
+	shm_unlink(XROE_SHM_NAME);
+	Shm.Segment = NULL;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns how long the main loop may wait before SHM_API_Poll() is due.
+*
+* @return
+*		- Milliseconds until the next publication
+*		- -1 when not publishing
+*
+******************************************************************************/
+int SHM_API_Timeout(void)
+{
+	uint64_t now;
+
+	if(!Shm.Segment)
+	{
+		return -1;
+	}
+
+	now = shm_clock_ns(CLOCK_MONOTONIC);
+	if(now >= Shm.NextNs)
+	{
+		return 0;
+	}
+
+	return (Shm.NextNs - now + SHM_NS_PER_MS - 1) / SHM_NS_PER_MS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Publishes the statistics if a publication is due.
+*
+* @return
+*		- 0 if nothing was due or on success
+*		- Return value of SHM_API_Publish() on error
+*
+******************************************************************************/
+int SHM_API_Poll(void)
+{
+	if(SHM_API_Timeout() != 0)
+	{
+		return 0;
+	}
+
+	return SHM_API_Publish();
+}
+
+/*****************************************************************************/
+/**
+*
+* Publishes the current statistics now.
+*
+* @return
+*		- 0 on success
+*		- ENODEV when not publishing
+*
+******************************************************************************/
+int SHM_API_Publish(void)
+{
+	xroe_shm_stats_t *pSegment = Shm.Segment;
+	uint32_t sequence;
+
+	if(!pSegment)
+	{
+		return ENODEV;
+	}
+
+	Shm.NextNs = shm_clock_ns(CLOCK_MONOTONIC) + shm_period_ms() * SHM_NS_PER_MS;
+
+	shm_gather();
+	Shm.Staging.Updates++;
+
+	/* Odd sequence while copying, readers retry until it is even again */
+	sequence = pSegment->Sequence;
+	__atomic_store_n(&pSegment->Sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	Shm.Staging.Sequence = sequence + 1;
+	memcpy(pSegment, &Shm.Staging, sizeof(*pSegment));
+
+	__atomic_store_n(&pSegment->Sequence, sequence + 2, __ATOMIC_RELEASE);
+
+	return 0;
+}
+/** @} */
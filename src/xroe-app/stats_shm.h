@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file stats_shm.h
+* @addtogroup framer_driver_api
+* @{
+*
+*  Publication of the statistics in shared memory
+*
+*  When enabled, the server copies the statistics totals, radio and antenna
+*  status and the latest eCPRI OWDM result into the shared memory segment
+*  described in xroe_shm.h, from the main loop at the sampling period (or
+*  every SAMPLER_WRAP_CHECK_MS while the sampler is stopped).
+*
+******************************************************************************/
+#ifndef STATS_SHM_H		/* prevent circular inclusions */
+#define STATS_SHM_H		/* by using protection macros */
+
+#include <xroe_shm.h>
+
+/* Shortest period between two publications, in milliseconds */
+#define SHM_MIN_PERIOD_MS 100
+
+/************************** Function Prototypes ******************************/
+int SHM_API_Open(void);
+void SHM_API_Close(void);
+int SHM_API_Timeout(void);
+int SHM_API_Poll(void);
+int SHM_API_Publish(void);
+#endif /* end of protection macro */
+/** @} */
@@ -32,22 +32,22 @@
 /**
  * STATS_USER_STR Help text for the stats module "user" option.
  */
-#define STATS_USER_STR "Returns user data packets stats\n"
+#define STATS_USER_STR "Returns user data packets stats, of [port] or all ports summed\n"
 
 /**
  * STATS_CTRL_STR Help text for the stats module "control" option.
  */
-#define STATS_CTRL_STR "Returns control packets stats\n"
+#define STATS_CTRL_STR "Returns control packets stats, of [port] or all ports summed\n"
 
 /**
  * STATS_RATE_STR Help text for the stats module "rate" option.
  */
-#define STATS_RATE_STR "Returns packet rate stats\n"
+#define STATS_RATE_STR "stats rate [counter] : packet rate stats, with the sampler's rates when running\n"
 
 /**
  * STATS_ALL_STR Help text for the stats module "all" option.
  */
-#define STATS_ALL_STR "Returns a summary of all stats\n"
+#define STATS_ALL_STR "Returns a summary of all stats, of [port] or all ports summed\n"
 
 /**
  * STATS_DEV_NUM_STR Help text for the stats module "rev" option.
@@ -57,5 +57,31 @@
 /**
  * STATS_GUI_NUM_STR Help text for the stats module "gui" option.
  */
-#define STATS_GUI_NUM_STR "[DEV] all stats output for GUI\n"
+#define STATS_GUI_NUM_STR "[DEV] all stats output for GUI, of [port] or all ports summed\n"
+
+/**
+ * STATS_HISTORY_STR Help text for the stats module "history" option.
+ */
+#define STATS_HISTORY_STR "stats history [counter] [samples] : recent samples of a counter taken by the sampler\n"
+
+/**
+ * STATS_SAMPLER_STR Help text for the stats module "sampler" option.
+ */
+#define STATS_SAMPLER_STR "stats sampler [period_ms|off] : shows or sets the period of the background sampler\n"
+
+/**
+ * STATS_TOTALS_STR Help text for the stats module "totals" option.
+ */
+#define STATS_TOTALS_STR "64-bit packet counter totals of [port] or all ports, with hardware counter wraps\n"
+
+/**
+ * STATS_RESET_STR Help text for the stats module "reset" option.
+ */
+#define STATS_RESET_STR "restarts the packet counter totals from zero\n"
+
+/**
+ * STATS_NO_SAMPLES_STR Response when the sampler has no samples yet.
+ */
+#define STATS_NO_SAMPLES_STR "No samples, start the sampler with \"stats sampler <period_ms>\"\n"
+
 /** @} */
\ No newline at end of file
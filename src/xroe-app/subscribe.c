@@ -0,0 +1,634 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file subscribe.c
+* @addtogroup comms_lib
+* @{
+*
+*  Push telemetry for subscribed clients
+*
+*  subscribe_func() only validates the request. The connection is handed over
+*  by send_response() through SUBSCRIBE_API_Attach() with the reply,
+*  and SUBSCRIBE_API_Timeout() and SUBSCRIBE_API_Poll() are called from the
+*  main loop, in the same way as the statistics sampler. Pushes never block
+*  the main loop: a client which does not keep up is disconnected.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+#include <xroe_types.h>
+#include <subscribe_str.h>
+#include <roe_framer_fields.h>
+#include <xroe_api.h>
+#include <stats_sampler.h>
+#include <radio_ctrl.h>
+#include <ecpri_proto.h>
+#include <subscribe.h>
+
+#define SUBSCRIBE_NS_PER_SEC 1000000000ULL
+#define SUBSCRIBE_NS_PER_MS 1000000ULL
+
+/* Length of a field name and of its formatted value */
+#define SUBSCRIBE_NAME_LENGTH 32
+#define SUBSCRIBE_VALUE_LENGTH 32
+
+/**
+ * subscribe_group_t Groups of fields which may be subscribed to.
+ */
+typedef enum subscribe_group_t{
+	SUBSCRIBE_STATS,
+	SUBSCRIBE_RADIO,
+	SUBSCRIBE_OWDM,
+	SUBSCRIBE_NUM_GROUPS
+} subscribe_group_t;
+
+/**
+ * SubscribeGroupNames Names of the groups, as given to "subscribe".
+ */
+static const char *SubscribeGroupNames[SUBSCRIBE_NUM_GROUPS] = {
+	[SUBSCRIBE_STATS] = "stats",
+	[SUBSCRIBE_RADIO] = "radio",
+	[SUBSCRIBE_OWDM] = "owdm",
+};
+
+/**
+ * subscribe_field_struct A field of a group, with its value as JSON text.
+ */
+typedef struct subscribe_field_struct{
+	char Name[SUBSCRIBE_NAME_LENGTH];
+	char Value[SUBSCRIBE_VALUE_LENGTH];
+} subscribe_field_struct;
+
+/**
+ * subscribe_client_struct A subscribed connection.
+ */
+typedef struct subscribe_client_struct{
+	int Fd;         /**< -1 when the slot is free */
+	int Group;
+	int PeriodMs;
+	uint64_t NextNs;
+	int NumFields;  /**< Fields last pushed, 0 before the first push */
+	subscribe_field_struct Last[SUBSCRIBE_MAX_FIELDS];
+} subscribe_client_struct;
+
+/**
+ * subscribe_struct State of the subscriptions.
+ */
+typedef struct subscribe_struct{
+	int Initialised;
+	int PendingGroup;    /**< Group of the subscription being replied to, -1 if none */
+	int PendingPeriodMs;
+	subscribe_client_struct Clients[SUBSCRIBE_MAX_CLIENTS];
+} subscribe_struct;
+
+/**
+ * Subscribe Subscribed connections.
+ */
+static subscribe_struct Subscribe;
+
+/*****************************************************************************/
+/**
+*
+* Returns the time of a clock in nanoseconds.
+*
+* @param [in]	clock   Clock to read.
+*
+* @return
+*		- Time in nanoseconds
+*
+******************************************************************************/
+static uint64_t subscribe_clock_ns(clockid_t clock)
+{
+	struct timespec now;
+
+	clock_gettime(clock, &now);
+	return (uint64_t)now.tv_sec * SUBSCRIBE_NS_PER_SEC + now.tv_nsec;
+}
+
+/*****************************************************************************/
+/**
+*
+* Frees all the client slots the first time the module is used.
+*
+******************************************************************************/
+static void subscribe_init(void)
+{
+	int i;
+
+	if(Subscribe.Initialised)
+	{
+		return;
+	}
+
+	for(i = 0; i < SUBSCRIBE_MAX_CLIENTS; i++)
+	{
+		Subscribe.Clients[i].Fd = -1;
+	}
+	Subscribe.PendingGroup = -1;
+	Subscribe.Initialised = 1;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns a free client slot.
+*
+* @return
+*		- Pointer to the slot
+*		- NULL if all slots are in use
+*
+******************************************************************************/
+static subscribe_client_struct *subscribe_free_slot(void)
+{
+	int i;
+
+	for(i = 0; i < SUBSCRIBE_MAX_CLIENTS; i++)
+	{
+		if(Subscribe.Clients[i].Fd < 0)
+		{
+			return &Subscribe.Clients[i];
+		}
+	}
+
+	return NULL;
+}
+
+/*****************************************************************************/
+/**
+*
+* Ends a subscription and closes its connection.
+*
+* @param [in,out]	pClient   Subscribed client.
+*
+******************************************************************************/
+static void subscribe_close(subscribe_client_struct *pClient)
+{
+	close(pClient->Fd);
+	pClient->Fd = -1;
+	pClient->NumFields = 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets the next field of a group.
+*
+* @param [in,out]	fields    Fields of the group.
+* @param [in,out]	pNum      Number of fields set so far.
+* @param [in]		name      Field name.
+* @param [in]		fmt       printf() format of the value, as JSON text.
+*
+******************************************************************************/
+static void subscribe_field(subscribe_field_struct *fields, int *pNum, const char *name, const char *fmt, ...)
+{
+	va_list args;
+
+	if(*pNum >= SUBSCRIBE_MAX_FIELDS)
+	{
+		return;
+	}
+
+	snprintf(fields[*pNum].Name, SUBSCRIBE_NAME_LENGTH, "%s", name);
+	va_start(args, fmt);
+	vsnprintf(fields[*pNum].Value, SUBSCRIBE_VALUE_LENGTH, fmt, args);
+	va_end(args);
+	(*pNum)++;
+}
+
+/*****************************************************************************/
+/**
+*
+* Gets the statistics totals of all ports summed, as of the last read.
+*
+* @param [out]	fields    Fields of the group.
+*
+* @return
+*		- Number of fields
+*
+******************************************************************************/
+static int subscribe_stats(subscribe_field_struct *fields)
+{
+	sampler_total_t total;
+	int num = 0;
+	int i;
+
+	subscribe_field(fields, &num, "NumPorts", "%d", SAMPLER_API_Num_Ports());
+	for(i = 0; i < SAMPLER_NUM_COUNTERS; i++)
+	{
+		if(!SAMPLER_API_Total(SAMPLER_ALL_PORTS, i, &total))
+		{
+			subscribe_field(fields, &num, SAMPLER_API_Counter_Name(i), "%" PRIu64, total.Total);
+		}
+	}
+
+	return num;
+}
+
+/*****************************************************************************/
+/**
+*
+* Gets the radio and antenna status, with the names of "radio gui".
+*
+* @param [out]	fields    Fields of the group.
+*
+* @return
+*		- Number of fields, 0 if the status could not be read
+*
+******************************************************************************/
+static int subscribe_radio(subscribe_field_struct *fields)
+{
+	antennas_status_struct antennas;
+	radio_ctrl_struct radio;
+	char name[SUBSCRIBE_NAME_LENGTH];
+	int num = 0;
+	int i;
+
+	memset(&antennas, 0, sizeof(antennas));
+	if(RADIO_CTRL_Get_Status(&radio, &antennas))
+	{
+		return 0;
+	}
+
+	subscribe_field(fields, &num, "Enable", "%u", radio.Enable);
+	subscribe_field(fields, &num, "Error", "%u", radio.Error);
+	subscribe_field(fields, &num, "Status", "%u", radio.Status);
+	subscribe_field(fields, &num, "Loopback", "%u", radio.Loopback);
+	for(i = 0; i < antennas.NumOfAntennas; i++)
+	{
+		snprintf(name, sizeof(name), "Antenna%dAlign", i);
+		subscribe_field(fields, &num, name, "%u", antennas.Antenna[i].Align);
+		snprintf(name, sizeof(name), "Antenna%dRegular", i);
+		subscribe_field(fields, &num, name, "%u", antennas.Antenna[i].Regular);
+		snprintf(name, sizeof(name), "Antenna%dOverflow", i);
+		subscribe_field(fields, &num, name, "%u", antennas.Antenna[i].Overflow);
+		snprintf(name, sizeof(name), "Antenna%dUnderflow", i);
+		subscribe_field(fields, &num, name, "%u", antennas.Antenna[i].Underflow);
+		snprintf(name, sizeof(name), "Antenna%dCheckError", i);
+		subscribe_field(fields, &num, name, "%u", antennas.Antenna[i].CheckError);
+		snprintf(name, sizeof(name), "Antenna%dBufStateLatency", i);
+		subscribe_field(fields, &num, name, "%u", antennas.Antenna[i].BufStateLatency);
+	}
+
+	return num;
+}
+
+/*****************************************************************************/
+/**
+*
+* Gets the latest eCPRI One-Way Delay Measurement result.
+*
+* @param [out]	fields    Fields of the group.
+*
+* @return
+*		- Number of fields
+*
+******************************************************************************/
+static int subscribe_owdm(subscribe_field_struct *fields)
+{
+	ecpri_owdm_direction_type direction = TO_REMOTE;
+	struct in_addr node;
+	unsigned long long secs = 0;
+	unsigned long nsecs = 0;
+	int req_no = 0;
+	int resp_no = 0;
+	int num = 0;
+
+	node.s_addr = 0;
+	proto_ecpri_get_owdm_result(&req_no, &resp_no, &direction, &node, &secs, &nsecs);
+
+	subscribe_field(fields, &num, "Requests", "%d", req_no);
+	subscribe_field(fields, &num, "Responses", "%d", resp_no);
+	subscribe_field(fields, &num, "Direction", "\"%s\"", (direction == TO_REMOTE) ? "TO_REMOTE" : "FROM_REMOTE");
+	subscribe_field(fields, &num, "Node", "\"%s\"", inet_ntoa(node));
+	subscribe_field(fields, &num, "Delay", "%llu.%09lu", secs, nsecs);
+
+	return num;
+}
+
+/*****************************************************************************/
+/**
+*
+* Pushes the fields of a client's group which changed since the last push.
+*
+* @param [in,out]	pClient   Subscribed client.
+*
+* @return
+*		- 0 on success
+*		- errno of the failed send, the client must be closed
+*
+******************************************************************************/
+static int subscribe_push(subscribe_client_struct *pClient)
+{
+	subscribe_field_struct fields[SUBSCRIBE_MAX_FIELDS];
+	char line[SUBSCRIBE_LINE_LENGTH];
+	char *str = line;
+	char *end = line + sizeof(line) - 2;
+	ssize_t sent;
+	int num = 0;
+	int len;
+	int i;
+
+	switch(pClient->Group)
+	{
+	case SUBSCRIBE_STATS:
+		num = subscribe_stats(fields);
+		break;
+	case SUBSCRIBE_RADIO:
+		num = subscribe_radio(fields);
+		break;
+	case SUBSCRIBE_OWDM:
+		num = subscribe_owdm(fields);
+		break;
+	}
+
+	str += snprintf(str, end - str, "{\"Group\": \"%s\", \"TimestampMs\": %" PRIu64,
+		SubscribeGroupNames[pClient->Group], (uint64_t)(subscribe_clock_ns(CLOCK_REALTIME) / SUBSCRIBE_NS_PER_MS));
+
+	/* A group whose fields changed in number is pushed again in full */
+	for(i = 0; i < num; i++)
+	{
+		if((num != pClient->NumFields) || strcmp(fields[i].Value, pClient->Last[i].Value))
+		{
+			len = snprintf(str, end - str, ", \"%s\": %s", fields[i].Name, fields[i].Value);
+			str += (len < end - str) ? len : (end - str - 1);
+		}
+	}
+	str += sprintf(str, "}\n");
+
+	memcpy(pClient->Last, fields, num * sizeof(fields[0]));
+	pClient->NumFields = num;
+
+	len = str - line;
+	sent = send(pClient->Fd, line, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+	if(sent < 0)
+	{
+		return errno;
+	}
+	else if(sent != len)
+	{
+		/* The client's socket buffer is full, it is not keeping up */
+		return EAGAIN;
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Handles the "subscribe" command. The connection is subscribed once the
+* reply is sent.
+*
+* @param [in]	argc   Number of string arguments.
+* @param [in]	argv   Array of strings containg arguments.
+* @param [in,out]	resp   Response to append the reply text to.
+*
+* @return
+*		- 0
+*
+******************************************************************************/
+int subscribe_func(int argc, char **argv, response_t *resp)
+{
+	int period;
+	int i;
+
+	subscribe_init();
+	Subscribe.PendingGroup = -1;
+
+	if(argc != 2)
+	{
+		resp_printf(resp, SUBSCRIBE_USAGE_STR);
+		return 0;
+	}
+
+	period = atoi(argv[1]);
+	for(i = 0; i < SUBSCRIBE_NUM_GROUPS; i++)
+	{
+		if(!strcmp(argv[0], SubscribeGroupNames[i]))
+		{
+			break;
+		}
+	}
+
+	if((i == SUBSCRIBE_NUM_GROUPS) || (period < SUBSCRIBE_MIN_PERIOD_MS))
+	{
+		resp_printf(resp, SUBSCRIBE_USAGE_STR);
+	}
+	else if(!subscribe_free_slot())
+	{
+		resp_printf(resp, SUBSCRIBE_FULL_STR, SUBSCRIBE_MAX_CLIENTS);
+	}
+	else
+	{
+		Subscribe.PendingGroup = i;
+		Subscribe.PendingPeriodMs = period;
+		resp_printf(resp, SUBSCRIBE_OK_STR, SubscribeGroupNames[i], period);
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns whether the command just handled was an accepted "subscribe",
+* whose connection must be handed over with SUBSCRIBE_API_Attach().
+*
+* @return
+*		- 1 if a subscription is pending
+*		- 0 otherwise
+*
+******************************************************************************/
+int SUBSCRIBE_API_Is_Pending(void)
+{
+	return Subscribe.Initialised && (Subscribe.PendingGroup >= 0);
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes over the connection of an accepted "subscribe", with the output not
+* yet sent on it, which includes the reply.
+*
+* @param [in]	fd        Connection the command came from.
+* @param [in]	pending   Output still to be sent before the first push.
+* @param [in]	len       Length of the pending output.
+*
+* @return
+*		- 1 if the connection was taken over, and is closed by this module
+*		  from now on
+*		- 0 if no subscription is pending, the caller keeps the connection
+*
+******************************************************************************/
+int SUBSCRIBE_API_Attach(int fd, const char *pending, int len)
+{
+	subscribe_client_struct *pClient;
+
+	subscribe_init();
+	if(Subscribe.PendingGroup < 0)
+	{
+		return 0;
+	}
+
+	pClient = subscribe_free_slot();
+	if(!pClient)
+	{
+		Subscribe.PendingGroup = -1;
+		return 0;
+	}
+
+	/* Commands sent after subscribing are ignored */
+	shutdown(fd, SHUT_RD);
+
+	pClient->Fd = fd;
+	pClient->Group = Subscribe.PendingGroup;
+	pClient->PeriodMs = Subscribe.PendingPeriodMs;
+	pClient->NextNs = subscribe_clock_ns(CLOCK_MONOTONIC);
+	pClient->NumFields = 0;
+	Subscribe.PendingGroup = -1;
+
+	if((len > 0) && (send(fd, pending, len, MSG_NOSIGNAL | MSG_DONTWAIT) != len))
+	{
+		syslog(LOG_NOTICE, "Subscription to %s ended: reply not sent\n", SubscribeGroupNames[pClient->Group]);
+		subscribe_close(pClient);
+	}
+
+	return 1;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns how long the main loop may wait before SUBSCRIBE_API_Poll() is due.
+*
+* @return
+*		- Milliseconds until the next push
+*		- -1 if no connection is subscribed
+*
+******************************************************************************/
+int SUBSCRIBE_API_Timeout(void)
+{
+	uint64_t next = 0;
+	uint64_t now;
+	int i;
+
+	for(i = 0; i < SUBSCRIBE_MAX_CLIENTS; i++)
+	{
+		if(Subscribe.Initialised && (Subscribe.Clients[i].Fd >= 0) &&
+		   (!next || (Subscribe.Clients[i].NextNs < next)))
+		{
+			next = Subscribe.Clients[i].NextNs;
+		}
+	}
+
+	if(!next)
+	{
+		return -1;
+	}
+
+	now = subscribe_clock_ns(CLOCK_MONOTONIC);
+	if(now >= next)
+	{
+		return 0;
+	}
+
+	return (next - now + SUBSCRIBE_NS_PER_MS - 1) / SUBSCRIBE_NS_PER_MS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Pushes the groups of the subscribed connections which are due.
+*
+* @return
+*		- Number of connections pushed to
+*
+******************************************************************************/
+int SUBSCRIBE_API_Poll(void)
+{
+	subscribe_client_struct *pClient;
+	int refreshed = 0;
+	int pushed = 0;
+	uint64_t now;
+	int ret;
+	int i;
+
+	if(SUBSCRIBE_API_Timeout() != 0)
+	{
+		return 0;
+	}
+
+	now = subscribe_clock_ns(CLOCK_MONOTONIC);
+	for(i = 0; i < SUBSCRIBE_MAX_CLIENTS; i++)
+	{
+		pClient = &Subscribe.Clients[i];
+		if((pClient->Fd < 0) || (pClient->NextNs > now))
+		{
+			continue;
+		}
+
+		/* Keep to the period, unless pushes were missed altogether */
+		pClient->NextNs += pClient->PeriodMs * SUBSCRIBE_NS_PER_MS;
+		if(pClient->NextNs <= now)
+		{
+			pClient->NextNs = now + pClient->PeriodMs * SUBSCRIBE_NS_PER_MS;
+		}
+
+		/* Counters are read once for all the clients due */
+		if((pClient->Group == SUBSCRIBE_STATS) && !refreshed)
+		{
+			SAMPLER_API_Refresh();
+			refreshed = 1;
+		}
+
+		ret = subscribe_push(pClient);
+		if(ret)
+		{
+			syslog(LOG_NOTICE, "Subscription to %s ended: %s\n", SubscribeGroupNames[pClient->Group], strerror(ret));
+			subscribe_close(pClient);
+			continue;
+		}
+		pushed++;
+	}
+
+	return pushed;
+}
+
+/*****************************************************************************/
+/**
+*
+* Ends all the subscriptions.
+*
+******************************************************************************/
+void SUBSCRIBE_API_Close_All(void)
+{
+	int i;
+
+	for(i = 0; Subscribe.Initialised && (i < SUBSCRIBE_MAX_CLIENTS); i++)
+	{
+		if(Subscribe.Clients[i].Fd >= 0)
+		{
+			subscribe_close(&Subscribe.Clients[i]);
+		}
+	}
+}
+/** @} */
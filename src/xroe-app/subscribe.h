@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file subscribe.h
+* @addtogroup comms_lib
+* @{
+*
+*  Push telemetry for subscribed clients
+*
+*  "subscribe <group> <period_ms>" keeps the client's connection open and
+*  pushes one JSON object per line at the requested period: all the fields
+*  of the group first, then only the fields which changed. A line with no
+*  field but the timestamp is still sent when nothing changed.
+*
+******************************************************************************/
+#ifndef SUBSCRIBE_H		/* prevent circular inclusions */
+#define SUBSCRIBE_H		/* by using protection macros */
+
+/* Number of connections which may be subscribed at the same time */
+#define SUBSCRIBE_MAX_CLIENTS 8
+
+/* Shortest push period accepted, in milliseconds */
+#define SUBSCRIBE_MIN_PERIOD_MS 100
+
+/* Largest number of fields in a group */
+#define SUBSCRIBE_MAX_FIELDS 64
+
+/* Length of a pushed line, which holds all the fields of a group */
+#define SUBSCRIBE_LINE_LENGTH 4096
+
+/************************** Function Prototypes ******************************/
+int subscribe_func(int argc, char **argv, response_t *resp);
+int SUBSCRIBE_API_Is_Pending(void);
+int SUBSCRIBE_API_Attach(int fd, const char *pending, int len);
+int SUBSCRIBE_API_Timeout(void);
+int SUBSCRIBE_API_Poll(void);
+void SUBSCRIBE_API_Close_All(void);
+#endif /* end of protection macro */
+/** @} */
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/ 
+
+/** 
+* @file subscribe_str.h
+* @addtogroup command_parser
+* @{
+*
+*  A sample command parser for the RoE Framer software modules.
+*
+******************************************************************************/
+
+/**
+ * SUBSCRIBE_USAGE_STR Help text for the subscribe command.
+ */
+#define SUBSCRIBE_USAGE_STR "Usage \"subscribe <stats|radio|owdm> <period_ms>\", keeps the connection open and pushes the changed fields every <period_ms>\n"
+
+/**
+ * SUBSCRIBE_FULL_STR Response when no more connections may subscribe.
+ */
+#define SUBSCRIBE_FULL_STR "Too many subscribed connections, %d at most\n"
+
+/**
+ * SUBSCRIBE_OK_STR Response to a subscription, followed by the pushed lines.
+ */
+#define SUBSCRIBE_OK_STR "Subscribed to %s every %d ms\n"
+/** @} */
@@ -45,6 +45,7 @@ int template_func(int argc, char **argv)
 {
 	int count = 0;
 	int found = 0;
+	int ret = 0;
 	
 	if(argc < 2)
 	{
@@ -58,7 +59,7 @@ int template_func(int argc, char **argv)
 		{
 			found = 1;
 			/* Call the handler function for the command given */
-			template_cmds[count].func(argc-1, &argv[1]);
+			ret = template_cmds[count].func(argc-1, &argv[1]);
 		}
 	}
 	
@@ -68,5 +69,5 @@ int template_func(int argc, char **argv)
 		return(2);
 	}
 
-	return 0;
+	return ret;
 }
@@ -0,0 +1,73 @@
+#!/bin/sh
+#
+# Command line checks against a simulated daemon (xroe-app -s).
+#
+# Usage: tests/cli_test.sh [path to xroe-app] [port]
+#
+APP=${1:-./xroe-app}
+PORT=${2:-5999}
+TMP=$(mktemp -d)
+FAILED=0
+
+$APP -s -p $PORT >/dev/null 2>&1 &
+DAEMON=$!
+trap 'kill $DAEMON 2>/dev/null; rm -rf $TMP' EXIT
+sleep 1
+
+# expect <name> <exit status> <pattern or ""> <command...>
+expect()
+{
+	name=$1; want=$2; pattern=$3
+	shift 3
+	"$@" >$TMP/out 2>&1
+	got=$?
+	if [ "$got" -ne "$want" ]; then
+		echo "FAIL: $name: exit status $got, expected $want"
+		cat $TMP/out
+		FAILED=1
+	elif [ -n "$pattern" ] && ! grep -q "$pattern" $TMP/out; then
+		echo "FAIL: $name: no \"$pattern\" in output"
+		cat $TMP/out
+		FAILED=1
+	else
+		echo "PASS: $name"
+	fi
+}
+
+# A failing subcommand stops a script run with --stop-on-error
+printf 'framing set_fram 0 bogus 1\nstats user\n' >$TMP/script
+expect "script stops on failing subcommand" 1 "Stopped after 1 of 2 commands" \
+	$APP -n 127.0.0.1 -p $PORT -E -f $TMP/script
+
+# Scripts are only taken from XROE_SCRIPT_DIR
+expect "script outside the script directory" 1 "not a script name" \
+	$APP -n 127.0.0.1 -p $PORT -c "script ../etc/passwd"
+expect "missing script" 1 "No such file" \
+	$APP -n 127.0.0.1 -p $PORT -c "script no-such-script"
+
+# -c exits non-zero when a subcommand fails, or with no daemon to ask
+expect "-c failing subcommand" 1 "Register bogus not found" \
+	$APP -n 127.0.0.1 -p $PORT -c "framing set_fram 0 bogus 1"
+expect "-c succeeding subcommand" 0 "data_pc_id:0x" \
+	$APP -n 127.0.0.1 -p $PORT -c "framing get_fram 0 data_pc_id"
+expect "-f without daemon" 1 "" \
+	$APP -n 127.0.0.1 -p $((PORT + 1)) -f $TMP/script
+
+# Register access errors are reported rather than read back as zero
+expect "get_fram out of range antenna fails" 1 "access failed" \
+	$APP -n 127.0.0.1 -p $PORT -c "framing get_fram 99999 data_pc_id"
+expect "set_defr out of range antenna fails" 1 "access failed" \
+	$APP -n 127.0.0.1 -p $PORT -c "framing set_defr 99999 data_pc_id 1"
+
+# The register cache is refused for a layout without cacheable registers
+expect "cache on with V1_0 layout" 0 "" \
+	$APP -n 127.0.0.1 -p $PORT -c "framing cache on"
+$APP -n 127.0.0.1 -p $PORT -c "ip poke 0 0x02020000" >/dev/null
+expect "V2_2 layout detected" 0 "layout V2_2" \
+	$APP -n 127.0.0.1 -p $PORT -c "ip version"
+expect "cache off with V2_2 layout" 0 "cache:off" \
+	$APP -n 127.0.0.1 -p $PORT -c "framing cache"
+expect "cache on refused with V2_2 layout" 1 "Cache on failed" \
+	$APP -n 127.0.0.1 -p $PORT -c "framing cache on"
+
+exit $FAILED
@@ -0,0 +1,287 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file uring.c
+* @addtogroup comms_lib
+* @{
+*
+*  Minimal io_uring instance, on the raw system calls
+*
+*  The submission and completion rings are shared with the kernel: the
+*  tails written here are published with release stores, and the tails
+*  written by the kernel read with acquire loads.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <uring.h>
+
+/*****************************************************************************/
+/**
+*
+* Sets up an io_uring instance.
+*
+* @param [out]	ring      Instance.
+* @param [in]	entries   Number of submission entries, a power of 2.
+*
+* @return
+*		- 0 on success
+*		- errno value if the kernel has no io_uring, or it is disabled
+*
+******************************************************************************/
+int uring_init(uring_t *ring, unsigned entries)
+{
+	struct io_uring_params params;
+	int err;
+
+	memset(ring, 0, sizeof(*ring));
+	memset(&params, 0, sizeof(params));
+	ring->Fd = syscall(__NR_io_uring_setup, entries, &params);
+	if(ring->Fd < 0)
+	{
+		ring->Fd = -1;
+		return errno;
+	}
+
+	ring->SqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring->CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	ring->SqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	ring->SqRing = mmap(NULL, ring->SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+	                    ring->Fd, IORING_OFF_SQ_RING);
+	ring->CqRing = mmap(NULL, ring->CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+	                    ring->Fd, IORING_OFF_CQ_RING);
+	ring->Sqes = mmap(NULL, ring->SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+	                  ring->Fd, IORING_OFF_SQES);
+	if((ring->SqRing == MAP_FAILED) || (ring->CqRing == MAP_FAILED) || (ring->Sqes == MAP_FAILED))
+	{
+		err = errno;
+		uring_exit(ring);
+		return err;
+	}
+
+	ring->SqHead = (unsigned *)((char *)ring->SqRing + params.sq_off.head);
+	ring->SqTail = (unsigned *)((char *)ring->SqRing + params.sq_off.tail);
+	ring->SqMask = (unsigned *)((char *)ring->SqRing + params.sq_off.ring_mask);
+	ring->SqArray = (unsigned *)((char *)ring->SqRing + params.sq_off.array);
+	ring->SqEntries = params.sq_entries;
+	ring->SqLocalTail = *ring->SqTail;
+	ring->CqHead = (unsigned *)((char *)ring->CqRing + params.cq_off.head);
+	ring->CqTail = (unsigned *)((char *)ring->CqRing + params.cq_off.tail);
+	ring->CqMask = (unsigned *)((char *)ring->CqRing + params.cq_off.ring_mask);
+	ring->Cqes = (struct io_uring_cqe *)((char *)ring->CqRing + params.cq_off.cqes);
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Tears down an io_uring instance, also unregistering its files and buffers.
+*
+* @param [in,out]	ring   Instance, set up or not.
+*
+******************************************************************************/
+void uring_exit(uring_t *ring)
+{
+	if(ring->Sqes && (ring->Sqes != MAP_FAILED))
+	{
+		munmap(ring->Sqes, ring->SqesSize);
+	}
+	if(ring->CqRing && (ring->CqRing != MAP_FAILED))
+	{
+		munmap(ring->CqRing, ring->CqRingSize);
+	}
+	if(ring->SqRing && (ring->SqRing != MAP_FAILED))
+	{
+		munmap(ring->SqRing, ring->SqRingSize);
+	}
+	if(ring->Fd >= 0)
+	{
+		close(ring->Fd);
+	}
+	memset(ring, 0, sizeof(*ring));
+	ring->Fd = -1;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the next free submission entry, cleared.
+*
+* @param [in,out]	ring   Instance.
+*
+* @return
+*		- Entry, submitted by the next uring_submit_and_wait()
+*		- NULL if the submission ring is full
+*
+******************************************************************************/
+struct io_uring_sqe *uring_get_sqe(uring_t *ring)
+{
+	unsigned head = __atomic_load_n(ring->SqHead, __ATOMIC_ACQUIRE);
+	struct io_uring_sqe *pSqe;
+	unsigned index;
+
+	if(ring->SqLocalTail - head >= ring->SqEntries)
+	{
+		return NULL;
+	}
+
+	index = ring->SqLocalTail & *ring->SqMask;
+	pSqe = &ring->Sqes[index];
+	memset(pSqe, 0, sizeof(*pSqe));
+	ring->SqArray[index] = index;
+	ring->SqLocalTail++;
+	return pSqe;
+}
+
+/*****************************************************************************/
+/**
+*
+* Submits the entries prepared, and waits for a number of completions.
+*
+* @param [in,out]	ring   Instance.
+* @param [in]		wait   Number of completions to wait for, 0 for none.
+*
+* @return
+*		- Number of entries submitted
+*		- -errno value on error
+*
+******************************************************************************/
+int uring_submit_and_wait(uring_t *ring, unsigned wait)
+{
+	unsigned submit = ring->SqLocalTail - *ring->SqTail;
+	int ret;
+
+	__atomic_store_n(ring->SqTail, ring->SqLocalTail, __ATOMIC_RELEASE);
+	do
+	{
+		ret = syscall(__NR_io_uring_enter, ring->Fd, submit, wait, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+	} while((ret < 0) && (errno == EINTR));
+
+	return (ret < 0) ? -errno : ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the oldest completion not seen yet.
+*
+* @param [in]	ring   Instance.
+*
+* @return
+*		- Completion, valid until uring_cqe_seen()
+*		- NULL if there is none
+*
+******************************************************************************/
+struct io_uring_cqe *uring_peek_cqe(uring_t *ring)
+{
+	unsigned head = *ring->CqHead;
+
+	if(head == __atomic_load_n(ring->CqTail, __ATOMIC_ACQUIRE))
+	{
+		return NULL;
+	}
+	return &ring->Cqes[head & *ring->CqMask];
+}
+
+/*****************************************************************************/
+/**
+*
+* Hands the oldest completion back to the kernel.
+*
+* @param [in,out]	ring   Instance.
+*
+******************************************************************************/
+void uring_cqe_seen(uring_t *ring)
+{
+	__atomic_store_n(ring->CqHead, *ring->CqHead + 1, __ATOMIC_RELEASE);
+}
+
+/*****************************************************************************/
+/**
+*
+* Registers a table of files, used with IOSQE_FIXED_FILE by their index.
+*
+* @param [in,out]	ring   Instance.
+* @param [in]		fds    Files, -1 for entries set later.
+* @param [in]		num    Number of files.
+*
+* @return
+*		- 0 on success
+*		- errno value otherwise
+*
+******************************************************************************/
+int uring_register_files(uring_t *ring, const int *fds, unsigned num)
+{
+	if(syscall(__NR_io_uring_register, ring->Fd, IORING_REGISTER_FILES, fds, num) < 0)
+	{
+		return errno;
+	}
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Replaces entries of the registered file table.
+*
+* @param [in,out]	ring     Instance.
+* @param [in]		offset   First entry.
+* @param [in]		fds      Files, -1 to clear an entry.
+* @param [in]		num      Number of entries.
+*
+* @return
+*		- 0 on success
+*		- errno value otherwise
+*
+******************************************************************************/
+int uring_update_files(uring_t *ring, unsigned offset, int *fds, unsigned num)
+{
+	struct io_uring_files_update update;
+
+	memset(&update, 0, sizeof(update));
+	update.offset = offset;
+	update.fds = (unsigned long)fds;
+	if(syscall(__NR_io_uring_register, ring->Fd, IORING_REGISTER_FILES_UPDATE, &update, num) < 0)
+	{
+		return errno;
+	}
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Registers buffers, used by IORING_OP_READ_FIXED by their index.
+*
+* @param [in,out]	ring   Instance.
+* @param [in]		iov    Buffers.
+* @param [in]		num    Number of buffers.
+*
+* @return
+*		- 0 on success
+*		- errno value otherwise
+*
+******************************************************************************/
+int uring_register_buffers(uring_t *ring, const struct iovec *iov, unsigned num)
+{
+	if(syscall(__NR_io_uring_register, ring->Fd, IORING_REGISTER_BUFFERS, iov, num) < 0)
+	{
+		return errno;
+	}
+	return 0;
+}
+/** @} */
@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file uring.h
+* @addtogroup comms_lib
+* @{
+*
+*  Minimal io_uring instance, on the raw system calls
+*
+*  Just enough to prepare a batch of requests, submit them with one system
+*  call, wait for their completions and register files and buffers. A ring
+*  is used by one thread at a time.
+*
+******************************************************************************/
+#ifndef URING_H		/* prevent circular inclusions */
+#define URING_H		/* by using protection macros */
+
+#include <stddef.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+/**
+ * uring_t State of an io_uring instance.
+ */
+typedef struct uring_struct{
+	int Fd;                          /**< -1 if not set up */
+	unsigned *SqHead;
+	unsigned *SqTail;
+	unsigned *SqMask;
+	unsigned *SqArray;
+	struct io_uring_sqe *Sqes;
+	unsigned SqLocalTail;            /**< Entries prepared, not submitted */
+	unsigned SqEntries;
+	unsigned *CqHead;
+	unsigned *CqTail;
+	unsigned *CqMask;
+	struct io_uring_cqe *Cqes;
+	void *SqRing;
+	size_t SqRingSize;
+	void *CqRing;
+	size_t CqRingSize;
+	size_t SqesSize;
+} uring_t;
+
+/************************** Function Prototypes ******************************/
+int uring_init(uring_t *ring, unsigned entries);
+void uring_exit(uring_t *ring);
+struct io_uring_sqe *uring_get_sqe(uring_t *ring);
+int uring_submit_and_wait(uring_t *ring, unsigned wait);
+struct io_uring_cqe *uring_peek_cqe(uring_t *ring);
+void uring_cqe_seen(uring_t *ring);
+int uring_register_files(uring_t *ring, const int *fds, unsigned num);
+int uring_update_files(uring_t *ring, unsigned offset, int *fds, unsigned num);
+int uring_register_buffers(uring_t *ring, const struct iovec *iov, unsigned num);
+#endif /* end of protection macro */
+/** @} */
@@ -0,0 +1,440 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file workers.c
+* @addtogroup command_parser
+* @{
+*
+*  Pool of threads running the commands
+*
+*  Jobs move from the free list to the pending queue when submitted, are
+*  taken by a thread, and go to the done queue when the command returns.
+*  The done queue is drained by the main loop, woken by an eventfd, so that
+*  replies are only ever sent from the main loop.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <syslog.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+#include <comms.h>
+#include <parser.h>
+#include <bin_proto.h>
+#include <workers.h>
+
+/**
+ * workers_job_struct A command, or binary request, and its reply.
+ */
+typedef struct workers_job_struct{
+	void *Context;                       /**< Given back with the reply */
+	int Length;                          /**< Bytes of a binary request, 0 for a command */
+	char Command[MAX_RESPONSE_LENGTH];
+	response_t Response;
+} workers_job_struct;
+
+/**
+ * workers_queue_struct Ring of jobs.
+ */
+typedef struct workers_queue_struct{
+	workers_job_struct *Jobs[WORKERS_MAX_JOBS];
+	int Head;
+	int Count;
+} workers_queue_struct;
+
+/**
+ * workers_struct State of the pool.
+ */
+typedef struct workers_struct{
+	int NumThreads;     /**< 0 when not started */
+	int Nohw;
+	int Stopping;
+	int EventFd;
+	int InUse;          /**< Jobs submitted and not completed yet */
+	pthread_t Threads[WORKERS_MAX_THREADS];
+	pthread_mutex_t Lock;
+	pthread_cond_t Wake;
+	workers_queue_struct Pending;
+	workers_queue_struct Done;
+	workers_job_struct JobStore[WORKERS_MAX_JOBS];
+	workers_job_struct *Free[WORKERS_MAX_JOBS];
+	int NumFree;
+} workers_struct;
+
+/**
+ * Workers Worker pool state.
+ */
+static workers_struct Workers = {
+	.EventFd = -1,
+	.Lock = PTHREAD_MUTEX_INITIALIZER,
+	.Wake = PTHREAD_COND_INITIALIZER
+};
+
+/*****************************************************************************/
+/**
+*
+* Adds a job at the end of a queue, which has room for all jobs.
+*
+* @param [in]	pQueue  Queue.
+* @param [in]	pJob    Job.
+*
+******************************************************************************/
+static void workers_push(workers_queue_struct *pQueue, workers_job_struct *pJob)
+{
+	pQueue->Jobs[(pQueue->Head + pQueue->Count) % WORKERS_MAX_JOBS] = pJob;
+	pQueue->Count++;
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes the job at the front of a queue.
+*
+* @param [in]	pQueue  Queue.
+*
+* @return
+*		- Job
+*		- NULL if the queue is empty
+*
+******************************************************************************/
+static workers_job_struct *workers_pop(workers_queue_struct *pQueue)
+{
+	workers_job_struct *pJob;
+
+	if(!pQueue->Count)
+	{
+		return NULL;
+	}
+
+	pJob = pQueue->Jobs[pQueue->Head];
+	pQueue->Head = (pQueue->Head + 1) % WORKERS_MAX_JOBS;
+	pQueue->Count--;
+	return pJob;
+}
+
+/*****************************************************************************/
+/**
+*
+* Runs the pending commands until the pool is stopped.
+*
+* @param [in]	arg     Unused.
+*
+* @return
+*		- NULL
+*
+******************************************************************************/
+static void *workers_thread(void *arg)
+{
+	workers_job_struct *pJob;
+	uint64_t one = 1;
+
+	(void)arg;
+
+	pthread_mutex_lock(&Workers.Lock);
+	while(!Workers.Stopping)
+	{
+		pJob = workers_pop(&Workers.Pending);
+		if(!pJob)
+		{
+			pthread_cond_wait(&Workers.Wake, &Workers.Lock);
+			continue;
+		}
+		pthread_mutex_unlock(&Workers.Lock);
+
+		if(pJob->Length)
+		{
+			proto_bin_handle((uint8_t *)pJob->Command, &pJob->Response);
+		}
+		else
+		{
+			parse_command(Workers.Nohw, pJob->Command, &pJob->Response);
+		}
+
+		pthread_mutex_lock(&Workers.Lock);
+		workers_push(&Workers.Done, pJob);
+		if(write(Workers.EventFd, &one, sizeof(one)) < 0)
+		{
+			syslog(LOG_ERR, "Failed to signal a finished command\n");
+		}
+	}
+	pthread_mutex_unlock(&Workers.Lock);
+
+	return NULL;
+}
+
+/*****************************************************************************/
+/**
+*
+* Starts the threads running the commands.
+*
+* @param [in]	num_threads Number of threads, up to WORKERS_MAX_THREADS.
+* @param [in]	nohw        Passed to parse_command().
+*
+* @return
+*		- 0 on success
+*		- EINVAL on a number of threads out of range
+*		- EALREADY if the pool is running
+*		- errno of the failing call otherwise, no thread is left running
+*
+******************************************************************************/
+int WORKERS_API_Start(int num_threads, int nohw)
+{
+	int ret;
+	int i;
+
+	if((num_threads < 1) || (num_threads > WORKERS_MAX_THREADS))
+	{
+		return EINVAL;
+	}
+	if(Workers.NumThreads)
+	{
+		return EALREADY;
+	}
+
+	Workers.EventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(Workers.EventFd < 0)
+	{
+		return errno;
+	}
+
+	Workers.Nohw = nohw;
+	Workers.Stopping = 0;
+	Workers.InUse = 0;
+	memset(&Workers.Pending, 0, sizeof(Workers.Pending));
+	memset(&Workers.Done, 0, sizeof(Workers.Done));
+	for(i = 0; i < WORKERS_MAX_JOBS; i++)
+	{
+		resp_reset(&Workers.JobStore[i].Response);
+		Workers.Free[i] = &Workers.JobStore[i];
+	}
+	Workers.NumFree = WORKERS_MAX_JOBS;
+
+	for(i = 0; i < num_threads; i++)
+	{
+		ret = pthread_create(&Workers.Threads[i], NULL, workers_thread, NULL);
+		if(ret)
+		{
+			syslog(LOG_ERR, "Failed to start command thread: %s\n", strerror(ret));
+			Workers.NumThreads = i;
+			WORKERS_API_Stop();
+			return ret;
+		}
+	}
+	Workers.NumThreads = num_threads;
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Stops the threads once the commands they are running return. Commands
+* still queued are dropped without a reply.
+*
+******************************************************************************/
+void WORKERS_API_Stop(void)
+{
+	int i;
+
+	pthread_mutex_lock(&Workers.Lock);
+	Workers.Stopping = 1;
+	pthread_cond_broadcast(&Workers.Wake);
+	pthread_mutex_unlock(&Workers.Lock);
+
+	for(i = 0; i < Workers.NumThreads; i++)
+	{
+		pthread_join(Workers.Threads[i], NULL);
+	}
+	Workers.NumThreads = 0;
+
+	if(Workers.EventFd >= 0)
+	{
+		close(Workers.EventFd);
+		Workers.EventFd = -1;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the descriptor readable when finished commands are waiting for
+* WORKERS_API_Complete().
+*
+* @return
+*		- eventfd descriptor
+*		- -1 when the pool is not running
+*
+******************************************************************************/
+int WORKERS_API_Event_Fd(void)
+{
+	return Workers.EventFd;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns whether a command can be submitted now.
+*
+* @return
+*		- 1 if WORKERS_MAX_JOBS commands are queued or running
+*		- 0 otherwise, or when the pool is not running
+*
+******************************************************************************/
+int WORKERS_API_Full(void)
+{
+	return Workers.NumThreads && (Workers.InUse == WORKERS_MAX_JOBS);
+}
+
+/*****************************************************************************/
+/**
+*
+* Queues a command string or binary request to be run by a thread of the pool.
+*
+* @param [in]	data    Command string, or binary request.
+* @param [in]	length  Bytes of the binary request, 0 for a command string.
+* @param [in]	context Given back to the done callback with the reply.
+*
+* @return
+*		- 0 if queued
+*		- ENODEV when the pool is not running
+*		- EBUSY if WORKERS_MAX_JOBS commands are queued or running
+*
+******************************************************************************/
+static int workers_submit(const void *data, int length, void *context)
+{
+	workers_job_struct *pJob;
+
+	if(!Workers.NumThreads)
+	{
+		return ENODEV;
+	}
+
+	pthread_mutex_lock(&Workers.Lock);
+	if(!Workers.NumFree)
+	{
+		pthread_mutex_unlock(&Workers.Lock);
+		return EBUSY;
+	}
+	pJob = Workers.Free[--Workers.NumFree];
+	Workers.InUse++;
+
+	pJob->Context = context;
+	pJob->Length = length;
+	if(length)
+	{
+		memcpy(pJob->Command, data, length);
+	}
+	else
+	{
+		strncpy(pJob->Command, data, MAX_RESPONSE_LENGTH - 1);
+		pJob->Command[MAX_RESPONSE_LENGTH - 1] = 0;
+	}
+	workers_push(&Workers.Pending, pJob);
+	pthread_cond_signal(&Workers.Wake);
+	pthread_mutex_unlock(&Workers.Lock);
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Queues a command to be run by a thread of the pool.
+*
+* @param [in]	command Command string.
+* @param [in]	context Given back to the done callback with the reply.
+*
+* @return
+*		- 0 if queued
+*		- ENODEV when the pool is not running
+*		- EBUSY if WORKERS_MAX_JOBS commands are queued or running
+*
+******************************************************************************/
+int WORKERS_API_Submit(const char *command, void *context)
+{
+	return workers_submit(command, 0, context);
+}
+
+/*****************************************************************************/
+/**
+*
+* Queues a binary request, see xroe_bin.h, to be run by a thread of the pool.
+*
+* @param [in]	frame   Request, of the length given by proto_bin_frame_length().
+* @param [in]	length  Bytes of the request.
+* @param [in]	context Given back to the done callback with the reply.
+*
+* @return
+*		- 0 if queued
+*		- EINVAL if the request is empty or longer than a command
+*		- ENODEV when the pool is not running
+*		- EBUSY if WORKERS_MAX_JOBS commands are queued or running
+*
+******************************************************************************/
+int WORKERS_API_Submit_Binary(const uint8_t *frame, int length, void *context)
+{
+	if((length <= 0) || (length > MAX_RESPONSE_LENGTH))
+	{
+		return EINVAL;
+	}
+
+	return workers_submit(frame, length, context);
+}
+
+/*****************************************************************************/
+/**
+*
+* Hands the replies of the finished commands to a callback, in the order the
+* commands finished. Called from the main loop.
+*
+* @param [in]	done    Callback given the context and reply of each command.
+*
+* @return
+*		- Number of commands completed
+*
+******************************************************************************/
+int WORKERS_API_Complete(workers_done_t done)
+{
+	workers_job_struct *pJob;
+	uint64_t count;
+	int num = 0;
+
+	if(Workers.EventFd < 0)
+	{
+		return 0;
+	}
+
+	/* Clear the event first, so that a reply finished meanwhile sets it again */
+	if(read(Workers.EventFd, &count, sizeof(count)) < 0)
+	{
+		count = 0;
+	}
+
+	pthread_mutex_lock(&Workers.Lock);
+	while((pJob = workers_pop(&Workers.Done)) != NULL)
+	{
+		pthread_mutex_unlock(&Workers.Lock);
+		done(pJob->Context, &pJob->Response);
+		resp_reset(&pJob->Response);
+		num++;
+		pthread_mutex_lock(&Workers.Lock);
+		Workers.Free[Workers.NumFree++] = pJob;
+		Workers.InUse--;
+	}
+	pthread_mutex_unlock(&Workers.Lock);
+
+	return num;
+}
+/** @} */
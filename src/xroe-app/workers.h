@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file workers.h
+* @addtogroup command_parser
+* @{
+*
+*  Pool of threads running the commands
+*
+*  Commands taken by the main loop are queued to a fixed number of threads,
+*  so that a command making many register or sysfs accesses does not hold up
+*  the connections and timers of the main loop. Finished commands are handed
+*  back to the main loop, which sends their replies.
+*
+******************************************************************************/
+#ifndef WORKERS_H		/* prevent circular inclusions */
+#define WORKERS_H		/* by using protection macros */
+
+#include <stdint.h>
+#include <response.h>
+
+/* Number of threads started by default, 0 runs the commands in the main loop */
+#define WORKERS_DEFAULT_THREADS 4
+
+/* Largest number of threads */
+#define WORKERS_MAX_THREADS 16
+
+/* Number of commands queued or running at the same time */
+#define WORKERS_MAX_JOBS 64
+
+/**
+ * workers_done_t Called from the main loop for each finished command.
+ */
+typedef void (*workers_done_t)(void *context, response_t *response);
+
+/************************** Function Prototypes ******************************/
+int WORKERS_API_Start(int num_threads, int nohw);
+void WORKERS_API_Stop(void);
+int WORKERS_API_Event_Fd(void);
+int WORKERS_API_Full(void);
+int WORKERS_API_Submit(const char *command, void *context);
+int WORKERS_API_Submit_Binary(const uint8_t *frame, int length, void *context);
+int WORKERS_API_Complete(workers_done_t done);
+#endif /* end of protection macro */
+/** @} */
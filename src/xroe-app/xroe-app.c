@@ -54,6 +54,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <signal.h>
 #include <string.h>
 #include <sys/socket.h>
@@ -71,8 +72,15 @@
 #include <parser.h>
 
 #include "xroe_api.h"
-
-int radio_ctrl_update_values(void);
+#include "xroe_sim.h"
+#include "roe_framer_fields.h"
+#include "stats_sampler.h"
+#include "stats_shm.h"
+#include "subscribe.h"
+#include "buf_state.h"
+#include "workers.h"
+#include "ecpri_rt.h"
+#include "ecpri_proto.h"
 
 
 /**
@@ -82,6 +90,25 @@ int radio_ctrl_update_values(void);
 
 char pid_path[30];
 
+/*****************************************************************************/
+/**
+*
+* Returns the earlier of two poll timeouts, where -1 waits forever.
+*
+* @param [in]  a   Timeout in ms, or -1
+* @param [in]  b   Timeout in ms, or -1
+* @return
+*  - The shorter timeout
+******************************************************************************/
+static int min_timeout(int a, int b)
+{
+  if(a < 0)
+  {
+    return b;
+  }
+  return ((b >= 0) && (b < a)) ? b : a;
+}
+
 /*****************************************************************************/
 /**
 *
@@ -190,10 +217,21 @@ static void skeleton_daemon(int port)
 * help text.
 * Other valid options are:
 * - d: daemonise the application
-* - s: soft mode, do not open UNIX socket or UDP socket for eCPRI messages
+* - s: soft mode, do not open UNIX socket or UDP socket for eCPRI messages,
+*      and use the simulated framer backend instead of the hardware
 * - n: connect to remote application at given IP address (requires -c)
 * - p: connect to given remote port (-c) or listen on the given port
 * - c: send command to listening application (UNIX socket by default)
+* - S: sample the framer statistics every given number of milliseconds
+* - m: serve OpenMetrics scrapes on the given TCP port
+* - P: publish the statistics in shared memory
+* - f: send the commands of a file to the listening application
+* - w: run the commands in the given number of threads, 0 in the main loop
+* - r: real-time settings of the eCPRI thread, "cpu=<n>,prio=<p>"
+* - u: batch the socket and stats sysfs reads with io_uring
+* - U: receive eCPRI on the given number of sockets and threads
+* - E, --stop-on-error: with -f, stop at the first command failing
+* - T, --timing: with -f, print the time taken by each command
 *
 * @param [in]  argc   Number of command-line arguments (including program name)
 * @param [in]  argv   Array of strings containg command-line arguments
@@ -205,7 +243,7 @@ static void skeleton_daemon(int port)
 ******************************************************************************/
 int main(int argc, char **argv)
 {
-  char response[MAX_RESPONSE_LENGTH];
+  response_t response;
   char command[MAX_RESPONSE_LENGTH];
   char eth_port_name[MAX_RESPONSE_LENGTH];
   int quit = 0;
@@ -216,6 +254,20 @@ int main(int argc, char **argv)
   int port = 0;
   int opt;
   int msg_to_parse = 0;
+  int sample_period = 0;
+  int metrics_port = 0;
+  int publish_shm = 0;
+  char *command_file = NULL;
+  int file_flags = 0;
+  int num_workers = WORKERS_DEFAULT_THREADS;
+  int use_uring = 0;
+  int ecpri_threads = 1;
+  int timeout;
+  static const struct option long_options[] = {
+    {"stop-on-error", no_argument, NULL, 'E'},
+    {"timing", no_argument, NULL, 'T'},
+    {NULL, 0, NULL, 0}
+  };
   
   // Initialise the ethernet 
   bzero(eth_port_name, sizeof(command));
@@ -249,7 +301,7 @@ int main(int argc, char **argv)
     exit(EXIT_FAILURE);
   }
   
-    while ((opt = getopt(argc, argv, "dsn:p:c:e:")) != -1) 
+    while ((opt = getopt_long(argc, argv, "dsn:p:c:e:S:m:Pf:w:r:uU:ET", long_options, NULL)) != -1) 
   {
         switch (opt) 
     {
@@ -274,17 +326,61 @@ int main(int argc, char **argv)
             bzero(eth_port_name, sizeof(eth_port_name));
             strncpy(eth_port_name, optarg, MAX_RESPONSE_LENGTH-1);
             break;
+        case 'S':
+            sample_period = atoi(optarg);
+            break;
+        case 'm':
+            metrics_port = atoi(optarg);
+            break;
+        case 'P':
+            publish_shm = 1;
+            break;
+        case 'f':
+            command_file = optarg;
+            break;
+        case 'w':
+            num_workers = atoi(optarg);
+            break;
+        case 'r':
+            if(ECPRI_RT_API_Configure(optarg))
+            {
+                printf(XROE_USAGE_STR);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'u':
+            use_uring = 1;
+            break;
+        case 'U':
+            ecpri_threads = atoi(optarg);
+            if((ecpri_threads < 1) || (ecpri_threads > ECPRI_PROTO_MAX_SOCKETS))
+            {
+                printf(XROE_USAGE_STR);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'E':
+            file_flags |= CLIENT_STOP_ON_ERROR;
+            break;
+        case 'T':
+            file_flags |= CLIENT_TIMING;
+            break;
         default: /* '?' */
             printf(XROE_USAGE_STR);
             exit(EXIT_FAILURE);
         }
     }
      
+  /* Command file streamed to daemon over one connection */
+  if(command_file)
+  {
+    exit(client_send_file(in_addr, port, command_file, file_flags) ? EXIT_FAILURE : EXIT_SUCCESS);
+  }
+
   /* Command line client used to talk to daemon */
   if(send_command)
   {
-    client_send_message(in_addr, port, command);
-    exit(0);
+    exit(client_send_message(in_addr, port, command) ? EXIT_FAILURE : EXIT_SUCCESS);
   }
 
   if(daemonise)
@@ -307,18 +403,85 @@ int main(int argc, char **argv)
     openlog ("xroe-appd", LOG_PID, LOG_USER);
   }
  
-  if(open_connections(nohw, port, eth_port_name)<0)
+  if(open_connections(nohw, port, eth_port_name, ecpri_threads)<0)
   {
     syslog(LOG_ERR, "Exiting on connection error\n");
     exit(EXIT_FAILURE);
   }
+
+  if(metrics_port && (open_metrics(metrics_port) < 0))
+  {
+    syslog(LOG_ERR, "Exiting on metrics port %d error\n", metrics_port);
+    exit(EXIT_FAILURE);
+  }
+
+  /* Falls back to one system call per socket without io_uring */
+  if(use_uring)
+  {
+    open_uring();
+  }
+
+  if(nohw)
+  {
+    /* No hardware, serve register and sysfs accesses from the simulator */
+    IP_API_Set_Backend(SIM_API_Backend());
+  }
+  else
+  {
+    /* Keep the framer device open and mapped for the life of the server */
+    IP_API_Open();
+  }
+
+  IP_API_Use_Uring(use_uring);
+
+  /* Pick the register layout matching the framer IP version */
+  XROE_FIELDS_Detect();
+
+  if(sample_period && SAMPLER_API_Start(sample_period))
+  {
+    syslog(LOG_ERR, "Invalid stats sampling period %d ms, sampler not started\n", sample_period);
+  }
+
+  if(publish_shm && SHM_API_Open())
+  {
+    syslog(LOG_ERR, "Statistics not published in shared memory\n");
+  }
+
+  if(num_workers && (WORKERS_API_Start(num_workers, nohw) || (open_workers() < 0)))
+  {
+    syslog(LOG_ERR, "Invalid number of command threads %d, commands run in the main loop\n", num_workers);
+    WORKERS_API_Stop();
+  }
   
+  resp_init(&response);
   while(!quit)
   {
     bzero(command, sizeof(command));
-    bzero(response, sizeof(response));
+    resp_reset(&response);
     
-    msg_to_parse = get_message(nohw, command);
+    /* Write back the register cache if its commit interval has expired */
+    IP_API_Cache_Poll();
+
+    /* Take a statistics sample if one is due */
+    SAMPLER_API_Poll();
+
+    /* Sample the deframer buffer states if due */
+    BUFSTATE_API_Poll();
+
+    /* Publish the statistics in shared memory if due */
+    SHM_API_Poll();
+
+    /* Push telemetry to the subscribed clients if due */
+    SUBSCRIBE_API_Poll();
+
+    /* Wait for a message until the first of the timers is due */
+    timeout = IP_API_Cache_Timeout();
+    timeout = min_timeout(timeout, SAMPLER_API_Timeout());
+    timeout = min_timeout(timeout, BUFSTATE_API_Timeout());
+    timeout = min_timeout(timeout, SHM_API_Timeout());
+    timeout = min_timeout(timeout, SUBSCRIBE_API_Timeout());
+
+    msg_to_parse = get_message(nohw, command, timeout);
     if(msg_to_parse == 0)
     {
       /* Message already dealt with internally (eCPRI) */
@@ -329,17 +492,26 @@ int main(int argc, char **argv)
       /* Deal with error? */
       quit = 1;
     }
-    else if(parse_command(nohw, command, response) < 0)
+    else if(!parse_command_is_inline(command) && !dispatch_command(command))
+    {
+      /* Answered by send_response() once a worker thread has run it */
+      continue;
+    }
+    else if(parse_command(nohw, command, &response) < 0)
     {
       quit = 1;
     }
     else
     {
-      send_response(response);
+      send_response(&response);
     }
   }
  
+  resp_reset(&response);
+  WORKERS_API_Stop();
   close_connections(nohw);
+  SHM_API_Close();
+  IP_API_Close();
   syslog(LOG_NOTICE, "xroe-app terminated.");
   closelog();
   unlink(pid_path);
@@ -16,205 +16,1838 @@
 ******************************************************************************/
 
 /***************************** Include Files *********************************/
+#define _GNU_SOURCE /* PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <errno.h>
+#include <time.h>
+#include <pthread.h>
 #include <syslog.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <roe_framer_ctrl.h>
+#include <xroe_api.h>
+#include <uring.h>
 
 /* Maximum allowed length of sysfs path */
 #define XROE_MAX_SYSPATH_LENGTH 1024
 
+/* Most stats sysfs entries of a port kept open by STATS_SYSFS_API_Read_Counters() */
+#define XROE_STATS_FILES_MAX 32
+
+/* Size of the buffer a stats sysfs value is read into */
+#define XROE_STATS_VALUE_LENGTH 32
+
+/* Framer IP device node */
+#define XROE_IP_DEV_NAME "/dev/xroe/ip"
+
+/* Size of the framer register window (0x0-0xFFFF) mapped by IP_API_Open() */
+#define XROE_IP_MAP_SIZE 0x10000
+
 /* IOCTL commands */
 /* Use 0xF5 as magic number */
 #define XROE_FRAMER_MAGIC_NUMBER  0xF5
 
 #define XROE_FRAMER_IOSET		_IOW(XROE_FRAMER_MAGIC_NUMBER,  0, uint32_t)
 #define XROE_FRAMER_IOGET 	_IOR(XROE_FRAMER_MAGIC_NUMBER,  1, uint32_t)
+#define XROE_FRAMER_IOBATCH	_IOWR(XROE_FRAMER_MAGIC_NUMBER, 2, struct ioctl_batch_arguments)
+
+struct ioctl_arguments {
+         uint32_t *offset;
+         uint32_t *value;
+ };
+
+/* Layout must match struct xroe_reg_batch in the framer driver */
+struct ioctl_batch_arguments {
+	uint64_t ops;
+	uint32_t num_ops;
+	uint32_t reserved;
+};
+
+/**
+ * ip_dev_fd Persistent framer device file descriptor, -1 when not opened.
+ */
+static int ip_dev_fd = -1;
+
+/**
+ * ip_dev_regs Framer register window mapped into the process, NULL if the
+ * device could not be mapped.
+ */
+static volatile uint32_t *ip_dev_regs = NULL;
+
+/**
+ * ip_dev_batch_unsupported Set once the driver has rejected XROE_FRAMER_IOBATCH
+ * so that later batches go straight to the per-operation fallback.
+ */
+static int ip_dev_batch_unsupported = 0;
+
+/**
+ * IpBackend Device backend replacing the framer device and sysfs, NULL to
+ * use the hardware.
+ */
+static const xroe_backend_t *IpBackend = NULL;
+
+/* Number of 32-bit words in the framer register window */
+#define XROE_CACHE_WORDS (XROE_IP_MAP_SIZE >> 2)
+
+/* Bitmap helpers for the shadow cache valid and dirty maps */
+#define XROE_CACHE_TEST(map, i)		((map)[(i) >> 5] & (1U << ((i) & 0x1F)))
+#define XROE_CACHE_SET(map, i)		((map)[(i) >> 5] |= (1U << ((i) & 0x1F)))
+#define XROE_CACHE_CLEAR(map, i)	((map)[(i) >> 5] &= ~(1U << ((i) & 0x1F)))
+
+/**
+ * ip_cache_struct Write-back shadow cache of the framer configuration registers.
+ */
+typedef struct ip_cache_struct{
+	int Enabled;
+	const xroe_reg_range_t *Ranges; /**< Cacheable registers of the register layout */
+	int NumRanges;
+	int IntervalMs;
+	int DirtyCount;
+	struct timespec DirtySince;
+	uint32_t Words[XROE_CACHE_WORDS];
+	uint32_t Valid[XROE_CACHE_WORDS / 32];
+	uint32_t Dirty[XROE_CACHE_WORDS / 32];
+} ip_cache_struct;
+
+/**
+ * IpCache Shadow cache variable, disabled until IP_API_Cache_Enable().
+ */
+static ip_cache_struct IpCache;
+
+/**
+ * IpLock Serialises the register accesses, the shadow cache and the device
+ * backend between threads. Recursive, as the API functions call each other.
+ */
+static pthread_mutex_t IpLock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+/**
+ * ip_stats_files_struct Stats sysfs entries kept open, each read again from
+ * offset 0 for a new value. With io_uring, the files and value buffers are
+ * registered and the entries of a port are read by one submission.
+ */
+typedef struct ip_stats_files_struct{
+	int UseUring;     /**< io_uring wanted, see IP_API_Use_Uring() */
+	int Uring;        /**< Ring set up, files and buffers registered */
+	uring_t Ring;
+	const char * const *Names; /**< Entries the files were opened for */
+	int NumNames;
+	int Opened[XROE_STATS_SNAPSHOT_MAX_PORTS];
+	int Fds[XROE_STATS_SNAPSHOT_MAX_PORTS][XROE_STATS_FILES_MAX];
+	char Values[XROE_STATS_SNAPSHOT_MAX_PORTS][XROE_STATS_FILES_MAX][XROE_STATS_VALUE_LENGTH];
+} ip_stats_files_struct;
+
+/**
+ * IpStatsFiles Open stats sysfs entries, protected by IpLock.
+ */
+static ip_stats_files_struct IpStatsFiles = {.Ring = {.Fd = -1}};
+
+/*****************************************************************************/
+/**
+*
+* Takes the lock serialising the framer accesses between threads, so that a
+* sequence of IP_API_* calls, or an access to a device backend's own state,
+* is not interleaved with those of other threads. May be nested.
+*
+******************************************************************************/
+void IP_API_Lock(void)
+{
+	pthread_mutex_lock(&IpLock);
+}
+
+/*****************************************************************************/
+/**
+*
+* Releases the lock taken by IP_API_Lock().
+*
+******************************************************************************/
+void IP_API_Unlock(void)
+{
+	pthread_mutex_unlock(&IpLock);
+}
+
+/*****************************************************************************/
+/**
+*
+* Opens the framer device once and maps its register window.
+* After a successful call the IP_API_* register functions use plain volatile
+* loads and stores on the mapped window. If the device cannot be mapped the
+* persistent descriptor is still kept for pread/pwrite/ioctl access. If the
+* device cannot be opened at all every call keeps opening the device itself.
+*
+* @return
+*		- 0 on success (mapped or descriptor only)
+*		- EIO on device open failure
+*
+******************************************************************************/
+int IP_API_Open(void)
+{
+	void *map;
+
+	if(ip_dev_fd >= 0 || IpBackend)
+	{
+		return 0;
+	}
+
+	ip_dev_fd = open(XROE_IP_DEV_NAME, O_RDWR | O_SYNC);
+	if(ip_dev_fd < 0)
+	{
+		syslog(LOG_NOTICE, "IP_API_Open: cannot open %s, using per-call access\n", XROE_IP_DEV_NAME);
+		return EIO;
+	}
+
+	map = mmap(NULL, XROE_IP_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, ip_dev_fd, 0);
+	if(map == MAP_FAILED)
+	{
+		syslog(LOG_NOTICE, "IP_API_Open: mmap of %s failed (%d), using ioctl access\n", XROE_IP_DEV_NAME, errno);
+		ip_dev_regs = NULL;
+	}
+	else
+	{
+		ip_dev_regs = (volatile uint32_t *)map;
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Closes the stats sysfs entries kept open, so that they are opened again
+* on the next read, and tears down their io_uring instance.
+*
+******************************************************************************/
+static void ip_stats_files_close(void)
+{
+	int port;
+	int i;
+
+	pthread_mutex_lock(&IpLock);
+	for(port = 0; port < XROE_STATS_SNAPSHOT_MAX_PORTS; port++)
+	{
+		for(i = 0; IpStatsFiles.Opened[port] && (i < IpStatsFiles.NumNames); i++)
+		{
+			if(IpStatsFiles.Fds[port][i] >= 0)
+			{
+				close(IpStatsFiles.Fds[port][i]);
+			}
+		}
+		IpStatsFiles.Opened[port] = 0;
+	}
+	if(IpStatsFiles.Uring)
+	{
+		uring_exit(&IpStatsFiles.Ring);
+		IpStatsFiles.Uring = 0;
+	}
+	IpStatsFiles.Names = NULL;
+	IpStatsFiles.NumNames = 0;
+	pthread_mutex_unlock(&IpLock);
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets up the io_uring instance reading the stats sysfs entries, with a
+* table of files and the value buffers registered. Called with IpLock held.
+*
+* @return
+*		- 0 on success
+*		- errno value otherwise
+*
+******************************************************************************/
+static int ip_stats_files_uring(void)
+{
+	int fds[XROE_STATS_SNAPSHOT_MAX_PORTS * XROE_STATS_FILES_MAX];
+	struct iovec iov;
+	unsigned i;
+	int err;
+
+	err = uring_init(&IpStatsFiles.Ring, XROE_STATS_FILES_MAX);
+	if(err)
+	{
+		return err;
+	}
+
+	for(i = 0; i < sizeof(fds) / sizeof(fds[0]); i++)
+	{
+		fds[i] = -1;
+	}
+	iov.iov_base = IpStatsFiles.Values;
+	iov.iov_len = sizeof(IpStatsFiles.Values);
+	err = uring_register_files(&IpStatsFiles.Ring, fds, sizeof(fds) / sizeof(fds[0]));
+	if(!err)
+	{
+		err = uring_register_buffers(&IpStatsFiles.Ring, &iov, 1);
+	}
+	if(err)
+	{
+		uring_exit(&IpStatsFiles.Ring);
+		return err;
+	}
+
+	IpStatsFiles.Uring = 1;
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Opens the stats sysfs entries of a port. Called with IpLock held.
+*
+* @param [in]  port   Ethernet port
+*
+* @return
+*		- 0 on success
+*		- -1 on open failure
+*
+******************************************************************************/
+static int ip_stats_files_open(int port)
+{
+	char syspath[XROE_MAX_SYSPATH_LENGTH];
+	int *fds = IpStatsFiles.Fds[port];
+	int err;
+	int i;
+
+	for(i = 0; i < IpStatsFiles.NumNames; i++)
+	{
+		fds[i] = -1;
+		if(!IpStatsFiles.Names[i])
+		{
+			continue;
+		}
+
+		snprintf(syspath, sizeof(syspath), "/sys/kernel/xroe/stats/eth_port_%d/%s", port, IpStatsFiles.Names[i]);
+		fds[i] = open(syspath, O_RDONLY | O_CLOEXEC);
+		if(fds[i] < 0)
+		{
+			while(i--)
+			{
+				if(fds[i] >= 0)
+				{
+					close(fds[i]);
+				}
+			}
+			return -1;
+		}
+	}
+
+	if(IpStatsFiles.Uring)
+	{
+		err = uring_update_files(&IpStatsFiles.Ring, port * XROE_STATS_FILES_MAX, fds, IpStatsFiles.NumNames);
+		if(err)
+		{
+			syslog(LOG_NOTICE, "%s:%d Stats files not registered (%d), reading them without io_uring\n", __FILE__, __LINE__, err);
+			uring_exit(&IpStatsFiles.Ring);
+			IpStatsFiles.Uring = 0;
+			IpStatsFiles.UseUring = 0;
+		}
+	}
+
+	IpStatsFiles.Opened[port] = 1;
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the open stats sysfs entries of a port with one io_uring
+* submission. The reads are not linked, as a value shorter than the buffer
+* would cancel the reads after it. Called with IpLock held.
+*
+* @param [in]  port   Ethernet port
+*
+* @return
+*		- 0 on success
+*		- -1 if the ring or a read failed, the entries are then to be read
+*		  without the ring to tell which
+*
+******************************************************************************/
+static int ip_stats_files_submit(int port)
+{
+	struct io_uring_sqe *pSqe;
+	struct io_uring_cqe *pCqe;
+	char *value;
+	int count = 0;
+	int ret = 0;
+	int i;
+
+	for(i = 0; i < IpStatsFiles.NumNames; i++)
+	{
+		if(IpStatsFiles.Fds[port][i] < 0)
+		{
+			continue;
+		}
+		pSqe = uring_get_sqe(&IpStatsFiles.Ring);
+		if(!pSqe)
+		{
+			return -1;
+		}
+		pSqe->opcode = IORING_OP_READ_FIXED;
+		pSqe->flags = IOSQE_FIXED_FILE;
+		pSqe->fd = port * XROE_STATS_FILES_MAX + i;
+		pSqe->addr = (unsigned long)IpStatsFiles.Values[port][i];
+		pSqe->len = XROE_STATS_VALUE_LENGTH - 1;
+		pSqe->off = 0;
+		pSqe->buf_index = 0;
+		pSqe->user_data = i;
+		count++;
+	}
+	if(!count)
+	{
+		return 0;
+	}
+	if(uring_submit_and_wait(&IpStatsFiles.Ring, count) != count)
+	{
+		return -1;
+	}
+
+	while(count--)
+	{
+		pCqe = uring_peek_cqe(&IpStatsFiles.Ring);
+		if(!pCqe)
+		{
+			/* Cannot happen once waited for, give up the ring */
+			return -1;
+		}
+		i = pCqe->user_data;
+		if(pCqe->res < 0)
+		{
+			ret = -1;
+		}
+		else
+		{
+			value = IpStatsFiles.Values[port][i];
+			value[pCqe->res] = 0;
+		}
+		uring_cqe_seen(&IpStatsFiles.Ring);
+	}
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Commits any pending shadow cache writes, then unmaps the framer register
+* window and closes the persistent descriptor and stats sysfs entries.
+* Subsequent IP_API_* calls fall back to opening the device on every call.
+*
+******************************************************************************/
+void IP_API_Close(void)
+{
+	IP_API_Cache_Commit();
+	ip_stats_files_close();
+
+	if(ip_dev_regs)
+	{
+		munmap((void *)ip_dev_regs, XROE_IP_MAP_SIZE);
+		ip_dev_regs = NULL;
+	}
+
+	if(ip_dev_fd >= 0)
+	{
+		close(ip_dev_fd);
+		ip_dev_fd = -1;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Selects whether the stats sysfs entries are read with io_uring, see
+* STATS_SYSFS_API_Read_Counters(). Without it, or when the kernel has no
+* io_uring, they are read one by one.
+*
+* @param [in]	enable  Non-zero to use io_uring
+*
+******************************************************************************/
+void IP_API_Use_Uring(int enable)
+{
+	ip_stats_files_close();
+	pthread_mutex_lock(&IpLock);
+	IpStatsFiles.UseUring = enable;
+	pthread_mutex_unlock(&IpLock);
+}
+
+/*****************************************************************************/
+/**
+*
+* Selects the device backend used for register and sysfs accesses.
+* Pending shadow cache writes are committed to the previous backend and the
+* cache is invalidated. The hardware device is closed when switching to a
+* backend.
+*
+* @param [in]	backend Backend to use, NULL for the framer hardware
+*
+* @return
+*		- 0 on success
+*		- EINVAL if backend is missing a required function
+*
+******************************************************************************/
+int IP_API_Set_Backend(const xroe_backend_t *backend)
+{
+	if(backend && (!backend->read_word || !backend->write_word ||
+		!backend->sysfs_read || !backend->sysfs_write))
+	{
+		return EINVAL;
+	}
+
+	IP_API_Close();
+	memset(IpCache.Valid, 0, sizeof(IpCache.Valid));
+	IpBackend = backend;
+
+	if(backend)
+	{
+		syslog(LOG_NOTICE, "IP_API_Set_Backend: using %s backend\n", backend->name);
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the device backend in use.
+*
+* @return
+*		- Backend set with IP_API_Set_Backend(), NULL for the framer hardware
+*
+******************************************************************************/
+const xroe_backend_t *IP_API_Get_Backend(void)
+{
+	return IpBackend;
+}
+
+/*****************************************************************************/
+/**
+*
+* Checks whether an access can be served from the mapped register window.
+*
+* @param [in]	addr   Address in framer address space (0 base)
+* @param [in]	length Number of bytes accessed
+*
+* @return
+*		- 1 if the whole access is 32-bit aligned and inside the window
+*		- 0 otherwise
+*
+******************************************************************************/
+static int ip_api_mapped(int addr, int length)
+{
+	return (ip_dev_regs != NULL) && (addr >= 0) && (length > 0) &&
+		((addr & 0x3) == 0) && ((length & 0x3) == 0) &&
+		((addr + length) <= XROE_IP_MAP_SIZE);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns a descriptor for the framer device.
+* Uses the persistent descriptor if IP_API_Open() succeeded, otherwise opens
+* the device. Release the descriptor with ip_api_release().
+*
+* @param [in]	flags  open() flags to use when opening the device
+*
+* @return
+*		- File descriptor on success
+*		- -1 on device open failure
+*
+******************************************************************************/
+static int ip_api_acquire(int flags)
+{
+	if(ip_dev_fd >= 0)
+	{
+		return ip_dev_fd;
+	}
+
+	return open(XROE_IP_DEV_NAME, flags);
+}
+
+/*****************************************************************************/
+/**
+*
+* Releases a descriptor obtained with ip_api_acquire().
+*
+* @param [in]	fd     File descriptor to release
+*
+******************************************************************************/
+static void ip_api_release(int fd)
+{
+	if(fd != ip_dev_fd)
+	{
+		close(fd);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads a whole 32-bit register from the framer, bypassing the shadow cache.
+*
+* @param [in]	addr   Address in framer address space (0 base) to read from
+* @param [out]	pRead  Pointer to use to store the register value
+*
+* @return
+*		- 0 on success
+*		- EIO on device open failure
+*		- ioctl() return value on ioctl() failure
+*
+******************************************************************************/
+static int ip_hw_read_word(int addr, uint32_t *pRead)
+{
+	int fd;
+	int ret = 0;
+	uint32_t buf;
+	struct ioctl_arguments args;
+
+	if(IpBackend)
+	{
+		return IpBackend->read_word(addr, pRead);
+	}
+
+	if(ip_api_mapped(addr, sizeof(buf)))
+	{
+		*pRead = ip_dev_regs[addr >> 2];
+		return 0;
+	}
+
+	fd=ip_api_acquire(O_WRONLY);
+
+	if(fd>=0)
+	{
+		args.offset = (uint32_t *)&addr;
+		args.value = &buf;
+
+		ret = ioctl(fd, XROE_FRAMER_IOGET, &args);
+		if(!ret)
+		{
+			*pRead = buf;
+		}
+
+		ip_api_release(fd);
+	}
+	else
+	{
+		ret = EIO;
+	}
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes a whole 32-bit register in the framer, bypassing the shadow cache.
+*
+* @param [in]	addr   Address in framer address space (0 base) to write to
+* @param [in]	Write  Register value to write
+*
+* @return
+*		- 0 on success
+*		- EIO on device open failure
+*		- ioctl() return value on ioctl() failure
+*
+******************************************************************************/
+static int ip_hw_write_word(int addr, uint32_t Write)
+{
+	int fd;
+	int ret = 0;
+	struct ioctl_arguments args;
+
+	if(IpBackend)
+	{
+		return IpBackend->write_word(addr, Write);
+	}
+
+	if(ip_api_mapped(addr, sizeof(Write)))
+	{
+		ip_dev_regs[addr >> 2] = Write;
+		return 0;
+	}
+
+	fd=ip_api_acquire(O_WRONLY);
+
+	if(fd>=0)
+	{
+		args.offset = (uint32_t *)&addr;
+		args.value = &Write;
+
+		ret = ioctl(fd, XROE_FRAMER_IOSET, &args);
+
+		ip_api_release(fd);
+	}
+	else
+	{
+		ret = EIO;
+	}
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Executes a single register operation directly on the framer.
+*
+* @param [in,out]	op     Operation to execute, reads store their result
+*
+* @return
+*		- 0 on success
+*		- EINVAL on unknown operation
+*		- Return value of ip_hw_read_word()/ip_hw_write_word() otherwise
+*
+******************************************************************************/
+static int ip_hw_single_op(xroe_reg_op_t *op)
+{
+	uint32_t buf = 0;
+	int ret;
+
+	switch(op->op)
+	{
+	case XROE_REG_OP_READ:
+		ret = ip_hw_read_word(op->addr, &buf);
+		if(!ret)
+		{
+			op->value = (buf & op->mask) >> op->offset;
+		}
+		break;
+	case XROE_REG_OP_WRITE:
+		ret = ip_hw_write_word(op->addr, (op->value << op->offset) & op->mask);
+		break;
+	case XROE_REG_OP_RMW:
+		ret = ip_hw_read_word(op->addr, &buf);
+		if(!ret)
+		{
+			buf &= ~op->mask;
+			buf |= (op->value << op->offset) & op->mask;
+			ret = ip_hw_write_word(op->addr, buf);
+		}
+		break;
+	default:
+		ret = EINVAL;
+		break;
+	}
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Executes a list of register operations directly on the framer.
+* The whole list is handed to the driver in a single XROE_FRAMER_IOBATCH
+* ioctl. If the driver does not support it the operations are executed one
+* at a time instead.
+*
+* @param [in,out]	ops     Array of operations, reads store their result
+* @param [in]		num_ops Number of operations in ops
+*
+* @return
+*		- 0 on success
+*		- EIO on device open failure
+*		- errno of the failed ioctl() otherwise
+*
+******************************************************************************/
+static int ip_hw_batch(xroe_reg_op_t *ops, int num_ops)
+{
+	struct ioctl_batch_arguments args;
+	int fd;
+	int ret = 0;
+	int i;
+
+	if(!ip_dev_batch_unsupported && !IpBackend)
+	{
+		fd = ip_api_acquire(O_RDWR);
+		if(fd < 0)
+		{
+			return EIO;
+		}
+
+		args.ops = (uint64_t)(uintptr_t)ops;
+		args.num_ops = num_ops;
+		args.reserved = 0;
+
+		ret = ioctl(fd, XROE_FRAMER_IOBATCH, &args);
+		if(ret)
+		{
+			ret = errno;
+		}
+		ip_api_release(fd);
+
+		if(ret != ENOTTY)
+		{
+			return ret;
+		}
+
+		syslog(LOG_NOTICE, "IP_API_Batch: batch ioctl not supported, using single register access\n");
+		ip_dev_batch_unsupported = 1;
+		ret = 0;
+	}
+
+	for(i = 0; i < num_ops && !ret; i++)
+	{
+		ret = ip_hw_single_op(&ops[i]);
+	}
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Checks whether a register can be held in the shadow cache.
+* Only the configuration registers given by IP_API_Cache_Set_Ranges() are
+* cacheable, status and counter registers are always accessed in the framer.
+*
+* @param [in]	addr   Address in framer address space (0 base)
+*
+* @return
+*		- 1 if the register is cacheable
+*		- 0 otherwise
+*
+******************************************************************************/
+static int ip_cache_cacheable(int addr)
+{
+	int i;
+
+	if(addr < 0 || (addr & 0x3) || addr >= XROE_IP_MAP_SIZE)
+	{
+		return 0;
+	}
+
+	for(i = 0; i < IpCache.NumRanges; i++)
+	{
+		if((uint32_t)addr >= IpCache.Ranges[i].start && (uint32_t)addr < IpCache.Ranges[i].end)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Looks up the shadow copy of a register.
+*
+* @param [in]	addr   Address in framer address space (0 base)
+* @param [in]	load   Non-zero to read the register from the framer on a miss
+* @param [out]	pWord  Set to the cached word, or NULL if the register is not
+*                      cached (cache disabled or register uncacheable)
+*
+* @return
+*		- 0 on success
+*		- Return value of ip_hw_read_word() if the register could not be loaded
+*
+******************************************************************************/
+static int ip_cache_lookup(int addr, int load, uint32_t **pWord)
+{
+	int index = addr >> 2;
+	int ret = 0;
+
+	*pWord = NULL;
+
+	if(!IpCache.Enabled || !ip_cache_cacheable(addr))
+	{
+		return 0;
+	}
+
+	if(load && !XROE_CACHE_TEST(IpCache.Valid, index))
+	{
+		ret = ip_hw_read_word(addr, &IpCache.Words[index]);
+		if(ret)
+		{
+			return ret;
+		}
+		XROE_CACHE_SET(IpCache.Valid, index);
+	}
+
+	*pWord = &IpCache.Words[index];
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Marks a cached register as valid and dirty.
+*
+* @param [in]	addr   Address in framer address space (0 base)
+*
+******************************************************************************/
+static void ip_cache_mark_dirty(int addr)
+{
+	int index = addr >> 2;
+
+	XROE_CACHE_SET(IpCache.Valid, index);
+	if(!XROE_CACHE_TEST(IpCache.Dirty, index))
+	{
+		if(!IpCache.DirtyCount)
+		{
+			clock_gettime(CLOCK_MONOTONIC, &IpCache.DirtySince);
+		}
+		XROE_CACHE_SET(IpCache.Dirty, index);
+		IpCache.DirtyCount++;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Drops the shadow copy of a register written behind the cache's back.
+*
+* @param [in]	addr   Address in framer address space (0 base)
+*
+******************************************************************************/
+static void ip_cache_invalidate(int addr)
+{
+	if(IpCache.Enabled && ip_cache_cacheable(addr))
+	{
+		XROE_CACHE_CLEAR(IpCache.Valid, addr >> 2);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads bytes from the framer address space, with IpLock held. See IP_API_Read().
+*
+******************************************************************************/
+static int ip_api_read(int addr, uint8_t *pRead, int length)
+{
+	int fd=0;
+	int read = 0;
+	int ret = 0;
+	int i;
+	uint32_t word;
+	uint32_t *cached;
+
+	if(IpCache.Enabled && (addr & 0x3) == 0 && (length & 0x3) == 0 && length > 0)
+	{
+		for(i = 0; i < length && ip_cache_cacheable(addr + i); i += 4);
+		if(i == length)
+		{
+			for(i = 0; i < length && !ret; i += 4)
+			{
+				ret = ip_cache_lookup(addr + i, 1, &cached);
+				if(!ret)
+				{
+					memcpy(pRead + i, cached, sizeof(*cached));
+				}
+			}
+			return ret;
+		}
+	}
+
+	ret = IP_API_Cache_Commit();
+	if(ret)
+	{
+		return ret;
+	}
+
+	if(IpBackend)
+	{
+		if((addr & 0x3) || (length & 0x3))
+		{
+			return EINVAL;
+		}
+		for(i = 0; i < length && !ret; i += 4)
+		{
+			ret = ip_hw_read_word(addr + i, &word);
+			if(!ret)
+			{
+				memcpy(pRead + i, &word, sizeof(word));
+			}
+		}
+		return ret;
+	}
+
+	if(ip_api_mapped(addr, length))
+	{
+		for(i = 0; i < length; i += 4)
+		{
+			word = ip_dev_regs[(addr + i) >> 2];
+			memcpy(pRead + i, &word, sizeof(word));
+		}
+		return 0;
+	}
+
+	fd=ip_api_acquire(O_RDONLY);
+
+	if(fd>=0)
+	{
+		/* Short or failed reads leave pRead partly unset */
+		read = pread(fd, pRead, length, addr);
+		if(read != length)
+		{
+			ret = EFAULT;
+		}
+
+		ip_api_release(fd);
+	}
+	else
+	{
+		ret = EIO;
+	}
+	
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads bytes from anywhere in the framer address space.
+* Reads bytes from the address given and writes them into pRead.
+* Uses the mapped register window if IP_API_Open() has succeeded.
+* If the shadow cache is enabled and every word read is cacheable the
+* values are taken from the cache, otherwise pending writes are committed
+* first.
+*
+* @param [in]	addr   Address in framer address space (0 base) to read from
+* @param [out]	pRead  Pointer to use to store output
+* @param [in]	length Number of bytes to read
+*
+* @return
+*		- 0 on success
+*		- EIO on device open failure
+*		- EFAULT on pread() failure
+*
+******************************************************************************/
+int IP_API_Read(int addr, uint8_t *pRead, int length)
+{
+	int ret;
+
+	pthread_mutex_lock(&IpLock);
+	ret = ip_api_read(addr, pRead, length);
+	pthread_mutex_unlock(&IpLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes bytes to the framer address space, with IpLock held. See IP_API_Write().
+*
+******************************************************************************/
+static int ip_api_write(int addr, uint8_t *pWrite, int length)
+{
+	int fd=0;
+	int write = 0;
+	int ret = 0;
+	int i;
+	uint32_t word;
+	uint32_t *cached;
+
+	if(IpCache.Enabled && (addr & 0x3) == 0 && (length & 0x3) == 0 && length > 0)
+	{
+		for(i = 0; i < length && ip_cache_cacheable(addr + i); i += 4);
+		if(i == length)
+		{
+			for(i = 0; i < length; i += 4)
+			{
+				ip_cache_lookup(addr + i, 0, &cached);
+				memcpy(cached, pWrite + i, sizeof(*cached));
+				ip_cache_mark_dirty(addr + i);
+			}
+			return 0;
+		}
+	}
+
+	ret = IP_API_Cache_Commit();
+	if(ret)
+	{
+		return ret;
+	}
+
+	for(i = 0; i < length; i += 4)
+	{
+		ip_cache_invalidate((addr & ~0x3) + i);
+	}
+
+	if(IpBackend)
+	{
+		if((addr & 0x3) || (length & 0x3))
+		{
+			return EINVAL;
+		}
+		for(i = 0; i < length && !ret; i += 4)
+		{
+			memcpy(&word, pWrite + i, sizeof(word));
+			ret = ip_hw_write_word(addr + i, word);
+		}
+		return ret;
+	}
+
+	if(ip_api_mapped(addr, length))
+	{
+		for(i = 0; i < length; i += 4)
+		{
+			memcpy(&word, pWrite + i, sizeof(word));
+			ip_dev_regs[(addr + i) >> 2] = word;
+		}
+		return 0;
+	}
+
+	fd=ip_api_acquire(O_WRONLY);
+
+	if(fd>=0)
+	{
+		write = pwrite(fd, pWrite, length, addr);
+		if(write != length)
+		{
+			ret = EFAULT;
+		}
+
+		ip_api_release(fd);
+	}
+	else
+	{
+		ret = EIO;
+	}
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes bytes to anywhere in the framer address space.
+* Writes length bytes to addr from pWrite.
+* Uses the mapped register window if IP_API_Open() has succeeded.
+* If the shadow cache is enabled and every word written is cacheable the
+* values are only written to the cache, otherwise pending writes are
+* committed first.
+*
+* @param [in]	addr   Address in framer address space (0 base) to write to
+* @param [in]	pWrite Pointer to read from
+* @param [in]	length Number of bytes to write
+*
+* @return
+*		- 0 on success
+*		- EIO on device open failure
+*		- EFAULT on pwrite() failure
+*
+******************************************************************************/
+int IP_API_Write(int addr, uint8_t *pWrite, int length)
+{
+	int ret;
+
+	pthread_mutex_lock(&IpLock);
+	ret = ip_api_write(addr, pWrite, length);
+	pthread_mutex_unlock(&IpLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads a field of a framer register, with IpLock held. See IP_API_Read_Register().
+*
+******************************************************************************/
+static int ip_api_read_register(int addr, unsigned int *pRead, int Mask, int Offset)
+{
+	uint32_t buf;
+	uint32_t *cached;
+	int ret;
+
+	ret = ip_cache_lookup(addr, 1, &cached);
+	if(!ret && cached)
+	{
+		*pRead = (*cached & Mask) >> Offset;
+		return 0;
+	}
+
+	/* Pending writes land before an uncacheable register is read */
+	if(!ret)
+	{
+		ret = IP_API_Cache_Commit();
+	}
+	if(!ret)
+	{
+		ret = ip_hw_read_word(addr, &buf);
+	}
+	if(!ret)
+	{
+		*pRead = (buf & Mask) >> Offset;
+	}
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads 32-bits from anywhere in the framer address space.
+* Reads 32-bits from the address given, shifts and masks them
+* as per Offset and Mask, and writes them into pRead.
+* Uses the mapped register window if IP_API_Open() has succeeded, and the
+* shadow cache for cacheable registers if it is enabled.
+*
+* @param [in]  	addr   Address in framer address space (0 base) to read from
+* @param [out] 	pRead  Pointer to use to store output
+* @param [in]  	Mask   Mask to use to mask output before shifting
+* @param [in]  	Offset Number of bits to shift output down by after masking
+*
+* @return
+*		- 0 on success
+*		- EIO on device open failure
+*		- ioctl() return value on ioctl() failure
+*
+******************************************************************************/
+int IP_API_Read_Register(int addr, unsigned int *pRead, int Mask, int Offset)
+{
+	int ret;
+
+	pthread_mutex_lock(&IpLock);
+	ret = ip_api_read_register(addr, pRead, Mask, Offset);
+	pthread_mutex_unlock(&IpLock);
+
+	return ret;
+}
+
+
+/*****************************************************************************/
+/**
+*
+* Writes a framer register, with IpLock held. See IP_API_Write_Register().
+*
+******************************************************************************/
+static int ip_api_write_register(int addr, unsigned int Write, int Mask, int Offset)
+{
+	uint32_t *cached;
+	int ret;
+
+	ip_cache_lookup(addr, 0, &cached);
+	if(cached)
+	{
+		*cached = (Write << Offset) & Mask;
+		ip_cache_mark_dirty(addr);
+		return 0;
+	}
+
+	ret = IP_API_Cache_Commit();
+	if(!ret)
+	{
+		ret = ip_hw_write_word(addr, (Write << Offset) & Mask);
+	}
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes 32-bits to anywhere in the framer address space.
+* Writes 32-bits from Write to the address given, after
+* shifting and masking them as per Offset and Mask.
+* Uses the mapped register window if IP_API_Open() has succeeded. If the
+* shadow cache is enabled cacheable registers are only written to the cache,
+* and pending writes are committed before any uncacheable register is written.
+*
+* @param [in]  	addr   Address in framer address space (0 base) to write to
+* @param [in] 	Write  Value to write
+* @param [in]  	Mask   Mask to use to mask input after shifting
+* @param [in]  	Offset Number of bits to shift input up by before masking
+*
+* @return
+*		- 0 on success
+*		- EIO on device open failure
+*		- ioctl() return value on ioctl() failure
+*
+******************************************************************************/
+int IP_API_Write_Register(int addr, unsigned int Write, int Mask, int Offset)
+{
+	int ret;
+
+	pthread_mutex_lock(&IpLock);
+	ret = ip_api_write_register(addr, Write, Mask, Offset);
+	pthread_mutex_unlock(&IpLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Updates a field of a framer register, with IpLock held. See IP_API_Update_Register().
+*
+******************************************************************************/
+static int ip_api_update_register(int addr, unsigned int Write, int Mask, int Offset)
+{
+	xroe_reg_op_t op;
+	uint32_t *cached;
+	int ret;
+
+	ret = ip_cache_lookup(addr, 1, &cached);
+	if(ret)
+	{
+		return ret;
+	}
+	if(cached)
+	{
+		*cached &= ~Mask;
+		*cached |= (Write << Offset) & Mask;
+		ip_cache_mark_dirty(addr);
+		return 0;
+	}
+
+	op.addr = addr;
+	op.mask = Mask;
+	op.offset = Offset;
+	op.value = Write;
+	op.op = XROE_REG_OP_RMW;
+
+	return IP_API_Batch(&op, 1);
+}
+
+/*****************************************************************************/
+/**
+*
+* Performs a read/modify/write of a field in the framer address space.
+* Only the bits in Mask are changed, the rest of the register is preserved.
+* The read and the write are done in a single driver call when the batch
+* ioctl is available, so no other ioctl user can interleave with them.
+* If the shadow cache is enabled cacheable registers are merged into the
+* cached word and written to the framer on the next commit.
+*
+* @param [in]  	addr   Address in framer address space (0 base) to update
+* @param [in] 	Write  Field value to write
+* @param [in]  	Mask   Mask of the field in the register
+* @param [in]  	Offset Number of bits to shift input up by before masking
+*
+* @return
+*		- Return value of IP_API_Batch()
+*
+******************************************************************************/
+int IP_API_Update_Register(int addr, unsigned int Write, int Mask, int Offset)
+{
+	int ret;
+
+	pthread_mutex_lock(&IpLock);
+	ret = ip_api_update_register(addr, Write, Mask, Offset);
+	pthread_mutex_unlock(&IpLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Executes a list of register operations, with IpLock held. See IP_API_Batch().
+*
+******************************************************************************/
+static int ip_api_batch(xroe_reg_op_t *ops, int num_ops)
+{
+	int ret;
+	int i;
+
+	if(ops == NULL || num_ops <= 0 || num_ops > XROE_REG_BATCH_MAX_OPS)
+	{
+		return EINVAL;
+	}
+
+	ret = IP_API_Cache_Commit();
+	if(ret)
+	{
+		return ret;
+	}
+
+	ret = ip_hw_batch(ops, num_ops);
+
+	for(i = 0; i < num_ops; i++)
+	{
+		if(ops[i].op != XROE_REG_OP_READ)
+		{
+			ip_cache_invalidate(ops[i].addr);
+		}
+	}
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Executes a list of register operations in the framer address space.
+* The whole list is handed to the driver in a single XROE_FRAMER_IOBATCH
+* ioctl, which runs every operation in order under the driver's register
+* lock and returns the read results in place. If the driver does not
+* support the batch ioctl the operations are executed one at a time instead,
+* without the atomicity guarantee. Batches always go to the framer, pending
+* shadow cache writes are committed first.
+*
+* @param [in,out]	ops     Array of operations, reads store their result
+* @param [in]		num_ops Number of operations in ops
+*
+* @return
+*		- 0 on success
+*		- EINVAL on an empty or oversized list
+*		- EIO on device open failure
+*		- errno of the failed ioctl() otherwise
+*
+******************************************************************************/
+int IP_API_Batch(xroe_reg_op_t *ops, int num_ops)
+{
+	int ret;
+
+	pthread_mutex_lock(&IpLock);
+	ret = ip_api_batch(ops, num_ops);
+	pthread_mutex_unlock(&IpLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Enables the shadow cache, with IpLock held. See IP_API_Cache_Enable().
+*
+******************************************************************************/
+static int ip_api_cache_enable(int interval_ms)
+{
+	if(interval_ms < 0)
+	{
+		return EINVAL;
+	}
+
+	if(!IpCache.NumRanges)
+	{
+		return EOPNOTSUPP;
+	}
+
+	if(!IpCache.Enabled)
+	{
+		memset(IpCache.Valid, 0, sizeof(IpCache.Valid));
+		memset(IpCache.Dirty, 0, sizeof(IpCache.Dirty));
+		IpCache.DirtyCount = 0;
+		IpCache.Enabled = 1;
+	}
+	IpCache.IntervalMs = interval_ms;
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Enables the write-back shadow cache of the framer configuration registers.
+* Field writes to configuration registers are merged into the cached words
+* and written to the framer by IP_API_Cache_Commit(), or automatically once
+* interval_ms has passed since the first uncommitted write.
+*
+* @param [in]	interval_ms Automatic commit interval, 0 for explicit commits only
+*
+* @return
+*		- 0 on success
+*		- EINVAL on negative interval
+*		- EOPNOTSUPP if the register layout has no cacheable registers
+*
+******************************************************************************/
+int IP_API_Cache_Enable(int interval_ms)
+{
+	int ret;
+
+	pthread_mutex_lock(&IpLock);
+	ret = ip_api_cache_enable(interval_ms);
+	pthread_mutex_unlock(&IpLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Disables the shadow cache, with IpLock held. See IP_API_Cache_Disable().
+*
+******************************************************************************/
+static int ip_api_cache_disable(void)
+{
+	int ret;
+
+	ret = IP_API_Cache_Commit();
+	if(!ret)
+	{
+		IpCache.Enabled = 0;
+	}
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Commits pending writes and disables the shadow cache.
+* The cache stays enabled if the commit fails so no writes are lost.
+*
+* @return
+*		- 0 on success
+*		- Return value of IP_API_Cache_Commit() on error
+*
+******************************************************************************/
+int IP_API_Cache_Disable(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&IpLock);
+	ret = ip_api_cache_disable();
+	pthread_mutex_unlock(&IpLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes a set of dirty shadow cache words to the framer and marks them clean.
+*
+* @param [in]	ops     Full word write operations for the dirty words
+* @param [in]	index   Cache index of the word written by each operation
+* @param [in]	num_ops Number of operations in ops
+*
+* @return
+*		- 0 on success
+*		- Return value of ip_hw_batch() on error
+*
+******************************************************************************/
+static int ip_cache_flush_ops(xroe_reg_op_t *ops, int *index, int num_ops)
+{
+	int ret;
+	int i;
+
+	ret = ip_hw_batch(ops, num_ops);
+	if(ret)
+	{
+		syslog(LOG_ERR, "IP_API_Cache_Commit: failed to write %d registers (%d)\n", num_ops, ret);
+		return ret;
+	}
+
+	for(i = 0; i < num_ops; i++)
+	{
+		XROE_CACHE_CLEAR(IpCache.Dirty, index[i]);
+		IpCache.DirtyCount--;
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Commits the shadow cache, with IpLock held. See IP_API_Cache_Commit().
+*
+******************************************************************************/
+static int ip_api_cache_commit(void)
+{
+	static xroe_reg_op_t ops[XROE_REG_BATCH_MAX_OPS];
+	int index[XROE_REG_BATCH_MAX_OPS];
+	int num_ops = 0;
+	int ret = 0;
+	int i, j;
+
+	if(!IpCache.Enabled || !IpCache.DirtyCount)
+	{
+		return 0;
+	}
+
+	for(i = 0; i < XROE_CACHE_WORDS / 32 && !ret; i++)
+	{
+		if(!IpCache.Dirty[i])
+		{
+			continue;
+		}
+
+		for(j = i * 32; j < (i + 1) * 32; j++)
+		{
+			if(!XROE_CACHE_TEST(IpCache.Dirty, j))
+			{
+				continue;
+			}
+
+			ops[num_ops].addr = j << 2;
+			ops[num_ops].mask = 0xFFFFFFFF;
+			ops[num_ops].offset = 0;
+			ops[num_ops].value = IpCache.Words[j];
+			ops[num_ops].op = XROE_REG_OP_WRITE;
+			index[num_ops++] = j;
+
+			if(num_ops == XROE_REG_BATCH_MAX_OPS)
+			{
+				ret = ip_cache_flush_ops(ops, index, num_ops);
+				num_ops = 0;
+				if(ret)
+				{
+					break;
+				}
+			}
+		}
+	}
+
+	if(!ret && num_ops)
+	{
+		ret = ip_cache_flush_ops(ops, index, num_ops);
+	}
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes every dirty word of the shadow cache to the framer in one pass.
+* Dirty words are sent as full word writes in as few batch transactions as
+* possible.
+*
+* @return
+*		- 0 on success or if nothing is pending
+*		- Return value of ip_hw_batch() on error, the failed words stay dirty
+*
+******************************************************************************/
+int IP_API_Cache_Commit(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&IpLock);
+	ret = ip_api_cache_commit();
+	pthread_mutex_unlock(&IpLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the time left until the shadow cache commit, with IpLock held. See IP_API_Cache_Timeout().
+*
+******************************************************************************/
+static int ip_api_cache_timeout(void)
+{
+	struct timespec now;
+	long elapsed_ms;
+
+	if(!IpCache.Enabled || !IpCache.DirtyCount || !IpCache.IntervalMs)
+	{
+		return -1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed_ms = (now.tv_sec - IpCache.DirtySince.tv_sec) * 1000 +
+		(now.tv_nsec - IpCache.DirtySince.tv_nsec) / 1000000;
+
+	if(elapsed_ms >= IpCache.IntervalMs)
+	{
+		return 0;
+	}
+
+	return IpCache.IntervalMs - elapsed_ms;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the time left until the shadow cache is due to be committed.
+* Intended as the poll() timeout of the main loop.
+*
+* @return
+*		- -1 if no automatic commit is pending
+*		- Milliseconds until IP_API_Cache_Poll() will commit otherwise
+*
+******************************************************************************/
+int IP_API_Cache_Timeout(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&IpLock);
+	ret = ip_api_cache_timeout();
+	pthread_mutex_unlock(&IpLock);
+
+	return ret;
+}
+
+/*****************************************************************************/
+/**
+*
+* Commits the shadow cache if its automatic commit interval has expired.
+*
+* @return
+*		- 0 if nothing was due or on success
+*		- Return value of IP_API_Cache_Commit() on error
+*
+******************************************************************************/
+int IP_API_Cache_Poll(void)
+{
+	if(IP_API_Cache_Timeout() == 0)
+	{
+		return IP_API_Cache_Commit();
+	}
 
-struct ioctl_arguments {
-         uint32_t *offset;
-         uint32_t *value;
- };
+	return 0;
+}
 
 /*****************************************************************************/
 /**
 *
-* Reads bytes from anywhere in the framer address space.
-* Reads bytes from the address given and writes them into pRead.
+* Gets the state of the shadow cache, with IpLock held. See IP_API_Cache_Status().
 *
-* @param [in]	addr   Address in framer address space (0 base) to read from
-* @param [out]	pRead  Pointer to use to store output
-* @param [in]	length Number of bytes to read
+******************************************************************************/
+static void ip_api_cache_status(int *pEnabled, int *pIntervalMs, int *pDirty)
+{
+	*pEnabled = IpCache.Enabled;
+	*pIntervalMs = IpCache.IntervalMs;
+	*pDirty = IpCache.DirtyCount;
+}
+
+/*****************************************************************************/
+/**
 *
-* @return
-*		- 0 on success
-*		- EIO on device open failure
-*		- EFAULT on pread() failure
+* Gets the state of the shadow cache.
+*
+* @param [out]	pEnabled    Non-zero if the cache is enabled
+* @param [out]	pIntervalMs Automatic commit interval, 0 if explicit only
+* @param [out]	pDirty      Number of words waiting to be committed
 *
 ******************************************************************************/
-int IP_API_Read(int addr, uint8_t *pRead, int length)
+void IP_API_Cache_Status(int *pEnabled, int *pIntervalMs, int *pDirty)
 {
-	int fd=0;
-	int read = 0;
-	int ret = 0;
-	fd=open("/dev/xroe/ip", O_RDONLY);
-
-	if(fd>0)
-	{
-		read = pread(fd, pRead, length, addr);
-		if(!read)
-		{
-			ret = EFAULT;
-		}
-
-		close(fd);
-	}
-	else
-	{
-		ret = EIO;
-	}
-	
-	return ret;
+	pthread_mutex_lock(&IpLock);
+	ip_api_cache_status(pEnabled, pIntervalMs, pDirty);
+	pthread_mutex_unlock(&IpLock);
 }
 
 /*****************************************************************************/
 /**
 *
-* Writes bytes to anywhere in the framer address space.
-* Writes length bytes to addr from pWrite.
+* Sets the configuration registers the shadow cache may hold, those of the
+* register layout in use. Pending writes are committed and the cached values
+* dropped first. The cache is disabled if the layout has no cacheable
+* registers.
 *
-* @param [in]	addr   Address in framer address space (0 base) to write to
-* @param [in]	pWrite Pointer to read from
-* @param [in]	length Number of bytes to write
+* @param [in]	ranges      Cacheable register ranges, kept by reference
+* @param [in]	num_ranges  Number of ranges, 0 if the cache is not supported
 *
 * @return
 *		- 0 on success
-*		- EIO on device open failure
-*		- EFAULT on pwrite() failure
+*		- Return value of IP_API_Cache_Commit() on error, the ranges are
+*		  left unchanged
 *
 ******************************************************************************/
-int IP_API_Write(int addr, uint8_t *pWrite, int length)
+int IP_API_Cache_Set_Ranges(const xroe_reg_range_t *ranges, int num_ranges)
 {
-	int fd=0;
-	int write = 0;
 	int ret = 0;
-	fd=open("/dev/xroe/ip", O_WRONLY);
 
-	if(fd>0)
+	pthread_mutex_lock(&IpLock);
+	if(IpCache.Enabled)
 	{
-		write = pwrite(fd, pWrite, length, addr);
-		if(!write)
+		ret = IP_API_Cache_Commit();
+		if(!ret)
 		{
-			ret = EFAULT;
+			memset(IpCache.Valid, 0, sizeof(IpCache.Valid));
+			IpCache.Enabled = (num_ranges > 0);
 		}
-
-		close(fd);
 	}
-	else
+	if(!ret)
 	{
-		ret = EIO;
+		IpCache.Ranges = ranges;
+		IpCache.NumRanges = num_ranges;
 	}
+	pthread_mutex_unlock(&IpLock);
 
 	return ret;
 }
 
 /*****************************************************************************/
 /**
+* Reads a sysfs attribute.
+* Uses the device backend if one is set with IP_API_Set_Backend().
 *
-* Reads 32-bits from anywhere in the framer address space.
-* Reads 32-bits from the address given, shifts and masks them
-* as per Offset and Mask, and writes them into pRead.
-*
-* @param [in]  	addr   Address in framer address space (0 base) to read from
-* @param [out] 	pRead  Pointer to use to store output
-* @param [in]  	Mask   Mask to use to mask output before shifting
-* @param [in]  	Offset Number of bits to shift output down by after masking
+* @param [in]  path   Full path of the sysfs attribute
+* @param [out] buf    Buffer to read into
+* @param [in]  length Size of buf
 *
 * @return
-*		- 0 on success
-*		- EIO on device open failure
-*		- EFAULT on pread() failure
+*		- Number of bytes read on success
+*		- 0 on read() failure, errno is left set
+*		- -1 on open failure
 *
 ******************************************************************************/
-int IP_API_Read_Register(int addr, unsigned int *pRead, int Mask, int Offset)
+static int ip_sysfs_read(const char *path, char *buf, int length)
 {
-	int fd=0;
-	unsigned int buf;
-	int ret = 0;
-	struct ioctl_arguments args;
-
-	fd=open("/dev/xroe/ip", O_WRONLY);
+	int fd;
+	int w;
 
-	if(fd>0)
+	if(IpBackend)
 	{
-		args.offset = (uint32_t *)&addr;
-		args.value = (uint32_t *)&buf;
-		
-		ret = ioctl(fd, XROE_FRAMER_IOGET, &args);
-		if(!ret)
-		{
-			*pRead = (buf & Mask) >> Offset;
-		}
+		pthread_mutex_lock(&IpLock);
+		w = IpBackend->sysfs_read(path, buf, length);
+		pthread_mutex_unlock(&IpLock);
+		return w;
+	}
 
-		close(fd);
+	fd = open(path, O_RDONLY);
+	if(fd < 0)
+	{
+		return -1;
 	}
-	return ret;
-}
 
+	w = read(fd, buf, length);
+	close(fd);
+
+	return (w < 0) ? 0 : w;
+}
 
 /*****************************************************************************/
 /**
+* Writes a sysfs attribute.
+* Uses the device backend if one is set with IP_API_Set_Backend().
 *
-* Writes 32-bits to anywhere in the framer address space.
-* Writes 32-bits from Write to the address given, after
-* shifting and masking them as per Offset and Mask.
-*
-* @param [in]  	addr   Address in framer address space (0 base) to write to
-* @param [in] 	Write  Value to write
-* @param [in]  	Mask   Mask to use to mask input after shifting
-* @param [in]  	Offset Number of bits to shift input up by before masking
+* @param [in]  path   Full path of the sysfs attribute
+* @param [in]  buf    Value to write
+* @param [in]  length Number of bytes of buf to write
 *
 * @return
-*		- 0 on success
-*		- EIO on device open failure
-*		- EFAULT on pwrite() failure
+*		- Number of bytes written on success
+*		- 0 on write() failure, errno is left set
+*		- -1 on open failure
 *
 ******************************************************************************/
-int IP_API_Write_Register(int addr, unsigned int Write, int Mask, int Offset)
+static int ip_sysfs_write(const char *path, const char *buf, int length)
 {
-	int fd = 0;
-	int buf;
-	int ret = 0;
-	struct ioctl_arguments args;
-
-	fd=open("/dev/xroe/ip", O_WRONLY);
+	int fd;
+	int w;
 
-	if(fd>0)
+	if(IpBackend)
 	{
-		args.offset = (uint32_t *)&addr;
-		args.value = (uint32_t *)&buf;
-
-		buf = (Write << Offset) & Mask;
-		ret = ioctl(fd, XROE_FRAMER_IOSET, &args);
+		pthread_mutex_lock(&IpLock);
+		w = IpBackend->sysfs_write(path, buf, length);
+		pthread_mutex_unlock(&IpLock);
+		return w;
+	}
 
-		close(fd);
+	fd = open(path, O_WRONLY);
+	if(fd < 0)
+	{
+		return -1;
 	}
 
-	return ret;
+	w = write(fd, buf, length);
+	close(fd);
+
+	return (w < 0) ? 0 : w;
 }
 
 /*****************************************************************************/
 /**
-* Reads a value from the stats sysfs entries.
+* Reads a value from the stats sysfs entries of an Ethernet port.
 * Reads 32-bits from sysfs to resp.
 *
-* @param [in]  name   Path in TrafGen sysfs to read from
+* @param [in]  port   Ethernet port to read the entry of
+* @param [in]  name   Name of the entry in the port's stats directory
 * @param [in]  resp   Pointer to use to store output
 *
 * @return
@@ -223,36 +1856,169 @@ int IP_API_Write_Register(int addr, unsigned int Write, int Mask, int Offset)
 *		- read() return value on read() failure
 *
 ******************************************************************************/
-int STATS_SYSFS_API_Read(const char *name, char *resp)
+int STATS_SYSFS_API_Read(int port, const char *name, char *resp)
 {
-	int fd;
     int w;
 	char buff[1024];
-	char syspath[XROE_MAX_SYSPATH_LENGTH] = "/sys/kernel/xroe/stats/";
+	char syspath[XROE_MAX_SYSPATH_LENGTH];
 	int ret = -1;
 	
-	strncat(syspath, name, XROE_MAX_SYSPATH_LENGTH-strlen(syspath));
-	fd = open(syspath, O_RDONLY);
+	snprintf(syspath, sizeof(syspath), "/sys/kernel/xroe/stats/eth_port_%d/%s", port, name);
+	w = ip_sysfs_read(syspath, buff, sizeof(buff));
+
+	if (w > 0)
+	{
+		ret = 0;
+		strncpy(resp, buff, w);
+	}
+	else if (w == 0)
+	{
+		ret = errno;
+	}
+
+	return ret;
+}
+
+
+/*****************************************************************************/
+/**
+* Reads values from the stats sysfs entries of an Ethernet port.
+* The entries are kept open and read again from offset 0 at each call, all
+* in one submission when io_uring is used (see IP_API_Use_Uring()).
+* Entries that fail to read are opened again on the next call, in case the
+* driver was reloaded.
+*
+* @param [in]  port    Ethernet port to read the entries of
+* @param [in]  names   Names of the entries in the port's stats directory,
+*                      NULL for values not read. The same table is to be
+*                      given at each call.
+* @param [in]  num     Number of entries
+* @param [out] values  Values read, left as they are for NULL names
+*
+* @return
+*		- 0 on success
+*		- -1 on open failure
+*		- errno value of the first read failure
+*
+******************************************************************************/
+int STATS_SYSFS_API_Read_Counters(int port, const char * const *names, int num, uint32_t *values)
+{
+	char buff[XROE_STATS_VALUE_LENGTH];
+	char *value;
+	ssize_t w;
+	int ret = 0;
+	int i;
 
-	if (fd>0)
+	if(IpBackend || (port < 0) || (port >= XROE_STATS_SNAPSHOT_MAX_PORTS) || (num > XROE_STATS_FILES_MAX))
 	{
-		w = read(fd, buff, sizeof(buff));
-		if (w)
+		/* Backends only serve whole sysfs reads */
+		for(i = 0; (i < num) && !ret; i++)
 		{
-			ret = 0;
-			strncpy(resp, buff, w);
+			if(names[i])
+			{
+				memset(buff, 0, sizeof(buff));
+				ret = STATS_SYSFS_API_Read(port, names[i], buff);
+				values[i] = strtoul(buff, NULL, 0);
+			}
 		}
-		else
+		return ret;
+	}
+
+	pthread_mutex_lock(&IpLock);
+	if((IpStatsFiles.Names != names) || (IpStatsFiles.NumNames != num))
+	{
+		ip_stats_files_close();
+		IpStatsFiles.Names = names;
+		IpStatsFiles.NumNames = num;
+	}
+	if(IpStatsFiles.UseUring && !IpStatsFiles.Uring && ip_stats_files_uring())
+	{
+		syslog(LOG_NOTICE, "%s:%d No io_uring for the stats files, reading them one by one\n", __FILE__, __LINE__);
+		IpStatsFiles.UseUring = 0;
+	}
+	if(!IpStatsFiles.Opened[port] && ip_stats_files_open(port))
+	{
+		pthread_mutex_unlock(&IpLock);
+		return -1;
+	}
+
+	ret = IpStatsFiles.Uring ? ip_stats_files_submit(port) : -1;
+	if(ret < 0)
+	{
+		ret = 0;
+		for(i = 0; (i < num) && !ret; i++)
 		{
-			ret = errno;
+			if(IpStatsFiles.Fds[port][i] >= 0)
+			{
+				value = IpStatsFiles.Values[port][i];
+				w = pread(IpStatsFiles.Fds[port][i], value, XROE_STATS_VALUE_LENGTH - 1, 0);
+				ret = (w < 0) ? errno : 0;
+				value[(w < 0) ? 0 : w] = 0;
+			}
+		}
+		if(!ret && IpStatsFiles.Uring)
+		{
+			/* The files read fine, the ring is what failed */
+			syslog(LOG_NOTICE, "%s:%d io_uring reads failed, reading the stats files one by one\n", __FILE__, __LINE__);
+			uring_exit(&IpStatsFiles.Ring);
+			IpStatsFiles.Uring = 0;
+			IpStatsFiles.UseUring = 0;
 		}
-
-		close(fd);
 	}
 
+	for(i = 0; (i < num) && !ret; i++)
+	{
+		if(IpStatsFiles.Fds[port][i] >= 0)
+		{
+			values[i] = strtoul(IpStatsFiles.Values[port][i], NULL, 0);
+		}
+	}
+	if(ret)
+	{
+		ip_stats_files_close();
+	}
+	pthread_mutex_unlock(&IpLock);
 	return ret;
 }
 
+/*****************************************************************************/
+/**
+* Reads the binary snapshot of the statistics of all Ethernet ports.
+* All counters of a snapshot are read by the driver in one go.
+*
+* @param [out] pSnapshot  Pointer to store the snapshot in
+*
+* @return
+*		- 0 on success
+*		- errno of the failed open() or read(), ENOENT if the driver has
+*		  no snapshot entry
+*		- EPROTO if the snapshot is not in a known layout
+*
+******************************************************************************/
+int STATS_API_Read_Snapshot(xroe_stats_snapshot_t *pSnapshot)
+{
+	int w;
+	int header = offsetof(xroe_stats_snapshot_t, words);
+
+	errno = 0;
+	w = ip_sysfs_read("/sys/kernel/xroe/stats/snapshot", (char *)pSnapshot, sizeof(*pSnapshot));
+	if(w <= 0)
+	{
+		return errno ? errno : EIO;
+	}
+
+	if((w < header) ||
+	   (pSnapshot->version != XROE_STATS_SNAPSHOT_VERSION) ||
+	   (pSnapshot->num_words != XROE_STATS_SNAPSHOT_WORDS) ||
+	   (pSnapshot->num_ports == 0) ||
+	   (pSnapshot->num_ports > XROE_STATS_SNAPSHOT_MAX_PORTS) ||
+	   (w < header + pSnapshot->num_ports * XROE_STATS_SNAPSHOT_WORDS * sizeof(uint32_t)))
+	{
+		return EPROTO;
+	}
+
+	return 0;
+}
 
 /*****************************************************************************/
 /**
@@ -271,31 +2037,28 @@ int STATS_SYSFS_API_Read(const char *name, char *resp)
 ******************************************************************************/
 int FRAMER_API_Framer_Restart(int restart)
 {
-	int fd;
 	int w;
 	int ret = -1;
-	fd = open("/sys/kernel/xroe/framer_restart", O_WRONLY);
 
-	if(fd>0)
+	/* Configuration must reach the framer before it is restarted */
+	IP_API_Cache_Commit();
+
+	if(restart)
 	{
-		if(restart)
-		{
-			w = write (fd, "true", 1);
-		}
-		else
-		{
-			w = write (fd, "false", 1);
-		}
-		
-		if(w)
-		{
-			ret = 0;
-		}
-		else
-		{
-			ret = EFAULT;
-		}
-		close(fd);
+		w = ip_sysfs_write("/sys/kernel/xroe/framer_restart", "true", 1);
+	}
+	else
+	{
+		w = ip_sysfs_write("/sys/kernel/xroe/framer_restart", "false", 1);
+	}
+
+	if(w > 0)
+	{
+		ret = 0;
+	}
+	else if(w == 0)
+	{
+		ret = EFAULT;
 	}
 
 	return ret;
@@ -318,31 +2081,28 @@ int FRAMER_API_Framer_Restart(int restart)
 ******************************************************************************/
 int FRAMER_API_Deframer_Restart(int restart)
 {
-	int fd;
 	int w;
 	int ret = -1;
-	fd = open("/sys/kernel/xroe/deframer_restart", O_WRONLY);
 
-	if(fd>0)
+	/* Configuration must reach the framer before it is restarted */
+	IP_API_Cache_Commit();
+
+	if(restart)
 	{
-		if(restart)
-		{
-			w = write (fd, "true", 1);
-		}
-		else
-		{
-			w = write (fd, "false", 1);
-		}
-		
-		if(w)
-		{
-			ret = 0;
-		}
-		else
-		{
-			ret = EFAULT;
-		}
-		close(fd);
+		w = ip_sysfs_write("/sys/kernel/xroe/deframer_restart", "true", 1);
+	}
+	else
+	{
+		w = ip_sysfs_write("/sys/kernel/xroe/deframer_restart", "false", 1);
+	}
+
+	if(w > 0)
+	{
+		ret = 0;
+	}
+	else if(w == 0)
+	{
+		ret = EFAULT;
 	}
 
 	return ret;
@@ -364,7 +2124,6 @@ int FRAMER_API_Deframer_Restart(int restart)
 ******************************************************************************/
 int TRAFGEN_SYSFS_API_Read(const char *name, char *resp)
 {
-	int fd;
     int w;
 	char buff[1024];
 	// char syspath[XROE_MAX_SYSPATH_LENGTH] = "/sys/devices/platform/amba_pl@0/a0060000.roe_radio_ctrl/";
@@ -373,23 +2132,16 @@ int TRAFGEN_SYSFS_API_Read(const char *name, char *resp)
 	int ret = -1;
 	
 	strncat(syspath, name, XROE_MAX_SYSPATH_LENGTH - strlen(syspath));
+	w = ip_sysfs_read(syspath, buff, sizeof(buff));
 
-	fd = open(syspath, O_RDONLY);
-
-	if (fd>0)
+	if (w > 0)
 	{
-		w = read(fd, buff, sizeof(buff));
-		if (w)
-		{
-			ret = 0;
-			strncpy(resp, buff, w);
-		}
-		else
-		{
-			ret = errno;
-		}
-
-		close(fd);
+		ret = 0;
+		strncpy(resp, buff, w);
+	}
+	else if (w == 0)
+	{
+		ret = errno;
 	}
 
 	return ret;
@@ -412,27 +2164,20 @@ int TRAFGEN_SYSFS_API_Read(const char *name, char *resp)
 ******************************************************************************/
 int TRAFGEN_SYSFS_API_Write(const char *name, char *val)
 {
-	int fd;
     int w;
 	char syspath[XROE_MAX_SYSPATH_LENGTH] = "/sys/kernel/traffic/";
 	int ret = -1;
 	
 	strncat(syspath, name, XROE_MAX_SYSPATH_LENGTH-strlen(syspath));
-	fd = open(syspath, O_RDONLY);
+	w = ip_sysfs_write(syspath, val, strlen(val));
 
-	if (fd>0)
+	if (w > 0)
 	{
-		w = write(fd, val, sizeof(val));
-		if (w)
-		{
-			ret = 0;
-		}
-		else
-		{
-			ret = errno;
-		}
-
-		close(fd);
+		ret = 0;
+	}
+	else if (w == 0)
+	{
+		ret = errno;
 	}
 
 	return ret;
@@ -453,33 +2198,19 @@ int TRAFGEN_SYSFS_API_Write(const char *name, char *val)
 ******************************************************************************/
 int XXV_API_Reset(void)
 {
-	int fd;
 	int w;
 	int ret = -1;
-	fd = open("/sys/kernel/xroe/xxv_reset", O_WRONLY);
 
-	if (fd>0)
+	w = ip_sysfs_write("/sys/kernel/xroe/xxv_reset", "true", 1);
+	if (w >= 0)
 	{
-		w = write(fd, "true", 1);
-		if (w)
-		{
-			ret = 0;
-		}
-		else
-		{
-			ret = EFAULT;
-		}
+		ret = w ? 0 : EFAULT;
 
-		w = write(fd, "false", 1);
-		if (w)
-		{
-			ret = 0;
-		}
-		else
+		w = ip_sysfs_write("/sys/kernel/xroe/xxv_reset", "false", 1);
+		if (w <= 0)
 		{
 			ret = EFAULT;
 		}
-		close(fd);
 	}
 
 	return ret;
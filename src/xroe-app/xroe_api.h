@@ -16,12 +16,103 @@
 ******************************************************************************/
 #ifndef XROE_API_H		/* prevent circular inclusions */
 #define XROE_API_H		/* by using protection macros */
+
+#include <stdint.h>
+
+/***************************** Type Definitions ******************************/
+/* Register operation types for IP_API_Batch() */
+#define XROE_REG_OP_READ	0
+#define XROE_REG_OP_WRITE	1
+#define XROE_REG_OP_RMW		2
+
+/* Maximum number of operations accepted by IP_API_Batch() */
+#define XROE_REG_BATCH_MAX_OPS	1024
+
+/**
+ * xroe_reg_op_t A single register operation of a batched transaction.
+ * For reads value receives the masked and shifted field, for writes and
+ * read-modify-writes value is shifted by offset and masked before writing.
+ */
+typedef struct xroe_reg_op_t{
+	uint32_t addr;
+	uint32_t mask;
+	uint32_t offset;
+	uint32_t value;
+	uint32_t op;
+} xroe_reg_op_t;
+
+/**
+ * xroe_reg_range_t A range of registers, end is exclusive.
+ */
+typedef struct xroe_reg_range_t{
+	uint32_t start;
+	uint32_t end;
+} xroe_reg_range_t;
+
+/* Layout version of the stats snapshot understood by STATS_API_Read_Snapshot() */
+#define XROE_STATS_SNAPSHOT_VERSION	1
+
+/* Number of 32-bit statistics registers per Ethernet port in a snapshot */
+#define XROE_STATS_SNAPSHOT_WORDS	13
+
+/* Maximum number of Ethernet ports in a snapshot */
+#define XROE_STATS_SNAPSHOT_MAX_PORTS	4
+
+/**
+ * xroe_stats_snapshot_t Binary snapshot of the statistics registers of all
+ * Ethernet ports, as read from /sys/kernel/xroe/stats/snapshot. words[port]
+ * holds the raw registers of the port starting from STATS_TOTAL_RX_GOOD_PKT_CNT,
+ * in address order. Only the first num_ports entries are filled in.
+ */
+typedef struct __attribute__((packed)) xroe_stats_snapshot_t{
+	uint32_t version;
+	uint32_t num_ports;
+	uint32_t num_words;
+	uint32_t reserved;
+	uint64_t timestamp_ns;
+	uint32_t words[XROE_STATS_SNAPSHOT_MAX_PORTS][XROE_STATS_SNAPSHOT_WORDS];
+} xroe_stats_snapshot_t;
+
+/* Index of a statistics register in the words of a snapshot */
+#define XROE_STATS_WORD(_reg) ((_reg##_ADDR - STATS_TOTAL_RX_GOOD_PKT_CNT_ADDR) >> 2)
+
+/**
+ * xroe_backend_t Device backend replacing the framer device node and sysfs,
+ * see IP_API_Set_Backend(). The sysfs functions return the number of bytes
+ * transferred, or -1 if the attribute does not exist.
+ */
+typedef struct xroe_backend_t{
+	const char *name;
+	int (*read_word)(uint32_t addr, uint32_t *value);
+	int (*write_word)(uint32_t addr, uint32_t value);
+	int (*sysfs_read)(const char *path, char *buf, int length);
+	int (*sysfs_write)(const char *path, const char *buf, int length);
+} xroe_backend_t;
+
 /************************** Function Prototypes ******************************/
+void IP_API_Lock(void);
+void IP_API_Unlock(void);
+int IP_API_Open(void);
+void IP_API_Close(void);
+int IP_API_Set_Backend(const xroe_backend_t *backend);
+void IP_API_Use_Uring(int enable);
+const xroe_backend_t *IP_API_Get_Backend(void);
 int IP_API_Read(int addr, uint8_t *pRead, int length);
 int IP_API_Write(int addr, uint8_t *pWrite, int length);
 int IP_API_Read_Register(int addr, unsigned int *pRead, int Mask, int Offset);
 int IP_API_Write_Register(int addr, unsigned int pWrite, int Mask, int Offset);
-int STATS_SYSFS_API_Read(const char *name, char *resp);
+int IP_API_Update_Register(int addr, unsigned int Write, int Mask, int Offset);
+int IP_API_Batch(xroe_reg_op_t *ops, int num_ops);
+int IP_API_Cache_Enable(int interval_ms);
+int IP_API_Cache_Disable(void);
+int IP_API_Cache_Commit(void);
+int IP_API_Cache_Timeout(void);
+int IP_API_Cache_Poll(void);
+void IP_API_Cache_Status(int *pEnabled, int *pIntervalMs, int *pDirty);
+int IP_API_Cache_Set_Ranges(const xroe_reg_range_t *ranges, int num_ranges);
+int STATS_SYSFS_API_Read(int port, const char *name, char *resp);
+int STATS_SYSFS_API_Read_Counters(int port, const char * const *names, int num, uint32_t *values);
+int STATS_API_Read_Snapshot(xroe_stats_snapshot_t *pSnapshot);
 int FRAMER_API_Framer_Restart(int restart);
 int FRAMER_API_Deframer_Restart(int restart);
 int TRAFGEN_SYSFS_API_Read(const char *name, char *resp);
@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file xroe_bin.h
+* @addtogroup framer_driver_api
+* @{
+*
+*  Binary command protocol of xroe-app
+*
+*  A connection to the command port whose first bytes are XROE_BIN_MAGIC
+*  carries binary requests instead of text commands. Each request is an
+*  xroe_bin_request_t header followed by Length bytes of value, and is
+*  answered by an xroe_bin_reply_t header followed by Length bytes of data,
+*  in the order of the requests. All fields are little-endian. For example,
+*  reading the data Ethernet port of framer antenna 2:
+*
+*  @code
+*	xroe_bin_request_t req = {XROE_BIN_MAGIC, XROE_BIN_OP_FIELD_GET, 2,
+*	                          XROE_FIELD_fram_data_port, 0, tag};
+*	xroe_bin_reply_t reply;
+*	uint32_t value;
+*
+*	write(fd, &req, sizeof(req));
+*	read(fd, &reply, sizeof(reply));
+*	if(!reply.Status)
+*		read(fd, &value, sizeof(value));
+*  @endcode
+*
+*  Field identifiers are the xroe_field_id_t values of roe_framer_fields.h.
+*
+******************************************************************************/
+#ifndef XROE_BIN_H		/* prevent circular inclusions */
+#define XROE_BIN_H		/* by using protection macros */
+
+#include <stdint.h>
+
+/* First bytes of each request and reply, 0xFE 0xAE on the wire */
+#define XROE_BIN_MAGIC 0xAEFE
+
+/* Protocol version, returned by XROE_BIN_OP_VERSION */
+#define XROE_BIN_VERSION 1
+
+/* Longest value of a request */
+#define XROE_BIN_MAX_VALUE 256
+
+/* Index selecting all ports or antennas */
+#define XROE_BIN_ALL 0xFF
+
+/**
+ * xroe_bin_opcode_t Operations of the binary protocol.
+ */
+typedef enum {
+	XROE_BIN_OP_VERSION = 1,    /**< Reply xroe_bin_version_t */
+	XROE_BIN_OP_PEEK,           /**< Value uint32_t address, reply xroe_bin_reg_t */
+	XROE_BIN_OP_POKE,           /**< Value xroe_bin_reg_t, reply xroe_bin_reg_t */
+	XROE_BIN_OP_FIELD_GET,      /**< Index antenna, Field, reply uint32_t */
+	XROE_BIN_OP_FIELD_SET,      /**< Index antenna, Field, value uint32_t */
+	XROE_BIN_OP_STATS,          /**< Index port or XROE_BIN_ALL, reply xroe_bin_stats_t */
+	XROE_BIN_OP_RADIO,          /**< Index antenna or XROE_BIN_ALL, reply xroe_bin_radio_t */
+} xroe_bin_opcode_t;
+
+/**
+ * xroe_bin_request_t Header of a request.
+ */
+typedef struct __attribute__((packed)) xroe_bin_request_t{
+	uint16_t Magic;     /**< XROE_BIN_MAGIC */
+	uint8_t Opcode;     /**< xroe_bin_opcode_t */
+	uint8_t Index;      /**< Antenna or port */
+	uint16_t Field;     /**< xroe_field_id_t of field operations */
+	uint16_t Length;    /**< Bytes of value following, up to XROE_BIN_MAX_VALUE */
+	uint32_t Tag;       /**< Returned in the reply */
+} xroe_bin_request_t;
+
+/**
+ * xroe_bin_reply_t Header of a reply.
+ */
+typedef struct __attribute__((packed)) xroe_bin_reply_t{
+	uint16_t Magic;     /**< XROE_BIN_MAGIC */
+	uint8_t Opcode;     /**< Opcode of the request */
+	uint8_t Status;     /**< 0 on success, an errno value otherwise */
+	uint32_t Tag;       /**< Tag of the request */
+	uint32_t Length;    /**< Bytes of data following, 0 on error */
+} xroe_bin_reply_t;
+
+/**
+ * xroe_bin_version_t Reply to XROE_BIN_OP_VERSION.
+ */
+typedef struct __attribute__((packed)) xroe_bin_version_t{
+	uint32_t Protocol;  /**< XROE_BIN_VERSION */
+	uint32_t Major;     /**< IP revision */
+	uint32_t Minor;
+	uint32_t Revision;
+} xroe_bin_version_t;
+
+/**
+ * xroe_bin_reg_t Register of XROE_BIN_OP_PEEK and XROE_BIN_OP_POKE.
+ */
+typedef struct __attribute__((packed)) xroe_bin_reg_t{
+	uint32_t Addr;
+	uint32_t Value;
+} xroe_bin_reg_t;
+
+/**
+ * xroe_bin_stats_t Reply to XROE_BIN_OP_STATS, the totals of the counters
+ * in the order of "stats totals".
+ */
+typedef struct __attribute__((packed)) xroe_bin_stats_t{
+	uint32_t Port;          /**< XROE_BIN_ALL for the sum of the ports */
+	uint32_t NumCounters;
+	uint64_t Totals[];      /**< NumCounters entries */
+} xroe_bin_stats_t;
+
+/**
+ * xroe_bin_antenna_t Deframer buffer state of an antenna.
+ */
+typedef struct __attribute__((packed)) xroe_bin_antenna_t{
+	uint32_t Align;
+	uint32_t Regular;
+	uint32_t Overflow;
+	uint32_t Underflow;
+	uint32_t CheckError;
+	uint32_t BufStateLatency;
+} xroe_bin_antenna_t;
+
+/**
+ * xroe_bin_radio_t Reply to XROE_BIN_OP_RADIO.
+ */
+typedef struct __attribute__((packed)) xroe_bin_radio_t{
+	uint32_t Enable;
+	uint32_t Error;
+	uint32_t Status;
+	uint32_t Loopback;
+	uint32_t FirstAntenna;  /**< Index of Antennas[0] */
+	uint32_t NumAntennas;
+	xroe_bin_antenna_t Antennas[]; /**< NumAntennas entries */
+} xroe_bin_radio_t;
+#endif /* end of protection macro */
+/** @} */
@@ -0,0 +1,863 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file xroe_client.c
+* @addtogroup framer_driver_api
+* @{
+*
+*  Client library of xroe-app, see xroe_client.h
+*
+*  Each connection starts with COMMS_PIPELINE_STATUS_CMD, so that every reply
+*  is preceded by its length and the status of its command. Commands are
+*  queued in submission order: those from Head to Unsent wait for their
+*  reply, those from Unsent on wait to be sent. Replies match the commands
+*  in order, so a command not answered in time can only be given up by
+*  dropping the connection.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include <comms.h>
+#include <xroe_client.h>
+
+/**
+ * XROE_CLIENT_MAX_IOV Most commands handed to the socket by one send.
+ */
+#define XROE_CLIENT_MAX_IOV 16
+
+/**
+ * xroe_client_req_struct A command submitted and not completed yet.
+ */
+typedef struct xroe_client_req_struct{
+	struct xroe_client_req_struct *Next;
+	xroe_client_done_t Done;
+	void *Context;
+	struct timespec Deadline;   /**< Time to be answered by, with a timeout */
+	size_t Len;                 /**< Length of the command and its newline */
+	size_t Sent;                /**< Bytes of the command sent */
+	char Command[];
+} xroe_client_req_struct;
+
+/**
+ * xroe_client_struct State of a handle.
+ */
+struct xroe_client_struct{
+	int Fd;                     /**< Connected socket, -1 if not connected */
+	int Timeout;                /**< Time for a command to be answered (ms), 0 for none */
+	struct sockaddr_storage Addr;
+	socklen_t AddrLen;
+	size_t OptionSent;          /**< Bytes of the connection option sent */
+	int Framed;                 /**< The connection option was answered */
+	int Pending;                /**< Number of commands not completed */
+	xroe_client_req_struct *Head;
+	xroe_client_req_struct *Unsent;
+	xroe_client_req_struct *Tail;
+	char *In;                   /**< Replies received and not handled yet */
+	size_t InLen;
+	size_t InSize;
+};
+
+/**
+ * xroe_client_result_struct Reply of a blocking request.
+ */
+typedef struct xroe_client_result_struct{
+	int Done;
+	int Error;
+	int Status;
+	char *Reply;
+	size_t Len;
+} xroe_client_result_struct;
+
+/**
+ * XroeClientOption Connection option sent first on each connection.
+ */
+static const char XroeClientOption[] = COMMS_PIPELINE_STATUS_CMD "\n";
+
+/*****************************************************************************/
+/**
+*
+* Returns the milliseconds left until a time, 0 if it has passed.
+*
+* @param [in]	when   Time (CLOCK_MONOTONIC).
+*
+* @return
+*		- Milliseconds left
+*
+******************************************************************************/
+static int xroe_client_ms_left(const struct timespec *when)
+{
+	struct timespec now;
+	long long ms;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	ms = (when->tv_sec - now.tv_sec) * 1000LL + (when->tv_nsec - now.tv_nsec + 999999) / 1000000;
+	return (ms > 0) ? (int)ms : 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes the oldest command off the queue and completes it.
+*
+* @param [in,out]	client   Handle.
+* @param [in]		error    0, or the errno value of the failure.
+* @param [in]		status   Return value of the command.
+* @param [in]		reply    Reply text, NUL-terminated.
+* @param [in]		len      Length of the reply.
+*
+******************************************************************************/
+static void xroe_client_complete(xroe_client_t *client, int error, int status, const char *reply, size_t len)
+{
+	xroe_client_req_struct *pReq = client->Head;
+
+	client->Head = pReq->Next;
+	if(client->Unsent == pReq)
+	{
+		client->Unsent = pReq->Next;
+	}
+	if(client->Tail == pReq)
+	{
+		client->Tail = NULL;
+	}
+	client->Pending--;
+
+	if(pReq->Done)
+	{
+		pReq->Done(pReq->Context, error, status, reply, len);
+	}
+	free(pReq);
+}
+
+/*****************************************************************************/
+/**
+*
+* Drops the connection, failing the commands sent on it. Those not sent are
+* kept for the next connection.
+*
+* @param [in,out]	client   Handle.
+* @param [in]		error    errno value given to the failed commands.
+*
+******************************************************************************/
+static void xroe_client_drop(xroe_client_t *client, int error)
+{
+	if(client->Fd >= 0)
+	{
+		close(client->Fd);
+		client->Fd = -1;
+	}
+	client->OptionSent = 0;
+	client->Framed = 0;
+	client->InLen = 0;
+
+	/* A partly sent command may still run, as the last of the connection */
+	while(client->Head && ((client->Head != client->Unsent) || client->Head->Sent))
+	{
+		xroe_client_complete(client, error, 0, "", 0);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Tells whether the server closed the connection of a handle.
+*
+* @param [in]	client   Handle, connected.
+*
+* @return
+*		- 1 if the connection is closed or failed
+*		- 0 otherwise
+*
+******************************************************************************/
+static int xroe_client_closed(xroe_client_t *client)
+{
+	ssize_t len;
+	char byte;
+
+	len = recv(client->Fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+	return (len == 0) || ((len < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK));
+}
+
+/*****************************************************************************/
+/**
+*
+* Connects a handle to its server, within the handle timeout.
+*
+* @param [in,out]	client   Handle.
+*
+* @return
+*		- 0 on success
+*		- errno value otherwise
+*
+******************************************************************************/
+static int xroe_client_connect(xroe_client_t *client)
+{
+	struct pollfd pfd;
+	socklen_t optlen = sizeof(int);
+	int one = 1;
+	int err = 0;
+	int fd;
+
+	fd = socket(client->Addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if(fd < 0)
+	{
+		return errno;
+	}
+
+	if(connect(fd, (struct sockaddr *)&client->Addr, client->AddrLen) < 0)
+	{
+		err = errno;
+		if(err == EINPROGRESS)
+		{
+			pfd.fd = fd;
+			pfd.events = POLLOUT;
+			err = poll(&pfd, 1, client->Timeout ? client->Timeout : -1);
+			if(err == 0)
+			{
+				err = ETIMEDOUT;
+			}
+			else if(err < 0)
+			{
+				err = errno;
+			}
+			else if(getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &optlen) < 0)
+			{
+				err = errno;
+			}
+		}
+	}
+	if(err)
+	{
+		close(fd);
+		return err;
+	}
+
+	if(client->Addr.ss_family != AF_UNIX)
+	{
+		/* Pipelined commands are short, do not hold them back */
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	}
+	client->Fd = fd;
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Sends as much of the connection option and of the queued commands as the
+* socket takes, connecting first if needed.
+*
+* @param [in,out]	client   Handle.
+*
+* @return
+*		- 0 on success, the rest is sent once the socket has room
+*		- errno value if the connection failed
+*
+******************************************************************************/
+static int xroe_client_send(xroe_client_t *client)
+{
+	struct iovec iov[1 + XROE_CLIENT_MAX_IOV];
+	struct msghdr msg;
+	xroe_client_req_struct *pReq;
+	ssize_t sent;
+	int count;
+	int err;
+
+	if((client->Fd < 0) && client->Unsent)
+	{
+		err = xroe_client_connect(client);
+		if(err)
+		{
+			return err;
+		}
+	}
+
+	while((client->Fd >= 0) && ((client->OptionSent < sizeof(XroeClientOption) - 1) || client->Unsent))
+	{
+		count = 0;
+		if(client->OptionSent < sizeof(XroeClientOption) - 1)
+		{
+			iov[count].iov_base = (char *)XroeClientOption + client->OptionSent;
+			iov[count].iov_len = sizeof(XroeClientOption) - 1 - client->OptionSent;
+			count++;
+		}
+		for(pReq = client->Unsent; pReq && (count < 1 + XROE_CLIENT_MAX_IOV); pReq = pReq->Next)
+		{
+			iov[count].iov_base = pReq->Command + pReq->Sent;
+			iov[count].iov_len = pReq->Len - pReq->Sent;
+			count++;
+		}
+
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+		msg.msg_iovlen = count;
+		sent = sendmsg(client->Fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if(sent < 0)
+		{
+			if((errno == EAGAIN) || (errno == EWOULDBLOCK))
+			{
+				break;
+			}
+			return errno;
+		}
+
+		/* Account for what was sent, in order */
+		if(client->OptionSent < sizeof(XroeClientOption) - 1)
+		{
+			count = sizeof(XroeClientOption) - 1 - client->OptionSent;
+			count = ((size_t)sent < (size_t)count) ? (int)sent : count;
+			client->OptionSent += count;
+			sent -= count;
+		}
+		while(sent && client->Unsent)
+		{
+			pReq = client->Unsent;
+			if((size_t)sent < pReq->Len - pReq->Sent)
+			{
+				pReq->Sent += sent;
+				break;
+			}
+			sent -= pReq->Len - pReq->Sent;
+			pReq->Sent = pReq->Len;
+			client->Unsent = pReq->Next;
+		}
+	}
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Completes the commands whose replies were received. Each reply is preceded
+* by "<length> <status> <usecs>\n"; the first one, to the connection option,
+* is skipped.
+*
+* @param [in,out]	client   Handle.
+*
+******************************************************************************/
+static void xroe_client_replies(xroe_client_t *client)
+{
+	size_t start = 0;
+	size_t len;
+	char *newline;
+	char *field;
+	char *reply;
+	char saved;
+	int status;
+
+	while((newline = memchr(client->In + start, '\n', client->InLen - start)) != NULL)
+	{
+		len = strtoul(client->In + start, &field, 10);
+		status = (field < newline) ? strtol(field, NULL, 10) : 0;
+		reply = newline + 1;
+		if((size_t)(reply - client->In) + len > client->InLen)
+		{
+			break;
+		}
+		start = reply - client->In + len;
+
+		if(!client->Framed)
+		{
+			client->Framed = 1;
+			continue;
+		}
+		if(!client->Head || (client->Head == client->Unsent))
+		{
+			/* A reply to no command sent, out of step with the server */
+			xroe_client_drop(client, EPROTO);
+			return;
+		}
+
+		/* The buffer has room for the NUL, see xroe_client_read() */
+		saved = reply[len];
+		reply[len] = 0;
+		xroe_client_complete(client, 0, status, reply, len);
+		reply[len] = saved;
+	}
+
+	memmove(client->In, client->In + start, client->InLen - start);
+	client->InLen -= start;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads what the server sent, and completes the commands answered.
+*
+* @param [in,out]	client   Handle.
+*
+* @return
+*		- 0 on success
+*		- errno value if the connection was lost
+*
+******************************************************************************/
+static int xroe_client_read(xroe_client_t *client)
+{
+	size_t size;
+	char *larger;
+	ssize_t len;
+
+	while(client->Fd >= 0)
+	{
+		/* Keep a byte spare to terminate the replies */
+		if(client->InSize - client->InLen < 2)
+		{
+			size = client->InSize ? 2 * client->InSize : 4 * MAX_RESPONSE_LENGTH;
+			larger = realloc(client->In, size);
+			if(!larger)
+			{
+				return ENOMEM;
+			}
+			client->In = larger;
+			client->InSize = size;
+		}
+
+		len = recv(client->Fd, client->In + client->InLen, client->InSize - client->InLen - 1, MSG_DONTWAIT);
+		if(len < 0)
+		{
+			if((errno == EAGAIN) || (errno == EWOULDBLOCK))
+			{
+				return 0;
+			}
+			return errno;
+		}
+		else if(len == 0)
+		{
+			return ECONNRESET;
+		}
+		client->InLen += len;
+		xroe_client_replies(client);
+	}
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Gives up the commands not answered within the handle timeout.
+*
+* @param [in,out]	client   Handle.
+*
+******************************************************************************/
+static void xroe_client_expire(xroe_client_t *client)
+{
+	if(!client->Timeout || !client->Head || xroe_client_ms_left(&client->Head->Deadline))
+	{
+		return;
+	}
+
+	xroe_client_drop(client, ETIMEDOUT);
+	while(client->Head && !xroe_client_ms_left(&client->Head->Deadline))
+	{
+		xroe_client_complete(client, ETIMEDOUT, 0, "", 0);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Opens a handle and connects it to a server.
+*
+* @param [in]	host      IPv4/IPv6 address or name of the server, NULL for
+*                         the local UNIX socket.
+* @param [in]	port      TCP port of the server, 0 for XROE_COMM_PORT.
+* @param [in]	timeout   Time for a command to be answered, and for the
+*                         connection to be made (ms), 0 for no limit.
+*
+* @return
+*		- Handle, to be closed with XROE_CLIENT_API_Close()
+*		- NULL on error, errno set
+*
+******************************************************************************/
+xroe_client_t *XROE_CLIENT_API_Open(const char *host, int port, int timeout)
+{
+	struct addrinfo hints;
+	struct addrinfo *pInfo;
+	struct sockaddr_un *pUnix;
+	xroe_client_t *client;
+	char service[16];
+	int err;
+
+	client = calloc(1, sizeof(*client));
+	if(!client)
+	{
+		return NULL;
+	}
+	client->Fd = -1;
+	client->Timeout = (timeout > 0) ? timeout : 0;
+
+	if(host)
+	{
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		snprintf(service, sizeof(service), "%d", port ? port : XROE_COMM_PORT);
+		err = getaddrinfo(host, service, &hints, &pInfo);
+		if(err)
+		{
+			free(client);
+			errno = (err == EAI_SYSTEM) ? errno : EHOSTUNREACH;
+			return NULL;
+		}
+		memcpy(&client->Addr, pInfo->ai_addr, pInfo->ai_addrlen);
+		client->AddrLen = pInfo->ai_addrlen;
+		freeaddrinfo(pInfo);
+	}
+	else
+	{
+		pUnix = (struct sockaddr_un *)&client->Addr;
+		pUnix->sun_family = AF_UNIX;
+		strncpy(pUnix->sun_path, XROE_SOCKET_FILE, sizeof(pUnix->sun_path) - 1);
+		client->AddrLen = sizeof(*pUnix);
+	}
+
+	err = xroe_client_connect(client);
+	if(err)
+	{
+		free(client);
+		errno = err;
+		return NULL;
+	}
+	return client;
+}
+
+/*****************************************************************************/
+/**
+*
+* Closes a handle. Commands not completed fail with ECANCELED.
+*
+* @param [in]	client   Handle, may be NULL.
+*
+******************************************************************************/
+void XROE_CLIENT_API_Close(xroe_client_t *client)
+{
+	if(!client)
+	{
+		return;
+	}
+
+	if(client->Fd >= 0)
+	{
+		close(client->Fd);
+	}
+	while(client->Head)
+	{
+		xroe_client_complete(client, ECANCELED, 0, "", 0);
+	}
+	free(client->In);
+	free(client);
+}
+
+/*****************************************************************************/
+/**
+*
+* Queues a command, and sends it if the socket has room. The connection is
+* opened again if it was lost.
+*
+* @param [in,out]	client    Handle.
+* @param [in]		command   Command, without newline.
+* @param [in]		done      Completion callback, may be NULL.
+* @param [in]		context   Passed to the callback.
+*
+* @return
+*		- 0 on success, done is called from XROE_CLIENT_API_Process()
+*		- EINVAL if the command is too long or has a newline
+*		- ENOMEM if out of memory
+*		- errno value if the connection cannot be opened, the command is
+*		  not queued
+*
+******************************************************************************/
+int XROE_CLIENT_API_Submit(xroe_client_t *client, const char *command, xroe_client_done_t done, void *context)
+{
+	xroe_client_req_struct *pReq;
+	size_t len = strlen(command);
+	int err;
+
+	if((len >= MAX_RESPONSE_LENGTH) || strchr(command, '\n'))
+	{
+		return EINVAL;
+	}
+
+	/* An idle connection closed by the server is replaced before use */
+	if((client->Fd >= 0) && !client->Head && xroe_client_closed(client))
+	{
+		xroe_client_drop(client, 0);
+	}
+	if(client->Fd < 0)
+	{
+		err = xroe_client_connect(client);
+		if(err)
+		{
+			return err;
+		}
+	}
+
+	pReq = malloc(sizeof(*pReq) + len + 1);
+	if(!pReq)
+	{
+		return ENOMEM;
+	}
+	pReq->Next = NULL;
+	pReq->Done = done;
+	pReq->Context = context;
+	pReq->Len = len + 1;
+	pReq->Sent = 0;
+	memcpy(pReq->Command, command, len);
+	pReq->Command[len] = '\n';
+	if(client->Timeout)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &pReq->Deadline);
+		pReq->Deadline.tv_sec += client->Timeout / 1000;
+		pReq->Deadline.tv_nsec += (client->Timeout % 1000) * 1000000;
+		if(pReq->Deadline.tv_nsec >= 1000000000)
+		{
+			pReq->Deadline.tv_sec++;
+			pReq->Deadline.tv_nsec -= 1000000000;
+		}
+	}
+
+	if(client->Tail)
+	{
+		client->Tail->Next = pReq;
+	}
+	else
+	{
+		client->Head = pReq;
+	}
+	client->Tail = pReq;
+	if(!client->Unsent)
+	{
+		client->Unsent = pReq;
+	}
+	client->Pending++;
+
+	/* Errors are left for XROE_CLIENT_API_Process() to report */
+	err = xroe_client_send(client);
+	if(err)
+	{
+		xroe_client_drop(client, err);
+	}
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Sends the queued commands and completes those answered, waiting for the
+* socket at most the given time. Completion callbacks are called from here.
+*
+* @param [in,out]	client    Handle.
+* @param [in]		timeout   Longest wait (ms), 0 for none, -1 for no limit.
+*
+* @return
+*		- 0 on success
+*		- errno value of poll() otherwise
+*
+******************************************************************************/
+int XROE_CLIENT_API_Process(xroe_client_t *client, int timeout)
+{
+	struct pollfd pfd;
+	int left;
+	int err;
+
+	/* Commands kept from a lost connection are sent on a new one */
+	if((client->Fd < 0) && client->Unsent)
+	{
+		err = xroe_client_send(client);
+		while(err && client->Head)
+		{
+			xroe_client_complete(client, err, 0, "", 0);
+		}
+	}
+	if(client->Fd < 0)
+	{
+		return 0;
+	}
+
+	if(client->Timeout && client->Head)
+	{
+		left = xroe_client_ms_left(&client->Head->Deadline);
+		timeout = ((timeout < 0) || (left < timeout)) ? left : timeout;
+	}
+
+	pfd.fd = client->Fd;
+	pfd.events = XROE_CLIENT_API_Events(client);
+	if(poll(&pfd, 1, timeout) < 0)
+	{
+		return (errno == EINTR) ? 0 : errno;
+	}
+
+	err = 0;
+	if(pfd.revents & POLLOUT)
+	{
+		err = xroe_client_send(client);
+	}
+	if(!err && (pfd.revents & (POLLIN | POLLHUP | POLLERR)))
+	{
+		err = xroe_client_read(client);
+	}
+	if(err)
+	{
+		xroe_client_drop(client, err);
+	}
+
+	xroe_client_expire(client);
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Completion callback of a blocking request, keeping a copy of the reply.
+*
+* @param [in]	context   xroe_client_result_struct of the request.
+* @param [in]	error     0, or the errno value of the failure.
+* @param [in]	status    Return value of the command.
+* @param [in]	reply     Reply text.
+* @param [in]	len       Length of the reply.
+*
+******************************************************************************/
+static void xroe_client_result(void *context, int error, int status, const char *reply, size_t len)
+{
+	xroe_client_result_struct *pResult = context;
+
+	pResult->Done = 1;
+	pResult->Error = error;
+	pResult->Status = status;
+	if(!error)
+	{
+		pResult->Reply = malloc(len + 1);
+		if(!pResult->Reply)
+		{
+			pResult->Error = ENOMEM;
+			return;
+		}
+		memcpy(pResult->Reply, reply, len + 1);
+		pResult->Len = len;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Sends a command and waits for its reply, within the handle timeout. The
+* commands submitted before it are completed on the way.
+*
+* @param [in,out]	client    Handle.
+* @param [in]		command   Command, without newline.
+* @param [out]		reply     Reply text, NUL-terminated, to be freed by the
+*                             caller. NULL on error.
+* @param [out]		len       Length of the reply, may be NULL.
+* @param [out]		status    Return value of the command, may be NULL.
+*
+* @return
+*		- 0 on success
+*		- errno value otherwise
+*
+******************************************************************************/
+int XROE_CLIENT_API_Request(xroe_client_t *client, const char *command, char **reply, size_t *len, int *status)
+{
+	xroe_client_result_struct result;
+	int err;
+
+	memset(&result, 0, sizeof(result));
+	*reply = NULL;
+
+	err = XROE_CLIENT_API_Submit(client, command, xroe_client_result, &result);
+	while(!err && !result.Done)
+	{
+		err = XROE_CLIENT_API_Process(client, -1);
+	}
+	if(err && !result.Done)
+	{
+		/* Fail the request now, its result lives on this stack */
+		xroe_client_drop(client, err);
+		while(client->Head && !result.Done)
+		{
+			xroe_client_complete(client, err, 0, "", 0);
+		}
+		return err;
+	}
+
+	*reply = result.Reply;
+	if(len)
+	{
+		*len = result.Len;
+	}
+	if(status)
+	{
+		*status = result.Status;
+	}
+	return result.Error;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the number of commands submitted and not completed yet.
+*
+* @param [in]	client   Handle.
+*
+* @return
+*		- Number of commands
+*
+******************************************************************************/
+int XROE_CLIENT_API_Pending(const xroe_client_t *client)
+{
+	return client->Pending;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the socket of a handle, to be polled for XROE_CLIENT_API_Events().
+*
+* @param [in]	client   Handle.
+*
+* @return
+*		- Socket
+*		- -1 if not connected, XROE_CLIENT_API_Process() reconnects
+*
+******************************************************************************/
+int XROE_CLIENT_API_Fd(const xroe_client_t *client)
+{
+	return client->Fd;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the poll() events a handle waits for.
+*
+* @param [in]	client   Handle.
+*
+* @return
+*		- POLLIN, with POLLOUT while commands wait to be sent
+*
+******************************************************************************/
+short XROE_CLIENT_API_Events(const xroe_client_t *client)
+{
+	if((client->OptionSent < sizeof(XroeClientOption) - 1) || client->Unsent)
+	{
+		return POLLIN | POLLOUT;
+	}
+	return POLLIN;
+}
+/** @} */
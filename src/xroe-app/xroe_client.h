@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file xroe_client.h
+* @addtogroup framer_driver_api
+* @{
+*
+*  Client library of xroe-app (libxroe-client.a)
+*
+*  A handle holds one connection to an xroe-app server, reused by all the
+*  commands sent through it. Commands are pipelined: any number may be
+*  submitted before the first is answered, and each completion callback is
+*  called, in submission order, from XROE_CLIENT_API_Process(). A blocking
+*  request is a submission followed by processing until it is answered.
+*
+*  The library never exits or prints, errors are returned as errno values:
+*  - ETIMEDOUT: a command was not answered within the handle timeout
+*  - ECONNRESET, EPIPE...: the connection was lost
+*
+*  The connection is opened again, when lost, for the next commands sent.
+*  Commands already sent on a lost connection fail, as they may have run;
+*  commands not sent yet are kept for the new connection.
+*
+*  Many handles can be served by one thread by polling the descriptors of
+*  XROE_CLIENT_API_Fd() for XROE_CLIENT_API_Events(), then calling
+*  XROE_CLIENT_API_Process() with a timeout of 0. For example:
+*
+*  @code
+*	xroe_client_t *unit = XROE_CLIENT_API_Open("192.168.1.10", 0, 1000);
+*	char *reply;
+*	size_t len;
+*	int status;
+*
+*	if(unit && !XROE_CLIENT_API_Request(unit, "stats totals", &reply, &len, &status))
+*	{
+*		fwrite(reply, 1, len, stdout);
+*		free(reply);
+*	}
+*	XROE_CLIENT_API_Close(unit);
+*  @endcode
+*
+*  Commands taking over the connection, such as "subscribe", are not
+*  supported.
+*
+******************************************************************************/
+#ifndef XROE_CLIENT_H		/* prevent circular inclusions */
+#define XROE_CLIENT_H		/* by using protection macros */
+
+#include <stddef.h>
+
+/**
+ * xroe_client_t Handle of a connection to a server, opaque.
+ */
+typedef struct xroe_client_struct xroe_client_t;
+
+/**
+ * xroe_client_done_t Completion callback of a command.
+ *
+ * @param [in]	context   Context given when submitting the command.
+ * @param [in]	error     0, or the errno value of the connection failure.
+ * @param [in]	status    Return value of the command on the server.
+ * @param [in]	reply     Reply text, NUL-terminated, valid for the call only.
+ * @param [in]	len       Length of the reply.
+ *
+ * A callback may submit commands, but not process the handle or close it.
+ */
+typedef void (*xroe_client_done_t)(void *context, int error, int status, const char *reply, size_t len);
+
+/************************** Function Prototypes ******************************/
+xroe_client_t *XROE_CLIENT_API_Open(const char *host, int port, int timeout);
+void XROE_CLIENT_API_Close(xroe_client_t *client);
+int XROE_CLIENT_API_Submit(xroe_client_t *client, const char *command, xroe_client_done_t done, void *context);
+int XROE_CLIENT_API_Process(xroe_client_t *client, int timeout);
+int XROE_CLIENT_API_Request(xroe_client_t *client, const char *command, char **reply, size_t *len, int *status);
+int XROE_CLIENT_API_Pending(const xroe_client_t *client);
+int XROE_CLIENT_API_Fd(const xroe_client_t *client);
+short XROE_CLIENT_API_Events(const xroe_client_t *client);
+#endif /* end of protection macro */
+/** @} */
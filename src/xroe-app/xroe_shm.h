@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/
+
+/**
+* @file xroe_shm.h
+* @addtogroup framer_driver_api
+* @{
+*
+*  Shared memory statistics published by xroe-app, for local readers
+*
+*  The server publishes its latest statistics totals, radio and antenna
+*  status and eCPRI OWDM result in the POSIX shared memory object
+*  XROE_SHM_NAME. Writes are protected by a sequence lock: Sequence is odd
+*  while the server updates the segment, and changes with every update. This
+*  header is all a reader needs, for example:
+*
+*  @code
+*	const xroe_shm_stats_t *shm = xroe_shm_open();
+*	xroe_shm_stats_t stats;
+*
+*	if(shm && !xroe_shm_read(shm, &stats))
+*		printf("%" PRIu64 "\n", stats.Totals[0][0]);
+*  @endcode
+*
+*  Only xroe_shm_open() makes system calls, reads are plain memory copies
+*  and never hold up the server.
+*
+******************************************************************************/
+#ifndef XROE_SHM_H		/* prevent circular inclusions */
+#define XROE_SHM_H		/* by using protection macros */
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/* Name of the shared memory object, under /dev/shm */
+#define XROE_SHM_NAME "/xroe-stats"
+
+/* Layout version, changed whenever xroe_shm_stats_t changes */
+#define XROE_SHM_VERSION 1
+
+/* Sizes of the arrays of the segment */
+#define XROE_SHM_MAX_PORTS 4
+#define XROE_SHM_MAX_COUNTERS 16
+#define XROE_SHM_MAX_ANTENNAS 8
+#define XROE_SHM_NAME_LENGTH 32
+
+/* Attempts of xroe_shm_read() to get a copy not torn by an update */
+#define XROE_SHM_READ_RETRIES 1000
+
+/**
+ * xroe_shm_antenna_t Deframer buffer state of an antenna.
+ */
+typedef struct xroe_shm_antenna_t{
+	uint32_t Align;
+	uint32_t Regular;
+	uint32_t Overflow;
+	uint32_t Underflow;
+	uint32_t CheckError;
+	uint32_t BufStateLatency;
+} xroe_shm_antenna_t;
+
+/**
+ * xroe_shm_stats_t Content of the shared memory segment.
+ */
+typedef struct xroe_shm_stats_t{
+	uint32_t Version;      /**< XROE_SHM_VERSION */
+	uint32_t Size;         /**< sizeof(xroe_shm_stats_t) */
+	uint32_t Sequence;     /**< Odd while an update is in progress */
+	uint32_t Reserved;
+	uint64_t Updates;      /**< Number of updates since the server started */
+	uint64_t TimestampMs;  /**< Wall clock time of the update */
+
+	/* Statistics totals, as "stats totals" */
+	uint32_t NumPorts;
+	uint32_t NumCounters;
+	char CounterNames[XROE_SHM_MAX_COUNTERS][XROE_SHM_NAME_LENGTH];
+	uint64_t Totals[XROE_SHM_MAX_PORTS][XROE_SHM_MAX_COUNTERS];
+	uint32_t Wraps[XROE_SHM_MAX_PORTS][XROE_SHM_MAX_COUNTERS];
+
+	/* Radio and antenna status, as "radio gui", valid if RadioValid is set */
+	uint32_t RadioValid;
+	uint32_t RadioEnable;
+	uint32_t RadioError;
+	uint32_t RadioStatus;
+	uint32_t RadioLoopback;
+	uint32_t NumAntennas;
+	xroe_shm_antenna_t Antennas[XROE_SHM_MAX_ANTENNAS];
+
+	/* Latest eCPRI One-Way Delay Measurement, as "ecpri owdm_res" */
+	uint32_t OwdmRequests;
+	uint32_t OwdmResponses;
+	uint32_t OwdmDirection;  /**< 0 TO_REMOTE, 1 FROM_REMOTE */
+	uint32_t OwdmNode;       /**< IPv4 address of the other node, network order */
+	uint64_t OwdmDelaySec;
+	uint64_t OwdmDelayNsec;
+} xroe_shm_stats_t;
+
+/*****************************************************************************/
+/**
+*
+* Maps the statistics published by the server, read-only.
+*
+* @return
+*		- Pointer to the segment
+*		- NULL with errno set if the server does not publish statistics
+*
+******************************************************************************/
+static inline const xroe_shm_stats_t *xroe_shm_open(void)
+{
+	void *shm;
+	int fd;
+
+	fd = shm_open(XROE_SHM_NAME, O_RDONLY, 0);
+	if(fd < 0)
+	{
+		return NULL;
+	}
+
+	shm = mmap(NULL, sizeof(xroe_shm_stats_t), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	return (shm == MAP_FAILED) ? NULL : (const xroe_shm_stats_t *)shm;
+}
+
+/*****************************************************************************/
+/**
+*
+* Copies a consistent view of the published statistics.
+*
+* @param [in]	shm     Segment mapped by xroe_shm_open().
+* @param [out]	pStats  Pointer to copy the statistics to.
+*
+* @return
+*		- 0 on success
+*		- EPROTO if the segment is of another layout version
+*		- EAGAIN if no update-free copy could be taken
+*
+******************************************************************************/
+static inline int xroe_shm_read(const xroe_shm_stats_t *shm, xroe_shm_stats_t *pStats)
+{
+	uint32_t before;
+	uint32_t after;
+	int i;
+
+	for(i = 0; i < XROE_SHM_READ_RETRIES; i++)
+	{
+		before = __atomic_load_n(&shm->Sequence, __ATOMIC_ACQUIRE);
+		if(before & 1)
+		{
+			continue;
+		}
+
+		memcpy(pStats, shm, sizeof(*pStats));
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		after = __atomic_load_n(&shm->Sequence, __ATOMIC_RELAXED);
+		if(before == after)
+		{
+			return ((pStats->Version == XROE_SHM_VERSION) && (pStats->Size == sizeof(*pStats))) ? 0 : EPROTO;
+		}
+	}
+
+	return EAGAIN;
+}
+#endif /* end of protection macro */
+/** @} */
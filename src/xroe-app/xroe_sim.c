@@ -0,0 +1,900 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/ 
+
+/** 
+* @file xroe_sim.c
+* @addtogroup framer_driver_api
+* @{
+*
+*  Simulated Radio over Ethernet Framer and traffic generator device backend
+*
+*  Models the roe_framer register map and the roe_radio_ctrl register map in
+*  memory together with the sysfs attributes of the framer and traffic
+*  generator drivers, so that xroe-app can run without the hardware. The
+*  statistics counters advance at configurable packet rates while the
+*  deframer is out of restart.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <time.h>
+#include <inttypes.h>
+#include <roe_framer_ctrl.h>
+#include <roe_radio_ctrl.h>
+#include <xroe_api.h>
+#include <xroe_sim.h>
+
+/* Size in words of the simulated framer register map (0x0-0xFFFF) */
+#define SIM_FRAMER_WORDS (0x10000 >> 2)
+
+/* Size in words of the simulated radio control register map (0x0-0x1FFF) */
+#define SIM_RADIO_WORDS (0x2000 >> 2)
+
+/* Number of antennas and Ethernet ports reported by the simulated framer */
+#define SIM_NUM_ANTENNAS 8
+#define SIM_NUM_ETH_PORTS 1
+
+/* Packet rates used until changed with SIM_API_Set_Rates() */
+#define SIM_DEFAULT_DATA_PPS 100000
+#define SIM_DEFAULT_CTRL_PPS 1000
+#define SIM_DEFAULT_BAD_PPS 0
+
+/* Traffic generator fields exposed in sysfs but missing from roe_radio_ctrl.h */
+#define SIM_RADIO_SOURCE_ENABLE_ADDR 0x50
+#define SIM_RADIO_SOURCE_ENABLE_MASK 0x1
+#define SIM_RADIO_SOURCE_ENABLE_OFFSET 0x0
+#define SIM_RADIO_APP_SCRATCH_REG_0_ADDR 0x60
+#define SIM_RADIO_APP_SCRATCH_REG_1_ADDR 0x64
+#define SIM_RADIO_APP_SCRATCH_REG_2_ADDR 0x68
+#define SIM_RADIO_APP_SCRATCH_REG_3_ADDR 0x6c
+#define SIM_RADIO_APP_SCRATCH_REG_MASK 0xffffffff
+#define SIM_RADIO_APP_SCRATCH_REG_OFFSET 0x0
+
+/* sysfs directories of the framer and traffic generator drivers */
+#define SIM_SYSFS_XROE "/sys/kernel/xroe/"
+#define SIM_SYSFS_STATS SIM_SYSFS_XROE "stats/"
+#define SIM_SYSFS_TRAFFIC "/sys/kernel/traffic/"
+
+#define SIM_NS_PER_SEC 1000000000ULL
+
+/**
+ * sim_field_struct A register field and a value for it.
+ */
+typedef struct sim_field_struct{
+	uint32_t addr;
+	uint32_t mask;
+	uint32_t offset;
+	uint32_t value;
+} sim_field_struct;
+
+/* Field with its register map reset value */
+#define SIM_FIELD(_reg) {_reg##_ADDR, _reg##_MASK, _reg##_OFFSET, _reg##_DEFAULT}
+
+/**
+ * sim_attr_struct A sysfs attribute backed by a register field.
+ */
+typedef struct sim_attr_struct{
+	const char *name;
+	uint32_t addr;
+	uint32_t mask;
+	uint32_t offset;
+} sim_attr_struct;
+
+/* Attribute named _name backed by the field _reg */
+#define SIM_ATTR(_name, _reg) {#_name, _reg##_ADDR, _reg##_MASK, _reg##_OFFSET}
+
+/**
+ * SimFramerDefaults Non-zero reset values of the framer register map.
+ */
+static const sim_field_struct SimFramerDefaults[] = {
+	SIM_FIELD(CFG_MAJOR_REVISION),
+	SIM_FIELD(CFG_MINOR_REVISION),
+	SIM_FIELD(CFG_VERSION_REVISION),
+	SIM_FIELD(CFG_INTERNAL_REVISION),
+	SIM_FIELD(CFG_TIMEOUT_VALUE),
+	SIM_FIELD(CFG_AXI_TIMEOUT_ENABLE),
+	{CFG_CONFIG_NO_OF_FRAM_ANTS_ADDR, CFG_CONFIG_NO_OF_FRAM_ANTS_MASK, CFG_CONFIG_NO_OF_FRAM_ANTS_OFFSET, SIM_NUM_ANTENNAS},
+	{CFG_CONFIG_NO_OF_DEFM_ANTS_ADDR, CFG_CONFIG_NO_OF_DEFM_ANTS_MASK, CFG_CONFIG_NO_OF_DEFM_ANTS_OFFSET, SIM_NUM_ANTENNAS},
+	{CFG_CONFIG_NO_OF_ETH_PORTS_ADDR, CFG_CONFIG_NO_OF_ETH_PORTS_MASK, CFG_CONFIG_NO_OF_ETH_PORTS_OFFSET, SIM_NUM_ETH_PORTS},
+	SIM_FIELD(FRAM_RESTART),
+	SIM_FIELD(FRAM_SN_DATA_LOW_CNT_MIN),
+	SIM_FIELD(FRAM_SN_DATA_LOW_CNT_MAX),
+	SIM_FIELD(FRAM_SN_DATA_LOW_CNT_INITVAL),
+	SIM_FIELD(FRAM_SN_DATA_LOW_CNT_INCVAL),
+	SIM_FIELD(FRAM_SN_DATA_HIGH_CNT_MAX),
+	SIM_FIELD(FRAM_SN_DATA_HIGH_CNT_INITVAL),
+	SIM_FIELD(FRAM_SN_DATA_HIGH_CNT_INCVAL),
+	SIM_FIELD(FRAM_SN_CTRL_LOW_CNT_MIN),
+	SIM_FIELD(FRAM_SN_CTRL_LOW_CNT_MAX),
+	SIM_FIELD(FRAM_SN_CTRL_LOW_CNT_INITVAL),
+	SIM_FIELD(FRAM_SN_CTRL_LOW_CNT_INCVAL),
+	SIM_FIELD(FRAM_SN_CTRL_HIGH_CNT_MAX),
+	SIM_FIELD(FRAM_SN_CTRL_HIGH_CNT_INITVAL),
+	SIM_FIELD(FRAM_SN_CTRL_HIGH_CNT_INCVAL),
+	SIM_FIELD(DEFM_RESTART),
+	SIM_FIELD(DEFM_SN_DATA_LOW_CNT_MIN),
+	SIM_FIELD(DEFM_SN_DATA_LOW_CNT_MAX),
+	SIM_FIELD(DEFM_SN_DATA_LOW_CNT_INCVAL),
+	SIM_FIELD(DEFM_SN_DATA_HIGH_CNT_MAX),
+	SIM_FIELD(DEFM_SN_DATA_HIGH_CNT_INCVAL),
+	SIM_FIELD(DEFM_SN_CTRL_LOW_CNT_MIN),
+	SIM_FIELD(DEFM_SN_CTRL_LOW_CNT_MAX),
+	SIM_FIELD(DEFM_SN_CTRL_LOW_CNT_INCVAL),
+	SIM_FIELD(DEFM_SN_CTRL_HIGH_CNT_MAX),
+	SIM_FIELD(DEFM_SN_CTRL_HIGH_CNT_INCVAL),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W0_31_0),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W0_63_32),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W0_95_64),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W0_127_96),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W0_MASK),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W1_31_0),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W1_63_32),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W1_95_64),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W1_127_96),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W1_MASK),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W2_31_0),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W2_63_32),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W2_95_64),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W2_127_96),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W2_MASK),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W3_31_0),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W3_63_32),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W3_95_64),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W3_127_96),
+	SIM_FIELD(DEFM_USER_DATA_FILTER_W3_MASK),
+	SIM_FIELD(ETH_VLAN_ID),
+	SIM_FIELD(ETH_VLAN_PCP),
+	SIM_FIELD(ETH_IPV4_VERSION),
+	SIM_FIELD(ETH_IPV4_IHL),
+	SIM_FIELD(ETH_IPV4_DSCP),
+	SIM_FIELD(ETH_IPV4_FLAGS),
+	SIM_FIELD(ETH_IPV4_TIME_TO_LIVE),
+	SIM_FIELD(ETH_IPV4_PROTOCOL),
+	SIM_FIELD(ETH_UDP_SOURCE_PORT),
+	SIM_FIELD(ETH_UDP_DESTINATION_PORT),
+	SIM_FIELD(ETH_IPV6_V),
+	SIM_FIELD(ETH_IPV6_NEXT_HEADER),
+	SIM_FIELD(ETH_IPV6_HOP_LIMIT)
+};
+
+/**
+ * SimRadioDefaults Non-zero reset values of the radio control register map.
+ */
+static const sim_field_struct SimRadioDefaults[] = {
+	SIM_FIELD(RADIO_ID),
+	SIM_FIELD(RADIO_TIMEOUT_STATUS),
+	SIM_FIELD(RADIO_TIMEOUT_VALUE),
+	SIM_FIELD(RADIO_SINK_ENABLE)
+};
+
+/**
+ * SimStatsAttrs Attributes of the framer driver stats directory.
+ */
+static const sim_attr_struct SimStatsAttrs[] = {
+	SIM_ATTR(total_rx_good_pkt, STATS_TOTAL_RX_GOOD_PKT_CNT),
+	SIM_ATTR(total_rx_bad_pkt, STATS_TOTAL_RX_BAD_PKT_CNT),
+	SIM_ATTR(total_rx_bad_fcs, STATS_TOTAL_RX_BAD_FCS_CNT),
+	SIM_ATTR(total_rx_user_pkt, STATS_USER_DATA_RX_PACKETS_CNT),
+	SIM_ATTR(total_rx_good_user_pkt, STATS_USER_DATA_RX_GOOD_PKT_CNT),
+	SIM_ATTR(total_rx_bad_user_pkt, STATS_USER_DATA_RX_BAD_PKT_CNT),
+	SIM_ATTR(total_rx_bad_user_fcs, STATS_USER_DATA_RX_BAD_FCS_CNT),
+	SIM_ATTR(total_rx_user_ctrl_pkt, STATS_USER_CTRL_RX_PACKETS_CNT),
+	SIM_ATTR(total_rx_good_user_ctrl_pkt, STATS_USER_CTRL_RX_GOOD_PKT_CNT),
+	SIM_ATTR(total_rx_bad_user_ctrl_pkt, STATS_USER_CTRL_RX_BAD_PKT_CNT),
+	SIM_ATTR(total_rx_bad_user_ctrl_fcs, STATS_USER_CTRL_RX_BAD_FCS_CNT),
+	SIM_ATTR(rx_user_pkt_rate, STATS_USER_DATA_RX_PKTS_RATE),
+	SIM_ATTR(rx_user_ctrl_pkt_rate, STATS_USER_CTRL_RX_PKTS_RATE)
+};
+
+/**
+ * SimTrafficAttrs Attributes of the traffic generator driver.
+ */
+static const sim_attr_struct SimTrafficAttrs[] = {
+	SIM_ATTR(radio_id, RADIO_ID),
+	SIM_ATTR(radio_timeout_enable, RADIO_TIMEOUT_ENABLE),
+	SIM_ATTR(radio_timeout_status, RADIO_TIMEOUT_STATUS),
+	SIM_ATTR(radio_timeout_value, RADIO_TIMEOUT_VALUE),
+	SIM_ATTR(radio_gpio_cdc_ledmode2, RADIO_GPIO_CDC_LEDMODE2),
+	SIM_ATTR(radio_gpio_cdc_ledgpio, RADIO_GPIO_CDC_LEDGPIO),
+	SIM_ATTR(radio_gpio_cdc_dipstatus, RADIO_GPIO_CDC_DIPSTATUS),
+	SIM_ATTR(radio_sw_trigger, RADIO_SW_TRIGGER),
+	SIM_ATTR(radio_cdc_enable, RADIO_CDC_ENABLE),
+	SIM_ATTR(radio_cdc_error, RADIO_CDC_ERROR),
+	SIM_ATTR(radio_cdc_status, RADIO_CDC_STATUS),
+	SIM_ATTR(radio_cdc_loopback, RADIO_CDC_LOOPBACK),
+	SIM_ATTR(radio_sink_enable, RADIO_SINK_ENABLE),
+	SIM_ATTR(radio_cdc_error_31_0, RADIO_CDC_ERROR_31_0),
+	SIM_ATTR(radio_cdc_error_63_32, RADIO_CDC_ERROR_63_32),
+	SIM_ATTR(radio_cdc_error_95_64, RADIO_CDC_ERROR_95_64),
+	SIM_ATTR(radio_cdc_error_127_96, RADIO_CDC_ERROR_127_96),
+	SIM_ATTR(radio_cdc_status_31_0, RADIO_CDC_STATUS_31_0),
+	SIM_ATTR(radio_cdc_status_63_32, RADIO_CDC_STATUS_63_32),
+	SIM_ATTR(radio_cdc_status_95_64, RADIO_CDC_STATUS_95_64),
+	SIM_ATTR(radio_cdc_status_127_96, RADIO_CDC_STATUS_127_96),
+	SIM_ATTR(radio_source_enable, SIM_RADIO_SOURCE_ENABLE),
+	{"radio_app_scratch_reg_0", SIM_RADIO_APP_SCRATCH_REG_0_ADDR, SIM_RADIO_APP_SCRATCH_REG_MASK, SIM_RADIO_APP_SCRATCH_REG_OFFSET},
+	{"radio_app_scratch_reg_1", SIM_RADIO_APP_SCRATCH_REG_1_ADDR, SIM_RADIO_APP_SCRATCH_REG_MASK, SIM_RADIO_APP_SCRATCH_REG_OFFSET},
+	{"radio_app_scratch_reg_2", SIM_RADIO_APP_SCRATCH_REG_2_ADDR, SIM_RADIO_APP_SCRATCH_REG_MASK, SIM_RADIO_APP_SCRATCH_REG_OFFSET},
+	{"radio_app_scratch_reg_3", SIM_RADIO_APP_SCRATCH_REG_3_ADDR, SIM_RADIO_APP_SCRATCH_REG_MASK, SIM_RADIO_APP_SCRATCH_REG_OFFSET},
+	SIM_ATTR(fram_packet_data_size, FRAM_PACKET_DATA_SIZE),
+	SIM_ATTR(fram_pause_data_size, FRAM_PAUSE_DATA_SIZE)
+};
+
+/**
+ * sim_state_struct State of the simulated devices.
+ */
+typedef struct sim_state_struct{
+	int Initialised;
+	uint32_t Framer[SIM_FRAMER_WORDS];
+	uint32_t Radio[SIM_RADIO_WORDS];
+	uint32_t DataPps;
+	uint32_t CtrlPps;
+	uint32_t BadPps;
+	uint64_t DataGood;
+	uint64_t DataBad;
+	uint64_t CtrlGood;
+	uint64_t DataRem;
+	uint64_t BadRem;
+	uint64_t CtrlRem;
+	struct timespec LastUpdate;
+} sim_state_struct;
+
+/**
+ * Sim Simulated device state.
+ */
+static sim_state_struct Sim;
+
+/*****************************************************************************/
+/**
+*
+* Applies a list of field values to a register map.
+*
+* @param [out]	regs   Register map to write into
+* @param [in]	fields Fields to apply
+* @param [in]	num    Number of entries in fields
+*
+******************************************************************************/
+static void sim_apply_fields(uint32_t *regs, const sim_field_struct *fields, int num)
+{
+	int i;
+
+	for(i = 0; i < num; i++)
+	{
+		regs[fields[i].addr >> 2] &= ~fields[i].mask;
+		regs[fields[i].addr >> 2] |= (fields[i].value << fields[i].offset) & fields[i].mask;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Updates the ready bit of a restart/ready register from its restart bit.
+*
+* @param [in]	addr   Address of the FRAM or DEFM restart register
+*
+******************************************************************************/
+static void sim_update_ready(uint32_t addr)
+{
+	uint32_t *reg = &Sim.Framer[addr >> 2];
+
+	/* FRAM and DEFM use the same restart/ready layout */
+	if(*reg & FRAM_RESTART_MASK)
+	{
+		*reg &= ~FRAM_READY_MASK;
+	}
+	else
+	{
+		*reg |= FRAM_READY_MASK;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Adds rate x elapsed packets to a counter, keeping the sub-packet remainder.
+*
+* @param [in,out]	pCount Counter to advance
+* @param [in,out]	pRem   Remainder in packet nanoseconds
+* @param [in]		pps    Packet rate
+* @param [in]		ns     Elapsed time in nanoseconds
+*
+******************************************************************************/
+static void sim_accumulate(uint64_t *pCount, uint64_t *pRem, uint32_t pps, uint64_t ns)
+{
+	uint64_t acc;
+
+	*pCount += (uint64_t)pps * (ns / SIM_NS_PER_SEC);
+	acc = (uint64_t)pps * (ns % SIM_NS_PER_SEC) + *pRem;
+	*pCount += acc / SIM_NS_PER_SEC;
+	*pRem = acc % SIM_NS_PER_SEC;
+}
+
+/*****************************************************************************/
+/**
+*
+* Advances the receive counters to the current time.
+* Packets are only received while the deframer is out of restart.
+*
+******************************************************************************/
+static void sim_advance(void)
+{
+	struct timespec now;
+	uint64_t ns;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	ns = (uint64_t)(now.tv_sec - Sim.LastUpdate.tv_sec) * SIM_NS_PER_SEC +
+		now.tv_nsec - Sim.LastUpdate.tv_nsec;
+	Sim.LastUpdate = now;
+
+	if(Sim.Framer[DEFM_RESTART_ADDR >> 2] & DEFM_RESTART_MASK)
+	{
+		return;
+	}
+
+	sim_accumulate(&Sim.DataGood, &Sim.DataRem, Sim.DataPps, ns);
+	sim_accumulate(&Sim.DataBad, &Sim.BadRem, Sim.BadPps, ns);
+	sim_accumulate(&Sim.CtrlGood, &Sim.CtrlRem, Sim.CtrlPps, ns);
+}
+
+/*****************************************************************************/
+/**
+*
+* Initialises the simulated devices on first use.
+*
+******************************************************************************/
+static void sim_init(void)
+{
+	if(!Sim.Initialised)
+	{
+		SIM_API_Reset();
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the value of a statistics counter register, as of the last update
+* of the counters. Bad packets are all counted as user data packets with a bad
+* FCS.
+*
+* @param [in]	addr   Address of the counter in the framer address space
+*
+* @return
+*		- The lower 32 bits of the counter, as the hardware counter wraps
+*
+******************************************************************************/
+static uint32_t sim_stats_value(uint32_t addr)
+{
+	int running = !(Sim.Framer[DEFM_RESTART_ADDR >> 2] & DEFM_RESTART_MASK);
+
+	switch(addr)
+	{
+	case STATS_TOTAL_RX_GOOD_PKT_CNT_ADDR:
+		return (uint32_t)(Sim.DataGood + Sim.CtrlGood);
+	case STATS_TOTAL_RX_BAD_PKT_CNT_ADDR:
+	case STATS_TOTAL_RX_BAD_FCS_CNT_ADDR:
+	case STATS_USER_DATA_RX_BAD_PKT_CNT_ADDR:
+	case STATS_USER_DATA_RX_BAD_FCS_CNT_ADDR:
+		return (uint32_t)Sim.DataBad;
+	case STATS_USER_DATA_RX_PACKETS_CNT_ADDR:
+		return (uint32_t)(Sim.DataGood + Sim.DataBad);
+	case STATS_USER_DATA_RX_GOOD_PKT_CNT_ADDR:
+		return (uint32_t)Sim.DataGood;
+	case STATS_USER_CTRL_RX_PACKETS_CNT_ADDR:
+	case STATS_USER_CTRL_RX_GOOD_PKT_CNT_ADDR:
+		return (uint32_t)Sim.CtrlGood;
+	case STATS_USER_DATA_RX_PKTS_RATE_ADDR:
+		return running ? Sim.DataPps : 0;
+	case STATS_USER_CTRL_RX_PKTS_RATE_ADDR:
+		return running ? Sim.CtrlPps : 0;
+	default:
+		return 0;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the current value of a statistics counter register.
+*
+* @param [in]	addr   Address of the counter in the framer address space
+*
+* @return
+*		- The lower 32 bits of the counter, as the hardware counter wraps
+*
+******************************************************************************/
+static uint32_t sim_read_stats(uint32_t addr)
+{
+	sim_advance();
+
+	return sim_stats_value(addr);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the number of Ethernet ports of the simulated framer, as set in
+* its CFG_CONFIG_NO_OF_ETH_PORTS register.
+*
+* @return
+*		- Number of ports, between 1 and XROE_STATS_SNAPSHOT_MAX_PORTS
+*
+******************************************************************************/
+static int sim_num_eth_ports(void)
+{
+	uint32_t num_ports = (Sim.Framer[CFG_CONFIG_NO_OF_ETH_PORTS_ADDR >> 2] & CFG_CONFIG_NO_OF_ETH_PORTS_MASK) >> CFG_CONFIG_NO_OF_ETH_PORTS_OFFSET;
+
+	if(num_ports < 1)
+	{
+		return 1;
+	}
+
+	return (num_ports < XROE_STATS_SNAPSHOT_MAX_PORTS) ? num_ports : XROE_STATS_SNAPSHOT_MAX_PORTS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Fills in a binary statistics snapshot, as read from the stats "snapshot"
+* attribute. All counters are taken at the same point in time.
+*
+* @param [out]	buf    Buffer to read into
+* @param [in]	length Size of buf
+*
+* @return
+*		- Number of bytes read
+*
+******************************************************************************/
+static int sim_stats_snapshot(char *buf, int length)
+{
+	xroe_stats_snapshot_t snapshot;
+	struct timespec now;
+	int num_ports = sim_num_eth_ports();
+	int port;
+	int i;
+	int w;
+
+	memset(&snapshot, 0, sizeof(snapshot));
+	snapshot.version = XROE_STATS_SNAPSHOT_VERSION;
+	snapshot.num_ports = num_ports;
+	snapshot.num_words = XROE_STATS_SNAPSHOT_WORDS;
+
+	sim_advance();
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	snapshot.timestamp_ns = (uint64_t)now.tv_sec * SIM_NS_PER_SEC + now.tv_nsec;
+
+	/* All simulated ports see the same traffic */
+	for(port = 0; port < num_ports; port++)
+	{
+		for(i = 0; i < XROE_STATS_SNAPSHOT_WORDS; i++)
+		{
+			snapshot.words[port][i] = sim_stats_value(STATS_TOTAL_RX_GOOD_PKT_CNT_ADDR + (i << 2));
+		}
+	}
+
+	w = offsetof(xroe_stats_snapshot_t, words) + num_ports * sizeof(snapshot.words[0]);
+	w = (w < length) ? w : length;
+	memcpy(buf, &snapshot, w);
+
+	return w;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads a word of the simulated framer register map.
+*
+* @param [in]	addr   Address in framer address space (0 base)
+* @param [out]	value  Pointer to store the register value in
+*
+* @return
+*		- 0 on success
+*		- EINVAL on unaligned or out of range address
+*
+******************************************************************************/
+static int sim_read_word(uint32_t addr, uint32_t *value)
+{
+	sim_init();
+
+	if((addr & 0x3) || (addr >> 2) >= SIM_FRAMER_WORDS)
+	{
+		return EINVAL;
+	}
+
+	if(addr >= ROE_FRAMER_V1_0_STATS_BASE_ADDR)
+	{
+		*value = sim_read_stats(addr);
+	}
+	else
+	{
+		*value = Sim.Framer[addr >> 2];
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes a word of the simulated framer register map.
+* Statistics counters are read-only, ready bits follow the restart bits.
+*
+* @param [in]	addr   Address in framer address space (0 base)
+* @param [in]	value  Register value to write
+*
+* @return
+*		- 0 on success
+*		- EINVAL on unaligned or out of range address
+*
+******************************************************************************/
+static int sim_write_word(uint32_t addr, uint32_t value)
+{
+	sim_init();
+
+	if((addr & 0x3) || (addr >> 2) >= SIM_FRAMER_WORDS)
+	{
+		return EINVAL;
+	}
+
+	if(addr >= ROE_FRAMER_V1_0_STATS_BASE_ADDR)
+	{
+		return 0;
+	}
+
+	if(addr == DEFM_RESTART_ADDR)
+	{
+		/* Count up to the moment the deframer changes state */
+		sim_advance();
+	}
+
+	Sim.Framer[addr >> 2] = value;
+
+	if(addr == FRAM_RESTART_ADDR || addr == DEFM_RESTART_ADDR)
+	{
+		sim_update_ready(addr);
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Finds a sysfs attribute in a table.
+*
+* @param [in]	attrs  Attribute table
+* @param [in]	num    Number of entries in attrs
+* @param [in]	name   Attribute name
+*
+* @return
+*		- Pointer to the attribute, NULL if not found
+*
+******************************************************************************/
+static const sim_attr_struct *sim_find_attr(const sim_attr_struct *attrs, int num, const char *name)
+{
+	int i;
+
+	for(i = 0; i < num; i++)
+	{
+		if(strcmp(attrs[i].name, name) == 0)
+		{
+			return &attrs[i];
+		}
+	}
+
+	return NULL;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the name of a statistics attribute from its sysfs path.
+* Accepts both the flat stats directory and the per-port eth_port_N ones,
+* all ports seeing the same traffic.
+*
+* @param [in]	path   Full sysfs path
+*
+* @return
+*		- Attribute name, NULL if path is not in the stats directory
+*
+******************************************************************************/
+static const char *sim_stats_name(const char *path)
+{
+	const char *name;
+	int port;
+
+	if(strncmp(path, SIM_SYSFS_STATS, strlen(SIM_SYSFS_STATS)) != 0)
+	{
+		return NULL;
+	}
+
+	name = path + strlen(SIM_SYSFS_STATS);
+	if(sscanf(name, "eth_port_%d/", &port) == 1)
+	{
+		if(port < 0 || port >= sim_num_eth_ports() || (name = strchr(name, '/')) == NULL)
+		{
+			return NULL;
+		}
+		name++;
+	}
+
+	return name;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads a simulated sysfs attribute.
+*
+* @param [in]	path   Full sysfs path
+* @param [out]	buf    Buffer to read into
+* @param [in]	length Size of buf
+*
+* @return
+*		- Number of bytes read on success
+*		- -1 with errno set to ENOENT if the attribute does not exist
+*
+******************************************************************************/
+static int sim_sysfs_read(const char *path, char *buf, int length)
+{
+	const sim_attr_struct *attr = NULL;
+	const char *name;
+	uint32_t value = 0;
+	int w;
+
+	sim_init();
+
+	if((name = sim_stats_name(path)) != NULL)
+	{
+		if(strcmp(name, "snapshot") == 0)
+		{
+			return sim_stats_snapshot(buf, length);
+		}
+		attr = sim_find_attr(SimStatsAttrs, sizeof(SimStatsAttrs)/sizeof(SimStatsAttrs[0]), name);
+		if(attr)
+		{
+			sim_read_word(attr->addr, &value);
+		}
+	}
+	else if(strncmp(path, SIM_SYSFS_TRAFFIC, strlen(SIM_SYSFS_TRAFFIC)) == 0)
+	{
+		name = path + strlen(SIM_SYSFS_TRAFFIC);
+		attr = sim_find_attr(SimTrafficAttrs, sizeof(SimTrafficAttrs)/sizeof(SimTrafficAttrs[0]), name);
+		if(attr)
+		{
+			value = Sim.Radio[attr->addr >> 2];
+		}
+	}
+	else if(strcmp(path, SIM_SYSFS_XROE "framer_restart") == 0)
+	{
+		w = snprintf(buf, length, "%s\n", (Sim.Framer[FRAM_RESTART_ADDR >> 2] & FRAM_RESTART_MASK) ? "true" : "false");
+		return (w < length) ? w : length;
+	}
+	else if(strcmp(path, SIM_SYSFS_XROE "deframer_restart") == 0)
+	{
+		w = snprintf(buf, length, "%s\n", (Sim.Framer[DEFM_RESTART_ADDR >> 2] & DEFM_RESTART_MASK) ? "true" : "false");
+		return (w < length) ? w : length;
+	}
+	else if(strcmp(path, SIM_SYSFS_XROE "xxv_reset") == 0)
+	{
+		static const sim_attr_struct xxv_reset = SIM_ATTR(xxv_reset, CFG_USER_RW_OUT);
+
+		attr = &xxv_reset;
+		value = Sim.Framer[attr->addr >> 2];
+	}
+
+	if(!attr)
+	{
+		errno = ENOENT;
+		return -1;
+	}
+
+	w = snprintf(buf, length, "0x%x\n", (value & attr->mask) >> attr->offset);
+
+	return (w < length) ? w : length;
+}
+
+/*****************************************************************************/
+/**
+*
+* Parses a boolean written to a sysfs attribute, as the drivers do.
+*
+* @param [in]	buf    Value written
+*
+* @return
+*		- 1 for "true"/"1" (only the first character is checked), 0 otherwise
+*
+******************************************************************************/
+static int sim_sysfs_bool(const char *buf)
+{
+	return (buf[0] == 't' || buf[0] == '1');
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes a simulated sysfs attribute.
+*
+* @param [in]	path   Full sysfs path
+* @param [in]	buf    Value to write
+* @param [in]	length Number of bytes of buf to write
+*
+* @return
+*		- length on success
+*		- -1 with errno set to ENOENT if the attribute does not exist
+*		- -1 with errno set to EACCES if the attribute is read-only
+*
+******************************************************************************/
+static int sim_sysfs_write(const char *path, const char *buf, int length)
+{
+	const sim_attr_struct *attr;
+	char value[32];
+	uint32_t *reg;
+	uint32_t restart;
+
+	sim_init();
+
+	if(length <= 0)
+	{
+		return 0;
+	}
+	if(length >= (int)sizeof(value))
+	{
+		length = sizeof(value) - 1;
+	}
+	memcpy(value, buf, length);
+	value[length] = 0;
+
+	if(sim_stats_name(path) != NULL)
+	{
+		errno = EACCES;
+		return -1;
+	}
+	else if(strncmp(path, SIM_SYSFS_TRAFFIC, strlen(SIM_SYSFS_TRAFFIC)) == 0)
+	{
+		attr = sim_find_attr(SimTrafficAttrs, sizeof(SimTrafficAttrs)/sizeof(SimTrafficAttrs[0]), path + strlen(SIM_SYSFS_TRAFFIC));
+		if(!attr)
+		{
+			errno = ENOENT;
+			return -1;
+		}
+		reg = &Sim.Radio[attr->addr >> 2];
+		*reg &= ~attr->mask;
+		*reg |= (strtoul(value, NULL, 0) << attr->offset) & attr->mask;
+	}
+	else if(strcmp(path, SIM_SYSFS_XROE "framer_restart") == 0)
+	{
+		restart = Sim.Framer[FRAM_RESTART_ADDR >> 2] & ~FRAM_RESTART_MASK;
+		sim_write_word(FRAM_RESTART_ADDR, restart | (sim_sysfs_bool(value) << FRAM_RESTART_OFFSET));
+	}
+	else if(strcmp(path, SIM_SYSFS_XROE "deframer_restart") == 0)
+	{
+		restart = Sim.Framer[DEFM_RESTART_ADDR >> 2] & ~DEFM_RESTART_MASK;
+		sim_write_word(DEFM_RESTART_ADDR, restart | (sim_sysfs_bool(value) << DEFM_RESTART_OFFSET));
+	}
+	else if(strcmp(path, SIM_SYSFS_XROE "xxv_reset") == 0)
+	{
+		reg = &Sim.Framer[CFG_USER_RW_OUT_ADDR >> 2];
+		*reg &= ~CFG_USER_RW_OUT_MASK;
+		*reg |= (sim_sysfs_bool(value) << CFG_USER_RW_OUT_OFFSET) & CFG_USER_RW_OUT_MASK;
+	}
+	else
+	{
+		errno = ENOENT;
+		return -1;
+	}
+
+	return length;
+}
+
+/**
+ * SimBackend The simulated device backend.
+ */
+static const xroe_backend_t SimBackend = {
+	"simulated framer",
+	sim_read_word,
+	sim_write_word,
+	sim_sysfs_read,
+	sim_sysfs_write
+};
+
+/*****************************************************************************/
+/**
+*
+* Returns the simulated device backend, for use with IP_API_Set_Backend().
+*
+* @return
+*		- Pointer to the simulated backend
+*
+******************************************************************************/
+const xroe_backend_t *SIM_API_Backend(void)
+{
+	return &SimBackend;
+}
+
+/*****************************************************************************/
+/**
+*
+* Resets the simulated devices.
+* Restores the reset values of both register maps and clears the counters.
+* The configured packet rates are kept.
+*
+******************************************************************************/
+void SIM_API_Reset(void)
+{
+	/* The backend is called with the API lock held, so is the state here */
+	IP_API_Lock();
+	if(!Sim.Initialised)
+	{
+		Sim.DataPps = SIM_DEFAULT_DATA_PPS;
+		Sim.CtrlPps = SIM_DEFAULT_CTRL_PPS;
+		Sim.BadPps = SIM_DEFAULT_BAD_PPS;
+	}
+
+	memset(Sim.Framer, 0, sizeof(Sim.Framer));
+	memset(Sim.Radio, 0, sizeof(Sim.Radio));
+	sim_apply_fields(Sim.Framer, SimFramerDefaults, sizeof(SimFramerDefaults)/sizeof(SimFramerDefaults[0]));
+	sim_apply_fields(Sim.Radio, SimRadioDefaults, sizeof(SimRadioDefaults)/sizeof(SimRadioDefaults[0]));
+	sim_update_ready(FRAM_RESTART_ADDR);
+	sim_update_ready(DEFM_RESTART_ADDR);
+
+	Sim.DataGood = Sim.DataBad = Sim.CtrlGood = 0;
+	Sim.DataRem = Sim.BadRem = Sim.CtrlRem = 0;
+	clock_gettime(CLOCK_MONOTONIC, &Sim.LastUpdate);
+	Sim.Initialised = 1;
+	IP_API_Unlock();
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets the packet rates of the simulated deframer.
+* Counters are brought up to date at the old rates first.
+*
+* @param [in]	data_pps Good user data packets per second
+* @param [in]	ctrl_pps Good user control packets per second
+* @param [in]	bad_pps  User data packets per second received with a bad FCS
+*
+******************************************************************************/
+void SIM_API_Set_Rates(uint32_t data_pps, uint32_t ctrl_pps, uint32_t bad_pps)
+{
+	IP_API_Lock();
+	sim_init();
+	sim_advance();
+
+	Sim.DataPps = data_pps;
+	Sim.CtrlPps = ctrl_pps;
+	Sim.BadPps = bad_pps;
+	IP_API_Unlock();
+}
+
+/*****************************************************************************/
+/**
+*
+* Gets the packet rates of the simulated deframer.
+*
+* @param [out]	pDataPps Good user data packets per second
+* @param [out]	pCtrlPps Good user control packets per second
+* @param [out]	pBadPps  User data packets per second received with a bad FCS
+*
+******************************************************************************/
+void SIM_API_Get_Rates(uint32_t *pDataPps, uint32_t *pCtrlPps, uint32_t *pBadPps)
+{
+	IP_API_Lock();
+	sim_init();
+
+	*pDataPps = Sim.DataPps;
+	*pCtrlPps = Sim.CtrlPps;
+	*pBadPps = Sim.BadPps;
+	IP_API_Unlock();
+}
+/** @} */
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/******************************************************************************
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ *
+ ******************************************************************************/ 
+
+/** 
+* @file xroe_sim.h
+* @addtogroup framer_driver_api
+* @{
+*
+*  Simulated Radio over Ethernet Framer and traffic generator device backend
+*
+*
+******************************************************************************/
+#ifndef XROE_SIM_H		/* prevent circular inclusions */
+#define XROE_SIM_H		/* by using protection macros */
+
+#include <stdint.h>
+#include <xroe_api.h>
+
+/************************** Function Prototypes ******************************/
+const xroe_backend_t *SIM_API_Backend(void);
+void SIM_API_Reset(void);
+void SIM_API_Set_Rates(uint32_t data_pps, uint32_t ctrl_pps, uint32_t bad_pps);
+void SIM_API_Get_Rates(uint32_t *pDataPps, uint32_t *pCtrlPps, uint32_t *pBadPps);
+#endif /* end of protection macro */
+/** @} */
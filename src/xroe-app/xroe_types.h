@@ -4,8 +4,10 @@
  * Copyright (C) 2018 Xilinx, Inc.
  *
  ******************************************************************************/ 
- 
-typedef int (*CommandFunc)(int argc, char **argv, char *resp);
+
+#include <response.h>
+
+typedef int (*CommandFunc)(int argc, char **argv, response_t *resp);
 
 typedef struct _commands_t
 {
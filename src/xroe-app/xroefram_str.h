@@ -21,10 +21,20 @@
 "Usage: <app> [options] [\"command [args]\"]\n" \
 "Options:\n" \
 "  -d daemonise server\n" \
-"  -s soft server mode, no local hardware\n" \
+"  -s soft server mode, no local hardware, registers and sysfs are simulated\n" \
 "  -c send command to server\n" \
+"  -f <file> send the commands of <file> (- for stdin), one per line, to server over one connection\n" \
+"  -E, --stop-on-error with -f stops at the first command failing, later commands are not sent\n" \
+"  -T, --timing with -f prints the time each command took on the server, and the total, to stderr\n" \
 "  -n <ip_addr> with -c send command to remote app at <ip_addr>\n" \
 "  -p <port> with -n specifies remote port to send to, with -d or -s specifies server listen port\n" \
+"  -S <period_ms> with -d or -s samples the framer statistics every <period_ms> milliseconds\n" \
+"  -m <port> with -d or -s serves OpenMetrics at http://<host>:<port>/metrics\n" \
+"  -P with -d or -s publishes the statistics in shared memory, see xroe_shm.h\n" \
+"  -w <threads> with -d or -s runs the commands in <threads> threads (default 4), 0 runs them in the main loop\n" \
+"  -r cpu=<n>,prio=<p> with -d or -s pins the eCPRI thread to CPU <n> (the next ones to <n>+1...) at SCHED_FIFO priority <p>, with memory locked\n" \
+"  -U <threads> with -d or -s receives eCPRI on <threads> UDP sockets sharing the port (default 1, at most 16), each served by a thread, peers spread by source address\n" \
+"  -u with -d or -s batches the socket accepts and reads, and the stats sysfs reads, with io_uring when the kernel has it\n" \
 "  -h produces this help\n" \
 "\n" \
 "Commands:\n" \
@@ -85,4 +95,19 @@
  * RADIO_CTRL_STR Help text for "radio" command.
  */
 #define RADIO_CTRL_STR "Radio control device access\n"
+
+/**
+ * SIM_STR Help text for "sim" command.
+ */
+#define SIM_STR "Simulated framer control (soft server mode only)\n"
+
+/**
+ * SUBSCRIBE_STR Help text for "subscribe" command.
+ */
+#define SUBSCRIBE_STR "Pushes stats, radio or owdm changes: subscribe <group> <period_ms>\n"
+
+/**
+ * XROE_SCRIPT_STR Help text for "script" command.
+ */
+#define XROE_SCRIPT_STR "Runs the commands of a server script, stopping at the first failure: script <name> (a file of " XROE_SCRIPT_DIR ")\n"
 /** @} */